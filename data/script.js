@@ -359,7 +359,7 @@ const fetchWithTimeout = (url, options, timeout = 30000) => {
 
 function validateFirmwareFile(file) {
   // Check file type
-  if (!file.name.endsWith('.bin')) {
+  if (!file.name.endsWith('.bin') && !file.name.endsWith('.bin.gz')) {
     return { valid: false, message: "Invalid firmware file format. Expected .bin file." };
   }
   
@@ -371,8 +371,103 @@ function validateFirmwareFile(file) {
   return { valid: true };
 }
 
+// The device inflates a .bin.gz upload as it arrives, so compressing first
+// sends far less for a mostly empty filesystem image
+async function compressFirmwareFile(file) {
+  if (file.name.endsWith('.gz') || typeof CompressionStream === "undefined") {
+    return file;
+  }
+  try {
+    const stream = file.stream().pipeThrough(new CompressionStream("gzip"));
+    const compressed = await new Response(stream).blob();
+    return compressed.size < file.size
+      ? new File([compressed], file.name + '.gz')
+      : file;
+  } catch (error) {
+    console.warn("Compression failed, uploading as is:", error);
+    return file;
+  }
+}
+
+// SHA-256 of an image as lowercase hex. The device page is served over
+// plain http where crypto.subtle is missing, so hash in script there.
+const SHA256_K = new Uint32Array([
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+  0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+  0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+  0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+  0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+  0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+  0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+  0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+  0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+]);
+
+function sha256Script(bytes) {
+  const length = bytes.length;
+  const padded = new Uint8Array(((length + 72) >> 6) << 6);
+  padded.set(bytes);
+  padded[length] = 0x80;
+  const view = new DataView(padded.buffer);
+  view.setUint32(padded.length - 8, Math.floor(length / 0x20000000));
+  view.setUint32(padded.length - 4, length << 3);
+
+  const h = new Uint32Array([
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+  ]);
+  const w = new Uint32Array(64);
+  const rotr = (x, n) => (x >>> n) | (x << (32 - n));
+  for (let block = 0; block < padded.length; block += 64) {
+    for (let i = 0; i < 16; i++) w[i] = view.getUint32(block + i * 4);
+    for (let i = 16; i < 64; i++) {
+      const s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >>> 3);
+      const s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >>> 10);
+      w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    let [a, b, c, d, e, f, g, k] = h;
+    for (let i = 0; i < 64; i++) {
+      const t1 = k + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) +
+        ((e & f) ^ (~e & g)) + SHA256_K[i] + w[i];
+      const t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) +
+        ((a & b) ^ (a & c) ^ (b & c));
+      k = g; g = f; f = e; e = (d + t1) | 0;
+      d = c; c = b; b = a; a = (t1 + t2) | 0;
+    }
+    h[0] += a; h[1] += b; h[2] += c; h[3] += d;
+    h[4] += e; h[5] += f; h[6] += g; h[7] += k;
+  }
+  return Array.from(h, (x) => x.toString(16).padStart(8, "0")).join("");
+}
+
+async function sha256Hex(file) {
+  const bytes = new Uint8Array(await file.arrayBuffer());
+  if (window.crypto && crypto.subtle) {
+    const digest = new Uint8Array(await crypto.subtle.digest("SHA-256", bytes));
+    return Array.from(digest, (x) => x.toString(16).padStart(2, "0")).join("");
+  }
+  return sha256Script(bytes);
+}
+
+// How much of an interrupted upload of this image is already on the device,
+// 0 to start over
+async function getResumeOffset(imageHash) {
+  try {
+    const response = await fetchWithTimeout("/update/session", {}, 5000);
+    const data = await response.json();
+    return data.session && data.session.sha256 === imageHash
+      ? data.session.offset
+      : 0;
+  } catch (error) {
+    console.warn("No update session:", error);
+    return 0;
+  }
+}
+
 // Firmware update handler
-function handleFirmwareUpdate(e) {
+async function handleFirmwareUpdate(e) {
   e.preventDefault();
   ui.hideStatus(elements.updateStatusNotification);
   const form = e.target;
@@ -392,8 +487,31 @@ function handleFirmwareUpdate(e) {
 
   ui.initProgress();
 
+  // Naming the image lets the device resume an interrupted upload, only the
+  // part it does not have yet is sent. A .gz file can't be split, it is
+  // always sent whole.
+  let uploadUrl = form.action;
+  let imageFile = firmwareFile;
+  if (!firmwareFile.name.endsWith(".gz")) {
+    const imageHash = await sha256Hex(firmwareFile);
+    const offset = await getResumeOffset(imageHash);
+    uploadUrl += `?sha256=${imageHash}`;
+    if (offset > 0 && offset < firmwareFile.size) {
+      uploadUrl += `&offset=${offset}`;
+      imageFile = new File([firmwareFile.slice(offset)], firmwareFile.name);
+      ui.showStatus(
+        elements.updateStatusNotification,
+        `Resuming the update at ${Math.floor((offset * 100) / firmwareFile.size)}%`,
+        "WARNING"
+      );
+    }
+  }
+
+  const uploadFile = await compressFirmwareFile(imageFile);
+  formData.set("firmwareFile", uploadFile, uploadFile.name);
+
   const xhr = new XMLHttpRequest();
-  xhr.open("POST", form.action, true);
+  xhr.open("POST", uploadUrl, true);
 
   const handleError = (message) => {
     ui.resetProgress();
@@ -472,7 +590,8 @@ function handleFirmwareUpdate(e) {
       clearInterval(statusInterval);
     }
     handleError(
-      "Network timed out, make sure you are connected to your Wi-Fi network."
+      "Network timed out, make sure you are connected to your Wi-Fi network. " +
+        "Choose Update again with the same file to resume."
     );
   };
 
@@ -64,6 +64,10 @@
  #define ADXL345_INT_SOURCE_DATAREADY 0x80
  /** @brief FIFO bypass mode setting */
  #define ADXL345_FIFO_BYPASS_MODE 0x00
+ /** @brief FIFO stream mode setting (watermark goes in the lower 5 bits) */
+ #define ADXL345_FIFO_STREAM_MODE 0x80
+ /** @brief Low power bit of the BW_RATE register (valid 12.5-400 Hz) */
+ #define ADXL345_BW_RATE_LOW_POWER 0x10
  
  //------------------------------------------------------------------------------
  // Tap Axis Source Bitmasks
@@ -75,6 +79,32 @@
  /** @brief Z-axis tap detection bit */
  #define ADXL345_TAP_SOURCE_Z 0x01
  
+ //==============================================================================
+ // TYPE DEFINITIONS
+ //==============================================================================
+ 
+ /**
+  * @brief Sampling profiles selected by the motion governor
+  *
+  * Ordered from lowest to highest data rate so profiles can be compared.
+  */
+ enum class ADXLPowerProfile {
+   RESTING = 0, /**< Low power, low rate sampling while the device is idle */
+   ACTIVE,      /**< Default sampling rate for normal operation */
+   INTERACTIVE  /**< High rate sampling while the device is being handled */
+ };
+ 
+ /**
+  * @brief Register and polling settings for a sampling profile
+  */
+ struct ADXLProfileConfig {
+   dataRate_t dataRate;         /**< Output data rate register value */
+   float sampleRateHz;          /**< Output data rate in Hz */
+   bool lowPower;               /**< Whether the low power bit is set */
+   uint8_t fifoWatermark;       /**< FIFO watermark in samples (0-31) */
+   unsigned long pollInterval;  /**< Minimum time between FIFO reads (ms) */
+ };
+ 
  //==============================================================================
  // PUBLIC API FUNCTIONS
  //==============================================================================
@@ -125,6 +155,35 @@
   */
  bool isSensorEnabled();
  
+ /**
+  * @brief Switches output data rate, low power bit and FIFO watermark
+  *
+  * The FIFO is flushed on every change so samples taken at different rates
+  * are never mixed in one batch.
+  *
+  * @param profile Sampling profile to apply
+  * @return true if the profile was applied, false if the sensor is disabled
+  */
+ bool setADXLPowerProfile(ADXLPowerProfile profile);
+ 
+ /**
+  * @brief Gets the sampling profile currently applied to the sensor
+  * @return Active sampling profile
+  */
+ ADXLPowerProfile getADXLPowerProfile();
+ 
+ /**
+  * @brief Gets the output data rate of the active profile
+  * @return Sample rate in Hz
+  */
+ float getADXLSampleRate();
+ 
+ /**
+  * @brief Gets the minimum time between FIFO reads for the active profile
+  * @return Poll interval in milliseconds
+  */
+ unsigned long getADXLPollInterval();
+ 
  /**
   * @brief Reads a value from a specified register on the ADXL345
   * @param reg Register address to read
@@ -12,7 +12,9 @@
  #define ANIMATION_MODULE_H
  
  #include "common.h"
+ #include "emotes_module.h"
  #include "gif_module.h"
+ #include "motion_module.h"
  
  //==============================================================================
  // CONSTANTS & DEFINITIONS
@@ -21,10 +23,40 @@
  /** @brief Log tag for Animation module messages */
  static const char* ANIM_LOG = "::ANIMATION_MODULE::";
  
+ /** @brief Number of buckets in a reaction latency histogram */
+ #define LATENCY_BUCKET_COUNT 9
+ 
  //==============================================================================
  // TYPE DEFINITIONS
  //==============================================================================
  
+ /**
+  * @brief Scheduling priority of a playing emote
+  *
+  * An emote is preempted at the next frame boundary when a higher priority
+  * source becomes pending. A new interaction also restarts an interaction
+  * emote so every tap gets its own reaction.
+  */
+ enum class EmotePriority : uint8_t {
+   IDLE = 0,    /**< Idle, resting and sleep animations */
+   COMMS,       /**< ESP-NOW connection and conversation animations */
+   ORIENTATION, /**< Crash and tilt animations */
+   INTERACTION  /**< Tap, shake and sudden acceleration reactions */
+ };
+ 
+ /**
+  * @brief Interaction to first reaction pixel latency histogram
+  *
+  * Bucket upper bounds are 10, 20, 30, 50, 75, 100, 150 and 250 ms, the
+  * last bucket collects everything slower.
+  */
+ struct ReactionLatencyStats {
+   uint32_t buckets[LATENCY_BUCKET_COUNT]; /**< Samples per latency bucket */
+   uint32_t count;                         /**< Total samples recorded */
+   uint32_t maxMicros;                     /**< Slowest reaction (µs) */
+   uint64_t totalMicros;                   /**< Sum of all reactions (µs) */
+ };
+ 
  /**
   * @brief States for the animation sequence state machine
   */
@@ -82,15 +114,42 @@
  void initializeAnimationModule(void);
  
  /**
-  * @brief Play a GIF animation with interaction detection
+  * @brief Play an emote with interaction detection
+  * 
+  * This is a blocking function that plays an emote while monitoring
+  * for interactions that might interrupt the animation. Playback stops at
+  * the next frame boundary when a higher priority emote is pending.
+  * 
+  * @param emote Emote to play
+  * @param priority Scheduling priority of this emote
+  * @return true if playback completed successfully
+  */
+ bool playEmote(EmoteId emote, EmotePriority priority);
+ 
+ /**
+  * @brief Play an emote starting at a scheduled time
+  * 
+  * Waits for the start, then paces GIF frames against it so bots sharing a
+  * clock show the same frame together. Frames that are late run back to
+  * back until playback has caught up. Other renderers just start on time.
+  * 
+  * @param emote Emote to play
+  * @param priority Scheduling priority of this emote
+  * @param startMicros Local micros() time of the first frame
+  * @return true if playback completed successfully
+  */
+ bool playEmoteAt(EmoteId emote, EmotePriority priority, uint32_t startMicros);
+ 
+ /**
+  * @brief Play an emote at the priority its registry flags imply
   * 
-  * This is a blocking function that plays a GIF file while monitoring
-  * for interactions that might interrupt the animation.
+  * EMOTE_FLAG_ORIENTATION emotes play at ORIENTATION, EMOTE_FLAG_COMMS
+  * emotes at COMMS and everything else at IDLE.
   * 
-  * @param filename Path to the GIF file to play
+  * @param emote Emote to play
   * @return true if playback completed successfully
   */
- bool playGIF(const char* filename);
+ bool playEmote(EmoteId emote);
  
  /**
   * @brief Main function to handle emote playback
@@ -108,4 +167,17 @@
   */
  void playBootAnimation(void);
  
+ /**
+  * @brief Get the reaction latency histogram for an interaction type
+  * 
+  * @param type Interaction type
+  * @return Copy of the statistics recorded since boot or the last reset
+  */
+ ReactionLatencyStats getReactionLatencyStats(MotionEventType type);
+ 
+ /**
+  * @brief Clear all reaction latency histograms
+  */
+ void resetReactionLatencyStats(void);
+ 
  #endif /* ANIMATION_MODULE_H */
\ No newline at end of file
@@ -0,0 +1,178 @@
+/**
+ * @file behavior_module.h
+ * @brief Header for the table-driven behavior graph interpreter
+ *
+ * The behavior graph describes which emote the device plays in each state
+ * and which trigger moves it to the next state. It is compiled on the host
+ * from a readable source file (see tools/behavior_compiler.py) and loaded
+ * from LittleFS at boot, so behavior can change without reflashing.
+ *
+ * The interpreter only evaluates transitions. Every trigger is a single
+ * lookup in a dense state x trigger table, so evaluation cost is constant
+ * regardless of graph size. Playback is driven by the animation module.
+ */
+
+#ifndef BEHAVIOR_MODULE_H
+#define BEHAVIOR_MODULE_H
+
+#include "animation_module.h"
+#include "common.h"
+#include "emotes_module.h"
+
+//==============================================================================
+// CONSTANTS & DEFINITIONS
+//==============================================================================
+
+/** @brief Log tag for Behavior module messages */
+static const char *BEHAVIOR_LOG = "::BEHAVIOR_MODULE::";
+
+/** @brief Default location of the compiled behavior graph */
+#define BEHAVIOR_GRAPH_PATH "/behavior.bin"
+
+/** @brief Binary format version understood by the interpreter */
+#define BEHAVIOR_GRAPH_VERSION 1
+
+/** @brief Largest behavior graph file accepted (bytes) */
+#define BEHAVIOR_GRAPH_MAX_SIZE 8192
+
+/** @brief Transition table value for "no transition" */
+#define BEHAVIOR_NO_TRANSITION 0xFF
+/** @brief Transition table value for "return to the interrupted state" */
+#define BEHAVIOR_RETURN 0xFE
+/** @brief Emote reference value for "play nothing" */
+#define BEHAVIOR_NO_EMOTE 0xFF
+
+//==============================================================================
+// TYPE DEFINITIONS
+//==============================================================================
+
+/**
+ * @brief Inputs that can move the behavior graph to another state
+ *
+ * NOTE: The numeric values are part of the binary format and must match
+ * TRIGGERS in tools/behavior_compiler.py.
+ */
+enum class BehaviorTrigger : uint8_t {
+  TAPPED = 0,          /**< Single tap event */
+  DOUBLE_TAPPED,       /**< Double tap event */
+  SHAKING,             /**< Shake started */
+  SUDDEN_ACCELERATION, /**< Sudden acceleration event */
+  TILTED,              /**< Fully tilted left/right or upside down */
+  HALF_TILTED,         /**< Tilted about 45 degrees */
+  UPRIGHT,             /**< Resting in the normal position */
+  SLEEP,               /**< Idle timeout reached */
+  AWAKE,               /**< Not idle */
+  COMMS_ON,            /**< ESP-NOW was just turned on */
+  COMMS_OFF,           /**< ESP-NOW was just turned off */
+  TIMER,               /**< State timer expired */
+  DONE,                /**< State emote finished playing */
+  // Keep track of the total number of triggers
+  BEHAVIOR_TRIGGER_COUNT /**< Total count of triggers (for table sizing) */
+};
+
+/**
+ * @brief State flags stored in the binary graph
+ */
+enum BehaviorStateFlags : uint8_t {
+  BEHAVIOR_FLAG_TRANSIENT = 0x01, /**< Remembers the state it interrupted */
+  BEHAVIOR_FLAG_POOL = 0x02,      /**< Emote reference is a pool index */
+};
+
+/**
+ * @brief File header of a compiled behavior graph (little endian)
+ */
+struct __attribute__((packed)) BehaviorGraphHeader {
+  char magic[4];         /**< "BHVG" */
+  uint8_t version;       /**< BEHAVIOR_GRAPH_VERSION */
+  uint8_t stateCount;    /**< Number of states */
+  uint8_t triggerCount;  /**< Columns in the transition table */
+  uint8_t emoteCount;    /**< Number of emote paths */
+  uint8_t poolCount;     /**< Number of emote pools */
+  uint8_t poolSize;      /**< Total pool members across all pools */
+  uint8_t initialState;  /**< State entered after loading */
+  uint8_t reserved;      /**< Padding, must be zero */
+  uint16_t stringsSize;  /**< Size of the path string table */
+  uint16_t totalSize;    /**< Size of the whole file */
+};
+
+/**
+ * @brief A state record in a compiled behavior graph
+ */
+struct __attribute__((packed)) BehaviorStateRecord {
+  uint8_t flags;    /**< BehaviorStateFlags */
+  uint8_t emote;    /**< Emote or pool index, BEHAVIOR_NO_EMOTE for none */
+  uint8_t priority; /**< EmotePriority used for playback */
+  uint8_t reserved; /**< Padding, must be zero */
+  uint32_t timerMs; /**< TIMER fires after this long in the state, 0 = never */
+};
+
+/**
+ * @brief What the current behavior state wants to play
+ */
+struct BehaviorAction {
+  EmoteId emote;          /**< Single emote, EmoteId::NONE if none */
+  const EmoteId *pool;    /**< Pool of emotes, nullptr if none */
+  size_t poolCount;       /**< Number of emotes in pool */
+  EmotePriority priority; /**< Playback priority */
+};
+
+//==============================================================================
+// PUBLIC API FUNCTIONS
+//==============================================================================
+
+/**
+ * @brief Load and validate a compiled behavior graph from LittleFS
+ *
+ * Any previously loaded graph is released first. On failure no graph is
+ * loaded and the caller should fall back to the built-in behavior.
+ *
+ * @param path Path of the compiled graph
+ * @return true if the graph was loaded and entered its initial state
+ */
+bool loadBehaviorGraph(const char *path = BEHAVIOR_GRAPH_PATH);
+
+/**
+ * @brief Release the loaded behavior graph
+ */
+void unloadBehaviorGraph(void);
+
+/**
+ * @brief Check whether a behavior graph is loaded
+ *
+ * @return true if a graph is loaded
+ */
+bool behaviorGraphLoaded(void);
+
+/**
+ * @brief Evaluate a trigger against the current state
+ *
+ * A single table lookup. A transition to the current state keeps the state
+ * (and its timer) but still counts as handled.
+ *
+ * @param trigger Trigger to evaluate
+ * @return true if the current state defines a transition for the trigger
+ */
+bool fireBehaviorTrigger(BehaviorTrigger trigger);
+
+/**
+ * @brief Check whether the current state's timer has expired
+ *
+ * @return true if the state has a timer and it has run out
+ */
+bool behaviorTimerExpired(void);
+
+/**
+ * @brief Get what the current state wants to play
+ *
+ * @return Emote or pool to play and its priority
+ */
+BehaviorAction getBehaviorAction(void);
+
+/**
+ * @brief Index of the current state
+ *
+ * @return Current state index, or BEHAVIOR_NO_TRANSITION if no graph loaded
+ */
+uint8_t getBehaviorState(void);
+
+#endif /* BEHAVIOR_MODULE_H */
@@ -0,0 +1,193 @@
+/**
+ * @file compositor_module.h
+ * @brief Header for the layered sprite compositor
+ *
+ * Builds emotes from a static background plus independently animated
+ * sprite layers (eyes, mouth, overlays) instead of full-screen GIFs. Layers
+ * are RGB565 strips with an optional 8-bit alpha plane, composited one
+ * scanline at a time, and only the rectangles that changed since the last
+ * frame are sent to the display.
+ *
+ * Sprite files (.spr) are produced on the host by tools/sprite_converter.py.
+ * Scene files (.scene) are plain text:
+ *
+ *   background /sprites/face.spr   (or: background 0x0000 for a solid color)
+ *   duration 4000                  (ms, SCENE_DEFAULT_DURATION_MS if absent)
+ *   layer /sprites/eyes.spr 24 36  [frameMs] [depth] [slosh]
+ *
+ * A layer with a depth shifts up to that many pixels with the device tilt,
+ * or with the spring-damped slosh when "slosh" follows.
+ */
+
+#ifndef COMPOSITOR_MODULE_H
+#define COMPOSITOR_MODULE_H
+
+#include "common.h"
+
+//==============================================================================
+// CONSTANTS & DEFINITIONS
+//==============================================================================
+
+/** @brief Log tag for Compositor module messages */
+static const char *COMPOSITOR_LOG = "::COMPOSITOR_MODULE::";
+
+/** @brief File extension identifying composited scenes */
+#define SCENE_EXTENSION ".scene"
+
+/** @brief Scene length when the scene file does not set one (ms) */
+#define SCENE_DEFAULT_DURATION_MS 3000
+
+/** @brief Maximum number of sprite layers in a scene */
+#define COMPOSITOR_MAX_LAYERS 6
+/** @brief Maximum number of separate dirty rectangles per frame */
+#define COMPOSITOR_MAX_DIRTY_RECTS 8
+/** @brief Invalid layer handle */
+#define COMPOSITOR_INVALID_LAYER -1
+
+/** @brief Sprite file magic */
+#define SPRITE_MAGIC "SPR1"
+/** @brief Sprite flag: an alpha plane follows every color plane */
+#define SPRITE_FLAG_ALPHA 0x01
+
+//==============================================================================
+// TYPE DEFINITIONS
+//==============================================================================
+
+/**
+ * @brief Sprite file header (little endian), followed by the frames
+ *
+ * Each frame is width x height RGB565 pixels, then width x height alpha
+ * bytes when SPRITE_FLAG_ALPHA is set.
+ */
+struct __attribute__((packed)) SpriteHeader {
+  char magic[4];         /**< SPRITE_MAGIC */
+  uint16_t width;        /**< Frame width in pixels */
+  uint16_t height;       /**< Frame height in pixels */
+  uint8_t frameCount;    /**< Number of frames in the strip */
+  uint8_t flags;         /**< SPRITE_FLAG_* */
+  uint16_t frameDelayMs; /**< Default time per frame */
+};
+
+/**
+ * @brief Screen-space rectangle
+ */
+struct CompositorRect {
+  int16_t x; /**< Left edge */
+  int16_t y; /**< Top edge */
+  int16_t w; /**< Width, 0 for empty */
+  int16_t h; /**< Height, 0 for empty */
+};
+
+//==============================================================================
+// PUBLIC API FUNCTIONS
+//==============================================================================
+
+/**
+ * @brief Blend an RGB565 pixel over another
+ *
+ * @param fg Foreground color
+ * @param bg Background color
+ * @param alpha Foreground opacity 0-255
+ * @return Blended color
+ */
+uint16_t blendRGB565(uint16_t fg, uint16_t bg, uint8_t alpha);
+
+/**
+ * @brief Release every layer and the background
+ */
+void clearCompositor(void);
+
+/**
+ * @brief Load a sprite file as the background layer
+ *
+ * The first frame is used and alpha is ignored.
+ *
+ * @param path Sprite file path
+ * @return true if loaded
+ */
+bool setCompositorBackground(const char *path);
+
+/**
+ * @brief Use a solid color as the background layer
+ *
+ * @param color RGB565 color
+ */
+void setCompositorBackgroundColor(uint16_t color);
+
+/**
+ * @brief Add an animated sprite layer on top of the existing ones
+ *
+ * @param path Sprite file path
+ * @param x Left edge on screen
+ * @param y Top edge on screen
+ * @param frameDelayMs Time per frame, 0 to use the sprite default
+ * @return Layer handle, or COMPOSITOR_INVALID_LAYER on failure
+ */
+int addCompositorLayer(const char *path, int16_t x, int16_t y,
+                       uint32_t frameDelayMs = 0);
+
+/**
+ * @brief Move a layer, marking the old and new areas dirty
+ *
+ * @param layer Layer handle
+ * @param x New left edge
+ * @param y New top edge
+ */
+void setCompositorLayerPosition(int layer, int16_t x, int16_t y);
+
+/**
+ * @brief Make a layer shift with the device tilt
+ *
+ * @param layer Layer handle
+ * @param depth Shift at full tilt (px), negative moves against the tilt
+ * @param slosh true to follow the spring-damped slosh instead of the tilt
+ */
+void setCompositorLayerDepth(int layer, int8_t depth, bool slosh = false);
+
+/**
+ * @brief Show or hide a layer
+ *
+ * @param layer Layer handle
+ * @param visible true to show
+ */
+void setCompositorLayerVisible(int layer, bool visible);
+
+/**
+ * @brief Mark a screen area for redraw on the next frame
+ *
+ * @param rect Area to redraw
+ */
+void invalidateCompositorRect(const CompositorRect &rect);
+
+/**
+ * @brief Advance layer animations and send changed areas to the display
+ *
+ * @return Number of pixels written this frame
+ */
+uint32_t renderCompositorFrame(void);
+
+/**
+ * @brief Load a scene file into the compositor
+ *
+ * @param path Scene file path
+ * @param durationMs Receives the scene duration (ms)
+ * @return true if the background and every layer loaded
+ */
+bool loadCompositorScene(const char *path, unsigned long *durationMs);
+
+/**
+ * @brief Check whether any layer follows the device tilt
+ *
+ * @return true if the scene needs motion-reactive frames
+ */
+bool compositorMotionReactive(void);
+
+/**
+ * @brief Check whether a path names a composited scene
+ *
+ * @param path Emote path
+ * @return true if the path ends with SCENE_EXTENSION
+ */
+bool isCompositorScene(const char *path);
+
+#endif /* COMPOSITOR_MODULE_H */
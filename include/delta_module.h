@@ -0,0 +1,103 @@
+/**
+ * @file delta_module.h
+ * @brief Header for delta firmware updates against the running firmware
+ *
+ * A delta update carries a patch instead of an image. The patch rebuilds
+ * the new firmware from the running one and is applied as it arrives: old
+ * bytes are read back from the running app partition, combined with the
+ * patch and written to the next OTA slot through Update. RAM use is one
+ * small read buffer and a hash context whatever the image size.
+ *
+ * Patches are made by tools/delta_patch.py and name the running firmware
+ * by its SHA-256, which GET_INFO reports.
+ *
+ * Patch format, little endian:
+ * - Header: magic "B90D", uint32 old size, old SHA-256, uint32 new size,
+ *   new SHA-256
+ * - Records until new size bytes are produced: uint32 diff length, uint32
+ *   extra length, int32 seek, then diff length bytes that are added to the
+ *   old bytes at the old position, then extra length bytes copied as is.
+ *   The old position advances over the diff bytes and then moves by seek.
+ */
+
+#ifndef DELTA_MODULE_H
+#define DELTA_MODULE_H
+
+#include "common.h"
+
+//==============================================================================
+// CONSTANTS & DEFINITIONS
+//==============================================================================
+
+/** @brief Log tag for Delta module messages */
+static const char *DELTA_LOG = "::DELTA_MODULE::";
+
+/** @brief First bytes of every patch */
+#define DELTA_MAGIC "B90D"
+/** @brief SHA-256 digest size (bytes) */
+#define DELTA_HASH_SIZE 32
+/** @brief Magic, sizes and digests of both images (bytes) */
+#define DELTA_HEADER_SIZE (4 + 4 + DELTA_HASH_SIZE + 4 + DELTA_HASH_SIZE)
+/** @brief Diff length, extra length and seek (bytes) */
+#define DELTA_RECORD_SIZE 12
+/** @brief Old firmware bytes read from flash at a time */
+#define DELTA_READ_BUFFER_SIZE 1024
+
+//==============================================================================
+// PUBLIC API FUNCTIONS
+//==============================================================================
+
+/**
+ * @brief SHA-256 of the running firmware image, computed once
+ *
+ * Covers the image as flashed, so it equals the SHA-256 of its .bin file.
+ *
+ * @return Digest or nullptr if the partition could not be read
+ */
+const uint8_t *getRunningFirmwareHash();
+
+/**
+ * @brief Start applying a patch into a running Update
+ *
+ * Update must have been started for U_FLASH, the header is checked against
+ * the running firmware once it arrives.
+ */
+void beginDelta();
+
+/**
+ * @brief Apply the next patch bytes
+ *
+ * @param data Patch bytes in stream order
+ * @param length Number of bytes
+ * @return false if the patch is malformed, made for other firmware or a
+ *         flash access failed, see getDeltaError()
+ */
+bool deltaWrite(const uint8_t *data, size_t length);
+
+/**
+ * @brief Finish applying a patch
+ *
+ * @return true if the whole new image was produced and its SHA-256 matches
+ */
+bool endDelta();
+
+/**
+ * @brief Stop applying a patch, safe when idle
+ */
+void abortDelta();
+
+/**
+ * @brief New image bytes written to Update since beginDelta()
+ *
+ * @return Byte count
+ */
+size_t getDeltaOutputSize();
+
+/**
+ * @brief Why the last deltaWrite() or endDelta() failed
+ *
+ * @return Error message, empty if none
+ */
+const char *getDeltaError();
+
+#endif /* DELTA_MODULE_H */
@@ -4,7 +4,9 @@
  * 
  * This module provides definitions for all GIF animations and static images
  * used for the device's emotional expression system. It includes different
- * categories of emotes for various device modes and states.
+ * categories of emotes for various device modes and states. Emotes are
+ * passed around as EmoteId handles that index a registry generated from
+ * EMOTE_TABLE.
  */
 
  #ifndef EMOTES_MODULE_H
@@ -12,74 +14,148 @@
  
  #include "common.h"
  
+ /** @brief Log tag for Emotes module messages */
+ static const char *EMOTES_LOG = "::EMOTES_MODULE::";
+ 
  //==============================================================================
- // ANIMATED EMOTES (GIF FILES)
+ // EMOTE REGISTRY
  //==============================================================================
  
- //------------------------------------------------------------------------------
- // Common Emotes
- //------------------------------------------------------------------------------
- /** @brief GIF Animation Emotes for ALL variations MAC, PC, and BYTE-90 default
-  * Animations are optimized GIFs for the ESP32's SPIFFS filesystem
-  * GIFs are 128x128 pixels and 16FPS
+ /** @brief Emote is drawn without file access */
+ #define EMOTE_FLAG_PROCEDURAL 0x01
+ /** @brief Orientation emote, plays while tilted so a tilt never preempts it */
+ #define EMOTE_FLAG_ORIENTATION 0x02
+ /** @brief ESP-NOW communication emote */
+ #define EMOTE_FLAG_COMMS 0x04
+ 
+ /** @brief Maximum number of emotes registered at runtime (behavior graph) */
+ #define EMOTE_RUNTIME_MAX_COUNT 64
+ 
+ /**
+  * @brief Every built-in emote as X(id, kind, path, flags)
+  *
+  * GIF animations are optimized 128x128 GIFs at 16FPS on LittleFS. Eye
+  * emotes are drawn by eyes_module instead and follow the accelerometer
+  * between moves. The enum, path and flag tables are all generated from
+  * this list, so an emote is added by adding one line.
+  */
+ #define EMOTE_TABLE(X)                                                      \
+   /* Common emotes for ALL variations MAC, PC, and BYTE-90 default */       \
+   X(ANGRY, GIF, "/gifs/angry.gif", 0)                                       \
+   X(CRASH01, GIF, "/gifs/crash_01.gif", EMOTE_FLAG_ORIENTATION)             \
+   X(CRASH02, GIF, "/gifs/crash_02.gif", EMOTE_FLAG_ORIENTATION)             \
+   X(CRASH03, GIF, "/gifs/crash_03.gif", EMOTE_FLAG_ORIENTATION)             \
+   X(CRY, GIF, "/gifs/cry.gif", 0)                                           \
+   X(DIZZY, GIF, "/gifs/dizzy.gif", 0)                                       \
+   X(DOUBTFUL, GIF, "/gifs/doubtful.gif", 0)                                 \
+   X(IDLE, GIF, "/gifs/idle.gif", 0)                                         \
+   X(LOOK_DOWN, GIF, "/gifs/look_down.gif", 0)                               \
+   X(LOOK_LEFT_RIGHT, GIF, "/gifs/look_left_right.gif", 0)                   \
+   X(LOOK_UP, GIF, "/gifs/look_up.gif", 0)                                   \
+   X(REST, GIF, "/gifs/rest.gif", 0)                                         \
+   X(SCAN, GIF, "/gifs/scan.gif", 0)                                         \
+   X(SHOCK, GIF, "/gifs/shock.gif", EMOTE_FLAG_ORIENTATION)                  \
+   X(SLEEP01, GIF, "/gifs/sleep_01.gif", 0)                                  \
+   X(SLEEP02, GIF, "/gifs/sleep_02.gif", 0)                                  \
+   X(SLEEP03, GIF, "/gifs/sleep_03.gif", 0)                                  \
+   X(STARTUP, GIF, "/gifs/startup.gif", 0)                                   \
+   X(TALK, GIF, "/gifs/talk.gif", 0)                                         \
+   X(TAP, GIF, "/gifs/tap.gif", 0)                                           \
+   X(WINK, GIF, "/gifs/wink.gif", 0)                                         \
+   X(ZONED, GIF, "/gifs/zoned.gif", 0)                                       \
+   X(PIXEL, GIF, "/gifs/pixelated.gif", 0)                                   \
+   X(GLEE, GIF, "/gifs/glee.gif", 0)                                         \
+   X(BLINK, GIF, "/gifs/blink.gif", 0)                                       \
+   X(EXCITED, GIF, "/gifs/excited.gif", 0)                                   \
+   X(UWU, GIF, "/gifs/uwu.gif", 0)                                           \
+   X(HEARTS, GIF, "/gifs/hearts.gif", 0)                                     \
+   X(STARTLED, GIF, "/gifs/startled.gif", 0)                                 \
+   /* Special emotes for BYTE-90 only */                                     \
+   X(WHISTLE, GIF, "/gifs/whistle.gif", 0)                                   \
+   X(MISCHIEF, GIF, "/gifs/mischief.gif", 0)                                 \
+   X(HUMSUP, GIF, "/gifs/humsup.gif", 0)                                     \
+   X(WINK_02, GIF, "/gifs/wink_02.gif", 0)                                   \
+   /* Procedural eye emotes */                                               \
+   X(EYES_IDLE, EYES, "/eyes/idle", EMOTE_FLAG_PROCEDURAL)                   \
+   X(EYES_BLINK, EYES, "/eyes/blink", EMOTE_FLAG_PROCEDURAL)                 \
+   X(EYES_WINK, EYES, "/eyes/wink", EMOTE_FLAG_PROCEDURAL)                   \
+   X(EYES_LOOK_LEFT_RIGHT, EYES, "/eyes/look_left_right",                    \
+     EMOTE_FLAG_PROCEDURAL)                                                  \
+   X(EYES_LOOK_UP, EYES, "/eyes/look_up", EMOTE_FLAG_PROCEDURAL)             \
+   X(EYES_LOOK_DOWN, EYES, "/eyes/look_down", EMOTE_FLAG_PROCEDURAL)         \
+   X(EYES_HAPPY, EYES, "/eyes/happy", EMOTE_FLAG_PROCEDURAL)                 \
+   /* Special emotes for ESPNOW communication mode */                        \
+   X(COMS_AGREED, GIF, "/gifs/coms_agreed.gif", EMOTE_FLAG_COMMS)            \
+   X(COMS_CONNECT, GIF, "/gifs/coms_connect.gif", EMOTE_FLAG_COMMS)          \
+   X(COMS_DISCONNECT, GIF, "/gifs/coms_disconnect.gif", EMOTE_FLAG_COMMS)    \
+   X(COMS_DISAGREE, GIF, "/gifs/coms_disagree.gif", EMOTE_FLAG_COMMS)        \
+   X(COMS_HELLO, GIF, "/gifs/coms_hello.gif", EMOTE_FLAG_COMMS)              \
+   X(COMS_LAUGH, GIF, "/gifs/coms_laugh.gif", EMOTE_FLAG_COMMS)              \
+   X(COMS_SHOCK, GIF, "/gifs/coms_shock.gif", EMOTE_FLAG_COMMS)              \
+   X(COMS_TALK_01, GIF, "/gifs/coms_talk_01.gif", EMOTE_FLAG_COMMS)          \
+   X(COMS_TALK_02, GIF, "/gifs/coms_talk_02.gif", EMOTE_FLAG_COMMS)          \
+   X(COMS_TALK_03, GIF, "/gifs/coms_talk_03.gif", EMOTE_FLAG_COMMS)          \
+   X(COMS_WINK, GIF, "/gifs/coms_wink.gif", EMOTE_FLAG_COMMS)                \
+   X(COMS_YELL, GIF, "/gifs/coms_yell.gif", EMOTE_FLAG_COMMS)                \
+   X(COMS_ZONED, GIF, "/gifs/coms_zoned.gif", EMOTE_FLAG_COMMS)              \
+   X(COMS_IDLE, GIF, "/gifs/coms_idle.gif", EMOTE_FLAG_COMMS)
+ 
+ /**
+  * @brief How an emote is rendered
+  */
+ enum class EmoteKind : uint8_t {
+   GIF,    /**< Decoded by gif_module */
+   EYES,   /**< Drawn by eyes_module */
+   VECTOR, /**< Rasterized by vector_module */
+   SCENE   /**< Composited by compositor_module */
+ };
+ 
+ /**
+  * @brief Integer handle of an emote
+  *
+  * Built-in emotes come first, handles from registerEmotePath() follow.
+  */
+ enum class EmoteId : uint8_t {
+ #define EMOTE_ID(id, kind, path, flags) id,
+   EMOTE_TABLE(EMOTE_ID)
+ #undef EMOTE_ID
+   BUILTIN_COUNT, /**< Number of built-in emotes */
+   NONE = 0xFF    /**< No emote */
+ };
+ 
+ /**
+  * @brief Registry entry of an emote
+  */
+ struct EmoteInfo {
+   const char *path; /**< LittleFS path, or eye behavior name for EYES */
+   EmoteKind kind;   /**< Renderer */
+   uint8_t flags;    /**< EMOTE_FLAG_* bits */
+ };
+ 
+ /** @brief Built-in registry, indexed by EmoteId */
+ static constexpr EmoteInfo BUILTIN_EMOTES[] = {
+ #define EMOTE_INFO(id, kind, path, flags) {path, EmoteKind::kind, flags},
+     EMOTE_TABLE(EMOTE_INFO)
+ #undef EMOTE_INFO
+ };
+ 
+ static_assert(sizeof(BUILTIN_EMOTES) / sizeof(BUILTIN_EMOTES[0]) ==
+                   static_cast<size_t>(EmoteId::BUILTIN_COUNT),
+               "Emote registry out of sync");
+ static_assert(static_cast<size_t>(EmoteId::BUILTIN_COUNT) +
+                       EMOTE_RUNTIME_MAX_COUNT <
+                   static_cast<size_t>(EmoteId::NONE),
+               "Too many emotes for an 8-bit handle");
+ 
+ /**
+  * @brief Path of a built-in emote, usable in constant expressions
+  *
+  * @param id Built-in emote
+  * @return Emote path
   */
- #define ANGRY_EMOTE "/gifs/angry.gif"
- #define CRASH01_EMOTE "/gifs/crash_01.gif"
- #define CRASH02_EMOTE "/gifs/crash_02.gif"
- #define CRASH03_EMOTE "/gifs/crash_03.gif"
- #define CRY_EMOTE "/gifs/cry.gif"
- #define DIZZY_EMOTE "/gifs/dizzy.gif"
- #define DOUBTFUL_EMOTE "/gifs/doubtful.gif"
- #define IDLE_EMOTE "/gifs/idle.gif"
- #define LOOK_DOWN_EMOTE "/gifs/look_down.gif"
- #define LOOK_LEFT_RIGHT_EMOTE "/gifs/look_left_right.gif"
- #define LOOK_UP_EMOTE "/gifs/look_up.gif"
- #define REST_EMOTE "/gifs/rest.gif"
- #define SCAN_EMOTE "/gifs/scan.gif"
- #define SHOCK_EMOTE "/gifs/shock.gif"
- #define SLEEP01_EMOTE "/gifs/sleep_01.gif"
- #define SLEEP02_EMOTE "/gifs/sleep_02.gif"
- #define SLEEP03_EMOTE "/gifs/sleep_03.gif"
- #define STARTUP_EMOTE "/gifs/startup.gif"
- #define TALK_EMOTE "/gifs/talk.gif"
- #define TAP_EMOTE "/gifs/tap.gif"
- #define WINK_EMOTE "/gifs/wink.gif"
- #define ZONED_EMOTE "/gifs/zoned.gif"
- #define PIXEL_EMOTE "/gifs/pixelated.gif"
- #define GLEE_EMOTE "/gifs/glee.gif"
- #define BLINK_EMOTE "/gifs/blink.gif"
- #define EXCITED_EMOTE "/gifs/excited.gif"
- #define UWU_EMOTE "/gifs/uwu.gif"
- #define HEARTS_EMOTE "/gifs/hearts.gif"
- #define STARTLED_EMOTE "/gifs/startled.gif"
- 
- //------------------------------------------------------------------------------
- // BYTE-90 Specific Emotes
- //------------------------------------------------------------------------------
- /** @brief Special Emotes for BYTE-90 only */
- #define WHISTLE_EMOTE "/gifs/whistle.gif"
- #define MISCHIEF_EMOTE "/gifs/mischief.gif"
- #define HUMSUP_EMOTE "/gifs/humsup.gif"
- #define WINK_02_EMOTE "/gifs/wink_02.gif"
- 
- //------------------------------------------------------------------------------
- // ESPNOW Communication Emotes
- //------------------------------------------------------------------------------
- /** @brief Special Emotes for ESPNOW communication mode */
- #define COMS_AGREED_EMOTE "/gifs/coms_agreed.gif"
- #define COMS_CONNECT_EMOTE "/gifs/coms_connect.gif"
- #define COMS_DISCONNECT_EMOTE "/gifs/coms_disconnect.gif"
- #define COMS_DISAGREE_EMOTE "/gifs/coms_disagree.gif"
- #define COMS_HELLO_EMOTE "/gifs/coms_hello.gif"
- #define COMS_LAUGH_EMOTE "/gifs/coms_laugh.gif"
- #define COMS_SHOCK_EMOTE "/gifs/coms_shock.gif"
- #define COMS_TALK_01_EMOTE "/gifs/coms_talk_01.gif"
- #define COMS_TALK_02_EMOTE "/gifs/coms_talk_02.gif"
- #define COMS_TALK_03_EMOTE "/gifs/coms_talk_03.gif"
- #define COMS_WINK_EMOTE "/gifs/coms_wink.gif"
- #define COMS_YELL_EMOTE "/gifs/coms_yell.gif"
- #define COMS_ZONED_EMOTE "/gifs/coms_zoned.gif"
- #define COMS_IDLE_EMOTE "/gifs/coms_idle.gif"
+ constexpr const char *builtinEmotePath(EmoteId id) {
+   return BUILTIN_EMOTES[static_cast<uint8_t>(id)].path;
+ }
  
  //==============================================================================
  // STATIC IMAGES AND EXTERNAL DECLARATIONS
@@ -107,4 +183,50 @@
   /** @brief Startup static image */
  extern const uint16_t STARTUP_STATIC[];
  
+ //==============================================================================
+ // PUBLIC API FUNCTIONS
+ //==============================================================================
+ 
+ /**
+  * @brief Get the handle for an emote path, registering it if needed
+  *
+  * Built-in paths resolve to their built-in handle. Other paths get a
+  * runtime handle whose renderer is decided once here, so playback never
+  * compares strings.
+  *
+  * @param path Emote path, must outlive the handle
+  * @return Emote handle, or EmoteId::NONE if the runtime table is full
+  */
+ EmoteId registerEmotePath(const char *path);
+ 
+ /**
+  * @brief Forget every emote added by registerEmotePath()
+  */
+ void clearRuntimeEmotes(void);
+ 
+ /**
+  * @brief Path of an emote
+  *
+  * @param id Emote handle
+  * @return Emote path, or nullptr for an unknown handle
+  */
+ const char *emotePath(EmoteId id);
+ 
+ /**
+  * @brief Renderer of an emote
+  *
+  * @param id Emote handle
+  * @return Emote kind, GIF for an unknown handle
+  */
+ EmoteKind emoteKind(EmoteId id);
+ 
+ /**
+  * @brief Check an emote flag
+  *
+  * @param id Emote handle
+  * @param flag EMOTE_FLAG_* bit
+  * @return true if the emote has the flag
+  */
+ bool emoteHasFlag(EmoteId id, uint8_t flag);
+ 
  #endif /* EMOTES_MODULE_H */
\ No newline at end of file
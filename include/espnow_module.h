@@ -5,14 +5,29 @@
  * This module provides functions and types for device-to-device communication
  * using ESP-NOW, including device discovery, pairing, message exchange, and 
  * state management.
+ *
+ * Up to ESPNOW_MAX_PEERS bots are kept in a fixed-capacity peer table. The
+ * bot that is initiator towards every peer coordinates the group: it hands
+ * out speaking turns round-robin, and questions ask one listener for a
+ * targeted reply.
+ *
+ * Pairing is a three-way handshake: a bot that hears an unknown bot's
+ * discovery broadcast sends PAIR_REQUEST, the other side reserves a slot and
+ * answers PAIR_ACCEPT, and a reliable PAIR_CONFIRM puts both in each other's
+ * peer table. Unpaired bots broadcast with randomized exponential backoff so
+ * a roomful of bots powered on together doesn't keep colliding.
+ *
+ * Every bot syncs its clock to the peer with the largest MAC address from
+ * NTP-style round trips. Conversation messages carry a start time on that
+ * shared clock so all bots play the emote together.
  */
 
  #ifndef ESPNOW_MODULE_H
  #define ESPNOW_MODULE_H
  
  #include "common.h"
- #include <esp_now.h>
- #include <WiFi.h>
+ #include "emotes_module.h"
+ #include "transport_module.h"
  
  //==============================================================================
  // FORWARD DECLARATIONS
@@ -28,8 +43,95 @@
  /** @brief Log tag for ESP-NOW module messages */
  static const char* ESPNOW_LOG = "::ESPNOW_MODULE::";
  
- /** @brief Byte90 unique application signature for ESP-NOW messages */
- #define APP_SIGNATURE 0xCAFE2025
+ /** @brief Byte90 frame marker, first two bytes of every ESP-NOW frame */
+ #define ESPNOW_FRAME_MAGIC 0xB590
+ /** @brief Frame format version, frames of other versions are dropped */
+ #define ESPNOW_PROTOCOL_VERSION 1
+ /** @brief Largest frame the transport can carry (bytes) */
+ #define ESPNOW_MAX_FRAME_SIZE TRANSPORT_MAX_FRAME_SIZE
+ /** @brief Largest TLV record payload (bytes) */
+ #define ESPNOW_MAX_RECORD_PAYLOAD 32
+ 
+ //------------------------------------------------------------------------------
+ // Frame Flags
+ //------------------------------------------------------------------------------
+ #define FRAME_FLAG_RELIABLE 0x01 // Receiver acks the frame, duplicates dropped
+ 
+ //------------------------------------------------------------------------------
+ // Conversation Flags
+ //------------------------------------------------------------------------------
+ #define CONVERSATION_FLAG_REPLY 0x01 // Addressed listener answers the speaker
+ 
+ //------------------------------------------------------------------------------
+ // Delivery
+ //------------------------------------------------------------------------------
+ // Acks go out from the receiver's communication pass, which during playback
+ // runs between frames, so the wait covers a slow GIF frame and the next
+ // emote's load as well as the air time
+ #define ESPNOW_ACK_TIMEOUT_MS 400       // Wait before retransmitting (ms)
+ #define ESPNOW_MAX_RETRIES 3            // Retransmissions before giving up
+ #define ESPNOW_SEQ_WINDOW 64            // Older sequence numbers are duplicates
+ #define ESPNOW_STATS_LOG_INTERVAL 60000 // Between statistics log lines (ms)
+ #define ESPNOW_RX_QUEUE_SIZE 16         // Received frames awaiting the main loop
+ #define ESPNOW_PASS_BUDGET_US 1000      // Longer handleCommunication() passes are slow
+ 
+ //------------------------------------------------------------------------------
+ // Peer Table
+ //------------------------------------------------------------------------------
+ #define ESPNOW_MAX_PEERS 6              // Bots a device talks to at once
+ #define ESPNOW_PEER_SLOTS 16            // MAC hash slots, power of two
+ #define ESPNOW_PEER_TIMEOUT_MS 30000    // Silence before a peer is dropped (ms)
+ #define ESPNOW_PRESENCE_INTERVAL 10000  // Discovery broadcasts while paired (ms)
+ #define ESPNOW_REPLY_DELAY_MS 1500      // Listener waits before replying (ms)
+ #define ESPNOW_TURN_JITTER_MIN_MS 100   // Conversation turns drawn from
+ #define ESPNOW_TURN_JITTER_MAX_MS 500   // ...this much after the interval (ms)
+
+ //------------------------------------------------------------------------------
+ // Discovery
+ //------------------------------------------------------------------------------
+ #define ESPNOW_DISCOVERY_MAX_MS 16000     // Backoff cap between broadcasts (ms)
+ #define ESPNOW_REQUEST_JITTER_MS 200      // Spread of answers to a broadcast (ms)
+ #define ESPNOW_HANDSHAKE_TIMEOUT_MS 150   // First wait for a handshake reply (ms)
+ #define ESPNOW_HANDSHAKE_RETRIES 3        // Requests before a handshake fails
+ #define ESPNOW_MAX_HANDSHAKES 4           // Handshakes in progress at once
+
+ //------------------------------------------------------------------------------
+ // Discovery Duty Cycle
+ //------------------------------------------------------------------------------
+ // Left unpaired, the radio only wakes for a window at the start of each
+ // period and broadcasts there. One period in ESPNOW_DUTY_LISTEN_EVERY it
+ // stays awake throughout and hears every other bot's window, which bounds
+ // time-to-pair at ESPNOW_DUTY_LISTEN_EVERY periods.
+ #define ESPNOW_DUTY_START_MS 30000        // Unpaired this long before sleeping (ms)
+ #define ESPNOW_DUTY_PERIOD_MS 2000        // Window to window (ms)
+ #define ESPNOW_DUTY_WINDOW_MS 200         // Radio awake at the start of a period (ms)
+ #define ESPNOW_DUTY_LISTEN_EVERY 8        // Periods per fully awake period
+ #define ESPNOW_DUTY_GUARD_MS 20           // Answers closer to a window end wait (ms)
+ // Longest a window stays open, a fully awake period runs into the next window
+ #define ESPNOW_DUTY_AWAKE_MS (ESPNOW_DUTY_PERIOD_MS + ESPNOW_DUTY_WINDOW_MS)
+ 
+ //------------------------------------------------------------------------------
+ // Clock Sync
+ //------------------------------------------------------------------------------
+ #define ESPNOW_CLOCK_SYNC_FAST_MS 2000       // Between requests until synced (ms)
+ #define ESPNOW_CLOCK_SYNC_INTERVAL_MS 10000  // Between requests once synced (ms)
+ #define ESPNOW_CLOCK_SAMPLES 8               // Round trips in the min-delay filter
+ #define ESPNOW_CLOCK_MIN_SAMPLES 4           // Round trips before the clock is used
+ #define ESPNOW_CLOCK_MAX_DELAY_US 20000      // Slower round trips are discarded
+ #define ESPNOW_CLOCK_DRIFT_SPAN_US 60000000  // Shortest span for a drift estimate
+ #define ESPNOW_CLOCK_MAX_DRIFT 0.0005f       // Drift clamp (500 ppm)
+ #define ESPNOW_PLAYBACK_LEAD_US 400000       // Start time ahead of the speaker (us)
+ 
+ static_assert((ESPNOW_PEER_SLOTS & (ESPNOW_PEER_SLOTS - 1)) == 0 &&
+                   ESPNOW_PEER_SLOTS > ESPNOW_MAX_PEERS,
+               "Peer slots must be a power of two above the peer count");
+ 
+ //------------------------------------------------------------------------------
+ // Airtime Estimate
+ //------------------------------------------------------------------------------
+ #define ESPNOW_PHY_OVERHEAD_US 192     // Long preamble and PLCP header (us)
+ #define ESPNOW_MAC_OVERHEAD_BYTES 43   // MAC header, vendor action header, FCS
+ #define ESPNOW_US_PER_BYTE 8           // 1 Mbps default ESP-NOW rate
  
  //==============================================================================
  // TYPE DEFINITIONS
@@ -46,7 +148,7 @@
  /**
   * @brief Role of the device in a paired connection
   * 
-  * Devices with larger MAC addresses are auto assigned as initiators
+  * Decided per peer, the device with the larger MAC address is the initiator
   */
  enum class DeviceRole {
      UNKNOWN,    /**< Role not yet determined */
@@ -68,7 +170,7 @@
   */
  enum class ComStatus {
      DISCOVERY,  /**< Searching for devices */
-     PAIRED      /**< Paired with another device */
+     PAIRED      /**< Paired with at least one other device */
  };
  
  /**
@@ -85,27 +187,116 @@
      LAUGH,      /**< Laughing animation */
      WINK,       /**< Winking animation */
      ZONE,       /**< Zoned out animation */
-     SHOCK       /**< Shocked animation */
+     SHOCK,      /**< Shocked animation */
+     CONVERSATION_TYPE_COUNT
+ };
+ 
+ /**
+  * @brief Types of TLV records carried in a frame
+  *
+  * Receivers skip record types they don't know, so new types can be added
+  * without a version bump.
+  */
+ enum class FrameRecordType : uint8_t {
+     DISCOVERY = 1,    /**< Looking for peers, uint16_t ms the sender stays
+                            awake when it duty cycles, at most
+                            ESPNOW_DUTY_AWAKE_MS, no payload if not */
+     CONVERSATION = 2, /**< uint8_t ConversationType, optional uint8_t
+                            CONVERSATION_FLAG_* bits and uint32_t start on
+                            the shared clock (us) */
+     ACK = 3,          /**< uint16_t sequence number being acknowledged */
+     TURN = 4,         /**< uint8_t ConversationType the receiver says to
+                            the group */
+     TIME_REQUEST = 5, /**< uint32_t requester send time (us) */
+     TIME_RESPONSE = 6, /**< uint32_t request send time, then receive and send
+                            time on the responder's shared clock (us) */
+     PAIR_REQUEST = 7, /**< Unicast, asks an unknown bot to pair */
+     PAIR_ACCEPT = 8,  /**< Unicast, a slot is reserved for the requester */
+     PAIR_CONFIRM = 9  /**< Reliable, both sides now hold each other */
+ };
+ 
+ /**
+  * @brief Header of every ESP-NOW frame (little endian)
+  *
+  * The sender MAC is not repeated, ESP-NOW reports it with every frame.
+  */
+ struct __attribute__((packed)) FrameHeader {
+     uint16_t magic;       /**< ESPNOW_FRAME_MAGIC */
+     uint8_t version;      /**< ESPNOW_PROTOCOL_VERSION */
+     uint8_t flags;        /**< FRAME_FLAG_* bits */
+     uint16_t sequence;    /**< Sender's frame counter */
+     uint8_t recordCount;  /**< Number of records that follow */
  };
  
  /**
-  * @brief Configuration mapping conversation types to animation paths
+  * @brief Header of a record, followed by length payload bytes
   */
- struct ConversationConfig {
-     ConversationType type;  /**< Type of conversation */
-     const char* gifPath;    /**< Path to associated GIF animation */
+ struct __attribute__((packed)) FrameRecordHeader {
+     uint8_t type;         /**< FrameRecordType */
+     uint8_t length;       /**< Payload length */
  };
  
  /**
-  * @brief Message structure for ESP-NOW communication
+  * @brief Snapshot of one entry of the peer table
   */
- struct Message {
-     uint32_t signature;         /**< Application signature for validation */
-     uint8_t mac[6];             /**< MAC address of sender */
-     char text[32];              /**< Message text content */
-     ConversationType type;      /**< Conversation type for animation */
+ struct PeerStatus {
+     uint8_t mac[6];            /**< Peer MAC address */
+     DeviceRole role;           /**< This device's role towards the peer */
+     unsigned long lastSeenAge; /**< Time since the peer was last heard (ms) */
+     uint8_t linkQuality;       /**< Ack success average, 0 (none) to 255 */
  };
  
+ /**
+  * @brief Shared clock estimate and achieved playback skew
+  */
+ struct ClockSyncStatus {
+     bool reference;            /**< This device's clock is the shared clock */
+     bool synced;               /**< Shared clock estimate is usable */
+     int32_t offsetUs;          /**< Shared minus local clock (us) */
+     float driftPpm;            /**< Rate of the shared clock against ours */
+     uint32_t delayUs;          /**< Round trip of the sample in use (us) */
+     uint32_t syncedStarts;     /**< Emotes started against a shared time */
+     uint32_t meanStartErrorUs; /**< Mean first pixel distance from it (us) */
+     uint32_t maxStartErrorUs;  /**< Worst first pixel distance from it (us) */
+ };
+ 
+ /**
+  * @brief ESP-NOW delivery and airtime statistics
+  */
+ struct EspNowStats {
+     uint32_t framesSent;       /**< Frames handed to ESP-NOW, incl. retries */
+     uint32_t framesReceived;   /**< Valid frames received */
+     uint32_t recordsSent;      /**< Records sent, batching packs several */
+     uint32_t retransmissions;  /**< Reliable frames sent again */
+     uint32_t delivered;        /**< Reliable frames acknowledged */
+     uint32_t undelivered;      /**< Reliable frames given up on */
+     uint32_t duplicates;       /**< Received frames dropped as duplicates */
+     uint32_t malformed;        /**< Received frames failing validation */
+     uint32_t rxOverflows;      /**< Received frames dropped on a full queue */
+     uint32_t linkFailures;     /**< Frames the radio reported as failed */
+     uint32_t airtimeMicros;    /**< Estimated time on air of sent frames */
+     uint32_t totalAckMillis;   /**< Sum of first send to ack times */
+     uint32_t passes;           /**< handleCommunication() passes while on */
+     uint32_t slowPasses;       /**< Passes over ESPNOW_PASS_BUDGET_US */
+     uint32_t maxPassMicros;    /**< Longest pass */
+     uint32_t totalPassMicros;  /**< Sum of pass durations */
+ };
+ 
+ /**
+  * @brief Discovery and pairing counters
+  */
+ struct DiscoveryStats {
+     uint32_t broadcasts;          /**< Discovery broadcasts while unpaired */
+     uint32_t handshakesStarted;   /**< Pair requests and accepts begun */
+     uint32_t handshakesCompleted; /**< Handshakes ending in a pairing */
+     uint32_t handshakesFailed;    /**< Handshakes that timed out */
+     uint32_t pairings;            /**< Times discovery ended in a pairing */
+     uint32_t lastTimeToPairMs;    /**< Discovery start to first peer, last time */
+     uint32_t totalTimeToPairMs;   /**< Sum over all pairings */
+     uint32_t radioAwakeMs;        /**< Duty-cycled discovery, radio on */
+     uint32_t radioAsleepMs;       /**< Duty-cycled discovery, radio off */
+ };
+
  /**
   * @brief Timing constants for communication operations
   */
@@ -114,7 +305,8 @@
      static const unsigned long STATUS_INTERVAL = 6000;
      /** @brief Interval between messages (ms) */
      static const unsigned long MESSAGE_INTERVAL = 4000;
-     /** @brief Interval between discovery broadcasts (ms) */
+     /** @brief First interval between discovery broadcasts, doubles up to
+      *  ESPNOW_DISCOVERY_MAX_MS while nobody answers (ms) */
      static const unsigned long DISCOVERY_INTERVAL = 1000;
      /** @brief Debounce time for ESP-NOW toggle (ms) */
      static const unsigned long TOGGLE_DEBOUNCE = 5000;
@@ -124,6 +316,16 @@
  // PUBLIC API FUNCTIONS
  //==============================================================================
  
+ /**
+  * @brief Select the link the protocol runs on
+  *
+  * Defaults to espNowRadioTransport(). Only call while ESP-NOW is off, a
+  * host harness uses it to run the protocol over a LoopbackBus.
+  *
+  * @param link Transport used by initializeESPNOW() and everything after
+  */
+ void setEspNowTransport(EspNowTransport *link);
+
  /**
   * @brief Initialize ESP-NOW communication
   * @return true if initialization successful
@@ -161,6 +363,9 @@
  
  /**
   * @brief Main communication handling function
+  *
+  * Never waits: retries, replies, conversation turns and reconnects are
+  * deadlines checked on each pass. Pass durations are kept in EspNowStats.
   */
  void handleCommunication();
  
@@ -170,15 +375,15 @@
  void forceDisconnect();
  
  /**
-  * @brief Reset the animation path and communication state
+  * @brief Reset the current animation and communication state
   */
- void resetAnimationPath();
+ void resetCurrentAnimation();
  
  /**
-  * @brief Get the currently active animation path
-  * @return Current animation path or nullptr if none
+  * @brief Get the emote of the current conversation message
+  * @return Current emote or EmoteId::NONE if none
   */
- const char* getCurrentAnimationPath();
+ EmoteId getCurrentAnimation();
  
  /**
   * @brief Get current ESP-NOW state
@@ -203,4 +408,89 @@
   */
  void resetEspNowToggleState();
  
+ /**
+  * @brief Get the number of paired peers
+  * @return Peers in the peer table
+  */
+ uint8_t getPeerCount();
+ 
+ /**
+  * @brief Get a snapshot of a paired peer
+  * @param index Peer index, 0 to getPeerCount() - 1
+  * @param status Receives the peer snapshot
+  * @return true if the index names a peer
+  */
+ bool getPeerStatus(uint8_t index, PeerStatus &status);
+ 
+ /**
+  * @brief Current time on the clock shared by the group
+  * @return Shared clock (us), this device's micros() if unsynced
+  */
+ uint32_t sharedClockMicros();
+ 
+ /**
+  * @brief Take the scheduled start of the current conversation emote
+  *
+  * The start is handed out once, replays of the same message are not
+  * scheduled.
+  *
+  * @param startMicros Receives the start as a local micros() time
+  * @return true if the emote has a scheduled start
+  */
+ bool takeScheduledStart(uint32_t &startMicros);
+ 
+ /**
+  * @brief Record how far from its scheduled start an emote began
+  * @param errorUs First pixel time minus scheduled start (us)
+  */
+ void recordSyncedStart(int32_t errorUs);
+ 
+ /**
+  * @brief Get the shared clock estimate and achieved skew
+  * @return Clock sync snapshot
+  */
+ ClockSyncStatus getClockSyncStatus();
+ 
+ /**
+  * @brief Get discovery and time-to-pair counters
+  * @return Copy of the counters since boot
+  */
+ DiscoveryStats getDiscoveryStats();
+
+ /**
+  * @brief Check if received frames are waiting for handleCommunication()
+  * @return true if the receive queue is not empty
+  */
+ bool commsFramesPending();
+
+ /**
+  * @brief Check whether a device is in the peer table
+  * @param mac Device address
+  * @return true if the device is a paired peer
+  */
+ bool isKnownPeer(const uint8_t *mac);
+
+ /**
+  * @brief Send a frame of another protocol over the ESP-NOW link
+  *
+  * Used by transfer_module, counted in the airtime statistics.
+  *
+  * @param mac Paired peer or broadcast address
+  * @param data Frame bytes
+  * @param length Frame length
+  * @return true if the transport accepted the frame
+  */
+ bool sendEspNowFrame(const uint8_t *mac, const uint8_t *data, size_t length);
+ 
+ /**
+  * @brief Get ESP-NOW delivery and airtime statistics
+  * @return Copy of the statistics since boot or the last reset
+  */
+ EspNowStats getEspNowStats();
+ 
+ /**
+  * @brief Clear ESP-NOW statistics
+  */
+ void resetEspNowStats();
+ 
  #endif /* ESPNOW_MODULE_H */
\ No newline at end of file
@@ -0,0 +1,136 @@
+/**
+ * @file eyes_module.h
+ * @brief Header for the procedural parametric eye renderer
+ *
+ * Draws the idle eyes (blink, wink, looking around) from a handful of
+ * parameters instead of decoding GIFs. Each eye is an ellipse, rounded
+ * rectangle or happy arc with a pupil, filled one scanline at a time with
+ * fixed-point math. Between scripted moves the gaze follows the tilt state
+ * from tilt_module. Only the rows around each eye are redrawn per frame.
+ *
+ * Procedural eyes are played like any other emote through paths that start
+ * with EYES_PATH_PREFIX, e.g. "/eyes/blink".
+ */
+
+#ifndef EYES_MODULE_H
+#define EYES_MODULE_H
+
+#include "common.h"
+
+//==============================================================================
+// CONSTANTS & DEFINITIONS
+//==============================================================================
+
+/** @brief Log tag for Eyes module messages */
+static const char *EYES_LOG = "::EYES_MODULE::";
+
+/** @brief Path prefix identifying procedural eye emotes */
+#define EYES_PATH_PREFIX "/eyes/"
+
+/** @brief Microseconds between frames for 40FPS playback */
+#define EYES_FRAME_DELAY_MICROSECONDS (1000000 / 40)
+
+/** @brief Fractional bits of eye coordinates */
+#define EYE_FIXED_SHIFT 8
+/** @brief Convert whole pixels to eye fixed point */
+#define EYE_FIXED(px) ((int32_t)(px) << EYE_FIXED_SHIFT)
+/** @brief Fully open eye */
+#define EYE_OPEN EYE_FIXED(1)
+
+//------------------------------------------------------------------------------
+// Appearance
+//------------------------------------------------------------------------------
+#define EYE_COLOR 0xFFFF        // Eye fill color
+#define EYE_PUPIL_COLOR 0x0000  // Pupil color
+#define EYE_BACKGROUND 0x0000   // Face color behind the eyes
+#define EYE_LEFT_X 40           // Left eye center (px)
+#define EYE_RIGHT_X 88          // Right eye center (px)
+#define EYE_CENTER_Y 64         // Eye center row (px)
+#define EYE_RADIUS_X 16         // Eye half width (px)
+#define EYE_RADIUS_Y 22         // Eye half height (px)
+#define EYE_PUPIL_RADIUS 7      // Pupil radius (px)
+#define EYE_GAZE_RANGE_X 8      // Furthest horizontal pupil offset (px)
+#define EYE_GAZE_RANGE_Y 12     // Furthest vertical pupil offset (px)
+#define EYE_PARALLAX_RANGE 3    // Furthest slosh of the whole eye (px)
+
+//==============================================================================
+// TYPE DEFINITIONS
+//==============================================================================
+
+/**
+ * @brief Outline of an eye
+ */
+enum class EyeShape : uint8_t {
+  ROUND,  /**< Ellipse */
+  SQUARE, /**< Rounded rectangle */
+  HAPPY   /**< Upper arc, no pupil */
+};
+
+/**
+ * @brief Scripted eye behaviors
+ */
+enum class EyeBehavior : uint8_t {
+  IDLE,            /**< Follow the tilt with occasional blinks */
+  BLINK,           /**< Hold, then blink once */
+  WINK,            /**< Close the right eye */
+  LOOK_LEFT_RIGHT, /**< Glance left, then right */
+  LOOK_UP,         /**< Glance up */
+  LOOK_DOWN,       /**< Glance down */
+  HAPPY,           /**< Happy arcs */
+  EYE_BEHAVIOR_COUNT
+};
+
+/**
+ * @brief Parameters of one eye, coordinates in EYE_FIXED units
+ */
+struct EyeParams {
+  int32_t centerX;     /**< Eye center column */
+  int32_t centerY;     /**< Eye center row */
+  int32_t radiusX;     /**< Half width */
+  int32_t radiusY;     /**< Half height when fully open */
+  int32_t openness;    /**< 0 closed to EYE_OPEN */
+  int32_t pupilX;      /**< Pupil offset from the eye center */
+  int32_t pupilY;      /**< Pupil offset from the eye center */
+  int32_t pupilRadius; /**< Pupil radius */
+  EyeShape shape;      /**< Outline */
+};
+
+//==============================================================================
+// PUBLIC API FUNCTIONS
+//==============================================================================
+
+/**
+ * @brief Check whether a path names a procedural eye emote
+ *
+ * @param path Emote path
+ * @return true if the path starts with EYES_PATH_PREFIX
+ */
+bool isProceduralEyes(const char *path);
+
+/**
+ * @brief Start the eye behavior named by a path
+ *
+ * The next frame redraws the whole screen, later frames only the eyes.
+ *
+ * @param path Emote path, e.g. "/eyes/blink"
+ * @param durationMs Receives the behavior length (ms)
+ * @return true if the behavior exists
+ */
+bool loadEyeBehavior(const char *path, unsigned long *durationMs);
+
+/**
+ * @brief Advance the current behavior and draw the eyes
+ *
+ * @return Number of pixels written this frame
+ */
+uint32_t renderEyesFrame(void);
+
+/**
+ * @brief Current parameters of an eye
+ *
+ * @param right true for the right eye
+ * @return Eye parameters as last drawn
+ */
+EyeParams getEyeParams(bool right);
+
+#endif /* EYES_MODULE_H */
@@ -71,6 +71,14 @@ bool initializeGIFPlayer(void);
  */
 void stopGifPlayback(void);
 
+/**
+ * @brief Close the current GIF but keep the frame buffer allocated
+ *
+ * Used between emotes so the next loadGIF() starts warm instead of
+ * re-allocating the PSRAM frame buffer.
+ */
+void closeGIF(void);
+
 /**
  * @brief Check if the GIF player is initialized
  *
@@ -103,6 +111,16 @@ void checkMemoryStatus(void);
  */
 bool loadGIF(const char *filename);
 
+/**
+ * @brief Open a GIF file ahead of time
+ *
+ * The next loadGIF() for the same path reuses the open handle instead of
+ * looking the file up again. Only one file is kept warm at a time.
+ *
+ * @param filename Path to the GIF file, nullptr to drop the warm handle
+ */
+void prefetchGIF(const char *filename);
+
 /**
  * @brief Play a single frame of the current GIF
  *
@@ -112,4 +130,11 @@ bool loadGIF(const char *filename);
  */
 int playGIFFrame(bool bSync, int *delayMilliseconds);
 
+/**
+ * @brief Time the first scanline of the current GIF reached the display
+ *
+ * @return micros() timestamp, or 0 if nothing was drawn since loadGIF()
+ */
+uint32_t getFirstPixelTime(void);
+
 #endif /* GIF_MODULE_H */
\ No newline at end of file
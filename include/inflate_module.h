@@ -0,0 +1,130 @@
+/**
+ * @file inflate_module.h
+ * @brief Header for streaming decompression of update images
+ *
+ * Serial and HTTP updates may carry a gzip or zlib compressed image. The
+ * compressed bytes are inflated as they arrive with the inflater in ROM and
+ * written straight to Update, so RAM use is the 32 KB history window plus
+ * the decompressor state however large the image is. Both are allocated
+ * when an update starts and freed when it ends.
+ *
+ * Only one image is inflated at a time, like Update itself.
+ */
+
+#ifndef INFLATE_MODULE_H
+#define INFLATE_MODULE_H
+
+#include "common.h"
+
+//==============================================================================
+// CONSTANTS & DEFINITIONS
+//==============================================================================
+
+/** @brief Log tag for Inflate module messages */
+static const char *INFLATE_LOG = "::INFLATE_MODULE::";
+
+/** @brief Encodings accepted, as a JSON array for device info */
+#define INFLATE_ENCODINGS_JSON "[\"gzip\",\"deflate\"]"
+
+/** @brief File name suffix of a gzip compressed image uploaded over HTTP */
+#define INFLATE_GZIP_SUFFIX ".gz"
+
+//==============================================================================
+// TYPE DEFINITIONS
+//==============================================================================
+
+/**
+ * @brief How an update image is encoded on the wire
+ */
+enum class ImageEncoding : uint8_t {
+  NONE,   /**< Raw image bytes */
+  GZIP,   /**< gzip member, CRC32 and size checked at the end */
+  DEFLATE /**< zlib stream, Adler-32 checked at the end */
+};
+
+/**
+ * @brief Called after each block of inflated bytes is written
+ * @param inflated Image bytes written so far
+ */
+typedef void (*InflateProgressHandler)(size_t inflated);
+
+/**
+ * @brief Takes a block of inflated bytes instead of Update
+ * @param data Inflated bytes
+ * @param length Number of bytes
+ * @return false to stop inflating
+ */
+typedef bool (*InflateOutputHandler)(uint8_t *data, size_t length);
+
+//==============================================================================
+// PUBLIC API FUNCTIONS
+//==============================================================================
+
+/**
+ * @brief Look up an encoding by name
+ *
+ * @param name "gzip" or "deflate", an empty name is a raw image
+ * @param encoding Set to the encoding found
+ * @return true if the name is known
+ */
+bool parseImageEncoding(const String &name, ImageEncoding &encoding);
+
+/**
+ * @brief Get the name of an encoding
+ *
+ * @param encoding Encoding
+ * @return "gzip", "deflate" or "none"
+ */
+const char *getImageEncodingName(ImageEncoding encoding);
+
+/**
+ * @brief Start inflating an image into a running Update
+ *
+ * @param encoding GZIP or DEFLATE
+ * @param onProgress Optional handler, lets callers keep their link alive
+ *                   while a long run of output is written to flash
+ * @param onOutput Optional handler that takes the output instead of
+ *                 Update, e.g. a patch to apply
+ * @return true if the buffers could be allocated
+ */
+bool beginInflate(ImageEncoding encoding,
+                  InflateProgressHandler onProgress = nullptr,
+                  InflateOutputHandler onOutput = nullptr);
+
+/**
+ * @brief Inflate the next compressed bytes and pass the output on
+ *
+ * @param data Compressed bytes in stream order
+ * @param length Number of bytes
+ * @return false on corrupt data or a flash write error, see
+ *         getInflateError()
+ */
+bool inflateWrite(const uint8_t *data, size_t length);
+
+/**
+ * @brief Finish inflating and free the buffers
+ *
+ * @return true if the stream ended and its checksum and size matched
+ */
+bool endInflate();
+
+/**
+ * @brief Free the buffers without checking the stream, safe when idle
+ */
+void abortInflate();
+
+/**
+ * @brief Image bytes written to Update since beginInflate()
+ *
+ * @return Inflated byte count
+ */
+size_t getInflatedSize();
+
+/**
+ * @brief Why the last inflateWrite() or endInflate() failed
+ *
+ * @return Error message
+ */
+const char *getInflateError();
+
+#endif /* INFLATE_MODULE_H */
@@ -0,0 +1,167 @@
+/**
+ * @file loopback_transport.h
+ * @brief Header for the in-process transport used on a host
+ *
+ * LoopbackBus connects any number of LoopbackTransport endpoints inside one
+ * process. Frames are held for a configurable latency plus jitter and lost
+ * at a configurable rate, so protocol logic can be tested, fuzzed and
+ * benchmarked on Linux without boards. The bus only moves time forward
+ * when run() is called, which keeps simulations deterministic for a seed.
+ *
+ * Not used by the firmware.
+ */
+
+#ifndef LOOPBACK_TRANSPORT_H
+#define LOOPBACK_TRANSPORT_H
+
+#include "transport_module.h"
+
+//==============================================================================
+// CONSTANTS & DEFINITIONS
+//==============================================================================
+
+/** @brief Endpoints one bus connects */
+#define LOOPBACK_MAX_ENDPOINTS 16
+/** @brief Frames in flight on one bus */
+#define LOOPBACK_QUEUE_SIZE 64
+
+//==============================================================================
+// TYPE DEFINITIONS
+//==============================================================================
+
+class LoopbackTransport;
+
+/**
+ * @brief Behavior of every link on a bus
+ */
+struct LoopbackLinkConfig {
+  uint16_t lossPermille; /**< Frames lost per 1000 sent */
+  uint32_t latencyUs;    /**< Fixed delay of every frame */
+  uint32_t jitterUs;     /**< Extra random delay, frames may reorder */
+};
+
+/**
+ * @brief Traffic counters of a bus
+ */
+struct LoopbackStats {
+  uint32_t sent;      /**< Frame copies put on the bus, one per receiver */
+  uint32_t delivered; /**< Copies handed to a receiver */
+  uint32_t lost;      /**< Copies dropped by the loss model */
+  uint32_t overflows; /**< Copies dropped on a full bus */
+};
+
+/**
+ * @brief Shared medium between loopback endpoints
+ */
+class LoopbackBus {
+public:
+  /**
+   * @brief Create a lossless bus without delay
+   * @param seed Seed of the loss and jitter generator
+   */
+  explicit LoopbackBus(uint32_t seed = 1);
+
+  /**
+   * @brief Change loss and latency for frames sent from now on
+   * @param config Link behavior
+   */
+  void configure(const LoopbackLinkConfig &config);
+
+  /**
+   * @brief Advance bus time and hand out every frame due by then
+   *
+   * Handlers run from inside this call and may send again.
+   *
+   * @param nowUs New bus time (us)
+   */
+  void run(uint32_t nowUs);
+
+  /**
+   * @brief Current bus time
+   * @return Time passed to the last run() (us)
+   */
+  uint32_t now() const { return busTime; }
+
+  /**
+   * @brief Number of frame copies still in flight
+   * @return Queued copies
+   */
+  size_t pending() const { return queuedCount; }
+
+  /**
+   * @brief Traffic counters since creation
+   * @return Copy of the counters
+   */
+  LoopbackStats getStats() const { return stats; }
+
+private:
+  friend class LoopbackTransport;
+
+  /** @brief One frame copy on its way to one receiver */
+  struct QueuedFrame {
+    uint8_t from[6];                        /**< Sender */
+    uint8_t to[6];                          /**< Address the frame was sent to */
+    LoopbackTransport *receiver;            /**< Endpoint receiving this copy */
+    uint32_t deliverAt;                     /**< Bus time of arrival */
+    uint8_t length;                         /**< Frame length */
+    bool lost;                              /**< Dropped by the loss model */
+    bool reportStatus;                      /**< Copy reports the send result */
+    uint8_t data[TRANSPORT_MAX_FRAME_SIZE]; /**< Frame bytes */
+  };
+
+  bool attach(LoopbackTransport *endpoint);
+  void detach(LoopbackTransport *endpoint);
+  bool send(LoopbackTransport &sender, const uint8_t *to, const uint8_t *data,
+            size_t length);
+  bool enqueue(LoopbackTransport &sender, LoopbackTransport *receiver,
+               const uint8_t *to, const uint8_t *data, size_t length,
+               bool reportStatus);
+  uint32_t nextRandom();
+
+  LoopbackTransport *endpoints[LOOPBACK_MAX_ENDPOINTS];
+  QueuedFrame queue[LOOPBACK_QUEUE_SIZE];
+  size_t queuedCount;
+  LoopbackLinkConfig link;
+  LoopbackStats stats;
+  uint32_t busTime;
+  uint32_t randomState;
+};
+
+/**
+ * @brief EspNowTransport endpoint on a LoopbackBus
+ */
+class LoopbackTransport : public EspNowTransport {
+public:
+  /**
+   * @brief Create an endpoint, it joins the bus on begin()
+   * @param bus Bus to join
+   * @param mac Address of the endpoint
+   */
+  LoopbackTransport(LoopbackBus &bus, const uint8_t *mac);
+  ~LoopbackTransport() override;
+
+  bool begin(TransportReceiveHandler onReceive,
+             TransportSendHandler onSend) override;
+  void end() override;
+  bool send(const uint8_t *mac, const uint8_t *data, size_t length) override;
+  bool addPeer(const uint8_t *mac) override;
+  void removePeer(const uint8_t *mac) override;
+  void macAddress(uint8_t *mac) override;
+  bool setAwake(bool awake) override;
+
+private:
+  friend class LoopbackBus;
+
+  int findPeer(const uint8_t *mac) const;
+
+  LoopbackBus &bus;
+  uint8_t address[6];
+  uint8_t peers[LOOPBACK_MAX_ENDPOINTS][6];
+  uint8_t peerCount;
+  TransportReceiveHandler receiveHandler;
+  TransportSendHandler sendHandler;
+  bool up;
+  bool awake;
+};
+
+#endif /* LOOPBACK_TRANSPORT_H */
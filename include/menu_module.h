@@ -114,6 +114,10 @@ static const char* MENU_LOG = "::MENU_MODULE::";
 #define LABEL_ENABLE "ENABLE"
 /** @brief Feature toggle label disable */
 #define LABEL_DISABLE "DISABLE"
+/** @brief Offer this firmware to the paired group */
+#define LABEL_SHARE_FIRMWARE "SHARE FIRMWARE"
+/** @brief Take firmware offered by the paired group for a while */
+#define LABEL_ACCEPT_FIRMWARE "ACCEPT FIRMWARE"
 
 //==============================================================================
 // TYPE DEFINITIONS
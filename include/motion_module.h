@@ -25,22 +25,77 @@
  //==============================================================================
  
  /**
-  * @brief Types of motion states that can be detected and tracked
-  */
- enum class MotionStateType {
-   SHAKING = 0,       /**< Device is being shaken */
-   TAPPED,            /**< Device received a single tap */
-   DOUBLE_TAPPED,     /**< Device received a double tap */
-   SLEEP,             /**< Device is in sleep mode (display dimmed) */
-   DEEP_SLEEP,        /**< Device is in deep sleep mode (power saving) */
-   UPSIDE_DOWN,       /**< Device is flipped upside down */
-   TILTED_LEFT,       /**< Device is tilted to the left */
-   TILTED_RIGHT,      /**< Device is tilted to the right */
+  * @brief Edge-triggered motion events delivered through the event queue
+  */
+ enum class MotionEventType : uint8_t {
+   SHAKING = 0,         /**< Device started being shaken */
+   TAPPED,              /**< Device received a single tap */
+   DOUBLE_TAPPED,       /**< Device received a double tap */
+   SUDDEN_ACCELERATION, /**< Device detected sudden acceleration */
+   // Keep track of the total number of event types
+   MOTION_EVENT_COUNT   /**< Total count of event types (for array sizing) */
+ };
+ 
+ /**
+  * @brief Motion event produced by ADXLDataPolling()
+  */
+ struct MotionEvent {
+   MotionEventType type; /**< Kind of event */
+   uint32_t timestamp;   /**< micros() when the event was detected */
+   float magnitude;      /**< Smoothed dynamic magnitude at detection (m/s²) */
+ };
+ 
+ /**
+  * @brief Level orientation of the device, mutually exclusive
+  */
+ enum class DeviceOrientation : uint8_t {
+   UPRIGHT = 0,       /**< Resting in the normal position */
    HALF_TILTED_LEFT,  /**< Device is tilted to the left at 45 degree */
    HALF_TILTED_RIGHT, /**< Device is tilted to the right at 45 degree */
-   SUDDEN_ACCELERATION, /**< Device detected sudden acceleration */
-   // Keep track of the total number of states
-   MOTION_STATE_COUNT /**< Total count of motion states (for array sizing) */
+   TILTED_LEFT,       /**< Device is tilted to the left */
+   TILTED_RIGHT,      /**< Device is tilted to the right */
+   UPSIDE_DOWN,       /**< Device is flipped upside down */
+ };
+ 
+ /**
+  * @brief Level motion state refreshed on every accelerometer poll
+  */
+ struct MotionSnapshot {
+   DeviceOrientation orientation; /**< Current orientation */
+   bool sleeping;                 /**< Idle timeout reached (display dimmed) */
+   bool deepSleep;                /**< Inactivity timeout reached */
+   float gravityX;                /**< Average X-axis acceleration (m/s²) */
+   float gravityY;                /**< Average Y-axis acceleration (m/s²) */
+   float gravityZ;                /**< Average Z-axis acceleration (m/s²) */
+   uint32_t timestamp;            /**< micros() of the poll that produced it */
+ };
+ 
+ /**
+  * @brief Low-pass filtered gravity, updated on every accelerometer sample
+  *
+  * Tracks the newest samples instead of the per-poll average so renderers
+  * can react to tilt within a frame.
+  */
+ struct GravityVector {
+   float x;             /**< X-axis acceleration (m/s²) */
+   float y;             /**< Y-axis acceleration (m/s²) */
+   float z;             /**< Z-axis acceleration (m/s²) */
+   uint32_t sampleTime; /**< Estimated micros() of the newest sample */
+ };
+ 
+ /**
+  * @brief Accelerometer samples drained from the FIFO in a single poll
+  *
+  * The FIFO is read once per poll and every detector works on this batch,
+  * so each sample goes through the magnitude filter exactly once.
+  */
+ struct MotionSampleBatch {
+   uint8_t count;       /**< Number of samples in the batch */
+   float avgX;          /**< Average X-axis acceleration (m/s²) */
+   float avgY;          /**< Average Y-axis acceleration (m/s²) */
+   float avgZ;          /**< Average Z-axis acceleration (m/s²) */
+   float avgMagnitude;  /**< Average smoothed dynamic magnitude (m/s²) */
+   float lastMagnitude; /**< Smoothed dynamic magnitude of newest sample */
  };
  
  //==============================================================================
@@ -51,37 +106,34 @@
   * @brief Main function to poll accelerometer data and process all motion events
   */
  void ADXLDataPolling(void);
- /**
- * @brief Check if device detected sudden acceleration
- * @return true if sudden acceleration detected, false otherwise
- */
- bool motionSuddenAcceleration();
  /**
   * @brief Detect shaking motion using the accelerometer
   * 
-  * @param samples Number of samples to analyze
+  * @param batch Samples drained from the FIFO for this poll
   */
- void detectShakes(uint8_t samples);
+ void detectShakes(const MotionSampleBatch &batch);
  
  /**
   * @brief Detect tap and double-tap events using the accelerometer
+  * 
+  * @param batch Samples drained from the FIFO for this poll
   */
- void detectTapping(void);
+ void detectTapping(const MotionSampleBatch &batch);
  
  /**
   * @brief Detect device orientation changes
   * 
-  * @param samples Number of samples to analyze
+  * @param batch Samples drained from the FIFO for this poll
   */
- void detectOrientation(uint8_t samples);
+ void detectOrientation(const MotionSampleBatch &batch);
  
  /**
   * @brief Detect lack of movement over time
   * 
-  * @param samples Number of samples to analyze
+  * @param batch Samples drained from the FIFO for this poll
   * @return true if device should enter deep sleep
   */
- bool detectInactivity(uint8_t samples);
+ bool detectInactivity(const MotionSampleBatch &batch);
  
  /**
   * @brief Handle entry into deep sleep mode
@@ -91,45 +143,67 @@
  void handleDeepSleep(void);
  
  //==============================================================================
- // MOTION STATE MANAGEMENT FUNCTIONS
+ // MOTION EVENT QUEUE FUNCTIONS
  //==============================================================================
  
  /**
-  * @brief Set a specific motion state
+  * @brief Remove the oldest pending motion event
+  * 
+  * Events are delivered exactly once and in the order they were detected.
   * 
-  * @param state The motion state to set
-  * @param value The boolean value to set (true/false)
+  * @param event Receives the event
+  * @return true if an event was available, false if the queue is empty
   */
- void setMotionState(MotionStateType state, bool value);
+ bool pollMotionEvent(MotionEvent &event);
  
  /**
-  * @brief Check if a specific motion state is active
+  * @brief Read the oldest pending motion event without consuming it
   * 
-  * @param state The motion state to check
-  * @return true if the state is active, false otherwise
+  * @param event Receives the event
+  * @return true if an event was available, false if the queue is empty
   */
- bool checkMotionState(MotionStateType state);
+ bool peekMotionEvent(MotionEvent &event);
  
  /**
-  * @brief Reset all motion states to inactive
+  * @brief Check whether any motion event is waiting to be consumed
+  * @return true if the queue is not empty
   */
- void resetMotionState();
+ bool hasPendingMotionEvent();
  
- //==============================================================================
- // MOTION STATE ACCESSOR FUNCTIONS
- //==============================================================================
+ /**
+  * @brief Discard all pending motion events
+  */
+ void clearMotionEvents();
+ 
+ /**
+  * @brief Number of motion events dropped because the queue was full
+  * @return Overflow count since boot
+  */
+ uint32_t getDroppedMotionEvents();
  
  /**
-  * @brief Check if device was tapped
-  * @return true if tapped, false otherwise
+  * @brief Get the level motion state from the latest poll
+  * @return Copy of the current snapshot
   */
- bool motionTapped();
+ MotionSnapshot getMotionSnapshot();
  
  /**
-  * @brief Check if device was double-tapped
-  * @return true if double-tapped, false otherwise
+  * @brief Get the per-sample filtered gravity vector
+  * @return Copy of the filtered gravity and its sample time
   */
- bool motionDoubleTapped();
+ GravityVector getFilteredGravity();
+ 
+ /**
+  * @brief Keep the sampling rate high enough for motion-reactive rendering
+  *
+  * Must be called at least every MOTION_TRACKING_HOLD_MS while a renderer
+  * follows gravity, the request lapses on its own afterwards.
+  */
+ void requestMotionTracking();
+ 
+ //==============================================================================
+ // MOTION STATE ACCESSOR FUNCTIONS
+ //==============================================================================
  
  /**
   * @brief Check if device is upside down
@@ -161,12 +235,6 @@ bool motionHalfTiltedLeft();
  */
 bool motionHalfTiltedRight();
  
- /**
-  * @brief Check if device has been interacted with (tapped, double-tapped, or shaking)
-  * @return true if interacted with, false otherwise
-  */
- bool motionInteracted();
- 
  /**
   * @brief Check if device is in a non-standard orientation
   * @return true if tilted left/right or upside down, false otherwise
@@ -185,10 +253,4 @@ bool motionHalfTiltedRight();
   */
  bool motionDeepSleep();
  
- /**
-  * @brief Check if device is being shaken
-  * @return true if being shaken, false otherwise
-  */
- bool motionShaking();
- 
  #endif /* MOTION_MODULE_H */
\ No newline at end of file
@@ -4,6 +4,10 @@
  * 
  * This module provides functions for handling firmware and filesystem updates
  * over WiFi, including status tracking, file uploads, and update application.
+ * Uploads named with a .gz suffix are gzip compressed and inflated as they
+ * arrive. An upload given the SHA-256 of its image (?sha256=) can be resumed
+ * after an interruption: GET /update/session tells how far it got, and the
+ * rest of the image is uploaded with ?sha256=&offset=, see resume_module.h.
  */
 
  #ifndef OTA_MODULE_H
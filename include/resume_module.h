@@ -0,0 +1,135 @@
+/**
+ * @file resume_module.h
+ * @brief Header for resumable update sessions
+ *
+ * Serial and HTTP updates write image bytes through a session. A session
+ * named by the SHA-256 of its image is persisted in NVS: every
+ * RESUME_COMMIT_INTERVAL bytes, and whenever the transfer stops early, the
+ * offset written to flash and the SHA-256 of the image up to it are saved.
+ * A host that lost the connection asks for the session, checks the image
+ * hash against its own and sends only the rest of the image, also after a
+ * reboot. Before continuing the written part of the partition is hashed
+ * again and compared, anything else starts over.
+ *
+ * A new session writes through Update. A resumed one writes the partition
+ * directly, since Update can only start at offset 0, and makes it bootable
+ * itself once the whole image is there and matches its hash.
+ *
+ * Sessions without an image hash are not persisted and behave like a plain
+ * Update. Only one session exists at a time, like Update itself.
+ */
+
+#ifndef RESUME_MODULE_H
+#define RESUME_MODULE_H
+
+#include "common.h"
+
+//==============================================================================
+// CONSTANTS & DEFINITIONS
+//==============================================================================
+
+/** @brief Log tag for Resume module messages */
+static const char *RESUME_LOG = "::RESUME_MODULE::";
+
+/** @brief NVS namespace of the persisted session */
+#define RESUME_NVS_NAMESPACE "update"
+/** @brief Image bytes between offsets persisted during a transfer */
+#define RESUME_COMMIT_INTERVAL (64 * 1024)
+/** @brief Flash sector size, offsets are committed on sector boundaries */
+#define RESUME_SECTOR_SIZE 4096
+/** @brief SHA-256 digest size (bytes) */
+#define RESUME_HASH_SIZE 32
+/** @brief Leading firmware bytes Update holds back until the image is done */
+#define RESUME_HEADER_SIZE 16
+
+//==============================================================================
+// PUBLIC API FUNCTIONS
+//==============================================================================
+
+/**
+ * @brief Start a session for a new image, after Update.begin()
+ *
+ * Replaces any persisted session.
+ *
+ * @param command U_FLASH or U_SPIFFS, as passed to Update.begin()
+ * @param imageHash SHA-256 of the whole image as 64 lowercase hex digits,
+ *                  empty for a session that can't be resumed
+ * @return false if the hash is malformed
+ */
+bool beginUpdateSession(int command, const String &imageHash);
+
+/**
+ * @brief Continue the persisted session
+ *
+ * Stops a session still running first, so it can also pick up a transfer
+ * that stalled without a reboot. The written part of the partition is
+ * checked against the persisted hash, a session failing the check is
+ * dropped.
+ *
+ * @param command U_FLASH or U_SPIFFS
+ * @param imageHash SHA-256 of the whole image as 64 lowercase hex digits
+ * @param offset Image offset the host continues from
+ * @return true if the image continues at offset, see getSessionError()
+ */
+bool resumeUpdateSession(int command, const String &imageHash, size_t offset);
+
+/**
+ * @brief Write the next image bytes
+ *
+ * @param data Image bytes in order
+ * @param length Number of bytes
+ * @return false if flash could not be written
+ */
+bool sessionWrite(uint8_t *data, size_t length);
+
+/**
+ * @brief Check the complete image and make it active
+ *
+ * The session is dropped either way.
+ *
+ * @return true if the image matched its hash and was accepted
+ */
+bool endUpdateSession();
+
+/**
+ * @brief Stop writing but keep the session for a later resume
+ *
+ * Saves the furthest offset known to be in flash. Safe when idle.
+ */
+void suspendUpdateSession();
+
+/**
+ * @brief Stop writing and forget the session, safe when idle
+ */
+void clearUpdateSession();
+
+/**
+ * @brief The session a host could resume, as JSON
+ *
+ * @return {"id","type","sha256","offset"} or null if there is nothing to
+ *         resume
+ */
+String getUpdateSessionJson();
+
+/**
+ * @brief Image bytes written, including those before a resume
+ *
+ * @return Byte count
+ */
+size_t getSessionWritten();
+
+/**
+ * @brief Size of the partition being written
+ *
+ * @return Byte count, 0 when idle
+ */
+size_t getSessionCapacity();
+
+/**
+ * @brief Why the last session call failed
+ *
+ * @return Error message, empty if none
+ */
+const char *getSessionError();
+
+#endif /* RESUME_MODULE_H */
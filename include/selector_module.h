@@ -0,0 +1,79 @@
+/**
+ * @file selector_module.h
+ * @brief Header for weighted, history-aware emote selection
+ *
+ * Each emote pool gets its own preallocated shuffle bag so pools can be
+ * interleaved without resetting each other. Selection inside a bag is
+ * weighted, skips emotes that are cooling down or were played recently,
+ * and can be peeked ahead of time so the player can warm the next asset.
+ */
+
+#ifndef SELECTOR_MODULE_H
+#define SELECTOR_MODULE_H
+
+#include "common.h"
+#include "emotes_module.h"
+
+//==============================================================================
+// CONSTANTS & DEFINITIONS
+//==============================================================================
+
+/** @brief Log tag for Selector module messages */
+static const char *SELECTOR_LOG = "::SELECTOR_MODULE::";
+
+/** @brief Maximum number of pools that can be registered */
+#define EMOTE_POOL_MAX_COUNT 8
+/** @brief Maximum number of emotes in a single pool */
+#define EMOTE_POOL_MAX_SIZE 32
+/** @brief Number of recent selections excluded from the next pick */
+#define EMOTE_HISTORY_SIZE 3
+/** @brief Handle returned when a pool cannot be registered */
+#define EMOTE_POOL_INVALID -1
+
+//==============================================================================
+// PUBLIC API FUNCTIONS
+//==============================================================================
+
+/**
+ * @brief Register a pool of emotes, or find it if already registered
+ *
+ * Pools are identified by the address of their emote array, weights and
+ * cooldowns are only taken from the first registration. Weights are
+ * relative, a weight of 0 removes an emote from selection.
+ *
+ * @param emotes Array of emote handles, must outlive the pool
+ * @param count Number of emotes in the array
+ * @param weights Per-emote weights, nullptr for uniform selection
+ * @param cooldownsMs Per-emote minimum time before an emote can be selected
+ *                    again, nullptr for none
+ * @return Pool handle, or EMOTE_POOL_INVALID if the pool cannot be stored
+ */
+int registerEmotePool(const EmoteId *emotes, size_t count,
+                      const uint8_t *weights = nullptr,
+                      const uint32_t *cooldownsMs = nullptr);
+
+/**
+ * @brief Select the next emote from a pool
+ *
+ * Returns the peeked emote if peekNextEmote() was called since the last
+ * selection, so warming and playing always agree.
+ *
+ * @param pool Pool handle
+ * @return Emote handle, or EmoteId::NONE if the pool handle is invalid
+ */
+EmoteId selectEmote(int pool);
+
+/**
+ * @brief Decide the next emote of a pool without consuming it
+ *
+ * @param pool Pool handle
+ * @return Emote the next selectEmote() call will return
+ */
+EmoteId peekNextEmote(int pool);
+
+/**
+ * @brief Forget all registered pools and selection history
+ */
+void resetEmotePools(void);
+
+#endif /* SELECTOR_MODULE_H */
@@ -10,6 +10,13 @@
  * Key features:
  * - High-speed firmware updates via USB serial connection
  * - Base64 data encoding with integrity validation
+ * - Optional binary mode: COBS-delimited frames with a CRC32, corrupt chunks
+ *   are retried instead of failing the update
+ * - Optional gzip or deflate compressed images, inflated as they arrive
+ * - Optional delta updates: a patch against the running firmware, type
+ *   "delta", applied straight into the next OTA slot
+ * - Resumable updates: an image named by its SHA-256 continues from the
+ *   last offset committed to flash after a lost connection or a reboot
  * - Size verification and partition safety checks
  * - JSON-based command protocol compatible with Web Serial API
  * - Real-time progress reporting and error handling
@@ -36,6 +43,12 @@ static const char* SERIAL_LOG = "::SERIAL_MODULE::";
 /** @brief Maximum size for serial command buffer */
 #define SERIAL_COMMAND_BUFFER_SIZE 4096
 
+/** @brief Serial receive buffer, bounds the bytes a host may have in flight */
+#define SERIAL_RX_BUFFER_SIZE 16384
+
+/** @brief Progress interval while one compressed chunk is written (ms) */
+#define SERIAL_KEEPALIVE_MS 500
+
 //==============================================================================
 // PROTOCOL COMMANDS
 //==============================================================================
@@ -43,22 +56,81 @@ static const char* SERIAL_LOG = "::SERIAL_MODULE::";
 // Command identifiers
 #define CMD_GET_INFO "GET_INFO"           /**< Request device information */
 #define CMD_GET_STATUS "GET_STATUS"       /**< Request current status */
-#define CMD_START_UPDATE "START_UPDATE"   /**< Initialize update process */
+#define CMD_START_UPDATE "START_UPDATE"   /**< size,type[,encoding[,sha256]] */
+#define CMD_RESUME_UPDATE "RESUME_UPDATE" /**< size,type,encoding,sha256,offset */
 #define CMD_SEND_CHUNK "SEND_CHUNK"       /**< Send firmware data chunk */
 #define CMD_FINISH_UPDATE "FINISH_UPDATE" /**< Finalize update process */
 #define CMD_ABORT_UPDATE "ABORT_UPDATE"   /**< Cancel ongoing update */
 #define CMD_RESTART "RESTART"             /**< Restart device */
 #define CMD_GET_LOGS "GET_LOGS"           /**< Get logging status */
+#define CMD_BINARY_MODE "BINARY"          /**< BINARY:1[,window] or BINARY:0 */
 
 // Response prefixes for protocol communication
 #define RESP_OK "OK:"                     /**< Success response prefix */
 #define RESP_ERROR "ERROR:"               /**< Error response prefix */
 #define RESP_PROGRESS "PROGRESS:"         /**< Progress update prefix */
 
+//==============================================================================
+// BINARY FRAMING
+//==============================================================================
+
+/*
+ * After BINARY:1 is acknowledged both directions carry frames instead of text
+ * lines. A frame is type, uint16 sequence, uint16 payload length (little
+ * endian), the payload and a CRC32 of everything before it, COBS-encoded and
+ * terminated by a zero byte. The device drops back to text after
+ * SERIAL_BINARY_IDLE_MS without a valid frame, so a new host always finds it
+ * speaking text.
+ *
+ * BINARY:1,<window> asks for up to that many DATA frames in flight. Chunks
+ * ahead of a gap are held until it is filled, and every ACK carries the
+ * next chunk expected, a bitmap of the chunks held beyond it and a receive
+ * limit: the count of frame bytes the device will have read once its RX
+ * buffer is full. A host that never lets its own count of frame bytes sent
+ * pass the last limit can't overrun the buffer and can stream without
+ * waiting for each chunk.
+ */
+
+/** @brief Largest payload of one frame (bytes) */
+#define SERIAL_FRAME_MAX_PAYLOAD 4096
+/** @brief Type, sequence and payload length (bytes) */
+#define SERIAL_FRAME_HEADER_SIZE 5
+/** @brief CRC32 after the payload (bytes) */
+#define SERIAL_FRAME_CRC_SIZE 4
+/** @brief Largest decoded frame (bytes) */
+#define SERIAL_FRAME_MAX_SIZE                                                  \
+  (SERIAL_FRAME_HEADER_SIZE + SERIAL_FRAME_MAX_PAYLOAD + SERIAL_FRAME_CRC_SIZE)
+/** @brief Largest encoded frame, COBS adds one byte per 254 (bytes) */
+#define SERIAL_FRAME_MAX_ENCODED                                               \
+  (SERIAL_FRAME_MAX_SIZE + SERIAL_FRAME_MAX_SIZE / 254 + 1)
+/** @brief Largest window of DATA frames in flight, one bit each in an ACK */
+#define SERIAL_WINDOW_MAX 8
+/** @brief Silence after which binary mode falls back to text (ms) */
+#define SERIAL_BINARY_IDLE_MS 10000
+
 //==============================================================================
 // TYPE DEFINITIONS
 //==============================================================================
 
+/**
+ * @brief Binary frame types
+ */
+enum class SerialFrameType : uint8_t {
+  COMMAND = 1,  /**< Host: command line without the newline */
+  DATA = 2,     /**< Host: raw image chunk, sequence 0 after START_UPDATE */
+  RESPONSE = 3, /**< Device: OK:, ERROR: or PROGRESS: line, command sequence */
+  ACK = 4,      /**< Device: next chunk expected, uint32 held, uint32 limit */
+  NAK = 5       /**< Device: next chunk expected, reason, uint32 limit */
+};
+
+/**
+ * @brief Why a frame was not accepted
+ */
+enum class SerialNakReason : uint8_t {
+  CORRUPT = 1,     /**< CRC or length check failed */
+  OUT_OF_ORDER = 2 /**< Chunk beyond the window */
+};
+
 /**
  * @brief Serial update states for tracking firmware update progress
  */
@@ -148,8 +220,8 @@ void setSerialVerbose(bool enabled);
 /**
  * @brief Clean shutdown of serial interface when leaving UPDATE_MODE
  * 
- * Gracefully stops serial command processing, aborts any active updates,
- * and resets state. This function should be called by system module 
+ * Gracefully stops serial command processing, suspends any active update
+ * so it can be resumed later, and resets state. This function should be called by system module 
  * during mode transitions to ensure clean state management.
  */
 void cleanupSerial();
@@ -0,0 +1,136 @@
+/**
+ * @file spsc_queue.h
+ * @brief Fixed-capacity single-producer/single-consumer queue
+ *
+ * Lock-free ring buffer used to hand events from a producer context (sensor
+ * polling, radio callbacks) to the consumer that acts on them. Storage is
+ * allocated inline so the queue never touches the heap, and only the
+ * producer writes the head index while only the consumer writes the tail.
+ */
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+//==============================================================================
+// TYPE DEFINITIONS
+//==============================================================================
+
+/**
+ * @brief Single-producer/single-consumer ring buffer
+ *
+ * One slot is always kept free to tell a full queue from an empty one, so
+ * the queue holds at most Capacity - 1 items. Items pushed while the queue is
+ * full are dropped and counted.
+ *
+ * @tparam T Trivially copyable item type
+ * @tparam Capacity Number of slots, must be a power of two
+ */
+template <typename T, size_t Capacity> class SPSCQueue {
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                "SPSCQueue capacity must be a power of two");
+
+public:
+  /**
+   * @brief Append an item (producer side)
+   * @param item Item to copy into the queue
+   * @return true if queued, false if the queue was full and the item dropped
+   */
+  bool push(const T &item) {
+    size_t head = headIndex.load(std::memory_order_relaxed);
+    size_t next = (head + 1) & MASK;
+    if (next == tailIndex.load(std::memory_order_acquire)) {
+      droppedCount.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    buffer[head] = item;
+    headIndex.store(next, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Remove the oldest item (consumer side)
+   * @param item Receives the removed item
+   * @return true if an item was removed, false if the queue was empty
+   */
+  bool pop(T &item) {
+    size_t tail = tailIndex.load(std::memory_order_relaxed);
+    if (tail == headIndex.load(std::memory_order_acquire)) {
+      return false;
+    }
+    item = buffer[tail];
+    tailIndex.store((tail + 1) & MASK, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Copy the oldest item without removing it (consumer side)
+   * @param item Receives the oldest item
+   * @return true if an item was available
+   */
+  bool peek(T &item) const {
+    size_t tail = tailIndex.load(std::memory_order_relaxed);
+    if (tail == headIndex.load(std::memory_order_acquire)) {
+      return false;
+    }
+    item = buffer[tail];
+    return true;
+  }
+
+  /**
+   * @brief Discard every queued item (consumer side)
+   */
+  void clear() {
+    tailIndex.store(headIndex.load(std::memory_order_acquire),
+                    std::memory_order_release);
+  }
+
+  /**
+   * @brief Check whether the queue holds no items
+   * @return true if empty
+   */
+  bool empty() const {
+    return tailIndex.load(std::memory_order_acquire) ==
+           headIndex.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief Number of queued items
+   * @return Items currently waiting for the consumer
+   */
+  size_t size() const {
+    return (headIndex.load(std::memory_order_acquire) -
+            tailIndex.load(std::memory_order_acquire)) &
+           MASK;
+  }
+
+  /**
+   * @brief Number of items dropped because the queue was full
+   * @return Overflow count since creation or the last resetDropped()
+   */
+  uint32_t dropped() const {
+    return droppedCount.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Reset the overflow counter
+   */
+  void resetDropped() { droppedCount.store(0, std::memory_order_relaxed); }
+
+private:
+  /** @brief Index mask for wrapping */
+  static const size_t MASK = Capacity - 1;
+  /** @brief Item storage */
+  T buffer[Capacity];
+  /** @brief Next slot the producer writes */
+  std::atomic<size_t> headIndex{0};
+  /** @brief Next slot the consumer reads */
+  std::atomic<size_t> tailIndex{0};
+  /** @brief Items dropped on overflow */
+  std::atomic<uint32_t> droppedCount{0};
+};
+
+#endif /* SPSC_QUEUE_H */
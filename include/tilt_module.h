@@ -0,0 +1,103 @@
+/**
+ * @file tilt_module.h
+ * @brief Header for the low-latency motion-reactive render path
+ *
+ * Connects the per-sample filtered gravity vector straight to the render
+ * stage. Each motion-reactive frame starts with beginMotionReactiveFrame(),
+ * which drains the accelerometer and derives a normalized tilt plus a
+ * spring-damped "slosh" offset from it, and ends with
+ * endMotionReactiveFrame() once the pixels are out. The time from the
+ * newest sample to the last pixel written is tracked against
+ * TILT_LATENCY_BUDGET_US.
+ */
+
+#ifndef TILT_MODULE_H
+#define TILT_MODULE_H
+
+#include "common.h"
+
+//==============================================================================
+// CONSTANTS & DEFINITIONS
+//==============================================================================
+
+/** @brief Log tag for Tilt module messages */
+static const char *TILT_LOG = "::TILT_MODULE::";
+
+/** @brief Sample-to-pixel latency target (us) */
+#define TILT_LATENCY_BUDGET_US 30000
+/** @brief Frames between latency log lines */
+#define TILT_LATENCY_LOG_INTERVAL 128
+/** @brief Microseconds between motion-reactive frames (40FPS) */
+#define TILT_FRAME_DELAY_MICROSECONDS (1000000 / 40)
+/** @brief Lateral acceleration treated as full tilt (m/s²) */
+#define TILT_FULL_SCALE 6.0f
+
+//==============================================================================
+// TYPE DEFINITIONS
+//==============================================================================
+
+/**
+ * @brief Motion state handed to renderers for one frame
+ *
+ * Tilt and slosh are normalized to -1..1 per axis. X is left/right on the
+ * screen, Y is up/down.
+ */
+struct TiltState {
+  float tiltX;         /**< Gravity tilt, follows the device directly */
+  float tiltY;         /**< Gravity tilt, follows the device directly */
+  float sloshX;        /**< Spring-damped tilt that overshoots and settles */
+  float sloshY;        /**< Spring-damped tilt that overshoots and settles */
+  uint32_t sampleTime; /**< micros() of the newest sample behind the state */
+};
+
+/**
+ * @brief Sample-to-pixel latency of motion-reactive frames
+ */
+struct MotionToPhotonStats {
+  uint32_t count;       /**< Frames measured */
+  uint32_t overBudget;  /**< Frames above TILT_LATENCY_BUDGET_US */
+  uint32_t maxMicros;   /**< Worst latency seen */
+  uint64_t totalMicros; /**< Sum of all latencies */
+};
+
+//==============================================================================
+// PUBLIC API FUNCTIONS
+//==============================================================================
+
+/**
+ * @brief Fetch fresh motion data for the frame about to be rendered
+ *
+ * Polls the accelerometer, keeps the sampling rate up and advances the
+ * slosh simulation to the newest sample.
+ *
+ * @return Tilt state to render with
+ */
+TiltState beginMotionReactiveFrame(void);
+
+/**
+ * @brief Finish a motion-reactive frame and record its latency
+ *
+ * @param pixelsWritten Pixels sent this frame, 0 skips the measurement
+ */
+void endMotionReactiveFrame(uint32_t pixelsWritten);
+
+/**
+ * @brief Tilt state of the current frame
+ *
+ * @return Copy of the state returned by beginMotionReactiveFrame()
+ */
+TiltState getTiltState(void);
+
+/**
+ * @brief Sample-to-pixel latency statistics since the last reset
+ *
+ * @return Copy of the statistics
+ */
+MotionToPhotonStats getMotionToPhotonStats(void);
+
+/**
+ * @brief Clear the latency statistics
+ */
+void resetMotionToPhotonStats(void);
+
+#endif /* TILT_MODULE_H */
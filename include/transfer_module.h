@@ -0,0 +1,217 @@
+/**
+ * @file transfer_module.h
+ * @brief Header for bulk file and firmware transfers between bots
+ *
+ * A seeding bot offers its running firmware or a LittleFS file to each
+ * paired peer in turn over ESP-NOW. Chunks are sent with a selective-repeat
+ * window sized to the transport frame, the receiver streams them in order
+ * into Update or a file, checks a SHA-256 of the whole image and only then
+ * commits it. Neither side ever holds more than one window in RAM.
+ *
+ * Pairing is not authenticated and the offered hash comes from the sender,
+ * so a paired peer can only write emote assets (GIF, vector, sprite and
+ * scene files under /gifs/, /vectors/ or /sprites/). The web UI, the behavior graph
+ * and other files are never taken from a peer, and firmware only after the
+ * owner opted in on this bot within the last TRANSFER_FIRMWARE_OPT_IN_MS.
+ *
+ * Transfer frames share the ESP-NOW link with the conversation protocol and
+ * are told apart by their own frame marker.
+ */
+
+#ifndef TRANSFER_MODULE_H
+#define TRANSFER_MODULE_H
+
+#include "common.h"
+#include "transport_module.h"
+
+//==============================================================================
+// CONSTANTS & DEFINITIONS
+//==============================================================================
+
+/** @brief Log tag for Transfer module messages */
+static const char *TRANSFER_LOG = "::TRANSFER_MODULE::";
+
+/** @brief Transfer frame marker, first two bytes of every transfer frame */
+#define TRANSFER_FRAME_MAGIC 0xB591
+/** @brief Transfer format version, frames of other versions are dropped */
+#define TRANSFER_PROTOCOL_VERSION 1
+/** @brief Magic, version, frame type and session id (bytes) */
+#define TRANSFER_HEADER_SIZE 6
+/** @brief Image bytes per data frame, what is left after the chunk index */
+#define TRANSFER_CHUNK_SIZE (TRANSPORT_MAX_FRAME_SIZE - TRANSFER_HEADER_SIZE - 4)
+/** @brief Chunks in flight, one bit each in an ack */
+#define TRANSFER_WINDOW 32
+/** @brief Frames buffered between the receive callback and the main loop */
+#define TRANSFER_RX_QUEUE_SIZE 32
+/** @brief Longest file path carried in an offer, including the terminator */
+#define TRANSFER_MAX_NAME 48
+/** @brief SHA-256 digest size (bytes) */
+#define TRANSFER_HASH_SIZE 32
+
+//------------------------------------------------------------------------------
+// Timing
+//------------------------------------------------------------------------------
+#define TRANSFER_CHUNK_RETRY_MS 100      // Resend a chunk not acked by then
+#define TRANSFER_BURST 8                 // Data frames sent per main loop pass
+#define TRANSFER_HASH_BURST 8            // File chunks hashed per main loop pass
+#define TRANSFER_ACK_EVERY 8             // Receiver acks after this many chunks
+#define TRANSFER_ACK_DELAY_MS 20         // ...or this long after the first one
+#define TRANSFER_CONTROL_RETRY_MS 500    // Resend offers and finish requests
+#define TRANSFER_CONTROL_RETRIES 20      // Offer/finish attempts per peer
+#define TRANSFER_STALL_TIMEOUT_MS 5000   // Give up without hearing the peer
+#define TRANSFER_RESTART_DELAY_MS 2000   // Keep answering before rebooting
+#define TRANSFER_FIRMWARE_OPT_IN_MS 120000 // Firmware offers taken after opt-in
+
+//==============================================================================
+// TYPE DEFINITIONS
+//==============================================================================
+
+/**
+ * @brief What an offer carries
+ */
+enum class TransferKind : uint8_t {
+  FIRMWARE = 1, /**< Running app image, written with Update */
+  FILE = 2      /**< LittleFS file, written under its own path */
+};
+
+/**
+ * @brief Transfer frame types
+ */
+enum class TransferFrameType : uint8_t {
+  OFFER = 1,  /**< kind, uint32 size, hash, name */
+  ACCEPT = 2, /**< Receiver opened its sink */
+  REJECT = 3, /**< TransferResult why the offer was declined */
+  DATA = 4,   /**< uint32 chunk index, chunk bytes */
+  ACK = 5,    /**< uint32 next missing chunk, uint32 bitmap from there on */
+  FINISH = 6, /**< Sender has every chunk acked */
+  RESULT = 7, /**< TransferResult after the hash check */
+  ABORT = 8   /**< Either side gave up */
+};
+
+/**
+ * @brief Activity of the transfer engine
+ */
+enum class TransferState {
+  IDLE,      /**< Nothing in progress */
+  HASHING,   /**< Hashing a file before offering it */
+  CHECKING,  /**< Comparing an offered file with the local copy */
+  OFFERING,  /**< Waiting for a peer to accept */
+  SENDING,   /**< Streaming chunks to a peer */
+  FINISHING, /**< Waiting for the peer's hash check */
+  RECEIVING  /**< Streaming chunks from a peer */
+};
+
+/**
+ * @brief Outcome of one transfer
+ */
+enum class TransferResult : uint8_t {
+  OK = 0,            /**< Image verified and committed */
+  UP_TO_DATE = 1,    /**< Receiver already has this image */
+  NO_SPACE = 2,      /**< Image doesn't fit the receiver */
+  BUSY = 3,          /**< Receiver is in another transfer */
+  WRITE_FAILED = 4,  /**< Sink rejected data */
+  HASH_MISMATCH = 5, /**< Received image doesn't match the offer */
+  TIMEOUT = 6,       /**< Peer stopped answering */
+  ABORTED = 7,       /**< Cancelled by either side */
+  NOT_ALLOWED = 8    /**< No firmware opt-in, or file isn't an emote asset */
+};
+
+/**
+ * @brief Progress and throughput of the current or last transfer
+ */
+struct TransferStatus {
+  TransferState state;       /**< Current activity */
+  TransferKind kind;         /**< What is or was transferred */
+  uint8_t peer[6];           /**< Other side */
+  uint32_t totalBytes;       /**< Image size */
+  uint32_t doneBytes;        /**< Bytes acked (sending) or written */
+  uint32_t retransmissions;  /**< Chunks sent more than once */
+  uint32_t elapsedMs;        /**< Time since the offer was accepted */
+  uint32_t bytesPerSecond;   /**< Throughput over elapsedMs */
+  TransferResult lastResult; /**< Outcome of the last finished transfer */
+  uint8_t seeded;            /**< Peers that took the image this round */
+};
+
+//==============================================================================
+// PUBLIC API FUNCTIONS
+//==============================================================================
+
+/**
+ * @brief Check whether a received frame belongs to the transfer protocol
+ * @param data Frame bytes
+ * @param len Frame length
+ * @return true if the frame carries the transfer marker
+ */
+bool isTransferFrame(const uint8_t *data, int len);
+
+/**
+ * @brief Queue a received transfer frame for handleTransfer()
+ *
+ * Called from the ESP-NOW receive callback, only copies the frame.
+ *
+ * @param mac Sender
+ * @param data Frame bytes
+ * @param len Frame length
+ */
+void transferFrameReceived(const uint8_t *mac, const uint8_t *data, int len);
+
+/**
+ * @brief Run the transfer engine, called from handleCommunication()
+ */
+void handleTransfer();
+
+/**
+ * @brief Offer the running firmware to every paired peer in turn
+ * @return true if seeding started
+ */
+bool seedFirmware();
+
+/**
+ * @brief Offer a LittleFS file to every paired peer in turn
+ *
+ * The file is hashed over the next handleTransfer() passes, the first offer
+ * goes out once that is done.
+ *
+ * @param path Emote asset path, shorter than TRANSFER_MAX_NAME
+ * @return true if seeding started
+ */
+bool seedFile(const char *path);
+
+/**
+ * @brief Take the next firmware offer from a paired peer
+ *
+ * The opt-in lapses after TRANSFER_FIRMWARE_OPT_IN_MS or once one firmware
+ * transfer was accepted. Must be called by a local action of the owner.
+ */
+void allowFirmwareTransfer();
+
+/**
+ * @brief Check if firmware offers are currently taken
+ * @return true within TRANSFER_FIRMWARE_OPT_IN_MS of allowFirmwareTransfer()
+ */
+bool isFirmwareTransferAllowed();
+
+/**
+ * @brief Cancel the current transfer and the rest of a seeding round
+ */
+void abortTransfer();
+
+/**
+ * @brief Check if a transfer is in progress
+ * @return true unless the engine is idle
+ */
+bool isTransferActive();
+
+/**
+ * @brief Check if transfer frames wait for handleTransfer()
+ * @return true if the transfer receive queue is not empty
+ */
+bool transferFramesPending();
+
+/**
+ * @brief Get progress and throughput of the current or last transfer
+ * @return Status snapshot
+ */
+TransferStatus getTransferStatus();
+
+#endif /* TRANSFER_MODULE_H */
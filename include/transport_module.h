@@ -0,0 +1,141 @@
+/**
+ * @file transport_module.h
+ * @brief Header for the link layer under the ESP-NOW protocol
+ *
+ * espnow_module only talks to the radio through EspNowTransport, so the
+ * discovery, pairing and conversation logic runs unchanged on the ESP-NOW
+ * radio or on LoopbackBus endpoints on a host.
+ */
+
+#ifndef TRANSPORT_MODULE_H
+#define TRANSPORT_MODULE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+//==============================================================================
+// CONSTANTS & DEFINITIONS
+//==============================================================================
+
+/** @brief Log tag for Transport module messages */
+static const char *TRANSPORT_LOG = "::TRANSPORT_MODULE::";
+
+/** @brief Largest frame a transport carries (bytes), ESP-NOW's limit */
+#define TRANSPORT_MAX_FRAME_SIZE 250
+
+/** @brief Stack of the task that powers the radio up and down (bytes) */
+#define TRANSPORT_POWER_TASK_STACK 3072
+/** @brief Priority of that task, above the loop task so switches finish */
+#define TRANSPORT_POWER_TASK_PRIORITY 2
+/** @brief Longest end() waits for a pending power switch (ms) */
+#define TRANSPORT_POWER_SETTLE_MS 100
+
+/** @brief Destination address that reaches every device in range */
+static const uint8_t TRANSPORT_BROADCAST_MAC[6] = {0xFF, 0xFF, 0xFF,
+                                                   0xFF, 0xFF, 0xFF};
+
+//==============================================================================
+// TYPE DEFINITIONS
+//==============================================================================
+
+/**
+ * @brief Called for every received frame
+ *
+ * May run in another task than the main loop, see Receive_data_cb().
+ *
+ * @param mac Sender
+ * @param data Frame bytes
+ * @param len Frame length
+ */
+typedef void (*TransportReceiveHandler)(const uint8_t *mac,
+                                        const uint8_t *data, int len);
+
+/**
+ * @brief Called once the link layer knows the fate of a sent frame
+ *
+ * @param mac Destination
+ * @param delivered true if the link layer saw the frame arrive
+ */
+typedef void (*TransportSendHandler)(const uint8_t *mac, bool delivered);
+
+/**
+ * @brief Datagram link between devices addressed by MAC
+ *
+ * Unicast needs the destination added with addPeer() first, frames to
+ * TRANSPORT_BROADCAST_MAC reach every device in range.
+ */
+class EspNowTransport {
+public:
+  virtual ~EspNowTransport() {}
+
+  /**
+   * @brief Bring the link up
+   * @param onReceive Receives incoming frames
+   * @param onSend Receives the link layer delivery status of sent frames
+   * @return true if the link is up
+   */
+  virtual bool begin(TransportReceiveHandler onReceive,
+                     TransportSendHandler onSend) = 0;
+
+  /**
+   * @brief Take the link down, no handler is called afterwards
+   */
+  virtual void end() = 0;
+
+  /**
+   * @brief Send a frame
+   * @param mac Destination or TRANSPORT_BROADCAST_MAC
+   * @param data Frame bytes
+   * @param length Frame length, at most TRANSPORT_MAX_FRAME_SIZE
+   * @return true if the frame was accepted for sending
+   */
+  virtual bool send(const uint8_t *mac, const uint8_t *data,
+                    size_t length) = 0;
+
+  /**
+   * @brief Allow unicast to a device, adding it twice is not an error
+   * @param mac Device to add
+   * @return true if the device can be sent to
+   */
+  virtual bool addPeer(const uint8_t *mac) = 0;
+
+  /**
+   * @brief Stop unicast to a device
+   * @param mac Device to remove
+   */
+  virtual void removePeer(const uint8_t *mac) = 0;
+
+  /**
+   * @brief Address of this device
+   * @param mac Receives 6 bytes
+   */
+  virtual void macAddress(uint8_t *mac) = 0;
+
+  /**
+   * @brief Power the radio down or back up, a running link stays set up
+   *
+   * While asleep nothing is received and send() fails. The switch may
+   * finish after the call returns, send() keeps failing until the radio is
+   * up again.
+   *
+   * @param awake false to sleep
+   * @return true if the radio is in or on its way to the requested state
+   */
+  virtual bool setAwake(bool awake) = 0;
+};
+
+//==============================================================================
+// PUBLIC API FUNCTIONS
+//==============================================================================
+
+/**
+ * @brief The ESP-NOW radio transport
+ *
+ * Puts WiFi in station mode on begin() and disconnects it again on end()
+ * while the device is in ESP mode.
+ *
+ * @return Transport backed by esp_now_*
+ */
+EspNowTransport &espNowRadioTransport(void);
+
+#endif /* TRANSPORT_MODULE_H */
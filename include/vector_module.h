@@ -0,0 +1,152 @@
+/**
+ * @file vector_module.h
+ * @brief Header for the compact vector animation format and renderer
+ *
+ * Simple emote overlays (hearts, Zs, exclamation marks, talk bubbles) are
+ * stored as a few keyframed primitives instead of full-screen GIFs. Shapes
+ * are flattened to polygons each frame and filled with a fixed-point
+ * scanline edge-list rasterizer into the RGB565 pipeline. Coordinates are
+ * in a design space scaled to the panel at load time, so one asset plays on
+ * any panel size.
+ *
+ * Vector files (.vec) are produced on the host by tools/vector_converter.py.
+ */
+
+#ifndef VECTOR_MODULE_H
+#define VECTOR_MODULE_H
+
+#include "common.h"
+
+//==============================================================================
+// CONSTANTS & DEFINITIONS
+//==============================================================================
+
+/** @brief Log tag for Vector module messages */
+static const char *VECTOR_LOG = "::VECTOR_MODULE::";
+
+/** @brief File extension identifying vector animations */
+#define VECTOR_EXTENSION ".vec"
+/** @brief Vector file magic */
+#define VECTOR_MAGIC "VEC1"
+/** @brief Supported vector file version */
+#define VECTOR_VERSION 1
+/** @brief Largest vector file accepted (bytes) */
+#define VECTOR_MAX_FILE_SIZE 4096
+/** @brief Maximum number of shapes in an animation */
+#define VECTOR_MAX_SHAPES 32
+/** @brief Maximum number of polygon edges per frame */
+#define VECTOR_MAX_EDGES 512
+/** @brief Microseconds between frames for 30FPS playback */
+#define VECTOR_FRAME_DELAY_MICROSECONDS (1000000 / 30)
+/** @brief Fractional bits of design coordinates */
+#define VECTOR_COORD_SHIFT 4
+
+//==============================================================================
+// TYPE DEFINITIONS
+//==============================================================================
+
+/**
+ * @brief Primitive types
+ */
+enum class VectorShapeType : uint8_t {
+  CIRCLE,       /**< size0 = radius */
+  ROUNDED_RECT, /**< size0 = width, size1 = height, size2 = corner radius */
+  POLYGON       /**< Vertices follow the shape record */
+};
+
+/**
+ * @brief Easing applied when moving into a keyframe
+ */
+enum class VectorEasing : uint8_t {
+  LINEAR,
+  EASE_IN,
+  EASE_OUT,
+  EASE_IN_OUT,
+  STEP /**< Jump when the keyframe is reached */
+};
+
+/**
+ * @brief Vector file header (little endian)
+ *
+ * Followed by shapeCount shape records. Each record is followed by its
+ * polygon vertices and then its keyframes.
+ */
+struct __attribute__((packed)) VectorHeader {
+  char magic[4];       /**< VECTOR_MAGIC */
+  uint8_t version;     /**< VECTOR_VERSION */
+  uint8_t shapeCount;  /**< Number of shapes, drawn in order */
+  uint16_t durationMs; /**< Animation length */
+  uint16_t designSize; /**< Width and height of the design space */
+  uint16_t background; /**< RGB565 background color */
+};
+
+/**
+ * @brief Shape record, sizes in design units with VECTOR_COORD_SHIFT bits
+ */
+struct __attribute__((packed)) VectorShapeRecord {
+  uint8_t type;          /**< VectorShapeType */
+  uint8_t keyframeCount; /**< Keyframes following the vertices, at least 1 */
+  uint8_t pointCount;    /**< Polygon vertices, 0 for other types */
+  uint8_t reserved;      /**< Must be 0 */
+  uint16_t color;        /**< RGB565 fill color */
+  uint16_t size[3];      /**< Type specific sizes */
+};
+
+/**
+ * @brief Polygon vertex relative to the shape position
+ */
+struct __attribute__((packed)) VectorPoint {
+  int16_t x; /**< Design units with VECTOR_COORD_SHIFT bits */
+  int16_t y; /**< Design units with VECTOR_COORD_SHIFT bits */
+};
+
+/**
+ * @brief Shape transform at a point in time
+ */
+struct __attribute__((packed)) VectorKeyframe {
+  uint16_t timeMs; /**< Time from the start of the animation */
+  uint8_t easing;  /**< VectorEasing used to reach this keyframe */
+  uint8_t alpha;   /**< Opacity, 0 hides the shape */
+  int16_t x;       /**< Position in design units with VECTOR_COORD_SHIFT bits */
+  int16_t y;       /**< Position in design units with VECTOR_COORD_SHIFT bits */
+  uint16_t scale;  /**< Scale with 8 fractional bits, 256 = 1.0 */
+};
+
+//==============================================================================
+// PUBLIC API FUNCTIONS
+//==============================================================================
+
+/**
+ * @brief Check whether a path names a vector animation
+ *
+ * @param path Emote path
+ * @return true if the path ends with VECTOR_EXTENSION
+ */
+bool isVectorAnimation(const char *path);
+
+/**
+ * @brief Load and validate a vector animation
+ *
+ * @param path Vector file path
+ * @param durationMs Receives the animation length (ms)
+ * @return true if loaded
+ */
+bool loadVectorAnimation(const char *path, unsigned long *durationMs);
+
+/**
+ * @brief Render the loaded animation at a point in time
+ *
+ * Only the area covered by the shapes in this or the previous frame is
+ * redrawn, except for the first frame which clears the whole screen.
+ *
+ * @param elapsedMs Time since the animation started (ms)
+ * @return Number of pixels written
+ */
+uint32_t renderVectorFrame(unsigned long elapsedMs);
+
+/**
+ * @brief Release the loaded animation
+ */
+void unloadVectorAnimation(void);
+
+#endif /* VECTOR_MODULE_H */
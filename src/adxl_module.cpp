@@ -21,6 +21,31 @@ static sensors_event_t event;
 /** @brief Flag indicating if ADXL345 is properly initialized and enabled */
 static bool ADXL345Enabled = false;
 
+//------------------------------------------------------------------------------
+// Power Profiles
+//------------------------------------------------------------------------------
+/** @brief Register settings per profile, indexed by ADXLPowerProfile */
+static const ADXLProfileConfig PROFILE_CONFIGS[] = {
+    // RESTING: wake detection only, data is drained a few times per second
+    {ADXL345_DATARATE_25_HZ, 25.0f, true, 8, 200},
+    // ACTIVE: matches the original fixed 100 Hz configuration
+    {ADXL345_DATARATE_100_HZ, 100.0f, false, 16, 10},
+    // INTERACTIVE: extra resolution while shaking or tapping
+    {ADXL345_DATARATE_200_HZ, 200.0f, false, 16, 10},
+};
+/** @brief Currently applied sampling profile */
+static ADXLPowerProfile currentProfile = ADXLPowerProfile::ACTIVE;
+
+//------------------------------------------------------------------------------
+// Magnitude Smoothing
+//------------------------------------------------------------------------------
+/** @brief Smoothing factor tuned for the original 100 Hz data rate */
+static const float BASE_SMOOTHING_FACTOR = 0.1f;
+/** @brief Data rate the base smoothing factor was tuned for (Hz) */
+static const float BASE_SAMPLE_RATE = 100.0f;
+/** @brief Per-sample smoothing factor for the active data rate */
+static float smoothingFactor = BASE_SMOOTHING_FACTOR;
+
 //==============================================================================
 // UTILITY FUNCTIONS (STATIC)
 //==============================================================================
@@ -129,6 +154,42 @@ static void writeRegister(uint8_t reg, uint8_t value) {
   adxl.writeRegister(reg, value);
 }
 
+/**
+ * @brief Returns the register settings for a profile
+ * @param profile Sampling profile
+ * @return Reference to the profile configuration
+ */
+static const ADXLProfileConfig &profileConfig(ADXLPowerProfile profile) {
+  return PROFILE_CONFIGS[static_cast<size_t>(profile)];
+}
+
+/**
+ * @brief Writes data rate, low power bit and FIFO settings for a profile
+ *
+ * The smoothing factor is rescaled so the magnitude filter keeps the same
+ * time constant it had at 100 Hz, keeping detector thresholds valid at every
+ * data rate.
+ *
+ * @param profile Sampling profile to apply
+ */
+static void applyPowerProfile(ADXLPowerProfile profile) {
+  const ADXLProfileConfig &config = profileConfig(profile);
+  uint8_t bwRate = (uint8_t)config.dataRate;
+  if (config.lowPower) {
+    bwRate |= ADXL345_BW_RATE_LOW_POWER;
+  }
+  adxl.writeRegister(ADXL345_REG_BW_RATE, bwRate);
+  // Flush samples taken at the previous rate by cycling through bypass mode
+  adxl.writeRegister(ADXL345_REG_FIFO_CTL, ADXL345_FIFO_BYPASS_MODE);
+  adxl.writeRegister(ADXL345_REG_FIFO_CTL,
+                     ADXL345_FIFO_STREAM_MODE | (config.fifoWatermark & 0x1F));
+
+  smoothingFactor =
+      1.0f - powf(1.0f - BASE_SMOOTHING_FACTOR,
+                  BASE_SAMPLE_RATE / config.sampleRateHz);
+  currentProfile = profile;
+}
+
 /**
  * @brief Configures ESP deep sleep mode with ADXL345 as wake-up source
  *
@@ -213,13 +274,12 @@ int calculateCombinedMagnitude(float accelX, float accelY, float accelZ) {
   if (!ADXL345Enabled)
     return 0;
   static float smoothedMagnitude = 0;
-  static const float SMOOTHING_FACTOR = 0.1;
   // Calculate the raw acceleration magnitude
   float rawAccelMagnitude = sqrt(sq(accelX) + sq(accelY) + sq(accelZ));
   // Subtract gravity to focus on dynamic acceleration
   float dynamicAccelMagnitude = abs(rawAccelMagnitude - SENSORS_GRAVITY_EARTH);
-  smoothedMagnitude = (SMOOTHING_FACTOR * dynamicAccelMagnitude) +
-                      ((1 - SMOOTHING_FACTOR) * smoothedMagnitude);
+  smoothedMagnitude = (smoothingFactor * dynamicAccelMagnitude) +
+                      ((1 - smoothingFactor) * smoothedMagnitude);
 
   return (int)round(smoothedMagnitude);
 }
@@ -259,7 +319,6 @@ bool initializeADXL345() {
   // Setup ADXL345 module
   ADXL345Enabled = true;
   adxl.setRange(ADXL345_RANGE_16_G);
-  adxl.setDataRate(ADXL345_DATARATE_100_HZ);
   // Setup interuptions and tap/double tap sensitivity
   adxl.writeRegister(ADXL345_REG_INT_ENABLE, 0x00);
   adxl.writeRegister(ADXL345_REG_THRESH_TAP, calcGforce(14.0));
@@ -272,9 +331,9 @@ bool initializeADXL345() {
   adxl.writeRegister(ADXL345_REG_INT_MAP, 0x00);
   // Enable only single and double tap interrupts (0x60 = 0b01100000)
   adxl.writeRegister(ADXL345_REG_INT_ENABLE, 0x60);
-  // Add FIFO configuration after your other settings
-  // Configure for stream mode with 16 samples
-  adxl.writeRegister(ADXL345_REG_FIFO_CTL, 0x80 | 0x10);
+  // Data rate and FIFO stream mode are owned by the power profile, start at
+  // the default 100 Hz profile until the motion governor decides otherwise
+  applyPowerProfile(ADXLPowerProfile::ACTIVE);
   // Clear any existing interrupts by reading INT_SOURCE
   clearInterrupts();
   configureESPDeepSleep();
@@ -295,4 +354,44 @@ uint8_t getFifoSampleData() {
   // Extract the number of samples available (lower 6 bits)
   uint8_t samplesAvailable = fifoStatus & 0x3F;
   return samplesAvailable;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Switches output data rate, low power bit and FIFO watermark
+ *
+ * @param profile Sampling profile to apply
+ * @return true if the profile was applied, false if the sensor is disabled
+ */
+bool setADXLPowerProfile(ADXLPowerProfile profile) {
+  if (!ADXL345Enabled)
+    return false;
+  if (profile == currentProfile)
+    return true;
+
+  applyPowerProfile(profile);
+  const ADXLProfileConfig &config = profileConfig(profile);
+  ESP_LOGI(ADXL_LOG, "Sampling profile changed: %.1f Hz%s, watermark %d",
+           config.sampleRateHz, config.lowPower ? " (low power)" : "",
+           config.fifoWatermark);
+  return true;
+}
+
+/**
+ * @brief Gets the sampling profile currently applied to the sensor
+ * @return Active sampling profile
+ */
+ADXLPowerProfile getADXLPowerProfile() { return currentProfile; }
+
+/**
+ * @brief Gets the output data rate of the active profile
+ * @return Sample rate in Hz
+ */
+float getADXLSampleRate() { return profileConfig(currentProfile).sampleRateHz; }
+
+/**
+ * @brief Gets the minimum time between FIFO reads for the active profile
+ * @return Poll interval in milliseconds
+ */
+unsigned long getADXLPollInterval() {
+  return profileConfig(currentProfile).pollInterval;
+}
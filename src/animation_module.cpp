@@ -9,13 +9,20 @@
  */
 
 #include "animation_module.h"
+#include "behavior_module.h"
+#include "compositor_module.h"
 #include "effects_module.h"
 #include "emotes_module.h"
 #include "espnow_module.h"
+#include "eyes_module.h"
 #include "gif_module.h"
 #include "motion_module.h"
+#include "selector_module.h"
+#include "vector_module.h"
 #include "system_module.h"
+#include "tilt_module.h"
 #include "menu_module.h"
+#include "transfer_module.h"
 
 //==============================================================================
 // GLOBAL VARIABLES AND CONSTANTS
@@ -24,7 +31,7 @@
 /** @brief Current animation sequence state */
 static AnimationSequence animSequence;
 /** @brief Pointer to the current emote set */
-const char **currentEmotes;
+const EmoteId *currentEmotes;
 /** @brief Number of emotes in the current set */
 size_t emoteCount;
 
@@ -58,129 +65,523 @@ const unsigned long COMS_CHECK_INTERVAL = 20000;
 static unsigned long lastInteractionCheck = 0;
 /** @brief Debounce time for interaction checks (ms) */
 const unsigned long INTERACTION_CHECK_DEBOUNCE = 10;
+/** @brief Time before an intense random emote can play again (ms) */
+const uint32_t INTENSE_EMOTE_COOLDOWN_MS = 10 * 60 * 1000;
+
+//------------------------------------------------------------------------------
+// Reaction Latency Variables
+//------------------------------------------------------------------------------
+/** @brief Upper bound of each latency bucket (ms), the last bucket is open */
+const uint16_t LATENCY_BUCKET_LIMITS_MS[LATENCY_BUCKET_COUNT - 1] = {
+    10, 20, 30, 50, 75, 100, 150, 250};
+/** @brief Samples per interaction type between latency log summaries */
+const uint32_t LATENCY_LOG_INTERVAL = 16;
+/** @brief Reaction latency histogram per interaction type */
+static ReactionLatencyStats latencyStats[static_cast<size_t>(
+    MotionEventType::MOTION_EVENT_COUNT)];
+/** @brief Interaction whose first reaction pixel has not been drawn yet */
+static MotionEvent pendingReaction;
+/** @brief Flag indicating pendingReaction is waiting to be measured */
+static bool reactionPending = false;
 
 //------------------------------------------------------------------------------
 // Emote Collections
 //------------------------------------------------------------------------------
 #if DEVICE_MODE == MAC_MODE | DEVICE_MODE == PC_MODE
-// File paths for emotes (replace the const arrays)
 /** @brief Random emotes for MAC and PC modes */
-const char *randomEmotes[] = {
-    ZONED_EMOTE, DOUBTFUL_EMOTE, TALK_EMOTE, SCAN_EMOTE, ANGRY_EMOTE,
-    CRY_EMOTE, PIXEL_EMOTE, GLEE_EMOTE, EXCITED_EMOTE, HEARTS_EMOTE, UWU_EMOTE,
+const EmoteId randomEmotes[] = {
+    EmoteId::ZONED,   EmoteId::DOUBTFUL, EmoteId::TALK,  EmoteId::SCAN,
+    EmoteId::ANGRY,   EmoteId::CRY,      EmoteId::PIXEL, EmoteId::GLEE,
+    EmoteId::EXCITED, EmoteId::HEARTS,   EmoteId::UWU,
+};
+
+/** @brief Relative weights of randomEmotes, intense emotes come up less */
+const uint8_t randomEmoteWeights[] = {
+    3, 2, 3, 3,
+    1, 1, 2, 2,
+    2, 2, 2,
+};
+
+/** @brief Re-selection cooldowns of randomEmotes (ms) */
+const uint32_t randomEmoteCooldowns[] = {
+    0, 0, 0, 0,
+    INTENSE_EMOTE_COOLDOWN_MS, INTENSE_EMOTE_COOLDOWN_MS, 0, 0,
+    0, 0, 0,
 };
 
 /** @brief Resting emotes for MAC and PC modes */
-const char *restingEmotes[] = {REST_EMOTE, IDLE_EMOTE, LOOK_DOWN_EMOTE,
-                               LOOK_UP_EMOTE, LOOK_LEFT_RIGHT_EMOTE};
+const EmoteId restingEmotes[] = {EmoteId::REST, EmoteId::EYES_IDLE,
+                                 EmoteId::EYES_LOOK_DOWN, EmoteId::EYES_LOOK_UP,
+                                 EmoteId::EYES_LOOK_LEFT_RIGHT};
 #else
-// File paths for emotes (replace the const arrays)
 /** @brief Random emotes for BYTE-90 mode */
-const char *randomEmotes[] = {
-    WINK_02_EMOTE, ZONED_EMOTE, DOUBTFUL_EMOTE, TALK_EMOTE, SCAN_EMOTE,
-    ANGRY_EMOTE, CRY_EMOTE, PIXEL_EMOTE, EXCITED_EMOTE, HEARTS_EMOTE,
-    UWU_EMOTE, WHISTLE_EMOTE, GLEE_EMOTE, MISCHIEF_EMOTE, HUMSUP_EMOTE,
+const EmoteId randomEmotes[] = {
+    EmoteId::WINK_02, EmoteId::ZONED,    EmoteId::DOUBTFUL, EmoteId::TALK,
+    EmoteId::SCAN,    EmoteId::ANGRY,    EmoteId::CRY,      EmoteId::PIXEL,
+    EmoteId::EXCITED, EmoteId::HEARTS,   EmoteId::UWU,      EmoteId::WHISTLE,
+    EmoteId::GLEE,    EmoteId::MISCHIEF, EmoteId::HUMSUP,
+};
+
+/** @brief Relative weights of randomEmotes, intense emotes come up less */
+const uint8_t randomEmoteWeights[] = {
+    3, 3, 2, 3,
+    3, 1, 1, 2,
+    2, 2, 2, 2,
+    2, 1, 2,
+};
+
+/** @brief Re-selection cooldowns of randomEmotes (ms) */
+const uint32_t randomEmoteCooldowns[] = {
+    0, 0, 0, 0,
+    0, INTENSE_EMOTE_COOLDOWN_MS, INTENSE_EMOTE_COOLDOWN_MS, 0,
+    0, 0, 0, 0,
+    0, INTENSE_EMOTE_COOLDOWN_MS, 0,
 };
 
 /** @brief Resting emotes for BYTE-90 mode */
-const char *restingEmotes[] = {
-    REST_EMOTE,
-    IDLE_EMOTE,
-    LOOK_DOWN_EMOTE,
-    LOOK_UP_EMOTE,
-    LOOK_LEFT_RIGHT_EMOTE,
+const EmoteId restingEmotes[] = {
+    EmoteId::REST,
+    EmoteId::EYES_IDLE,
+    EmoteId::EYES_LOOK_DOWN,
+    EmoteId::EYES_LOOK_UP,
+    EmoteId::EYES_LOOK_LEFT_RIGHT,
 };
 #endif
 
+static_assert(ARRAY_SIZE(randomEmoteWeights) == ARRAY_SIZE(randomEmotes),
+              "randomEmoteWeights must match randomEmotes");
+static_assert(ARRAY_SIZE(randomEmoteCooldowns) == ARRAY_SIZE(randomEmotes),
+              "randomEmoteCooldowns must match randomEmotes");
+
+//==============================================================================
+// EMOTE SCHEDULING FUNCTIONS
+//==============================================================================
+
+/**
+ * @brief Highest priority emote source currently waiting to play
+ *
+ * @return Priority of the most urgent pending source
+ */
+static EmotePriority pendingEmotePriority() {
+  if (hasPendingMotionEvent()) {
+    return EmotePriority::INTERACTION;
+  }
+  if (motionTiltedLeft() || motionTiltedRight() || motionUpsideDown()) {
+    return EmotePriority::ORIENTATION;
+  }
+  if (espNowToggledState() ||
+      (isPaired() && (commsFramesPending() || transferFramesPending()))) {
+    return EmotePriority::COMMS;
+  }
+  // Frames handled during playback leave their emote queued here
+  if (isPaired() && getCurrentComState() == ComState::PROCESSING &&
+      getCurrentAnimation() != EmoteId::NONE) {
+    return EmotePriority::COMMS;
+  }
+  return EmotePriority::IDLE;
+}
+
+/**
+ * @brief Check whether the playing emote should yield to a pending one
+ *
+ * @param priority Priority of the playing emote
+ * @return true if playback should stop at this frame boundary
+ */
+static bool shouldPreempt(EmotePriority priority) {
+  EmotePriority pending = pendingEmotePriority();
+  if (pending == EmotePriority::INTERACTION) {
+    // Every interaction gets its own reaction, even mid-reaction
+    return true;
+  }
+  return pending > priority;
+}
+
+/**
+ * @brief Wait out the remaining frame time while polling for interactions
+ *
+ * Motion is polled throughout the wait instead of once per frame, so a tap
+ * preempts playback within INTERACTION_CHECK_DEBOUNCE rather than after a
+ * full frame delay. The communication pass runs here too, so discovery duty
+ * cycle windows open on time and received frames are acked within the
+ * sender's ack timeout rather than between emotes.
+ *
+ * @param frameTime micros() when the current frame started
+ * @param priority Priority of the playing emote
+ * @param frameDelay Time between frames (us)
+ * @return true to continue with the next frame, false to stop playback
+ */
+static bool waitForNextFrame(unsigned long frameTime, EmotePriority priority,
+                             unsigned long frameDelay = FRAME_DELAY_MICROSECONDS) {
+  while (true) {
+    if (millis() - lastInteractionCheck >= INTERACTION_CHECK_DEBOUNCE) {
+      lastInteractionCheck = millis();
+      ADXLDataPolling();
+
+      if (menu_isActive()) {
+        ESP_LOGI(GIF_LOG, "Menu active - stopping GIF playback");
+        return false;
+      }
+
+      if (getCurrentMode() == SystemMode::UPDATE_MODE) {
+        return false;
+      }
+
+      if (shouldPreempt(priority)) {
+        return false;
+      }
+
+      // Discovery windows and acks can't wait for the emote to end
+      handleCommunication();
+    }
+
+    // Pace frames at the emote's rate (16FPS for GIFs)
+    unsigned long elapsed = micros() - frameTime;
+    if (elapsed >= frameDelay) {
+      return true;
+    }
+    unsigned long remaining = frameDelay - elapsed;
+    delayMicroseconds(min(remaining, INTERACTION_CHECK_DEBOUNCE * 1000));
+  }
+}
+
+//==============================================================================
+// REACTION LATENCY FUNCTIONS
+//==============================================================================
+
+/**
+ * @brief Log the latency histogram of one interaction type
+ *
+ * @param type Interaction type
+ */
+static void logReactionLatency(MotionEventType type) {
+  const ReactionLatencyStats &stats =
+      latencyStats[static_cast<size_t>(type)];
+  if (stats.count == 0)
+    return;
+
+  ESP_LOGI(ANIM_LOG,
+           "Reaction latency type %d: n=%u avg=%.1fms max=%.1fms "
+           "[<10:%u <20:%u <30:%u <50:%u <75:%u <100:%u <150:%u <250:%u "
+           ">=250:%u]",
+           static_cast<int>(type), stats.count,
+           stats.totalMicros / 1000.0f / stats.count,
+           stats.maxMicros / 1000.0f, stats.buckets[0], stats.buckets[1],
+           stats.buckets[2], stats.buckets[3], stats.buckets[4],
+           stats.buckets[5], stats.buckets[6], stats.buckets[7],
+           stats.buckets[8]);
+}
+
+/**
+ * @brief Record the latency of a pending reaction once its first pixel is out
+ *
+ * @param firstPixelTime micros() when the first pixel was written, 0 if none
+ */
+static void recordReactionLatency(uint32_t firstPixelTime) {
+  if (!reactionPending)
+    return;
+
+  if (firstPixelTime == 0)
+    return;
+  reactionPending = false;
+
+  uint32_t latencyMicros = firstPixelTime - pendingReaction.timestamp;
+  uint32_t latencyMs = latencyMicros / 1000;
+  size_t bucket = 0;
+  while (bucket < LATENCY_BUCKET_COUNT - 1 &&
+         latencyMs >= LATENCY_BUCKET_LIMITS_MS[bucket]) {
+    bucket++;
+  }
+
+  ReactionLatencyStats &stats =
+      latencyStats[static_cast<size_t>(pendingReaction.type)];
+  stats.buckets[bucket]++;
+  stats.count++;
+  stats.totalMicros += latencyMicros;
+  if (latencyMicros > stats.maxMicros) {
+    stats.maxMicros = latencyMicros;
+  }
+
+  if (stats.count % LATENCY_LOG_INTERVAL == 0) {
+    logReactionLatency(pendingReaction.type);
+  }
+}
+
+/**
+ * @brief Play the reaction emote for an interaction and measure its latency
+ *
+ * @param event Interaction being reacted to
+ * @param emote Reaction emote
+ * @param priority Scheduling priority of the reaction
+ */
+static void playReaction(const MotionEvent &event, EmoteId emote,
+                         EmotePriority priority = EmotePriority::INTERACTION) {
+  pendingReaction = event;
+  reactionPending = true;
+  playEmote(emote, priority);
+  reactionPending = false;
+}
+
 //==============================================================================
 // ANIMATION PLAYBACK FUNCTIONS
 //==============================================================================
 
 /**
- * @brief Play a GIF animation with interaction detection
+ * @brief Play a composited scene with interaction detection
  *
- * This is a blocking function that plays a GIF file while monitoring
- * for interactions that might interrupt the animation. Critical data polling
- * is performed within this function to ensure timely updates.
+ * Same scheduling as a GIF, but each frame only redraws the areas whose
+ * layers moved or changed frame.
  *
- * @param filename Path to the GIF file to play
+ * @param filename Path to the scene file
+ * @param priority Scheduling priority of this emote
  * @return true if playback completed successfully
  */
-bool playGIF(const char *filename) {
+static bool playScene(const char *filename, EmotePriority priority) {
   const unsigned long TIMEOUT_MS = 10000;
   unsigned long startTime = millis();
+  unsigned long durationMs = 0;
+
+  if (!loadCompositorScene(filename, &durationMs)) {
+    ESP_LOGE(ANIM_LOG, "ERROR: Failed to load scene %s", filename);
+    return false;
+  }
+
+  // Tilt-driven layers need fresh samples and a frame rate to match
+  bool motionReactive = compositorMotionReactive();
+  unsigned long frameDelay = motionReactive ? TILT_FRAME_DELAY_MICROSECONDS
+                                            : FRAME_DELAY_MICROSECONDS;
+
+  uint32_t firstPixelTime = 0;
   unsigned long frameTime = micros();
-  unsigned long lastCheck = 0;
-  const unsigned long INTERACTION_CHECK_DEBOUNCE = 10;
+  while (millis() - startTime < min(durationMs, TIMEOUT_MS)) {
+    if (motionReactive) {
+      beginMotionReactiveFrame();
+    }
+    uint32_t pixelsWritten = renderCompositorFrame();
+    if (motionReactive) {
+      endMotionReactiveFrame(pixelsWritten);
+    }
+    if (pixelsWritten > 0 && firstPixelTime == 0) {
+      firstPixelTime = max<uint32_t>(micros(), 1);
+    }
+    recordReactionLatency(firstPixelTime);
 
-  if (!loadGIF(filename)) {
-    ESP_LOGE(GIF_LOG, "ERROR: Failed to load GIF File.");
+    if (!waitForNextFrame(frameTime, priority, frameDelay)) {
+      break;
+    }
+    frameTime = micros();
+  }
+
+  clearCompositor();
+  return true;
+}
+
+/**
+ * @brief Play a procedural eye behavior with interaction detection
+ *
+ * Eyes are drawn without file access at EYES_FRAME_DELAY_MICROSECONDS.
+ * Every frame samples the accelerometer right before drawing, so the gaze
+ * tracks the tilt within a frame between scripted moves.
+ *
+ * @param filename Eye emote path
+ * @param priority Scheduling priority of this emote
+ * @return true if playback completed successfully
+ */
+static bool playEyes(const char *filename, EmotePriority priority) {
+  unsigned long startTime = millis();
+  unsigned long durationMs = 0;
+
+  if (!loadEyeBehavior(filename, &durationMs)) {
     return false;
   }
 
-  while (playGIFFrame(false, NULL)) {
-    // Efficient frame timing
-    unsigned long currentTime = micros();
-    unsigned long elapsed = currentTime - frameTime;
-    // Native GIF framerate is 16FPS, ensure that playback matches 16FPS
-    if (elapsed < FRAME_DELAY_MICROSECONDS) {
-      delayMicroseconds(FRAME_DELAY_MICROSECONDS - elapsed);
+  uint32_t firstPixelTime = 0;
+  unsigned long frameTime = micros();
+  while (millis() - startTime < durationMs) {
+    beginMotionReactiveFrame();
+    uint32_t pixelsWritten = renderEyesFrame();
+    endMotionReactiveFrame(pixelsWritten);
+    if (pixelsWritten > 0 && firstPixelTime == 0) {
+      firstPixelTime = max<uint32_t>(micros(), 1);
+    }
+    recordReactionLatency(firstPixelTime);
+
+    if (!waitForNextFrame(frameTime, priority,
+                          EYES_FRAME_DELAY_MICROSECONDS)) {
+      break;
     }
     frameTime = micros();
+  }
+  return true;
+}
 
-    currentTime = millis();
-    // This is our ADXL and interactions polling to break and trigger specific
-    // animations
-    if (currentTime - lastCheck >= INTERACTION_CHECK_DEBOUNCE) {
-      ADXLDataPolling();
+/**
+ * @brief Play a vector animation with interaction detection
+ *
+ * @param filename Path to the vector file
+ * @param priority Scheduling priority of this emote
+ * @return true if playback completed successfully
+ */
+static bool playVector(const char *filename, EmotePriority priority) {
+  unsigned long durationMs = 0;
 
-      if (menu_isActive()) {
-        ESP_LOGI(GIF_LOG, "Menu active - stopping GIF playback");
-        break;
-      }
+  if (!loadVectorAnimation(filename, &durationMs)) {
+    return false;
+  }
 
-      if (getCurrentMode() == SystemMode::UPDATE_MODE) {
-        break;
-      }
+  unsigned long startTime = millis();
+  uint32_t firstPixelTime = 0;
+  unsigned long frameTime = micros();
+  while (millis() - startTime < durationMs) {
+    if (renderVectorFrame(millis() - startTime) > 0 && firstPixelTime == 0) {
+      firstPixelTime = max<uint32_t>(micros(), 1);
+    }
+    recordReactionLatency(firstPixelTime);
 
-      if (espNowToggledState()) {
-        break;
-      }
-      // NOTE: The order of these checks is important
-      if (motionInteracted()) {
-        if (motionDoubleTapped()) {
-          break;
-        }
-        if (motionTapped()) {
-          break;
-        }
-        if (motionShaking()) {
-          break;
-        }
-        if (motionSuddenAcceleration()) {
-          break;
-        }
-      }
+    if (!waitForNextFrame(frameTime, priority,
+                          VECTOR_FRAME_DELAY_MICROSECONDS)) {
+      break;
+    }
+    frameTime = micros();
+  }
 
-      if ((motionTiltedLeft() || motionTiltedRight() || motionUpsideDown()) && strcmp(filename, CRASH01_EMOTE) != 0 &&
-          strcmp(filename, CRASH02_EMOTE) != 0 && strcmp(filename, SHOCK_EMOTE) != 0) {
-        break;
-      }
+  unloadVectorAnimation();
+  return true;
+}
 
-      lastCheck = currentTime;
+/**
+ * @brief Play a GIF animation with interaction detection
+ *
+ * This is a blocking function that plays a GIF file while monitoring
+ * for interactions that might interrupt the animation. Critical data polling
+ * is performed within this function to ensure timely updates. The frame
+ * buffer is kept between emotes so the next emote starts warm.
+ *
+ * With a scheduled start, frame n is due n frame delays after it instead
+ * of one frame delay after the previous frame.
+ *
+ * @param filename Path to the GIF file to play
+ * @param priority Scheduling priority of this emote
+ * @param scheduled true to pace frames against startMicros
+ * @param startMicros micros() time the first frame is due
+ * @return true if playback completed successfully
+ */
+static bool playGIF(const char *filename, EmotePriority priority,
+                    bool scheduled = false, uint32_t startMicros = 0) {
+  const unsigned long TIMEOUT_MS = 10000;
+  unsigned long startTime = millis();
+
+  if (!loadGIF(filename)) {
+    ESP_LOGE(GIF_LOG, "ERROR: Failed to load GIF File.");
+    return false;
+  }
+
+  if (scheduled) {
+    // Never wait longer than a speaker schedules ahead
+    int32_t early = static_cast<int32_t>(startMicros - micros());
+    if (early > 0 &&
+        !waitForNextFrame(micros(), priority,
+                          min<uint32_t>(early, ESPNOW_PLAYBACK_LEAD_US))) {
+      closeGIF();
+      return true;
     }
+  }
+
+  unsigned long frameTime = micros();
+  uint32_t frameIndex = 0;
+  while (playGIFFrame(false, NULL)) {
+    recordReactionLatency(getFirstPixelTime());
+
+    frameIndex++;
+    bool keepPlaying =
+        scheduled ? waitForNextFrame(startMicros, priority,
+                                     frameIndex * FRAME_DELAY_MICROSECONDS)
+                  : waitForNextFrame(frameTime, priority);
+    if (!keepPlaying) {
+      break;
+    }
+    frameTime = micros();
 
     // Timeout check
-    if (currentTime - startTime > TIMEOUT_MS) {
+    if (millis() - startTime > TIMEOUT_MS) {
       ESP_LOGE(GIF_LOG, "ERROR: GIF playback timeout");
       break;
     }
   }
+  // Single frame GIFs finish on the first playGIFFrame() call
+  recordReactionLatency(getFirstPixelTime());
+  if (scheduled && getFirstPixelTime() != 0) {
+    recordSyncedStart(static_cast<int32_t>(getFirstPixelTime() - startMicros));
+  }
 
-  stopGifPlayback();
+  closeGIF();
   return true;
 }
 
+/**
+ * @brief Play an emote with interaction detection
+ *
+ * The renderer is taken from the emote registry, so dispatch is a table
+ * lookup rather than a path comparison.
+ *
+ * @param emote Emote to play
+ * @param priority Scheduling priority of this emote
+ * @return true if playback completed successfully
+ */
+bool playEmote(EmoteId emote, EmotePriority priority) {
+  const char *path = emotePath(emote);
+  if (!path) {
+    ESP_LOGE(ANIM_LOG, "ERROR: Unknown emote %u", static_cast<uint8_t>(emote));
+    return false;
+  }
+
+  switch (emoteKind(emote)) {
+  case EmoteKind::SCENE:
+    return playScene(path, priority);
+  case EmoteKind::EYES:
+    return playEyes(path, priority);
+  case EmoteKind::VECTOR:
+    return playVector(path, priority);
+  case EmoteKind::GIF:
+  default:
+    return playGIF(path, priority);
+  }
+}
+
+/**
+ * @brief Play an emote starting at a scheduled time
+ *
+ * @param emote Emote to play
+ * @param priority Scheduling priority of this emote
+ * @param startMicros Local micros() time of the first frame
+ * @return true if playback completed successfully
+ */
+bool playEmoteAt(EmoteId emote, EmotePriority priority, uint32_t startMicros) {
+  const char *path = emotePath(emote);
+  if (!path || emoteKind(emote) != EmoteKind::GIF) {
+    return playEmote(emote, priority);
+  }
+  return playGIF(path, priority, true, startMicros);
+}
+
+/**
+ * @brief Play an emote at the priority its registry flags imply
+ *
+ * Orientation emotes play at ORIENTATION so the tilt that started them
+ * doesn't preempt them, communication emotes at COMMS, the rest at IDLE.
+ *
+ * @param emote Emote to play
+ * @return true if playback completed successfully
+ */
+bool playEmote(EmoteId emote) {
+  EmotePriority priority = EmotePriority::IDLE;
+  if (emoteHasFlag(emote, EMOTE_FLAG_ORIENTATION)) {
+    priority = EmotePriority::ORIENTATION;
+  } else if (emoteHasFlag(emote, EMOTE_FLAG_COMMS)) {
+    priority = EmotePriority::COMMS;
+  }
+  return playEmote(emote, priority);
+}
+
 /**
  * @brief Initialize the animation module
  *
@@ -198,52 +599,40 @@ void initializeAnimationModule() {
   animSequence.currentState = SequenceState::REST_START;
   animSequence.stateStartTime = 0;
   animSequence.isIdleMode = true;
+
+  // Registered up front so later lookups by address find the tuned pool
+  resetEmotePools();
+  registerEmotePool(randomEmotes, ARRAY_SIZE(randomEmotes), randomEmoteWeights,
+                    randomEmoteCooldowns);
+
+  // Behavior graph is optional, without it the built-in sequence is used
+  loadBehaviorGraph();
 }
 
 /**
  * @brief Play a random emote from a collection
  *
- * Selects and plays an emote from the provided collection, ensuring
- * that emotes don't repeat until all have been played.
+ * Each collection gets its own shuffle bag in the selector module, so
+ * emotes don't repeat until all have been played even when collections
+ * are interleaved.
  *
- * @param emotes Array of emote file paths
+ * @param emotes Array of emotes
  * @param count Number of emotes in the array
+ * @param priority Scheduling priority of the selected emote
  */
-void randomizeEmotes(const char **emotes, size_t count) {
+void randomizeEmotes(const EmoteId *emotes, size_t count,
+                     EmotePriority priority = EmotePriority::IDLE) {
   if (!emotes || count == 0) {
     ESP_LOGE(ANIM_LOG, "ERROR: Invalid emote parameters");
     return;
   }
 
-  static uint8_t *unplayedEmotes = NULL;
-  static size_t arraySize = 0;
-  static size_t remainingCount = 0;
-
-  // Reallocate if array size changed
-  if (arraySize != count) {
-    if (unplayedEmotes)
-      free(unplayedEmotes);
-    unplayedEmotes = (uint8_t *)malloc(count * sizeof(uint8_t));
-    arraySize = count;
-    remainingCount = 0; // Force reset
+  EmoteId emote = selectEmote(registerEmotePool(emotes, count));
+  if (emote == EmoteId::NONE) {
+    ESP_LOGE(ANIM_LOG, "ERROR: No emote available from pool");
+    return;
   }
-
-  // If no emotes left, reset the pool
-  if (remainingCount == 0) {
-    // Initially fill the unplayed emotes array with all indices
-    for (size_t i = 0; i < count; i++) {
-      unplayedEmotes[i] = i;
-    }
-    remainingCount = count;
-  }
-  // Randomly select from remaining unplayed emotes
-  size_t randomPos = random(remainingCount);
-  uint8_t selectedIndex = unplayedEmotes[randomPos];
-  // Replace the selected emote with the last unplayed emote
-  unplayedEmotes[randomPos] = unplayedEmotes[remainingCount - 1];
-  remainingCount--;
-  // Play the selected emote
-  playGIF(emotes[selectedIndex]);
+  playEmote(emote, priority);
 }
 
 //==============================================================================
@@ -266,21 +655,21 @@ bool checkCrashOrientation() {
     // First time entering crash state
     if (currentCrashState == CrashState::NONE) {
       currentCrashState = CrashState::ENTERING_CRASH;
-      playGIF(CRASH01_EMOTE); // Initial impact animation
+      playEmote(EmoteId::CRASH01); // Initial impact animation
       currentCrashState = CrashState::CRASHED;
       wasCrashed = true;
       return true;
     }
     // Continue being crashed
     else if (currentCrashState == CrashState::CRASHED) {
-      playGIF(CRASH02_EMOTE); // Dizzy/crashed animation loop
+      playEmote(EmoteId::CRASH02); // Dizzy/crashed animation loop
       return true;
     }
   }
   // Recovering from crash
   else if (wasCrashed) {
     currentCrashState = CrashState::RECOVERING;
-    playGIF(CRASH03_EMOTE); // Recovery animation
+    playEmote(EmoteId::CRASH03); // Recovery animation
     currentCrashState = CrashState::NONE;
     wasCrashed = false;
     return true;
@@ -304,21 +693,21 @@ bool handleSleepSequence() {
     // First time entering sleep
     if (currentSleepState == SleepState::NONE) {
       currentSleepState = SleepState::ENTERING_SLEEP;
-      playGIF(SLEEP01_EMOTE); // Play entering sleep animation once
+      playEmote(EmoteId::SLEEP01); // Play entering sleep animation once
       currentSleepState = SleepState::SLEEPING;
       wasAsleep = true;
       return true;
     }
     // Continue sleeping
     else if (currentSleepState == SleepState::SLEEPING) {
-      playGIF(SLEEP02_EMOTE); // Play sleeping animation repeatedly
+      playEmote(EmoteId::SLEEP02); // Play sleeping animation repeatedly
       return true;
     }
   }
   // Waking up from sleep
   else if (wasAsleep) {
     currentSleepState = SleepState::EXITING_SLEEP;
-    playGIF(SLEEP03_EMOTE); // Play waking animation once
+    playEmote(EmoteId::SLEEP03); // Play waking animation once
     currentSleepState = SleepState::NONE;
     wasAsleep = false;
     return true;
@@ -330,58 +719,44 @@ bool handleSleepSequence() {
 /**
  * @brief Handle special device states and related animations
  *
- * Checks for and responds to special states like ESP-NOW toggling,
- * motion interactions, crash states, and sleep states.
+ * Sources are served in priority order: interactions, then orientation,
+ * then ESP-NOW toggling, then sleep.
  *
  * @return true if a special state was handled and animation played
  */
 bool handleSpecialStates() {
-  // If Inactivity timed out and deep sleep kicks in loop REST_EMOTE
-  if (espNowToggledState()) {
-    resetEspNowToggleState();
-    if (getCurrentESPNowState() == ESPNowState::ON) {
-      // ESP-NOW was just turned ON
-      playGIF(COMS_CONNECT_EMOTE); // Play connection animation
-    } else {
-      // ESP-NOW was just turned OFF
-      playGIF(COMS_DISCONNECT_EMOTE); // Play disconnection animation
-    }
-    return true;
-  }
-
+  // If Inactivity timed out and deep sleep kicks in stop playback entirely
   if (motionDeepSleep()) {
-    setMotionState(MotionStateType::DEEP_SLEEP, false);
+    clearMotionEvents();
     stopGifPlayback();
     return true;
   }
 
-  // Check motion interrupts, NOTE: the order of these checks is important
-  if (motionInteracted()) {
-    if (motionShaking()) {
-      setMotionState(MotionStateType::SHAKING, false);
-      playGIF(DIZZY_EMOTE);
-      return true;
-    }
-    if (motionDoubleTapped()) {
-      setMotionState(MotionStateType::DOUBLE_TAPPED, false);
-      playGIF(SHOCK_EMOTE);
-      return true;
-    }
-    if (motionTapped()) {
-      setMotionState(MotionStateType::TAPPED, false);
-      playGIF(TAP_EMOTE);
-      return true;
-    }
-    if (motionSuddenAcceleration()) {
-      setMotionState(MotionStateType::SUDDEN_ACCELERATION, false);
-      playGIF(STARTLED_EMOTE);
-      return true;
+  // Motion events are handled one at a time, in the order they happened
+  MotionEvent event;
+  if (pollMotionEvent(event)) {
+    switch (event.type) {
+    case MotionEventType::SHAKING:
+      playReaction(event, EmoteId::DIZZY);
+      break;
+    case MotionEventType::DOUBLE_TAPPED:
+      playReaction(event, EmoteId::SHOCK);
+      break;
+    case MotionEventType::TAPPED:
+      playReaction(event, EmoteId::TAP);
+      break;
+    case MotionEventType::SUDDEN_ACCELERATION:
+      playReaction(event, EmoteId::STARTLED);
+      break;
+    default:
+      break;
     }
+    return true;
   }
 
   if ((motionHalfTiltedLeft() || motionHalfTiltedRight()) &&
       !motionTiltedLeft() && !motionTiltedRight() && !motionUpsideDown()) {
-    playGIF(SHOCK_EMOTE);
+    playEmote(EmoteId::SHOCK);
     return true;
   }
 
@@ -392,6 +767,18 @@ bool handleSpecialStates() {
     }
   }
 
+  if (espNowToggledState()) {
+    resetEspNowToggleState();
+    if (getCurrentESPNowState() == ESPNowState::ON) {
+      // ESP-NOW was just turned ON
+      playEmote(EmoteId::COMS_CONNECT); // Play connection animation
+    } else {
+      // ESP-NOW was just turned OFF
+      playEmote(EmoteId::COMS_DISCONNECT); // Play disconnection animation
+    }
+    return true;
+  }
+
   // Check sleep state
   if (motionSleep() || wasAsleep) {
     if (handleSleepSequence()) {
@@ -402,6 +789,18 @@ bool handleSpecialStates() {
   return false;
 }
 
+/**
+ * @brief Open an emote's file ahead of playback
+ *
+ * Only GIFs are streamed from an open file, other kinds have nothing to
+ * warm.
+ *
+ * @param emote Emote about to play
+ */
+static void prefetchEmote(EmoteId emote) {
+  prefetchGIF(emoteKind(emote) == EmoteKind::GIF ? emotePath(emote) : nullptr);
+}
+
 /**
  * @brief Handle normal animation sequence when no special states are active
  *
@@ -412,7 +811,7 @@ bool handleSpecialStates() {
 void handleAnimationSequence(unsigned long currentTime) {
   switch (animSequence.currentState) {
   case SequenceState::REST_START:
-    playGIF(WINK_EMOTE);
+    playEmote(EmoteId::EYES_WINK);
     animSequence.stateStartTime = currentTime;
     animSequence.currentState = SequenceState::ANIMATION_CYCLE;
     break;
@@ -428,6 +827,15 @@ void handleAnimationSequence(unsigned long currentTime) {
         emoteCount = ARRAY_SIZE(randomEmotes);
       }
 
+      // Warm the other collection's next emote while this one plays
+      if (animSequence.isIdleMode) {
+        prefetchEmote(peekNextEmote(
+            registerEmotePool(randomEmotes, ARRAY_SIZE(randomEmotes))));
+      } else {
+        prefetchEmote(peekNextEmote(
+            registerEmotePool(restingEmotes, ARRAY_SIZE(restingEmotes))));
+      }
+
       randomizeEmotes(currentEmotes, emoteCount);
       animSequence.isIdleMode = !animSequence.isIdleMode;
 
@@ -440,7 +848,7 @@ void handleAnimationSequence(unsigned long currentTime) {
     break;
 
   case SequenceState::REST_END:
-    playGIF(BLINK_EMOTE);
+    playEmote(EmoteId::EYES_BLINK);
     if (currentTime - animSequence.stateStartTime >= animSequence.IDLE_DELAY) {
       animSequence.currentState = SequenceState::REST_START;
       animSequence.stateStartTime = currentTime;
@@ -449,6 +857,108 @@ void handleAnimationSequence(unsigned long currentTime) {
   }
 }
 
+//==============================================================================
+// BEHAVIOR GRAPH FUNCTIONS
+//==============================================================================
+
+/**
+ * @brief Map a motion event to its behavior trigger
+ *
+ * @param type Motion event type
+ * @return Matching behavior trigger
+ */
+static BehaviorTrigger triggerForMotionEvent(MotionEventType type) {
+  switch (type) {
+  case MotionEventType::DOUBLE_TAPPED:
+    return BehaviorTrigger::DOUBLE_TAPPED;
+  case MotionEventType::SHAKING:
+    return BehaviorTrigger::SHAKING;
+  case MotionEventType::SUDDEN_ACCELERATION:
+    return BehaviorTrigger::SUDDEN_ACCELERATION;
+  case MotionEventType::TAPPED:
+  default:
+    return BehaviorTrigger::TAPPED;
+  }
+}
+
+/**
+ * @brief Play the current behavior state once and report it finished
+ *
+ * @param event Interaction that caused the state, nullptr if none
+ */
+static void playBehaviorState(const MotionEvent *event) {
+  BehaviorAction action = getBehaviorAction();
+  if (action.pool) {
+    randomizeEmotes(action.pool, action.poolCount, action.priority);
+  } else if (action.emote != EmoteId::NONE && event) {
+    playReaction(*event, action.emote, action.priority);
+  } else if (action.emote != EmoteId::NONE) {
+    playEmote(action.emote, action.priority);
+  }
+  fireBehaviorTrigger(BehaviorTrigger::DONE);
+}
+
+/**
+ * @brief Evaluate motion, orientation, comms and sleep triggers
+ *
+ * Triggers are offered in priority order and the first one the current
+ * state has a transition for wins, so each call costs a fixed handful of
+ * table lookups.
+ *
+ * @return true if a trigger was handled and its state played
+ */
+static bool handleBehaviorTriggers() {
+  if (motionDeepSleep()) {
+    clearMotionEvents();
+    stopGifPlayback();
+    return true;
+  }
+
+  MotionEvent event;
+  if (pollMotionEvent(event) &&
+      fireBehaviorTrigger(triggerForMotionEvent(event.type))) {
+    playBehaviorState(&event);
+    return true;
+  }
+
+  bool handled;
+  if (motionTiltedLeft() || motionTiltedRight() || motionUpsideDown()) {
+    handled = fireBehaviorTrigger(BehaviorTrigger::TILTED);
+  } else if (motionHalfTiltedLeft() || motionHalfTiltedRight()) {
+    handled = fireBehaviorTrigger(BehaviorTrigger::HALF_TILTED);
+  } else {
+    handled = fireBehaviorTrigger(BehaviorTrigger::UPRIGHT);
+  }
+
+  if (!handled && espNowToggledState()) {
+    resetEspNowToggleState();
+    handled = fireBehaviorTrigger(getCurrentESPNowState() == ESPNowState::ON
+                                      ? BehaviorTrigger::COMMS_ON
+                                      : BehaviorTrigger::COMMS_OFF);
+  }
+
+  if (!handled) {
+    handled = fireBehaviorTrigger(motionSleep() ? BehaviorTrigger::SLEEP
+                                                : BehaviorTrigger::AWAKE);
+  }
+
+  if (!handled)
+    return false;
+
+  playBehaviorState(nullptr);
+  return true;
+}
+
+/**
+ * @brief Advance the behavior graph when nothing else needs attention
+ */
+static void handleBehaviorSequence() {
+  if (behaviorTimerExpired()) {
+    fireBehaviorTrigger(BehaviorTrigger::TIMER);
+  }
+  playBehaviorState(nullptr);
+}
+
 //==============================================================================
 // PUBLIC API FUNCTIONS
 //==============================================================================
@@ -470,6 +980,11 @@ void playEmotes() {
     return;
   }
 
+  // Playback would stall the transfer's acks and window
+  if (isTransferActive()) {
+    return;
+  }
+
   if (!gifPlayerInitialized()) {
     ESP_LOGE(ANIM_LOG, "ERROR: GIF player not initialized");
     return;
@@ -478,19 +993,21 @@ void playEmotes() {
   unsigned long currentTime = millis();
 
   // Handle special states first (motion interrupts and sleep)
-  if (handleSpecialStates()) {
+  if (behaviorGraphLoaded() ? handleBehaviorTriggers()
+                            : handleSpecialStates()) {
     return;
   }
 
-  if (animSequence.currentState == SequenceState::ANIMATION_CYCLE) {
+  if (behaviorGraphLoaded() ||
+      animSequence.currentState == SequenceState::ANIMATION_CYCLE) {
     if (currentTime - lastCheckComs >= COMS_CHECK_INTERVAL) {
       if (getCurrentESPNowState() == ESPNowState::ON && !isPaired()) {
-        playGIF(COMS_CONNECT_EMOTE);
+        playEmote(EmoteId::COMS_CONNECT);
         lastCheckComs = currentTime;
       }
       // Uncomment this if you want to periodically check when ESP-NOW is turned off
       // else if (getCurrentESPNowState() == ESPNowState::OFF) {
-      //   playGIF(COMS_DISCONNECT_EMOTE);
+      //   playEmote(EmoteId::COMS_DISCONNECT);
       //   lastCheckComs = currentTime;
       // }
     }
@@ -499,17 +1016,28 @@ void playEmotes() {
   if (isPaired()) {
     switch (getCurrentComState()) {
     case ComState::PROCESSING:
-      if (getCurrentAnimationPath() != nullptr) {
-        playGIF(getCurrentAnimationPath());
+      if (getCurrentAnimation() != EmoteId::NONE) {
+        uint32_t startMicros;
+        if (takeScheduledStart(startMicros)) {
+          playEmoteAt(getCurrentAnimation(), EmotePriority::COMMS,
+                      startMicros);
+        } else {
+          playEmote(getCurrentAnimation(), EmotePriority::COMMS);
+        }
       }
       break;
     case ComState::WAITING:
-      playGIF(COMS_IDLE_EMOTE);
+      // Idle filler yields as soon as a message arrives
+      playEmote(EmoteId::COMS_IDLE, EmotePriority::IDLE);
       break;
     }
   } else {
-    resetAnimationPath();
-    handleAnimationSequence(millis());
+    resetCurrentAnimation();
+    if (behaviorGraphLoaded()) {
+      handleBehaviorSequence();
+    } else {
+      handleAnimationSequence(millis());
+    }
   }
 }
 
@@ -523,5 +1051,22 @@ void playBootAnimation() {
     ESP_LOGE(ANIM_LOG, "ERROR: GIF player not initialized");
     return;
   }
-  playGIF(STARTUP_EMOTE);
-}
\ No newline at end of file
+  playEmote(EmoteId::STARTUP);
+}
+
+/**
+ * @brief Get the reaction latency histogram for an interaction type
+ *
+ * @param type Interaction type
+ * @return Copy of the statistics recorded since boot or the last reset
+ */
+ReactionLatencyStats getReactionLatencyStats(MotionEventType type) {
+  return latencyStats[static_cast<size_t>(type)];
+}
+
+/**
+ * @brief Clear all reaction latency histograms
+ */
+void resetReactionLatencyStats() {
+  memset(latencyStats, 0, sizeof(latencyStats));
+}
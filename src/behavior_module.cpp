@@ -0,0 +1,357 @@
+/**
+ * @file behavior_module.cpp
+ * @brief Implementation of the table-driven behavior graph interpreter
+ *
+ * Loads a compiled behavior graph from LittleFS, validates it once, and
+ * evaluates triggers with a single lookup in the state x trigger table.
+ */
+
+#include "behavior_module.h"
+#include "flash_module.h"
+
+//==============================================================================
+// GLOBAL VARIABLES
+//==============================================================================
+
+/** @brief Raw contents of the loaded graph file */
+static uint8_t *graphData = nullptr;
+/** @brief Header of the loaded graph */
+static BehaviorGraphHeader graphHeader;
+/** @brief State records, one per state */
+static const BehaviorStateRecord *graphStates = nullptr;
+/** @brief Dense transition table, stateCount rows of triggerCount entries */
+static const uint8_t *graphTransitions = nullptr;
+/** @brief Pool start/count pairs, one per pool */
+static const uint8_t *graphPools = nullptr;
+/** @brief Emote handles resolved from the string table */
+static EmoteId *emoteIds = nullptr;
+/** @brief Pool members resolved to emote handles, pools are contiguous slices */
+static EmoteId *poolIds = nullptr;
+
+//------------------------------------------------------------------------------
+// Interpreter State
+//------------------------------------------------------------------------------
+/** @brief Current state index */
+static uint8_t currentState = BEHAVIOR_NO_TRANSITION;
+/** @brief State to resume when a transient state returns */
+static uint8_t returnState = BEHAVIOR_NO_TRANSITION;
+/** @brief Time the current state was entered (ms) */
+static unsigned long stateEnteredAt = 0;
+
+//==============================================================================
+// INTERNAL FUNCTIONS
+//==============================================================================
+
+/**
+ * @brief Read a little endian 16-bit value from an unaligned address
+ *
+ * @param data Pointer to the first byte
+ * @return Decoded value
+ */
+static uint16_t readU16(const uint8_t *data) {
+  return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
+/**
+ * @brief Check that every reference in the loaded graph is in range
+ *
+ * Done once at load time so the interpreter never has to bounds check.
+ *
+ * @param strings Start of the string table
+ * @param emoteOffsets Start of the emote offset table
+ * @param poolMembers Start of the pool member table
+ * @return true if the graph is consistent
+ */
+static bool validateGraph(const char *strings, const uint8_t *emoteOffsets,
+                          const uint8_t *poolMembers) {
+  const BehaviorGraphHeader &h = graphHeader;
+
+  if (h.initialState >= h.stateCount) {
+    ESP_LOGE(BEHAVIOR_LOG, "ERROR: Invalid initial state %u", h.initialState);
+    return false;
+  }
+
+  if (h.stringsSize == 0 || strings[h.stringsSize - 1] != '\0') {
+    ESP_LOGE(BEHAVIOR_LOG, "ERROR: Unterminated string table");
+    return false;
+  }
+
+  for (uint8_t i = 0; i < h.emoteCount; i++) {
+    if (readU16(emoteOffsets + i * 2) >= h.stringsSize) {
+      ESP_LOGE(BEHAVIOR_LOG, "ERROR: Emote %u path out of range", i);
+      return false;
+    }
+  }
+
+  for (uint8_t i = 0; i < h.poolCount; i++) {
+    uint8_t start = graphPools[i * 2];
+    uint8_t count = graphPools[i * 2 + 1];
+    if (count == 0 || start + count > h.poolSize) {
+      ESP_LOGE(BEHAVIOR_LOG, "ERROR: Pool %u out of range", i);
+      return false;
+    }
+  }
+
+  for (uint8_t i = 0; i < h.poolSize; i++) {
+    if (poolMembers[i] >= h.emoteCount) {
+      ESP_LOGE(BEHAVIOR_LOG, "ERROR: Pool member %u out of range", i);
+      return false;
+    }
+  }
+
+  for (uint8_t s = 0; s < h.stateCount; s++) {
+    const BehaviorStateRecord &state = graphStates[s];
+    if (state.priority > static_cast<uint8_t>(EmotePriority::INTERACTION)) {
+      ESP_LOGE(BEHAVIOR_LOG, "ERROR: State %u has invalid priority", s);
+      return false;
+    }
+    if (state.emote != BEHAVIOR_NO_EMOTE) {
+      uint8_t limit =
+          (state.flags & BEHAVIOR_FLAG_POOL) ? h.poolCount : h.emoteCount;
+      if (state.emote >= limit) {
+        ESP_LOGE(BEHAVIOR_LOG, "ERROR: State %u emote out of range", s);
+        return false;
+      }
+    }
+    for (uint8_t t = 0; t < h.triggerCount; t++) {
+      uint8_t next = graphTransitions[s * h.triggerCount + t];
+      if (next != BEHAVIOR_NO_TRANSITION && next != BEHAVIOR_RETURN &&
+          next >= h.stateCount) {
+        ESP_LOGE(BEHAVIOR_LOG, "ERROR: State %u trigger %u target invalid", s,
+                 t);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Make a state current
+ *
+ * Entering a transient state from a regular one remembers where to return.
+ *
+ * @param next Target state index or BEHAVIOR_RETURN
+ */
+static void enterState(uint8_t next) {
+  if (next == BEHAVIOR_RETURN) {
+    next = (returnState != BEHAVIOR_NO_TRANSITION) ? returnState
+                                                   : graphHeader.initialState;
+    returnState = BEHAVIOR_NO_TRANSITION;
+  }
+
+  if (next == currentState)
+    return;
+
+  bool nextTransient = graphStates[next].flags & BEHAVIOR_FLAG_TRANSIENT;
+  bool currentTransient = graphStates[currentState].flags &
+                          BEHAVIOR_FLAG_TRANSIENT;
+  if (nextTransient && !currentTransient) {
+    returnState = currentState;
+  }
+
+  currentState = next;
+  stateEnteredAt = millis();
+}
+
+//==============================================================================
+// PUBLIC API FUNCTIONS
+//==============================================================================
+
+/**
+ * @brief Release the loaded behavior graph
+ */
+void unloadBehaviorGraph() {
+  free(graphData);
+  free(emoteIds);
+  free(poolIds);
+  graphData = nullptr;
+  emoteIds = nullptr;
+  poolIds = nullptr;
+  clearRuntimeEmotes();
+  graphStates = nullptr;
+  graphTransitions = nullptr;
+  graphPools = nullptr;
+  currentState = BEHAVIOR_NO_TRANSITION;
+  returnState = BEHAVIOR_NO_TRANSITION;
+}
+
+/**
+ * @brief Load and validate a compiled behavior graph from LittleFS
+ *
+ * @param path Path of the compiled graph
+ * @return true if the graph was loaded and entered its initial state
+ */
+bool loadBehaviorGraph(const char *path) {
+  unloadBehaviorGraph();
+
+  if (!fileExists(path)) {
+    ESP_LOGW(BEHAVIOR_LOG, "No behavior graph at %s, using built-in behavior",
+             path);
+    return false;
+  }
+
+  File file = LittleFS.open(path, "r");
+  size_t fileSize = file ? file.size() : 0;
+  if (fileSize < sizeof(BehaviorGraphHeader) ||
+      fileSize > BEHAVIOR_GRAPH_MAX_SIZE) {
+    ESP_LOGE(BEHAVIOR_LOG, "ERROR: Invalid behavior graph size %u", fileSize);
+    file.close();
+    return false;
+  }
+
+  graphData = (uint8_t *)malloc(fileSize);
+  if (!graphData) {
+    ESP_LOGE(BEHAVIOR_LOG, "ERROR: Failed to allocate %u bytes", fileSize);
+    file.close();
+    return false;
+  }
+  size_t bytesRead = file.read(graphData, fileSize);
+  file.close();
+  if (bytesRead != fileSize) {
+    ESP_LOGE(BEHAVIOR_LOG, "ERROR: Short read on behavior graph");
+    unloadBehaviorGraph();
+    return false;
+  }
+
+  memcpy(&graphHeader, graphData, sizeof(graphHeader));
+  const BehaviorGraphHeader &h = graphHeader;
+  if (memcmp(h.magic, "BHVG", 4) != 0 ||
+      h.version != BEHAVIOR_GRAPH_VERSION ||
+      h.triggerCount !=
+          static_cast<uint8_t>(BehaviorTrigger::BEHAVIOR_TRIGGER_COUNT) ||
+      h.stateCount == 0 || h.totalSize != fileSize) {
+    ESP_LOGE(BEHAVIOR_LOG, "ERROR: Incompatible behavior graph header");
+    unloadBehaviorGraph();
+    return false;
+  }
+
+  // Section sizes are fixed by the header, so the layout is fully known
+  size_t offset = sizeof(BehaviorGraphHeader);
+  size_t statesOffset = offset;
+  offset += h.stateCount * sizeof(BehaviorStateRecord);
+  size_t transitionsOffset = offset;
+  offset += h.stateCount * h.triggerCount;
+  size_t poolsOffset = offset;
+  offset += h.poolCount * 2;
+  size_t membersOffset = offset;
+  offset += h.poolSize;
+  size_t emotesOffset = offset;
+  offset += h.emoteCount * 2;
+  size_t stringsOffset = offset;
+  offset += h.stringsSize;
+  if (offset != fileSize) {
+    ESP_LOGE(BEHAVIOR_LOG, "ERROR: Behavior graph sections do not match size");
+    unloadBehaviorGraph();
+    return false;
+  }
+
+  graphStates =
+      reinterpret_cast<const BehaviorStateRecord *>(graphData + statesOffset);
+  graphTransitions = graphData + transitionsOffset;
+  graphPools = graphData + poolsOffset;
+  const uint8_t *poolMembers = graphData + membersOffset;
+  const uint8_t *emoteOffsets = graphData + emotesOffset;
+  const char *strings = reinterpret_cast<const char *>(graphData + stringsOffset);
+
+  if (!validateGraph(strings, emoteOffsets, poolMembers)) {
+    unloadBehaviorGraph();
+    return false;
+  }
+
+  // Resolve paths to handles once so playback never compares strings
+  emoteIds = (EmoteId *)malloc(max<size_t>(h.emoteCount, 1) * sizeof(EmoteId));
+  poolIds = (EmoteId *)malloc(max<size_t>(h.poolSize, 1) * sizeof(EmoteId));
+  if (!emoteIds || !poolIds) {
+    ESP_LOGE(BEHAVIOR_LOG, "ERROR: Failed to allocate emote tables");
+    unloadBehaviorGraph();
+    return false;
+  }
+  for (uint8_t i = 0; i < h.emoteCount; i++) {
+    emoteIds[i] = registerEmotePath(strings + readU16(emoteOffsets + i * 2));
+    if (emoteIds[i] == EmoteId::NONE) {
+      unloadBehaviorGraph();
+      return false;
+    }
+  }
+  for (uint8_t i = 0; i < h.poolSize; i++) {
+    poolIds[i] = emoteIds[poolMembers[i]];
+  }
+
+  currentState = h.initialState;
+  returnState = BEHAVIOR_NO_TRANSITION;
+  stateEnteredAt = millis();
+  ESP_LOGI(BEHAVIOR_LOG, "Loaded behavior graph: %u states, %u emotes, %u pools",
+           h.stateCount, h.emoteCount, h.poolCount);
+  return true;
+}
+
+/**
+ * @brief Check whether a behavior graph is loaded
+ *
+ * @return true if a graph is loaded
+ */
+bool behaviorGraphLoaded() { return graphData != nullptr; }
+
+/**
+ * @brief Evaluate a trigger against the current state
+ *
+ * @param trigger Trigger to evaluate
+ * @return true if the current state defines a transition for the trigger
+ */
+bool fireBehaviorTrigger(BehaviorTrigger trigger) {
+  if (!graphData)
+    return false;
+
+  uint8_t next = graphTransitions[currentState * graphHeader.triggerCount +
+                                  static_cast<uint8_t>(trigger)];
+  if (next == BEHAVIOR_NO_TRANSITION)
+    return false;
+
+  enterState(next);
+  return true;
+}
+
+/**
+ * @brief Check whether the current state's timer has expired
+ *
+ * @return true if the state has a timer and it has run out
+ */
+bool behaviorTimerExpired() {
+  if (!graphData)
+    return false;
+
+  uint32_t timerMs = graphStates[currentState].timerMs;
+  return timerMs > 0 && millis() - stateEnteredAt >= timerMs;
+}
+
+/**
+ * @brief Get what the current state wants to play
+ *
+ * @return Emote or pool to play and its priority
+ */
+BehaviorAction getBehaviorAction() {
+  BehaviorAction action = {EmoteId::NONE, nullptr, 0, EmotePriority::IDLE};
+  if (!graphData)
+    return action;
+
+  const BehaviorStateRecord &state = graphStates[currentState];
+  action.priority = static_cast<EmotePriority>(state.priority);
+  if (state.emote == BEHAVIOR_NO_EMOTE)
+    return action;
+
+  if (state.flags & BEHAVIOR_FLAG_POOL) {
+    action.pool = poolIds + graphPools[state.emote * 2];
+    action.poolCount = graphPools[state.emote * 2 + 1];
+  } else {
+    action.emote = emoteIds[state.emote];
+  }
+  return action;
+}
+
+/**
+ * @brief Index of the current state
+ *
+ * @return Current state index, or BEHAVIOR_NO_TRANSITION if no graph loaded
+ */
+uint8_t getBehaviorState() { return currentState; }
@@ -0,0 +1,618 @@
+/**
+ * @file compositor_module.cpp
+ * @brief Implementation of the layered sprite compositor
+ *
+ * Layers live in PSRAM. Each frame the compositor advances layer
+ * animations, collects the screen areas that changed, and rebuilds only
+ * those areas one scanline at a time: background, then every layer in
+ * z-order with alpha blending, then the visual effects.
+ */
+
+#include "compositor_module.h"
+#include "display_module.h"
+#include "effects_module.h"
+#include "flash_module.h"
+#include "tilt_module.h"
+
+//==============================================================================
+// TYPE DEFINITIONS
+//==============================================================================
+
+/**
+ * @brief A loaded sprite layer
+ */
+struct CompositorLayer {
+  uint16_t *colors;         /**< Color planes of every frame */
+  uint8_t *alpha;           /**< Alpha planes, nullptr if opaque */
+  uint16_t width;           /**< Frame width */
+  uint16_t height;          /**< Frame height */
+  uint8_t frameCount;       /**< Frames in the strip */
+  uint8_t frame;            /**< Frame currently shown */
+  uint32_t frameDelayMs;    /**< Time per frame */
+  unsigned long frameStart; /**< Time the current frame was shown */
+  int16_t x;                /**< Left edge on screen */
+  int16_t y;                /**< Top edge on screen */
+  int16_t baseX;            /**< Left edge before parallax */
+  int16_t baseY;            /**< Top edge before parallax */
+  int8_t depth;             /**< Parallax shift at full tilt (px), 0 for none */
+  bool slosh;               /**< Parallax follows the slosh spring */
+  bool visible;             /**< Layer is drawn */
+};
+
+//==============================================================================
+// GLOBAL VARIABLES
+//==============================================================================
+
+/** @brief Background pixels, nullptr for a solid color */
+static uint16_t *background = nullptr;
+/** @brief Background color used when no background image is loaded */
+static uint16_t backgroundColor = 0x0000;
+/** @brief Loaded layers in z-order, bottom first */
+static CompositorLayer layers[COMPOSITOR_MAX_LAYERS];
+/** @brief Number of loaded layers */
+static size_t layerCount = 0;
+/** @brief Areas to redraw on the next frame */
+static CompositorRect dirtyRects[COMPOSITOR_MAX_DIRTY_RECTS];
+/** @brief Number of entries in dirtyRects */
+static size_t dirtyCount = 0;
+/** @brief Composited scanline sent to the display */
+static uint16_t lineBuffer[DISPLAY_WIDTH];
+
+//==============================================================================
+// RECTANGLE HELPERS
+//==============================================================================
+
+/**
+ * @brief Clip a rectangle to the screen
+ *
+ * @param rect Rectangle to clip
+ * @return Clipped rectangle, zero-sized if fully off screen
+ */
+static CompositorRect clipToScreen(const CompositorRect &rect) {
+  int16_t x0 = max<int16_t>(rect.x, 0);
+  int16_t y0 = max<int16_t>(rect.y, 0);
+  int16_t x1 = min<int16_t>(rect.x + rect.w, DISPLAY_WIDTH);
+  int16_t y1 = min<int16_t>(rect.y + rect.h, DISPLAY_HEIGHT);
+  if (x1 <= x0 || y1 <= y0) {
+    return {0, 0, 0, 0};
+  }
+  return {x0, y0, static_cast<int16_t>(x1 - x0),
+          static_cast<int16_t>(y1 - y0)};
+}
+
+/**
+ * @brief Smallest rectangle covering two rectangles
+ */
+static CompositorRect unionRect(const CompositorRect &a,
+                                const CompositorRect &b) {
+  int16_t x0 = min(a.x, b.x);
+  int16_t y0 = min(a.y, b.y);
+  int16_t x1 = max<int16_t>(a.x + a.w, b.x + b.w);
+  int16_t y1 = max<int16_t>(a.y + a.h, b.y + b.h);
+  return {x0, y0, static_cast<int16_t>(x1 - x0),
+          static_cast<int16_t>(y1 - y0)};
+}
+
+/**
+ * @brief Check whether two rectangles overlap or touch
+ */
+static bool rectsTouch(const CompositorRect &a, const CompositorRect &b) {
+  return a.x <= b.x + b.w && b.x <= a.x + a.w && a.y <= b.y + b.h &&
+         b.y <= a.y + a.h;
+}
+
+/**
+ * @brief Screen area covered by a layer
+ */
+static CompositorRect layerRect(const CompositorLayer &layer) {
+  return {layer.x, layer.y, static_cast<int16_t>(layer.width),
+          static_cast<int16_t>(layer.height)};
+}
+
+//==============================================================================
+// INTERNAL FUNCTIONS
+//==============================================================================
+
+/**
+ * @brief Free a layer's pixel data
+ */
+static void releaseLayer(CompositorLayer &layer) {
+  heap_caps_free(layer.colors);
+  heap_caps_free(layer.alpha);
+  layer.colors = nullptr;
+  layer.alpha = nullptr;
+}
+
+/**
+ * @brief Load a sprite file into PSRAM
+ *
+ * @param path Sprite file path
+ * @param layer Receives the pixel data and geometry
+ * @param keepAlpha false to skip the alpha planes
+ * @return true if loaded
+ */
+static bool loadSprite(const char *path, CompositorLayer &layer,
+                       bool keepAlpha) {
+  File file = LittleFS.open(path, "r");
+  if (!file) {
+    ESP_LOGE(COMPOSITOR_LOG, "ERROR: Sprite not found: %s", path);
+    return false;
+  }
+
+  SpriteHeader header;
+  if (file.read(reinterpret_cast<uint8_t *>(&header), sizeof(header)) !=
+          sizeof(header) ||
+      memcmp(header.magic, SPRITE_MAGIC, 4) != 0 || header.width == 0 ||
+      header.height == 0 || header.frameCount == 0 ||
+      header.width > DISPLAY_WIDTH || header.height > DISPLAY_HEIGHT) {
+    ESP_LOGE(COMPOSITOR_LOG, "ERROR: Invalid sprite header: %s", path);
+    file.close();
+    return false;
+  }
+
+  size_t pixels = header.width * header.height;
+  bool hasAlpha = header.flags & SPRITE_FLAG_ALPHA;
+  size_t expected = sizeof(header) +
+                    header.frameCount * pixels * (hasAlpha ? 3 : 2);
+  if (file.size() != expected) {
+    ESP_LOGE(COMPOSITOR_LOG, "ERROR: Sprite size mismatch: %s", path);
+    file.close();
+    return false;
+  }
+
+  memset(&layer, 0, sizeof(layer));
+  layer.colors = (uint16_t *)heap_caps_malloc(
+      header.frameCount * pixels * sizeof(uint16_t), MALLOC_CAP_SPIRAM);
+  if (hasAlpha && keepAlpha) {
+    layer.alpha = (uint8_t *)heap_caps_malloc(header.frameCount * pixels,
+                                              MALLOC_CAP_SPIRAM);
+  }
+  if (!layer.colors || (hasAlpha && keepAlpha && !layer.alpha)) {
+    ESP_LOGE(COMPOSITOR_LOG, "ERROR: Failed to allocate sprite: %s", path);
+    releaseLayer(layer);
+    file.close();
+    return false;
+  }
+
+  // The size matched, a short read means the file system failed under us
+  bool complete = true;
+  for (uint8_t f = 0; complete && f < header.frameCount; f++) {
+    size_t colorBytes = pixels * sizeof(uint16_t);
+    complete = file.read(reinterpret_cast<uint8_t *>(layer.colors + f * pixels),
+                         colorBytes) == colorBytes;
+    if (complete && hasAlpha) {
+      if (layer.alpha) {
+        complete = file.read(layer.alpha + f * pixels, pixels) == pixels;
+      } else {
+        complete = file.seek(file.position() + pixels);
+      }
+    }
+  }
+  file.close();
+  if (!complete) {
+    ESP_LOGE(COMPOSITOR_LOG, "ERROR: Truncated sprite: %s", path);
+    releaseLayer(layer);
+    return false;
+  }
+
+  layer.width = header.width;
+  layer.height = header.height;
+  layer.frameCount = header.frameCount;
+  layer.frameDelayMs = header.frameDelayMs;
+  layer.frameStart = millis();
+  layer.visible = true;
+  return true;
+}
+
+/**
+ * @brief Composite one scanline segment into lineBuffer
+ *
+ * @param y Screen row
+ * @param x0 First column
+ * @param width Number of columns
+ */
+static void compositeScanline(int16_t y, int16_t x0, int16_t width) {
+  if (background) {
+    memcpy(lineBuffer, background + y * DISPLAY_WIDTH + x0,
+           width * sizeof(uint16_t));
+  } else {
+    for (int16_t i = 0; i < width; i++) {
+      lineBuffer[i] = backgroundColor;
+    }
+  }
+
+  int16_t x1 = x0 + width;
+  for (size_t l = 0; l < layerCount; l++) {
+    const CompositorLayer &layer = layers[l];
+    if (!layer.visible || y < layer.y || y >= layer.y + layer.height)
+      continue;
+
+    int16_t start = max<int16_t>(x0, layer.x);
+    int16_t end = min<int16_t>(x1, layer.x + layer.width);
+    if (start >= end)
+      continue;
+
+    size_t rowOffset = layer.frame * layer.width * layer.height +
+                       (y - layer.y) * layer.width;
+    const uint16_t *src = layer.colors + rowOffset + (start - layer.x);
+    uint16_t *dst = lineBuffer + (start - x0);
+    int16_t count = end - start;
+
+    if (!layer.alpha) {
+      memcpy(dst, src, count * sizeof(uint16_t));
+      continue;
+    }
+
+    const uint8_t *alpha = layer.alpha + rowOffset + (start - layer.x);
+    for (int16_t i = 0; i < count; i++) {
+      uint8_t a = alpha[i];
+      if (a == 0xFF) {
+        dst[i] = src[i];
+      } else if (a != 0) {
+        dst[i] = blendRGB565(src[i], dst[i], a);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Composite and send one rectangle to the display
+ *
+ * @param rect Clipped screen rectangle
+ */
+static void flushRect(const CompositorRect &rect) {
+  startWrite();
+  setAddrWindow(rect.x, rect.y, rect.w, rect.h);
+  for (int16_t y = rect.y; y < rect.y + rect.h; y++) {
+    compositeScanline(y, rect.x, rect.w);
+    applyEffectsToScanline(lineBuffer, rect.w, y);
+    writePixels(lineBuffer, rect.w);
+  }
+  endWrite();
+}
+
+/**
+ * @brief Place a layer at its base position plus its parallax shift
+ *
+ * @param layer Layer to move
+ * @param tilt Tilt state of the current frame
+ */
+static void applyParallax(CompositorLayer &layer, const TiltState &tilt) {
+  int16_t x = layer.baseX;
+  int16_t y = layer.baseY;
+  if (layer.depth != 0) {
+    float shiftX = layer.slosh ? tilt.sloshX : tilt.tiltX;
+    float shiftY = layer.slosh ? tilt.sloshY : tilt.tiltY;
+    x += lroundf(shiftX * layer.depth);
+    y += lroundf(shiftY * layer.depth);
+  }
+  if (layer.x == x && layer.y == y)
+    return;
+
+  if (layer.visible) {
+    invalidateCompositorRect(layerRect(layer));
+  }
+  layer.x = x;
+  layer.y = y;
+  if (layer.visible) {
+    invalidateCompositorRect(layerRect(layer));
+  }
+}
+
+//==============================================================================
+// PUBLIC API FUNCTIONS
+//==============================================================================
+
+/**
+ * @brief Blend an RGB565 pixel over another
+ *
+ * Red, green and blue are spread across a 32-bit word so all three
+ * channels are blended with a single multiply.
+ *
+ * @param fg Foreground color
+ * @param bg Background color
+ * @param alpha Foreground opacity 0-255
+ * @return Blended color
+ */
+uint16_t blendRGB565(uint16_t fg, uint16_t bg, uint8_t alpha) {
+  uint32_t a = (alpha + 4) >> 3; // 0-32
+  uint32_t f = (fg | (fg << 16)) & 0x07E0F81F;
+  uint32_t b = (bg | (bg << 16)) & 0x07E0F81F;
+  uint32_t result = ((((f - b) * a) >> 5) + b) & 0x07E0F81F;
+  return static_cast<uint16_t>(result | (result >> 16));
+}
+
+/**
+ * @brief Release every layer and the background
+ */
+void clearCompositor() {
+  for (size_t i = 0; i < layerCount; i++) {
+    releaseLayer(layers[i]);
+  }
+  layerCount = 0;
+  heap_caps_free(background);
+  background = nullptr;
+  backgroundColor = 0x0000;
+  dirtyCount = 0;
+}
+
+/**
+ * @brief Mark a screen area for redraw on the next frame
+ *
+ * Touching rectangles are merged. When the list is full everything
+ * collapses into one bounding rectangle.
+ *
+ * @param rect Area to redraw
+ */
+void invalidateCompositorRect(const CompositorRect &rect) {
+  CompositorRect pending = clipToScreen(rect);
+  if (pending.w == 0)
+    return;
+
+  // Merging can make the result touch rectangles it missed before
+  bool merged = true;
+  while (merged) {
+    merged = false;
+    for (size_t i = 0; i < dirtyCount; i++) {
+      if (rectsTouch(pending, dirtyRects[i])) {
+        pending = unionRect(pending, dirtyRects[i]);
+        dirtyRects[i] = dirtyRects[--dirtyCount];
+        merged = true;
+        break;
+      }
+    }
+  }
+
+  if (dirtyCount == COMPOSITOR_MAX_DIRTY_RECTS) {
+    for (size_t i = 0; i < dirtyCount; i++) {
+      pending = unionRect(pending, dirtyRects[i]);
+    }
+    dirtyCount = 0;
+  }
+  dirtyRects[dirtyCount++] = pending;
+}
+
+/**
+ * @brief Load a sprite file as the background layer
+ *
+ * @param path Sprite file path
+ * @return true if loaded
+ */
+bool setCompositorBackground(const char *path) {
+  CompositorLayer sprite;
+  if (!loadSprite(path, sprite, false))
+    return false;
+
+  if (sprite.width != DISPLAY_WIDTH || sprite.height != DISPLAY_HEIGHT) {
+    ESP_LOGE(COMPOSITOR_LOG, "ERROR: Background must be %dx%d: %s",
+             DISPLAY_WIDTH, DISPLAY_HEIGHT, path);
+    releaseLayer(sprite);
+    return false;
+  }
+
+  heap_caps_free(background);
+  // Only the first frame of a background is used
+  background = sprite.colors;
+  invalidateCompositorRect({0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT});
+  return true;
+}
+
+/**
+ * @brief Use a solid color as the background layer
+ *
+ * @param color RGB565 color
+ */
+void setCompositorBackgroundColor(uint16_t color) {
+  heap_caps_free(background);
+  background = nullptr;
+  backgroundColor = color;
+  invalidateCompositorRect({0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT});
+}
+
+/**
+ * @brief Add an animated sprite layer on top of the existing ones
+ *
+ * @param path Sprite file path
+ * @param x Left edge on screen
+ * @param y Top edge on screen
+ * @param frameDelayMs Time per frame, 0 to use the sprite default
+ * @return Layer handle, or COMPOSITOR_INVALID_LAYER on failure
+ */
+int addCompositorLayer(const char *path, int16_t x, int16_t y,
+                       uint32_t frameDelayMs) {
+  if (layerCount >= COMPOSITOR_MAX_LAYERS) {
+    ESP_LOGE(COMPOSITOR_LOG, "ERROR: Too many layers, skipping %s", path);
+    return COMPOSITOR_INVALID_LAYER;
+  }
+
+  CompositorLayer &layer = layers[layerCount];
+  if (!loadSprite(path, layer, true))
+    return COMPOSITOR_INVALID_LAYER;
+
+  layer.x = layer.baseX = x;
+  layer.y = layer.baseY = y;
+  if (frameDelayMs > 0) {
+    layer.frameDelayMs = frameDelayMs;
+  }
+  invalidateCompositorRect(layerRect(layer));
+  return layerCount++;
+}
+
+/**
+ * @brief Move a layer, marking the old and new areas dirty
+ *
+ * @param layer Layer handle
+ * @param x New left edge
+ * @param y New top edge
+ */
+void setCompositorLayerPosition(int layer, int16_t x, int16_t y) {
+  if (layer < 0 || (size_t)layer >= layerCount)
+    return;
+
+  CompositorLayer &l = layers[layer];
+  l.baseX = x;
+  l.baseY = y;
+  applyParallax(l, getTiltState());
+}
+
+/**
+ * @brief Make a layer shift with the device tilt
+ *
+ * @param layer Layer handle
+ * @param depth Shift at full tilt (px), negative moves against the tilt
+ * @param slosh true to follow the spring-damped slosh instead of the tilt
+ */
+void setCompositorLayerDepth(int layer, int8_t depth, bool slosh) {
+  if (layer < 0 || (size_t)layer >= layerCount)
+    return;
+
+  CompositorLayer &l = layers[layer];
+  l.depth = depth;
+  l.slosh = slosh;
+  applyParallax(l, getTiltState());
+}
+
+/**
+ * @brief Show or hide a layer
+ *
+ * @param layer Layer handle
+ * @param visible true to show
+ */
+void setCompositorLayerVisible(int layer, bool visible) {
+  if (layer < 0 || (size_t)layer >= layerCount)
+    return;
+
+  CompositorLayer &l = layers[layer];
+  if (l.visible != visible) {
+    l.visible = visible;
+    invalidateCompositorRect(layerRect(l));
+  }
+}
+
+/**
+ * @brief Advance layer animations and send changed areas to the display
+ *
+ * @return Number of pixels written this frame
+ */
+uint32_t renderCompositorFrame() {
+  unsigned long now = millis();
+  TiltState tilt = getTiltState();
+  for (size_t i = 0; i < layerCount; i++) {
+    CompositorLayer &layer = layers[i];
+    if (layer.depth != 0) {
+      applyParallax(layer, tilt);
+    }
+    if (layer.frameCount < 2 || layer.frameDelayMs == 0)
+      continue;
+
+    unsigned long elapsed = now - layer.frameStart;
+    if (elapsed < layer.frameDelayMs)
+      continue;
+
+    // Skip frames that were missed rather than playing them late
+    unsigned long steps = elapsed / layer.frameDelayMs;
+    layer.frame = (layer.frame + steps) % layer.frameCount;
+    layer.frameStart += steps * layer.frameDelayMs;
+    if (layer.visible) {
+      invalidateCompositorRect(layerRect(layer));
+    }
+  }
+
+  uint32_t pixelsWritten = 0;
+  for (size_t i = 0; i < dirtyCount; i++) {
+    flushRect(dirtyRects[i]);
+    pixelsWritten += dirtyRects[i].w * dirtyRects[i].h;
+  }
+  dirtyCount = 0;
+  return pixelsWritten;
+}
+
+/**
+ * @brief Load a scene file into the compositor
+ *
+ * @param path Scene file path
+ * @param durationMs Receives the scene duration (ms)
+ * @return true if the background and every layer loaded
+ */
+bool loadCompositorScene(const char *path, unsigned long *durationMs) {
+  clearCompositor();
+  *durationMs = SCENE_DEFAULT_DURATION_MS;
+
+  File file = LittleFS.open(path, "r");
+  if (!file) {
+    ESP_LOGE(COMPOSITOR_LOG, "ERROR: Scene not found: %s", path);
+    return false;
+  }
+
+  bool ok = true;
+  char spritePath[64];
+  while (ok && file.available()) {
+    String line = file.readStringUntil('\n');
+    line.trim();
+    if (line.length() == 0 || line.startsWith("#"))
+      continue;
+
+    const char *text = line.c_str();
+    unsigned int color = 0;
+    unsigned long duration = 0;
+    int x = 0, y = 0, depth = 0;
+    unsigned long frameMs = 0;
+    char mode[8] = "";
+    if (sscanf(text, "background 0x%x", &color) == 1) {
+      setCompositorBackgroundColor(static_cast<uint16_t>(color));
+    } else if (sscanf(text, "background %63s", spritePath) == 1) {
+      ok = setCompositorBackground(spritePath);
+    } else if (sscanf(text, "duration %lu", &duration) == 1) {
+      *durationMs = duration;
+    } else if (sscanf(text, "layer %63s %d %d %lu %d %7s", spritePath, &x, &y,
+                      &frameMs, &depth, mode) >= 3) {
+      int layer = addCompositorLayer(spritePath, x, y, frameMs);
+      ok = layer != COMPOSITOR_INVALID_LAYER;
+      if (ok && depth != 0) {
+        setCompositorLayerDepth(layer, constrain(depth, -64, 64),
+                                strcmp(mode, "slosh") == 0);
+      }
+    } else {
+      ESP_LOGW(COMPOSITOR_LOG, "Ignoring scene line: %s", text);
+    }
+  }
+  file.close();
+
+  if (!ok) {
+    clearCompositor();
+    return false;
+  }
+
+  // The screen still shows the previous emote, redraw everything once
+  invalidateCompositorRect({0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT});
+  return true;
+}
+
+/**
+ * @brief Check whether any layer follows the device tilt
+ *
+ * @return true if the scene needs motion-reactive frames
+ */
+bool compositorMotionReactive() {
+  for (size_t i = 0; i < layerCount; i++) {
+    if (layers[i].depth != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Check whether a path names a composited scene
+ *
+ * @param path Emote path
+ * @return true if the path ends with SCENE_EXTENSION
+ */
+bool isCompositorScene(const char *path) {
+  if (!path)
+    return false;
+  size_t length = strlen(path);
+  size_t extensionLength = strlen(SCENE_EXTENSION);
+  return length > extensionLength &&
+         strcmp(path + length - extensionLength, SCENE_EXTENSION) == 0;
+}
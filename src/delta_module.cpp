@@ -0,0 +1,329 @@
+/**
+ * @file delta_module.cpp
+ * @brief Implementation of delta firmware updates against the running firmware
+ *
+ * The patch is parsed as a stream: the header and each record header are
+ * collected a byte at a time, diff and extra bytes are handled in place in
+ * the caller's buffer. Nothing but the current record is ever held.
+ */
+
+#include "delta_module.h"
+#include <Update.h>
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+#include <mbedtls/sha256.h>
+
+//==============================================================================
+// TYPE DEFINITIONS
+//==============================================================================
+
+/**
+ * @brief Part of the patch being parsed
+ */
+enum class DeltaStage : uint8_t {
+  HEADER, /**< Collecting the patch header */
+  RECORD, /**< Collecting a record header */
+  DIFF,   /**< Adding diff bytes to old bytes */
+  EXTRA,  /**< Copying extra bytes */
+  DONE    /**< New image complete, nothing more may follow */
+};
+
+//==============================================================================
+// GLOBAL VARIABLES
+//==============================================================================
+
+/** @brief A patch is being applied */
+static bool deltaActive = false;
+/** @brief Part of the patch being parsed */
+static DeltaStage stage = DeltaStage::HEADER;
+/** @brief Patch header, also holds the record header being collected */
+static uint8_t headerBuffer[DELTA_HEADER_SIZE];
+/** @brief Bytes collected in headerBuffer */
+static size_t headerCount = 0;
+/** @brief Running app partition the old bytes are read from */
+static const esp_partition_t *oldPartition = nullptr;
+/** @brief Size of the firmware the patch was made against */
+static uint32_t oldSize = 0;
+/** @brief Size of the firmware the patch produces */
+static uint32_t newSize = 0;
+/** @brief Expected SHA-256 of the new firmware */
+static uint8_t newHash[DELTA_HASH_SIZE];
+/** @brief Position in the old firmware, may leave it between records */
+static int64_t oldPos = 0;
+/** @brief Diff bytes left in the current record */
+static uint32_t diffLeft = 0;
+/** @brief Extra bytes left in the current record */
+static uint32_t extraLeft = 0;
+/** @brief Old position change after the current record */
+static int32_t recordSeek = 0;
+/** @brief New firmware bytes written */
+static size_t outputSize = 0;
+/** @brief SHA-256 of the new firmware bytes written */
+static mbedtls_sha256_context outputHash;
+/** @brief Old firmware bytes being combined with diff bytes */
+static uint8_t readBuffer[DELTA_READ_BUFFER_SIZE];
+/** @brief Why applying the patch failed */
+static const char *deltaError = "";
+
+/** @brief SHA-256 of the running firmware */
+static uint8_t runningHash[DELTA_HASH_SIZE];
+/** @brief runningHash has been computed */
+static bool runningHashValid = false;
+
+//==============================================================================
+// UTILITY FUNCTIONS
+//==============================================================================
+
+/**
+ * @brief Record why applying the patch failed
+ *
+ * @param message Error message
+ * @return false, for use in a return statement
+ */
+static bool fail(const char *message) {
+  deltaError = message;
+  ESP_LOGE(DELTA_LOG, "%s after %u image bytes", message,
+           (unsigned)outputSize);
+  return false;
+}
+
+/**
+ * @brief Read a little endian uint32
+ *
+ * @param in Four bytes
+ * @return Value
+ */
+static uint32_t getUint32(const uint8_t *in) {
+  return in[0] | (in[1] << 8) | (in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+/**
+ * @brief Write new firmware bytes to Update and hash them
+ *
+ * @param data Image bytes
+ * @param length Number of bytes
+ * @return true if Update took every byte
+ */
+static bool writeOutput(uint8_t *data, size_t length) {
+  if (Update.write(data, length) != length) {
+    return fail("Flash write failed");
+  }
+  mbedtls_sha256_update(&outputHash, data, length);
+  outputSize += length;
+  return true;
+}
+
+//==============================================================================
+// PATCH PARSING
+//==============================================================================
+
+/**
+ * @brief Check a complete patch header against the running firmware
+ *
+ * @return true if the patch applies to the running firmware
+ */
+static bool parseHeader() {
+  if (memcmp(headerBuffer, DELTA_MAGIC, 4) != 0) {
+    return fail("Not a delta patch");
+  }
+  oldSize = getUint32(headerBuffer + 4);
+  const uint8_t *oldHash = headerBuffer + 8;
+  newSize = getUint32(headerBuffer + 8 + DELTA_HASH_SIZE);
+  memcpy(newHash, headerBuffer + 12 + DELTA_HASH_SIZE, DELTA_HASH_SIZE);
+
+  oldPartition = esp_ota_get_running_partition();
+  const esp_partition_t *target = esp_ota_get_next_update_partition(NULL);
+  if (!oldPartition || !target) {
+    return fail("Failed to get OTA partitions");
+  }
+  // Records may only read the bytes the running firmware hash covers
+  if (oldSize != ESP.getSketchSize()) {
+    return fail("Patch is for a firmware of another size");
+  }
+  const uint8_t *hash = getRunningFirmwareHash();
+  if (!hash || memcmp(hash, oldHash, DELTA_HASH_SIZE) != 0) {
+    return fail("Patch is for a different firmware");
+  }
+  if (newSize == 0 || newSize > target->size) {
+    return fail("Patched firmware does not fit the partition");
+  }
+
+  ESP_LOGI(DELTA_LOG, "Patching %u byte firmware into %u bytes",
+           (unsigned)oldSize, (unsigned)newSize);
+  return true;
+}
+
+/**
+ * @brief Check a complete record header and start on its bytes
+ *
+ * @return true if the record stays inside both images
+ */
+static bool parseRecord() {
+  diffLeft = getUint32(headerBuffer);
+  extraLeft = getUint32(headerBuffer + 4);
+  recordSeek = static_cast<int32_t>(getUint32(headerBuffer + 8));
+
+  if ((uint64_t)diffLeft + extraLeft > newSize - outputSize) {
+    return fail("Patch record runs past the new firmware");
+  }
+  if (oldPos < 0 || oldPos + diffLeft > oldSize) {
+    return fail("Patch record runs past the old firmware");
+  }
+  return true;
+}
+
+/**
+ * @brief Move on once the current record's bytes are used up
+ */
+static void nextRecord() {
+  if (diffLeft > 0) {
+    stage = DeltaStage::DIFF;
+  } else if (extraLeft > 0) {
+    stage = DeltaStage::EXTRA;
+  } else {
+    oldPos += recordSeek;
+    stage = (outputSize == newSize) ? DeltaStage::DONE : DeltaStage::RECORD;
+  }
+  headerCount = 0;
+}
+
+//==============================================================================
+// PUBLIC API FUNCTIONS
+//==============================================================================
+
+const uint8_t *getRunningFirmwareHash() {
+  if (runningHashValid) {
+    return runningHash;
+  }
+  const esp_partition_t *running = esp_ota_get_running_partition();
+  if (!running) {
+    return nullptr;
+  }
+
+  mbedtls_sha256_context hash;
+  mbedtls_sha256_init(&hash);
+  mbedtls_sha256_starts(&hash, 0);
+
+  uint32_t size = ESP.getSketchSize();
+  bool ok = true;
+  uint8_t buffer[256];
+  for (uint32_t offset = 0; offset < size && ok; offset += sizeof(buffer)) {
+    size_t length = min<uint32_t>(sizeof(buffer), size - offset);
+    ok = esp_partition_read(running, offset, buffer, length) == ESP_OK;
+    mbedtls_sha256_update(&hash, buffer, length);
+  }
+
+  mbedtls_sha256_finish(&hash, runningHash);
+  mbedtls_sha256_free(&hash);
+  runningHashValid = ok;
+  return ok ? runningHash : nullptr;
+}
+
+void beginDelta() {
+  abortDelta();
+  deltaActive = true;
+  stage = DeltaStage::HEADER;
+  headerCount = 0;
+  oldPos = 0;
+  outputSize = 0;
+  deltaError = "";
+  mbedtls_sha256_init(&outputHash);
+  mbedtls_sha256_starts(&outputHash, 0);
+}
+
+bool deltaWrite(const uint8_t *data, size_t length) {
+  if (!deltaActive) {
+    return fail("Not applying a patch");
+  }
+
+  while (length > 0) {
+    size_t count;
+    switch (stage) {
+    case DeltaStage::HEADER:
+    case DeltaStage::RECORD: {
+      size_t wanted = (stage == DeltaStage::HEADER) ? DELTA_HEADER_SIZE
+                                                    : DELTA_RECORD_SIZE;
+      count = min(length, wanted - headerCount);
+      memcpy(headerBuffer + headerCount, data, count);
+      headerCount += count;
+      if (headerCount == wanted) {
+        if (!(stage == DeltaStage::HEADER ? parseHeader() : parseRecord())) {
+          return false;
+        }
+        if (stage == DeltaStage::HEADER) {
+          stage = DeltaStage::RECORD;
+          headerCount = 0;
+        } else {
+          nextRecord();
+        }
+      }
+      break;
+    }
+    case DeltaStage::DIFF:
+      count = min<size_t>(min<size_t>(length, diffLeft), sizeof(readBuffer));
+      if (esp_partition_read(oldPartition, oldPos, readBuffer, count) !=
+          ESP_OK) {
+        return fail("Reading the running firmware failed");
+      }
+      for (size_t i = 0; i < count; i++) {
+        readBuffer[i] += data[i];
+      }
+      if (!writeOutput(readBuffer, count)) {
+        return false;
+      }
+      oldPos += count;
+      diffLeft -= count;
+      if (diffLeft == 0) {
+        nextRecord();
+      }
+      break;
+    case DeltaStage::EXTRA:
+      count = min<size_t>(length, extraLeft);
+      // Update.write() only reads from the buffer
+      if (!writeOutput(const_cast<uint8_t *>(data), count)) {
+        return false;
+      }
+      extraLeft -= count;
+      if (extraLeft == 0) {
+        nextRecord();
+      }
+      break;
+    default:
+      return fail("Data after the end of the patch");
+    }
+    data += count;
+    length -= count;
+  }
+  return true;
+}
+
+bool endDelta() {
+  if (!deltaActive) {
+    return fail("Not applying a patch");
+  }
+
+  bool ok = true;
+  uint8_t digest[DELTA_HASH_SIZE];
+  mbedtls_sha256_finish(&outputHash, digest);
+  if (stage != DeltaStage::DONE) {
+    ok = fail("Patch is incomplete");
+  } else if (memcmp(digest, newHash, DELTA_HASH_SIZE) != 0) {
+    ok = fail("Patched firmware hash mismatch");
+  } else {
+    ESP_LOGI(DELTA_LOG, "Patched firmware verified, %u bytes",
+             (unsigned)outputSize);
+  }
+  abortDelta();
+  return ok;
+}
+
+void abortDelta() {
+  if (deltaActive) {
+    mbedtls_sha256_free(&outputHash);
+  }
+  deltaActive = false;
+}
+
+size_t getDeltaOutputSize() { return outputSize; }
+
+const char *getDeltaError() { return deltaError; }
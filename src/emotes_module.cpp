@@ -1,7 +1,119 @@
 #include "emotes_module.h"
+#include "compositor_module.h"
+#include "eyes_module.h"
+#include "vector_module.h"
 
 const char* deviceMode;
 
+//==============================================================================
+// EMOTE REGISTRY
+//==============================================================================
+
+/** @brief Number of built-in emotes, the first runtime handle */
+static const uint8_t BUILTIN_EMOTE_COUNT =
+    static_cast<uint8_t>(EmoteId::BUILTIN_COUNT);
+/** @brief Emotes registered at runtime, handles follow the built-ins */
+static EmoteInfo runtimeEmotes[EMOTE_RUNTIME_MAX_COUNT];
+/** @brief Number of runtime emotes */
+static uint8_t runtimeEmoteCount = 0;
+
+/**
+ * @brief Registry entry of an emote
+ *
+ * @param id Emote handle
+ * @return Entry, or nullptr for an unknown handle
+ */
+static const EmoteInfo *emoteInfo(EmoteId id) {
+  uint8_t index = static_cast<uint8_t>(id);
+  if (index < BUILTIN_EMOTE_COUNT)
+    return &BUILTIN_EMOTES[index];
+  index -= BUILTIN_EMOTE_COUNT;
+  return (index < runtimeEmoteCount) ? &runtimeEmotes[index] : nullptr;
+}
+
+/**
+ * @brief Get the handle for an emote path, registering it if needed
+ *
+ * @param path Emote path, must outlive the handle
+ * @return Emote handle, or EmoteId::NONE if the runtime table is full
+ */
+EmoteId registerEmotePath(const char *path) {
+  if (!path)
+    return EmoteId::NONE;
+
+  for (uint8_t i = 0; i < BUILTIN_EMOTE_COUNT; i++) {
+    if (strcmp(BUILTIN_EMOTES[i].path, path) == 0)
+      return static_cast<EmoteId>(i);
+  }
+  for (uint8_t i = 0; i < runtimeEmoteCount; i++) {
+    if (strcmp(runtimeEmotes[i].path, path) == 0)
+      return static_cast<EmoteId>(BUILTIN_EMOTE_COUNT + i);
+  }
+
+  if (runtimeEmoteCount >= EMOTE_RUNTIME_MAX_COUNT) {
+    ESP_LOGE(EMOTES_LOG, "ERROR: No room to register %s", path);
+    return EmoteId::NONE;
+  }
+
+  EmoteInfo &info = runtimeEmotes[runtimeEmoteCount];
+  info.path = path;
+  info.flags = 0;
+  if (isCompositorScene(path)) {
+    info.kind = EmoteKind::SCENE;
+  } else if (isProceduralEyes(path)) {
+    info.kind = EmoteKind::EYES;
+    info.flags = EMOTE_FLAG_PROCEDURAL;
+  } else if (isVectorAnimation(path)) {
+    info.kind = EmoteKind::VECTOR;
+  } else {
+    info.kind = EmoteKind::GIF;
+  }
+  return static_cast<EmoteId>(BUILTIN_EMOTE_COUNT + runtimeEmoteCount++);
+}
+
+/**
+ * @brief Forget every emote added by registerEmotePath()
+ */
+void clearRuntimeEmotes() { runtimeEmoteCount = 0; }
+
+/**
+ * @brief Path of an emote
+ *
+ * @param id Emote handle
+ * @return Emote path, or nullptr for an unknown handle
+ */
+const char *emotePath(EmoteId id) {
+  const EmoteInfo *info = emoteInfo(id);
+  return info ? info->path : nullptr;
+}
+
+/**
+ * @brief Renderer of an emote
+ *
+ * @param id Emote handle
+ * @return Emote kind, GIF for an unknown handle
+ */
+EmoteKind emoteKind(EmoteId id) {
+  const EmoteInfo *info = emoteInfo(id);
+  return info ? info->kind : EmoteKind::GIF;
+}
+
+/**
+ * @brief Check an emote flag
+ *
+ * @param id Emote handle
+ * @param flag EMOTE_FLAG_* bit
+ * @return true if the emote has the flag
+ */
+bool emoteHasFlag(EmoteId id, uint8_t flag) {
+  const EmoteInfo *info = emoteInfo(id);
+  return info && (info->flags & flag);
+}
+
+//==============================================================================
+// STATIC IMAGES
+//==============================================================================
+
  /**
   * @brief Static images stored as c arrays
   */
@@ -5,44 +5,248 @@
  * This module provides functions for device-to-device communication using
  * ESP-NOW, including device discovery, pairing, message exchange, and state
  * management. It handles animations tied to different conversation types.
+ *
+ * Peers live in a fixed array indexed through an open-addressing hash of
+ * their MAC address, so finding the sender of a frame costs the same no
+ * matter how many bots are in the group.
+ *
+ * The radio is only reached through an EspNowTransport, see
+ * setEspNowTransport().
+ *
+ * The ESP-NOW callbacks run in the WiFi task. They only validate frames and
+ * copy them into an SPSC queue, acks and every state change happen in
+ * handleCommunication() on the main loop.
  */
 
 #include "espnow_module.h"
 #include "common.h"
 #include "emotes_module.h"
 #include "motion_module.h"
+#include "spsc_queue.h"
 #include "system_module.h"
+#include "transfer_module.h"
+
+//==============================================================================
+// TYPE DEFINITIONS
+//==============================================================================
+
+/**
+ * @brief A frame under construction, records are appended after the header
+ */
+struct FrameBatch {
+  uint8_t data[ESPNOW_MAX_FRAME_SIZE]; /**< Header followed by records */
+  size_t length;                       /**< Bytes used in data */
+  uint8_t recordCount;                 /**< Records in data */
+  uint8_t flags;                       /**< FRAME_FLAG_* bits */
+};
+
+/**
+ * @brief A sent reliable frame kept for retransmission
+ */
+struct InFlightFrame {
+  FrameBatch frame;          /**< Frame as sent */
+  uint8_t mac[6];            /**< Destination */
+  uint16_t sequence;         /**< Sequence number the ack must carry */
+  uint8_t retries;           /**< Retransmissions so far */
+  unsigned long firstSentAt; /**< First transmission (ms) */
+  unsigned long lastSentAt;  /**< Latest transmission (ms) */
+  bool active;               /**< Flag indicating an ack is awaited */
+};
+
+/**
+ * @brief A validated frame handed from the receive callback to the main loop
+ */
+struct ReceivedFrame {
+  uint8_t mac[6];                      /**< Sender */
+  uint8_t length;                      /**< Frame length */
+  unsigned long receivedAt;            /**< Arrival time (ms) */
+  uint32_t receivedAtUs;               /**< Arrival time (us), for clock sync */
+  uint8_t data[ESPNOW_MAX_FRAME_SIZE]; /**< Frame bytes */
+};
+
+/**
+ * @brief One round trip against the reference clock
+ */
+struct ClockSample {
+  int32_t offsetUs; /**< Shared minus local clock (us) */
+  uint32_t delayUs; /**< Round trip without the responder's hold time */
+  uint32_t localUs; /**< Local time the response arrived */
+};
+
+/**
+ * @brief Progress of a pairing handshake with a device not yet a peer
+ */
+enum class HandshakeState : uint8_t {
+  NONE,        /**< Entry unused */
+  REQUEST_DUE, /**< Request waits out its jitter */
+  REQUESTED,   /**< Request sent, waiting for the accept */
+  ACCEPTED     /**< Slot reserved, waiting for the confirm */
+};
+
+/**
+ * @brief A pairing handshake in progress, holds a peer slot while it runs
+ */
+struct Handshake {
+  uint8_t mac[6];       /**< Other device */
+  HandshakeState state; /**< Progress */
+  uint8_t attempts;     /**< Requests sent so far */
+  unsigned long dueAt;  /**< Next send or give-up time */
+};
+
+/**
+ * @brief An entry of the peer table
+ */
+struct PeerEntry {
+  uint8_t mac[6];                /**< Peer MAC address */
+  DeviceRole role;               /**< This device's role towards the peer */
+  unsigned long lastSeen;        /**< Last valid frame from the peer (ms) */
+  uint8_t linkQuality;           /**< Ack success average, 0 to 255 */
+  uint16_t lastRxSequence;       /**< Newest reliable sequence received */
+  bool rxSequenceValid;          /**< Flag indicating lastRxSequence is set */
+  int consecutiveFailures;       /**< Undelivered frames in a row */
+  bool replyRequested;           /**< Flag indicating a reply is owed */
+  unsigned long replyRequestAt;  /**< When the reply was requested (ms) */
+  FrameBatch batch;              /**< Records queued for the peer */
+  InFlightFrame inFlight;        /**< Reliable frame waiting for its ack */
+  uint8_t slot;                  /**< Hash slot pointing at this entry */
+  bool used;                     /**< Flag indicating the entry holds a peer */
+};
 
 //==============================================================================
 // GLOBAL CONSTANTS AND VARIABLES
 //==============================================================================
 
-/** @brief Maximum consecutive communication failures before reset */
+/** @brief Maximum consecutive undelivered frames before a peer is dropped */
 const int MAX_FAILURES = 4;
-/** @brief Maximum discovery broadcast attempts before reset */
-const int MAX_BROADCAST_ATTEMPTS = 30;
-/** @brief Currently active animation path */
-static const char *currentAnimationPath = nullptr;
-
-/** @brief Mapping of conversation types to animation paths */
-static const ConversationConfig CONVERSATIONS[] = {
-    {ConversationType::HELLO, COMS_HELLO_EMOTE},
-    {ConversationType::QUESTION_01, COMS_TALK_01_EMOTE},
-    {ConversationType::QUESTION_02, COMS_TALK_02_EMOTE},
-    {ConversationType::QUESTION_03, COMS_TALK_03_EMOTE},
-    {ConversationType::AGREE, COMS_AGREED_EMOTE},
-    {ConversationType::DISAGREE, COMS_DISAGREE_EMOTE},
-    {ConversationType::YELL, COMS_YELL_EMOTE},
-    {ConversationType::LAUGH, COMS_LAUGH_EMOTE},
-    {ConversationType::WINK, COMS_WINK_EMOTE},
-    {ConversationType::ZONE, COMS_ZONED_EMOTE},
-    {ConversationType::SHOCK, COMS_SHOCK_EMOTE}};
+/** @brief Emote of the current conversation message */
+static EmoteId currentAnimation = EmoteId::NONE;
+
+/** @brief Conversation emotes, indexed by ConversationType */
+static constexpr EmoteId CONVERSATION_EMOTES[] = {
+    EmoteId::COMS_HELLO,    // HELLO
+    EmoteId::COMS_TALK_01,  // QUESTION_01
+    EmoteId::COMS_TALK_02,  // QUESTION_02
+    EmoteId::COMS_TALK_03,  // QUESTION_03
+    EmoteId::COMS_AGREED,   // AGREE
+    EmoteId::COMS_DISAGREE, // DISAGREE
+    EmoteId::COMS_YELL,     // YELL
+    EmoteId::COMS_LAUGH,    // LAUGH
+    EmoteId::COMS_WINK,     // WINK
+    EmoteId::COMS_ZONED,    // ZONE
+    EmoteId::COMS_SHOCK,    // SHOCK
+};
+/** @brief Number of conversation types */
+const size_t CONVERSATION_COUNT =
+    static_cast<size_t>(ConversationType::CONVERSATION_TYPE_COUNT);
+static_assert(sizeof(CONVERSATION_EMOTES) / sizeof(CONVERSATION_EMOTES[0]) ==
+                  CONVERSATION_COUNT,
+              "Every conversation type needs an emote");
+
+/** @brief Replies a listener picks from when asked a question */
+static constexpr ConversationType REPLY_TYPES[] = {
+    ConversationType::AGREE, ConversationType::DISAGREE,
+    ConversationType::LAUGH, ConversationType::WINK};
+/** @brief Number of reply types */
+const size_t REPLY_COUNT = sizeof(REPLY_TYPES) / sizeof(REPLY_TYPES[0]);
+
+//------------------------------------------------------------------------------
+// Peer Table
+//------------------------------------------------------------------------------
+/** @brief Hash slot that never held a peer, ends a lookup */
+const int8_t SLOT_EMPTY = -1;
+/** @brief Hash slot of a removed peer, lookups continue past it */
+const int8_t SLOT_DELETED = -2;
+/** @brief Speaker index meaning this device */
+const int SELF_TURN = ESPNOW_MAX_PEERS;
+/** @brief Initial link quality of a new peer */
+const uint8_t LINK_QUALITY_INITIAL = 128;
+
+/** @brief Peer entries */
+static PeerEntry peers[ESPNOW_MAX_PEERS];
+/** @brief MAC hash slots holding peer indices or SLOT_EMPTY/SLOT_DELETED */
+static int8_t peerSlots[ESPNOW_PEER_SLOTS];
+/** @brief Number of used peer entries */
+static uint8_t peerCount = 0;
+/** @brief Peers with a larger MAC address, 0 makes this device coordinator */
+static uint8_t peersAboveMe = 0;
+/** @brief This device's MAC address */
+static uint8_t ownMac[6] = {0};
+/** @brief Last speaker handed a turn, SELF_TURN for this device */
+static int turnCursor = SELF_TURN;
+/** @brief Last listener asked for a reply */
+static int replyCursor = 0;
+
+//------------------------------------------------------------------------------
+// Clock Sync
+//------------------------------------------------------------------------------
+/** @brief Largest conversation payload: type, flags and start time */
+const uint8_t CONVERSATION_PAYLOAD_MAX = 2 + sizeof(uint32_t);
+
+/** @brief Recent round trips, the fastest one sets the offset */
+static ClockSample clockSamples[ESPNOW_CLOCK_SAMPLES];
+/** @brief Valid entries in clockSamples */
+static uint8_t clockSampleCount = 0;
+/** @brief Entry of clockSamples written next */
+static uint8_t clockSampleNext = 0;
+/** @brief MAC address of the peer whose clock is the shared clock */
+static uint8_t clockRefMac[6] = {0};
+/** @brief Flag indicating clockRefMac names a peer */
+static bool hasClockRef = false;
+/** @brief Shared minus local clock at clockBaseLocal (us) */
+static int32_t clockOffset = 0;
+/** @brief Local time clockOffset was measured at */
+static uint32_t clockBaseLocal = 0;
+/** @brief Round trip of the sample in use (us) */
+static uint32_t clockDelay = 0;
+/** @brief Shared clock rate minus ours, as a fraction */
+static float clockDrift = 0;
+/** @brief Flag indicating clockDrift holds an estimate */
+static bool clockDriftValid = false;
+/** @brief Sample the next drift estimate is measured from */
+static ClockSample driftAnchor;
+/** @brief Flag indicating driftAnchor holds a sample */
+static bool driftAnchorValid = false;
+/** @brief Last time a clock sync request was sent */
+static unsigned long lastClockRequest = 0;
+
+/** @brief Local start of the current conversation emote */
+static uint32_t scheduledStart = 0;
+/** @brief Flag indicating scheduledStart is waiting to be taken */
+static bool startScheduled = false;
+/** @brief Emotes started against a scheduled time */
+static uint32_t syncedStarts = 0;
+/** @brief Sum of their start errors (us) */
+static uint64_t totalStartErrorUs = 0;
+/** @brief Worst start error (us) */
+static uint32_t maxStartErrorUs = 0;
+
+//------------------------------------------------------------------------------
+// Callback Handoff
+//------------------------------------------------------------------------------
+/** @brief Frames from the receive callback waiting for the main loop */
+static SPSCQueue<ReceivedFrame, ESPNOW_RX_QUEUE_SIZE> rxQueue;
+/** @brief Overflow count of rxQueue already added to the statistics */
+static uint32_t rxOverflowsCounted = 0;
+/** @brief Frames rejected by the receive callback, drained into stats */
+static std::atomic<uint32_t> callbackMalformed{0};
+/** @brief Radio failures reported to the send callback, drained into stats */
+static std::atomic<uint32_t> callbackLinkFailures{0};
+
+//------------------------------------------------------------------------------
+// Frame Protocol State
+//------------------------------------------------------------------------------
+/** @brief Ack frame, rebuilt for every ack */
+static FrameBatch ackFrame;
+/** @brief Sequence number of the next frame sent */
+static uint16_t txSequence = 0;
+/** @brief Delivery and airtime statistics */
+static EspNowStats stats = {};
+/** @brief Last time the statistics were logged */
+static unsigned long lastStatsLog = 0;
 
 //------------------------------------------------------------------------------
 // Communication States
 //------------------------------------------------------------------------------
-/** @brief MAC address of currently paired peer device */
-uint8_t peerMac[6] = {0};
 /** @brief MAC address of last known peer for reconnection attempts */
 uint8_t lastKnownPeerMac[6] = {0};
 /** @brief Flag indicating if a last known peer exists */
@@ -50,6 +254,9 @@ bool hasLastKnownPeer = false;
 /** @brief Flag indicating if ESP-NOW was toggled */
 bool espNowToggled = false;
 
+/** @brief Link the protocol runs on */
+static EspNowTransport *transport = &espNowRadioTransport();
+
 //------------------------------------------------------------------------------
 // Status Variables
 //------------------------------------------------------------------------------
@@ -57,22 +264,42 @@ bool espNowToggled = false;
 ComStatus currentStatus = ComStatus::DISCOVERY;
 /** @brief Current communication state (processing/waiting/none) */
 ComState currentComState = ComState::NONE;
-/** @brief Current device role in paired communication */
-DeviceRole currentRole = DeviceRole::UNKNOWN;
 /** @brief Current ESP-NOW activation state */
 ESPNowState currentESPNowState = ESPNowState::OFF;
 
 //------------------------------------------------------------------------------
 // Communication Timers and Counters
 //------------------------------------------------------------------------------
-/** @brief Count of consecutive communication failures */
-int consecutiveFailures = 0;
 /** @brief Count of broadcast attempts in discovery mode */
 int broadcastAttempts = 0;
 /** @brief Timestamp of last broadcast attempt */
 unsigned long lastBroadcastTime = 0;
+/** @brief Time of the next discovery or presence broadcast */
+static unsigned long nextBroadcastAt = 0;
+/** @brief Wait between discovery broadcasts, doubles while unanswered */
+static unsigned long discoveryInterval = ComsInterval::DISCOVERY_INTERVAL;
+/** @brief Time discovery last started, for time-to-pair */
+static unsigned long discoveryStartedAt = 0;
+/** @brief Pairing handshakes in progress */
+static Handshake handshakes[ESPNOW_MAX_HANDSHAKES];
+/** @brief Discovery and pairing counters */
+static DiscoveryStats discoveryStats = {};
+/** @brief Discovery follows the duty cycle */
+static bool dutyCycling = false;
+/** @brief Radio is powered down between duty cycle windows */
+static bool radioAsleep = false;
+/** @brief Start of the current duty cycle period */
+static unsigned long dutyPeriodStart = 0;
+/** @brief Periods since the duty cycle began */
+static uint32_t dutyPeriod = 0;
+/** @brief Period, modulo ESPNOW_DUTY_LISTEN_EVERY, the radio stays awake */
+static uint8_t dutyListenPeriod = 0;
+/** @brief Last radio power change, for the awake and asleep totals */
+static unsigned long radioStateSince = 0;
 /** @brief Timestamp of last status check */
 unsigned long lastStatusTime = 0;
+/** @brief Time of the next conversation turn while paired */
+static unsigned long nextConversationAt = 0;
 /** @brief Timestamp of last message sent */
 unsigned long lastMessageTime = 0;
 /** @brief Timestamp of last ESP-NOW toggle */
@@ -85,9 +312,9 @@ unsigned long lastToggleTime = 0;
 /**
  * @brief ESP-NOW send callback function
  * @param mac MAC address of the recipient
- * @param status Send status (success/failure)
+ * @param delivered true if the radio saw the frame arrive
  */
-static void Send_data_cb(const uint8_t *mac, esp_now_send_status_t status);
+static void Send_data_cb(const uint8_t *mac, bool delivered);
 
 /**
  * @brief ESP-NOW receive callback function
@@ -98,10 +325,17 @@ static void Send_data_cb(const uint8_t *mac, esp_now_send_status_t status);
 static void Receive_data_cb(const uint8_t *mac, const uint8_t *data, int len);
 
 /**
- * @brief Handle device pairing process
+ * @brief Add a device to the peer table
  * @param mac MAC address of device to pair with
+ * @return New peer entry or nullptr if the table is full
  */
-static void handlePairing(const uint8_t *mac);
+static PeerEntry *handlePairing(const uint8_t *mac);
+
+/**
+ * @brief Drop one peer, returning to discovery once none are left
+ * @param peer Peer to drop
+ */
+static void removePeer(PeerEntry &peer);
 
 /**
  * @brief Handle connection loss and reset communication
@@ -109,12 +343,11 @@ static void handlePairing(const uint8_t *mac);
 static void handleConnectionLost(void);
 
 /**
- * @brief Send a data message to paired device
- * @param text Message text content
+ * @brief Say something to every peer and play it locally
  * @param type Conversation type for animation selection
- * @return true if message was sent successfully
+ * @return true if the message was queued for at least one peer
  */
-static bool sendDataMessage(const char *text, ConversationType type);
+static bool speakToGroup(ConversationType type);
 
 /**
  * @brief Send a discovery broadcast message
@@ -122,35 +355,660 @@ static bool sendDataMessage(const char *text, ConversationType type);
  */
 static bool sendDiscoveryMessage(void);
 
+/**
+ * @brief Restart the broadcast backoff and ask the last peer first
+ */
+static void resetDiscovery(void);
+
+/**
+ * @brief Set the next conversation turn, jittered so bots don't align
+ */
+static void scheduleConversation(void);
+
+/**
+ * @brief Abandon every handshake in progress
+ */
+static void clearHandshakes(void);
+
+/**
+ * @brief Fill a conversation payload, scheduled on the shared clock if any
+ * @param payload Receives up to CONVERSATION_PAYLOAD_MAX bytes
+ * @param type Conversation type
+ * @param flags CONVERSATION_FLAG_* bits
+ * @return Payload length
+ */
+static uint8_t buildConversationPayload(uint8_t *payload, ConversationType type,
+                                        uint8_t flags);
+
+//==============================================================================
+// ANIMATION MANAGEMENT
+//==============================================================================
+
+/**
+ * @brief Get the emote for a conversation type
+ * @param type Conversation type, may come from an untrusted message
+ * @return Conversation emote or EmoteId::NONE for an unknown type
+ */
+static EmoteId getConversationEmote(ConversationType type) {
+  size_t index = static_cast<size_t>(type);
+  return (index < CONVERSATION_COUNT) ? CONVERSATION_EMOTES[index]
+                                      : EmoteId::NONE;
+}
+
+/**
+ * @brief Get the emote of the current conversation message
+ * @return Current emote or EmoteId::NONE if none
+ */
+EmoteId getCurrentAnimation() { return currentAnimation; }
+
+/**
+ * @brief Reset the current animation and communication state
+ */
+void resetCurrentAnimation() {
+  currentAnimation = EmoteId::NONE;
+  currentComState = ComState::NONE;
+}
+
 //==============================================================================
-// ANIMATION PATH MANAGEMENT
+// PEER TABLE
 //==============================================================================
 
 /**
- * @brief Get animation path for a specific conversation type
- * @param type Conversation type to find animation for
- * @return Path to the animation file or nullptr if not found
+ * @brief Home slot of a MAC address
+ *
+ * Vendor prefixes repeat across bots, so only the device specific bytes
+ * are mixed in.
+ *
+ * @param mac MAC address
+ * @return Slot index below ESPNOW_PEER_SLOTS
+ */
+static uint8_t peerHomeSlot(const uint8_t *mac) {
+  uint32_t hash = (mac[3] << 16) | (mac[4] << 8) | mac[5];
+  hash *= 2654435761u;
+  return (hash >> 24) & (ESPNOW_PEER_SLOTS - 1);
+}
+
+/**
+ * @brief Find the peer table entry of a MAC address
+ * @param mac MAC address
+ * @return Peer entry or nullptr if the device is not a peer
  */
-const char *getAnimationPath(ConversationType type) {
-  for (const auto &conv : CONVERSATIONS) {
-    if (conv.type == type)
-      return conv.gifPath;
+static PeerEntry *findPeer(const uint8_t *mac) {
+  uint8_t slot = peerHomeSlot(mac);
+  for (int probe = 0; probe < ESPNOW_PEER_SLOTS; probe++) {
+    int8_t index = peerSlots[slot];
+    if (index == SLOT_EMPTY)
+      return nullptr;
+    if (index >= 0 && memcmp(peers[index].mac, mac, 6) == 0)
+      return &peers[index];
+    slot = (slot + 1) & (ESPNOW_PEER_SLOTS - 1);
   }
   return nullptr;
 }
 
 /**
- * @brief Get the currently active animation path
- * @return Current animation path or nullptr if none
+ * @brief Hash a new peer entry into the first free slot
+ * @param index Peer entry index
  */
-const char *getCurrentAnimationPath() { return currentAnimationPath; }
+static void insertPeerSlot(int8_t index) {
+  uint8_t slot = peerHomeSlot(peers[index].mac);
+  while (peerSlots[slot] >= 0) {
+    slot = (slot + 1) & (ESPNOW_PEER_SLOTS - 1);
+  }
+  peerSlots[slot] = index;
+  peers[index].slot = slot;
+}
 
 /**
- * @brief Reset the animation path and communication state
+ * @brief Empty the peer table
  */
-void resetAnimationPath() {
-  currentAnimationPath = nullptr;
-  currentComState = ComState::NONE;
+static void clearPeerTable() {
+  memset(peerSlots, SLOT_EMPTY, sizeof(peerSlots));
+  for (PeerEntry &peer : peers) {
+    peer.used = false;
+  }
+  peerCount = 0;
+  peersAboveMe = 0;
+}
+
+/**
+ * @brief Check if this device coordinates the group conversation
+ * @return true if no peer has a larger MAC address
+ */
+static bool isCoordinator() { return peerCount > 0 && peersAboveMe == 0; }
+
+//==============================================================================
+// FRAME PROTOCOL
+//==============================================================================
+
+/**
+ * @brief Start an empty frame
+ * @param batch Frame to reset
+ */
+static void beginFrame(FrameBatch &batch) {
+  batch.length = sizeof(FrameHeader);
+  batch.recordCount = 0;
+  batch.flags = 0;
+}
+
+/**
+ * @brief Append a TLV record to a frame
+ * @param batch Frame to append to
+ * @param type Record type
+ * @param payload Record payload, may be nullptr if length is 0
+ * @param length Payload length
+ * @param reliable true if the frame must be acknowledged
+ * @return true if the record fit
+ */
+static bool appendRecord(FrameBatch &batch, FrameRecordType type,
+                         const void *payload, uint8_t length, bool reliable) {
+  if (length > ESPNOW_MAX_RECORD_PAYLOAD || batch.recordCount == UINT8_MAX ||
+      batch.length + sizeof(FrameRecordHeader) + length > sizeof(batch.data)) {
+    return false;
+  }
+
+  FrameRecordHeader record = {static_cast<uint8_t>(type), length};
+  memcpy(batch.data + batch.length, &record, sizeof(record));
+  batch.length += sizeof(record);
+  if (length > 0) {
+    memcpy(batch.data + batch.length, payload, length);
+    batch.length += length;
+  }
+  batch.recordCount++;
+  if (reliable) {
+    batch.flags |= FRAME_FLAG_RELIABLE;
+  }
+  return true;
+}
+
+/**
+ * @brief Estimated time on air of a frame
+ * @param length Frame length
+ * @return Airtime (us)
+ */
+static uint32_t frameAirtime(size_t length) {
+  return ESPNOW_PHY_OVERHEAD_US +
+         (length + ESPNOW_MAC_OVERHEAD_BYTES) * ESPNOW_US_PER_BYTE;
+}
+
+/**
+ * @brief Hand frame bytes to the transport and account for their airtime
+ * @param mac Destination MAC address
+ * @param data Frame bytes
+ * @param length Frame length
+ * @return true if the transport accepted the frame
+ */
+static bool transmitFrame(const uint8_t *mac, const uint8_t *data,
+                          size_t length) {
+  stats.framesSent++;
+  stats.airtimeMicros += frameAirtime(length);
+  return transport->send(mac, data, length);
+}
+
+/**
+ * @brief Write the frame header in front of the records
+ * @param batch Frame to stamp
+ * @param sequence Sequence number of the frame
+ */
+static void stampHeader(FrameBatch &batch, uint16_t sequence) {
+  FrameHeader header = {ESPNOW_FRAME_MAGIC, ESPNOW_PROTOCOL_VERSION,
+                        batch.flags, sequence, batch.recordCount};
+  memcpy(batch.data, &header, sizeof(header));
+}
+
+/**
+ * @brief Stamp the header on a frame, send it and start a new one
+ *
+ * Reliable frames are kept in the peer's inFlight until acknowledged.
+ *
+ * @param mac Destination MAC address
+ * @param batch Frame to send, empty afterwards
+ * @param inFlight Keeps the frame if it is reliable, nullptr for broadcasts
+ * @return true if ESP-NOW accepted the frame
+ */
+static bool sendFrame(const uint8_t *mac, FrameBatch &batch,
+                      InFlightFrame *inFlight) {
+  if (batch.recordCount == 0)
+    return false;
+
+  uint16_t sequence = txSequence++;
+  stampHeader(batch, sequence);
+
+  if (inFlight && (batch.flags & FRAME_FLAG_RELIABLE)) {
+    inFlight->frame = batch;
+    memcpy(inFlight->mac, mac, 6);
+    inFlight->sequence = sequence;
+    inFlight->retries = 0;
+    inFlight->firstSentAt = inFlight->lastSentAt = millis();
+    inFlight->active = true;
+  }
+
+  stats.recordsSent += batch.recordCount;
+  bool sent = transmitFrame(mac, batch.data, batch.length);
+  beginFrame(batch);
+  return sent;
+}
+
+/**
+ * @brief Queue owed replies and send each peer's records once no reliable
+ * frame to it is in flight
+ *
+ * Records queued while waiting for an ack go out together in one frame.
+ */
+static void flushPeers() {
+  if (!isPaired())
+    return;
+
+  for (PeerEntry &peer : peers) {
+    if (!peer.used)
+      continue;
+
+    if (peer.replyRequested &&
+        millis() - peer.replyRequestAt >= ESPNOW_REPLY_DELAY_MS) {
+      peer.replyRequested = false;
+      ConversationType reply = REPLY_TYPES[random(REPLY_COUNT)];
+      uint8_t payload[CONVERSATION_PAYLOAD_MAX];
+      uint8_t length = buildConversationPayload(payload, reply, 0);
+      if (appendRecord(peer.batch, FrameRecordType::CONVERSATION, payload,
+                       length, true)) {
+        currentAnimation = getConversationEmote(reply);
+        currentComState = ComState::PROCESSING;
+      }
+    }
+
+    if (!peer.inFlight.active && peer.batch.recordCount > 0) {
+      sendFrame(peer.mac, peer.batch, &peer.inFlight);
+    }
+  }
+}
+
+/**
+ * @brief Acknowledge a reliable frame
+ *
+ * Ack frames are unreliable, so they carry no sequence number of their own.
+ *
+ * @param mac Sender of the frame
+ * @param sequence Sequence number of the frame
+ */
+static void sendAck(const uint8_t *mac, uint16_t sequence) {
+  beginFrame(ackFrame);
+  appendRecord(ackFrame, FrameRecordType::ACK, &sequence, sizeof(sequence),
+               false);
+  stampHeader(ackFrame, 0);
+  stats.recordsSent++;
+  transmitFrame(mac, ackFrame.data, ackFrame.length);
+}
+
+/**
+ * @brief Add the counters kept by the ESP-NOW callbacks to the statistics
+ */
+static void collectCallbackStats() {
+  stats.malformed += callbackMalformed.exchange(0, std::memory_order_relaxed);
+  stats.linkFailures +=
+      callbackLinkFailures.exchange(0, std::memory_order_relaxed);
+
+  uint32_t dropped = rxQueue.dropped();
+  stats.rxOverflows += dropped - rxOverflowsCounted;
+  rxOverflowsCounted = dropped;
+}
+
+/**
+ * @brief Complete a peer's in-flight frame if an ack matches it
+ * @param peer Peer the ack came from
+ * @param sequence Sequence number carried by the ack
+ * @param receivedAt Arrival time of the ack (ms)
+ */
+static void handleAck(PeerEntry &peer, uint16_t sequence,
+                      unsigned long receivedAt) {
+  InFlightFrame &inFlight = peer.inFlight;
+  if (!inFlight.active || sequence != inFlight.sequence)
+    return;
+
+  stats.delivered++;
+  stats.totalAckMillis += receivedAt - inFlight.firstSentAt;
+  inFlight.active = false;
+  peer.consecutiveFailures = 0;
+  peer.linkQuality += (255 - peer.linkQuality) / 4;
+}
+
+/**
+ * @brief Retransmit in-flight frames or give up on them
+ *
+ * Only frames that stay unacknowledged through every retry count as
+ * failures, a lost radio frame or ack on its own does not.
+ */
+static void serviceRetransmission() {
+  for (PeerEntry &peer : peers) {
+    InFlightFrame &inFlight = peer.inFlight;
+    if (!peer.used || !inFlight.active ||
+        millis() - inFlight.lastSentAt < ESPNOW_ACK_TIMEOUT_MS) {
+      continue;
+    }
+
+    peer.linkQuality -= peer.linkQuality / 4;
+    if (inFlight.retries >= ESPNOW_MAX_RETRIES) {
+      inFlight.active = false;
+      stats.undelivered++;
+      ESP_LOGW(ESPNOW_LOG, "Frame %u undelivered after %u retries",
+               inFlight.sequence, inFlight.retries);
+      if (++peer.consecutiveFailures >= MAX_FAILURES) {
+        // If too many frames go unanswered the peer is gone
+        removePeer(peer);
+      }
+      continue;
+    }
+
+    inFlight.retries++;
+    inFlight.lastSentAt = millis();
+    stats.retransmissions++;
+    transmitFrame(inFlight.mac, inFlight.frame.data, inFlight.frame.length);
+  }
+}
+
+/**
+ * @brief Check a reliable sequence number against the last one received
+ *
+ * Numbers up to ESPNOW_SEQ_WINDOW behind the newest are duplicates or
+ * stale retransmissions. A bigger jump backwards means the peer restarted.
+ *
+ * @param peer Sender of the frame
+ * @param sequence Received sequence number
+ * @return true if the frame is new and should be processed
+ */
+static bool acceptSequence(PeerEntry &peer, uint16_t sequence) {
+  int16_t delta = static_cast<int16_t>(sequence - peer.lastRxSequence);
+  if (peer.rxSequenceValid && delta <= 0 && delta > -ESPNOW_SEQ_WINDOW) {
+    return false;
+  }
+  peer.lastRxSequence = sequence;
+  peer.rxSequenceValid = true;
+  return true;
+}
+
+/**
+ * @brief Check that a frame's records exactly fill its body
+ * @param body First byte after the frame header
+ * @param length Body length
+ * @param recordCount Records announced in the header
+ * @return true if every record lies within the frame
+ */
+static bool validateRecords(const uint8_t *body, size_t length,
+                            uint8_t recordCount) {
+  size_t offset = 0;
+  for (uint8_t i = 0; i < recordCount; i++) {
+    if (offset + sizeof(FrameRecordHeader) > length)
+      return false;
+    offset += sizeof(FrameRecordHeader) + body[offset + 1];
+    if (offset > length)
+      return false;
+  }
+  return offset == length;
+}
+
+/**
+ * @brief Check a received frame's header and record layout
+ * @param data Frame bytes
+ * @param len Frame length
+ * @param header Receives the frame header
+ * @return true if the frame can be processed
+ */
+static bool validateFrame(const uint8_t *data, int len, FrameHeader &header) {
+  if (len < (int)sizeof(header) || len > ESPNOW_MAX_FRAME_SIZE)
+    return false;
+  memcpy(&header, data, sizeof(header));
+  if (header.magic != ESPNOW_FRAME_MAGIC ||
+      header.version != ESPNOW_PROTOCOL_VERSION) {
+    return false;
+  }
+  return validateRecords(data + sizeof(header), len - sizeof(header),
+                         header.recordCount);
+}
+
+//==============================================================================
+// CLOCK SYNC
+//==============================================================================
+
+/**
+ * @brief Check if enough round trips were measured to use the shared clock
+ * @return true if the estimate is usable
+ */
+static bool clockSynced() {
+  return hasClockRef && clockSampleCount >= ESPNOW_CLOCK_MIN_SAMPLES;
+}
+
+/**
+ * @brief Check if this device can schedule against the shared clock
+ *
+ * The coordinator has no peer above it, so its own clock is the shared one.
+ *
+ * @return true if the device is the reference or synced to it
+ */
+static bool hasSharedClock() { return isCoordinator() || clockSynced(); }
+
+/**
+ * @brief Shared minus local clock at a local time
+ * @param localUs Local micros() time
+ * @return Offset including the drift since it was measured (us)
+ */
+static int32_t clockOffsetAt(uint32_t localUs) {
+  int32_t elapsed = static_cast<int32_t>(localUs - clockBaseLocal);
+  return clockOffset + static_cast<int32_t>(clockDrift * elapsed);
+}
+
+/**
+ * @brief Convert a local time to the shared clock
+ * @param localUs Local micros() time
+ * @return Shared clock time, unchanged on the reference or unsynced
+ */
+static uint32_t localToShared(uint32_t localUs) {
+  return clockSynced() ? localUs + clockOffsetAt(localUs) : localUs;
+}
+
+/**
+ * @brief Convert a shared clock time to the local clock
+ * @param sharedUs Shared clock time
+ * @return Local micros() time
+ */
+static uint32_t sharedToLocal(uint32_t sharedUs) {
+  if (!clockSynced())
+    return sharedUs;
+  return sharedUs - clockOffsetAt(sharedUs - clockOffset);
+}
+
+/**
+ * @brief Forget every clock measurement
+ */
+static void resetClockSync() {
+  hasClockRef = false;
+  clockSampleCount = 0;
+  clockSampleNext = 0;
+  clockOffset = 0;
+  clockDrift = 0;
+  clockDriftValid = false;
+  driftAnchorValid = false;
+  lastClockRequest = 0;
+}
+
+/**
+ * @brief Follow the peer with the largest MAC address as clock reference
+ *
+ * Any change of reference starts the estimate over.
+ *
+ * @return Reference peer or nullptr if this device is the reference
+ */
+static const PeerEntry *updateClockReference() {
+  const PeerEntry *reference = nullptr;
+  for (const PeerEntry &peer : peers) {
+    if (peer.used && peer.role == DeviceRole::RESPONDER &&
+        (!reference || memcmp(peer.mac, reference->mac, 6) > 0)) {
+      reference = &peer;
+    }
+  }
+
+  if (!reference) {
+    if (hasClockRef) {
+      resetClockSync();
+    }
+    return nullptr;
+  }
+  if (!hasClockRef || memcmp(reference->mac, clockRefMac, 6) != 0) {
+    resetClockSync();
+    memcpy(clockRefMac, reference->mac, 6);
+    hasClockRef = true;
+  }
+  return reference;
+}
+
+/**
+ * @brief Add a round trip and re-derive the offset and drift
+ *
+ * The fastest round trip in the window saw the least queueing on either
+ * path, so its offset is the most trustworthy. Drift comes from how that
+ * offset moves over at least ESPNOW_CLOCK_DRIFT_SPAN_US.
+ *
+ * @param sample New round trip
+ */
+static void addClockSample(const ClockSample &sample) {
+  clockSamples[clockSampleNext] = sample;
+  clockSampleNext = (clockSampleNext + 1) % ESPNOW_CLOCK_SAMPLES;
+  if (clockSampleCount < ESPNOW_CLOCK_SAMPLES) {
+    clockSampleCount++;
+  }
+
+  const ClockSample *best = &clockSamples[0];
+  for (uint8_t i = 1; i < clockSampleCount; i++) {
+    if (clockSamples[i].delayUs < best->delayUs) {
+      best = &clockSamples[i];
+    }
+  }
+  clockOffset = best->offsetUs;
+  clockBaseLocal = best->localUs;
+  clockDelay = best->delayUs;
+
+  if (!driftAnchorValid) {
+    driftAnchor = *best;
+    driftAnchorValid = true;
+    return;
+  }
+  int32_t span = static_cast<int32_t>(best->localUs - driftAnchor.localUs);
+  if (span < ESPNOW_CLOCK_DRIFT_SPAN_US)
+    return;
+
+  float rate = static_cast<int32_t>(best->offsetUs - driftAnchor.offsetUs) /
+               static_cast<float>(span);
+  rate = constrain(rate, -ESPNOW_CLOCK_MAX_DRIFT, ESPNOW_CLOCK_MAX_DRIFT);
+  clockDrift = clockDriftValid ? clockDrift + (rate - clockDrift) / 4 : rate;
+  clockDriftValid = true;
+  driftAnchor = *best;
+}
+
+/**
+ * @brief Ask the reference peer for its clock
+ *
+ * Requests are unreliable and stamped right before sending, a lost one is
+ * simply replaced by the next.
+ */
+static void requestClockSync() {
+  const PeerEntry *reference = updateClockReference();
+  unsigned long interval = clockSynced() ? ESPNOW_CLOCK_SYNC_INTERVAL_MS
+                                         : ESPNOW_CLOCK_SYNC_FAST_MS;
+  if (!reference || millis() - lastClockRequest < interval)
+    return;
+  lastClockRequest = millis();
+
+  FrameBatch request;
+  beginFrame(request);
+  uint32_t sentAt = micros();
+  appendRecord(request, FrameRecordType::TIME_REQUEST, &sentAt, sizeof(sentAt),
+               false);
+  sendFrame(reference->mac, request, nullptr);
+}
+
+/**
+ * @brief Answer a clock sync request
+ *
+ * Receive and send times are given on the shared clock, so a synced device
+ * can pass the reference time on.
+ *
+ * @param peer Requester
+ * @param payload Record payload
+ * @param length Payload length
+ * @param receivedAtUs Arrival time of the request (us)
+ */
+static void handleTimeRequest(const PeerEntry &peer, const uint8_t *payload,
+                              uint8_t length, uint32_t receivedAtUs) {
+  if (length < sizeof(uint32_t) || !hasSharedClock())
+    return;
+
+  uint32_t times[3];
+  memcpy(&times[0], payload, sizeof(uint32_t));
+  times[1] = localToShared(receivedAtUs);
+
+  FrameBatch response;
+  beginFrame(response);
+  times[2] = localToShared(micros());
+  appendRecord(response, FrameRecordType::TIME_RESPONSE, times, sizeof(times),
+               false);
+  sendFrame(peer.mac, response, nullptr);
+}
+
+/**
+ * @brief Turn a clock sync response into a clock sample
+ *
+ * With request sent at t1, received at t2, answered at t3 and the answer
+ * received at t4, the round trip is (t4 - t1) - (t3 - t2) and the offset
+ * (t2 - t1) - delay / 2, assuming both paths take equally long.
+ *
+ * @param peer Responder
+ * @param payload Record payload
+ * @param length Payload length
+ * @param receivedAtUs Arrival time of the response (us)
+ */
+static void handleTimeResponse(const PeerEntry &peer, const uint8_t *payload,
+                               uint8_t length, uint32_t receivedAtUs) {
+  if (length < 3 * sizeof(uint32_t) || !hasClockRef ||
+      memcmp(peer.mac, clockRefMac, 6) != 0) {
+    return;
+  }
+
+  uint32_t times[3];
+  memcpy(times, payload, sizeof(times));
+  int32_t delay = static_cast<int32_t>(receivedAtUs - times[0]) -
+                  static_cast<int32_t>(times[2] - times[1]);
+  if (delay < 0 || delay > ESPNOW_CLOCK_MAX_DELAY_US)
+    return;
+
+  ClockSample sample;
+  sample.offsetUs = static_cast<int32_t>(times[1] - times[0] - delay / 2);
+  sample.delayUs = delay;
+  sample.localUs = receivedAtUs;
+  addClockSample(sample);
+}
+
+/**
+ * @brief Fill a conversation payload, scheduled on the shared clock if any
+ *
+ * The start also becomes this device's own scheduled start, so the speaker
+ * plays along with its listeners.
+ *
+ * @param payload Receives up to CONVERSATION_PAYLOAD_MAX bytes
+ * @param type Conversation type
+ * @param flags CONVERSATION_FLAG_* bits
+ * @return Payload length
+ */
+static uint8_t buildConversationPayload(uint8_t *payload, ConversationType type,
+                                        uint8_t flags) {
+  payload[0] = static_cast<uint8_t>(type);
+  payload[1] = flags;
+  startScheduled = false;
+  if (!hasSharedClock())
+    return 2;
+
+  uint32_t startShared = sharedClockMicros() + ESPNOW_PLAYBACK_LEAD_US;
+  memcpy(payload + 2, &startShared, sizeof(startShared));
+  scheduledStart = sharedToLocal(startShared);
+  startScheduled = true;
+  return CONVERSATION_PAYLOAD_MAX;
 }
 
 //==============================================================================
@@ -172,203 +1030,841 @@ static void formatMacAddress(const uint8_t *mac, char *output) {
  * @param mac MAC address of the peer to set up
  * @return true if peer was set up successfully
  */
-static bool setupPeer(const uint8_t *mac) {
-  // First check if peer already exists
-  if (esp_now_is_peer_exist(mac)) {
-    return true;
+static bool setupPeer(const uint8_t *mac) { return transport->addPeer(mac); }
+
+/**
+ * @brief Select the link the protocol runs on
+ * @param link Transport used by initializeESPNOW() and everything after
+ */
+void setEspNowTransport(EspNowTransport *link) {
+  if (currentESPNowState == ESPNowState::ON) {
+    ESP_LOGE(ESPNOW_LOG, "Transport can't change while ESP-NOW is on");
+    return;
+  }
+  transport = link;
+}
+
+/**
+ * @brief Initialize ESP-NOW communication
+ * @return true if initialization successful
+ */
+bool initializeESPNOW() {
+  if (!transport->begin(Receive_data_cb, Send_data_cb)) {
+    ESP_LOGE(ESPNOW_LOG, "ESP-NOW init failed!");
+    return false;
+  }
+
+  // Roles are decided against this device's MAC for every peer
+  transport->macAddress(ownMac);
+  clearPeerTable();
+  // ESP_LOGI log removed
+  return true;
+}
+
+/**
+ * @brief Callback function to receive data from ESP-NOW protocol
+ *
+ * Runs in the WiFi task. Valid frames are copied into rxQueue for
+ * handleCommunication(), nothing else is touched.
+ */
+static void Receive_data_cb(const uint8_t *mac, const uint8_t *data, int len) {
+  uint32_t arrivalUs = micros();
+  if (isTransferFrame(data, len)) {
+    transferFrameReceived(mac, data, len);
+    return;
+  }
+
+  FrameHeader header;
+  if (!validateFrame(data, len, header)) {
+    callbackMalformed.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  ReceivedFrame frame;
+  memcpy(frame.mac, mac, 6);
+  frame.length = len;
+  frame.receivedAt = millis();
+  frame.receivedAtUs = arrivalUs;
+  memcpy(frame.data, data, len);
+  // Frames dropped on overflow are never acked, the sender retransmits them
+  rxQueue.push(frame);
+}
+
+/**
+ * @brief Callback function to send data from ESP-NOW protocol
+ *
+ * Only counts radio failures, retransmission and connection loss are
+ * decided by application acks in serviceRetransmission().
+ */
+static void Send_data_cb(const uint8_t *mac, bool delivered) {
+  if (!delivered) {
+    callbackLinkFailures.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+//==============================================================================
+// CONNECTION MANAGEMENT
+//==============================================================================
+
+/**
+ * @brief Check if device is paired with another device
+ * @return true if paired and ESP-NOW is active
+ */
+bool isPaired() {
+  ESPNowState espnowState = getCurrentESPNowState();
+  return espnowState == ESPNowState::ON && currentStatus == ComStatus::PAIRED;
+}
+
+/**
+ * @brief Start discovery mode to find other devices
+ * @return true if discovery mode started successfully
+ */
+bool startDiscovery() {
+  if (getCurrentESPNowState() == ESPNowState::OFF) {
+    // ESP_LOGI log removed
+    return false;
+  }
+
+  if (!setupPeer(TRANSPORT_BROADCAST_MAC)) {
+    ESP_LOGE(ESPNOW_LOG, "ESPNOW Discovery setup failed!");
+    return false;
+  }
+
+  resetDiscovery();
+
+  // ESP_LOGI log removed
+  return true;
+}
+
+/**
+ * @brief Handle lost connection to every peer
+ */
+static void handleConnectionLost() {
+  currentStatus = ComStatus::DISCOVERY;
+  ESP_LOGW(ESPNOW_LOG, "Connection reset - returning to discovery mode");
+
+  // Store a peer MAC before resetting for a direct reconnection attempt
+  for (PeerEntry &peer : peers) {
+    if (!peer.used)
+      continue;
+    memcpy(lastKnownPeerMac, peer.mac, 6);
+    hasLastKnownPeer = true;
+    transport->removePeer(peer.mac);
+  }
+  clearPeerTable();
+  clearHandshakes();
+
+  resetCurrentAnimation();
+  resetClockSync();
+  startScheduled = false;
+  turnCursor = SELF_TURN;
+  lastBroadcastTime = 0;
+  lastMessageTime = 0;
+
+  if (!startDiscovery()) {
+    ESP_LOGE(ESPNOW_LOG, "Failed to return to discovery mode");
+    return;
+  }
+}
+
+/**
+ * @brief Drop one peer, returning to discovery once none are left
+ * @param peer Peer to drop
+ */
+static void removePeer(PeerEntry &peer) {
+  if (!peer.used)
+    return;
+
+  char macStr[18];
+  formatMacAddress(peer.mac, macStr);
+  ESP_LOGW(ESPNOW_LOG, "Peer %s lost", macStr);
+
+  memcpy(lastKnownPeerMac, peer.mac, 6);
+  hasLastKnownPeer = true;
+  transport->removePeer(peer.mac);
+
+  peerSlots[peer.slot] = SLOT_DELETED;
+  peer.used = false;
+  peerCount--;
+  if (peer.role == DeviceRole::RESPONDER) {
+    peersAboveMe--;
+  }
+
+  if (peerCount == 0) {
+    handleConnectionLost();
+  }
+}
+
+/**
+ * @brief Drop peers that have been silent for ESPNOW_PEER_TIMEOUT_MS
+ */
+static void expirePeers() {
+  for (PeerEntry &peer : peers) {
+    if (peer.used && millis() - peer.lastSeen > ESPNOW_PEER_TIMEOUT_MS) {
+      removePeer(peer);
+    }
+  }
+}
+
+/**
+ * @brief Add a device to the peer table
+ * @param mac MAC address of device to pair with
+ * @return New peer entry or nullptr if the table is full
+ */
+static PeerEntry *handlePairing(const uint8_t *mac) {
+  if (getCurrentESPNowState() == ESPNowState::OFF ||
+      peerCount >= ESPNOW_MAX_PEERS) {
+    return nullptr;
+  }
+
+  int8_t index = 0;
+  while (peers[index].used) {
+    index++;
+  }
+
+  // Clear last known peer data if pairing with a different device
+  if (hasLastKnownPeer && memcmp(lastKnownPeerMac, mac, 6) != 0) {
+    hasLastKnownPeer = false;
+    memset(lastKnownPeerMac, 0, 6);
+  }
+
+  if (!setupPeer(mac)) {
+    ESP_LOGE(ESPNOW_LOG, "Failed to add peer!");
+    return nullptr;
+  }
+
+  // A new peer starts its own sequence numbering
+  PeerEntry &peer = peers[index];
+  memcpy(peer.mac, mac, 6);
+  peer.lastSeen = millis();
+  peer.linkQuality = LINK_QUALITY_INITIAL;
+  peer.rxSequenceValid = false;
+  peer.consecutiveFailures = 0;
+  peer.replyRequested = false;
+  peer.inFlight.active = false;
+  beginFrame(peer.batch);
+
+  // Compare full MAC addresses - larger becomes INITIATOR
+  if (memcmp(ownMac, mac, 6) > 0) {
+    peer.role = DeviceRole::INITIATOR;
+  } else {
+    peer.role = DeviceRole::RESPONDER;
+    peersAboveMe++;
+  }
+
+  insertPeerSlot(index);
+  peer.used = true;
+  peerCount++;
+
+  if (currentStatus == ComStatus::DISCOVERY) {
+    scheduleConversation();
+    unsigned long timeToPair = millis() - discoveryStartedAt;
+    discoveryStats.pairings++;
+    discoveryStats.lastTimeToPairMs = timeToPair;
+    discoveryStats.totalTimeToPairMs += timeToPair;
+    ESP_LOGI(ESPNOW_LOG, "Paired after %lu ms and %d broadcasts", timeToPair,
+             broadcastAttempts);
+  }
+  // Update status to PAIRED
+  currentStatus = ComStatus::PAIRED;
+
+  char macStr[18];
+  formatMacAddress(mac, macStr);
+  ESP_LOGD(ESPNOW_LOG, "Paired with %s (%u peers)", macStr, peerCount);
+  return &peer;
+}
+
+//==============================================================================
+// DISCOVERY DUTY CYCLE
+//==============================================================================
+
+/**
+ * @brief Power the radio down or up, adding the time spent to the totals
+ *
+ * The transport switches in the background, the pass doesn't wait for it.
+ *
+ * @param asleep true to sleep
+ */
+static void setRadioAsleep(bool asleep) {
+  if (asleep == radioAsleep)
+    return;
+  if (!transport->setAwake(!asleep)) {
+    ESP_LOGE(ESPNOW_LOG, "Radio failed to %s", asleep ? "sleep" : "wake");
+    return;
+  }
+
+  unsigned long now = millis();
+  if (radioAsleep) {
+    discoveryStats.radioAsleepMs += now - radioStateSince;
+  } else {
+    discoveryStats.radioAwakeMs += now - radioStateSince;
+  }
+  radioAsleep = asleep;
+  radioStateSince = now;
+}
+
+/**
+ * @brief Leave the duty cycle with the radio awake
+ */
+static void stopDutyCycle() {
+  if (!dutyCycling)
+    return;
+  setRadioAsleep(false);
+  discoveryStats.radioAwakeMs += millis() - radioStateSince;
+  dutyCycling = false;
+}
+
+/**
+ * @brief Share of duty-cycled discovery spent with the radio off
+ * @return Percent, 0 before the first duty cycle
+ */
+static uint32_t radioOffPercent() {
+  uint32_t total = discoveryStats.radioAwakeMs + discoveryStats.radioAsleepMs;
+  return total ? 100ull * discoveryStats.radioAsleepMs / total : 0;
+}
+
+/**
+ * @brief End of the current awake window
+ * @return Time the radio goes back to sleep (ms)
+ */
+static unsigned long dutyAwakeUntil() {
+  bool listening =
+      dutyPeriod % ESPNOW_DUTY_LISTEN_EVERY == dutyListenPeriod;
+  return dutyPeriodStart +
+         (listening ? ESPNOW_DUTY_AWAKE_MS : ESPNOW_DUTY_WINDOW_MS);
+}
+
+/**
+ * @brief Check if a handshake is in progress
+ * @return true if any handshake entry is used
+ */
+static bool handshakesActive() {
+  for (const Handshake &handshake : handshakes) {
+    if (handshake.state != HandshakeState::NONE)
+      return true;
   }
+  return false;
+}
+
+/**
+ * @brief Follow the discovery duty cycle
+ *
+ * Handshakes and unprocessed frames keep the radio awake past a window,
+ * the other side may be waiting for an answer.
+ *
+ * @return true if the radio sleeps and the pass has nothing else to do
+ */
+static bool serviceDutyCycle() {
+  unsigned long now = millis();
+  if (currentStatus != ComStatus::DISCOVERY ||
+      now - discoveryStartedAt < ESPNOW_DUTY_START_MS) {
+    stopDutyCycle();
+    return false;
+  }
+
+  if (!dutyCycling) {
+    dutyCycling = true;
+    dutyPeriodStart = now;
+    dutyPeriod = 0;
+    dutyListenPeriod = random(ESPNOW_DUTY_LISTEN_EVERY);
+    radioStateSince = now;
+    nextBroadcastAt = now;
+    ESP_LOGI(ESPNOW_LOG, "Discovery duty cycle started");
+  }
+  // Skip every period missed since the last pass in one step
+  unsigned long periods = (now - dutyPeriodStart) / ESPNOW_DUTY_PERIOD_MS;
+  dutyPeriodStart += periods * ESPNOW_DUTY_PERIOD_MS;
+  dutyPeriod += periods;
+
+  bool awake = static_cast<long>(now - dutyAwakeUntil()) < 0 ||
+               handshakesActive() || !rxQueue.empty();
+  setRadioAsleep(!awake);
+  return radioAsleep;
+}
+
+/**
+ * @brief Time to answer a broadcast from a duty-cycled bot
+ *
+ * Answers that would land too close to the end of the sender's window
+ * wait for its next one.
+ *
+ * @param closesAt Local time the sender's window ends (ms)
+ * @param dueAt Answer time without the duty cycle (ms)
+ * @return Answer time (ms)
+ */
+static unsigned long dutyAnswerTime(unsigned long closesAt,
+                                    unsigned long dueAt) {
+  unsigned long lastChance = closesAt - ESPNOW_DUTY_GUARD_MS;
+  if (static_cast<long>(lastChance - dueAt) >= 0)
+    return dueAt;
+
+  unsigned long now = millis();
+  if (static_cast<long>(lastChance - now) > 0)
+    return now + random(lastChance - now);
+  return closesAt - ESPNOW_DUTY_WINDOW_MS + ESPNOW_DUTY_PERIOD_MS +
+         random(ESPNOW_DUTY_WINDOW_MS / 2);
+}
+
+/**
+ * @brief Move this bot's windows onto another duty-cycled bot's
+ *
+ * Bots follow the smallest address they hear, so a crowd that can't pair
+ * ends up waking together and everyone's broadcast reaches everyone.
+ *
+ * @param mac Sender of the broadcast
+ * @param closesAt Local time the sender's window ends (ms)
+ */
+static void alignDutyCycle(const uint8_t *mac, unsigned long closesAt) {
+  if (!dutyCycling || memcmp(mac, ownMac, 6) > 0)
+    return;
+
+  // After a fully awake period the window that ends is the next one's
+  unsigned long start = closesAt - ESPNOW_DUTY_WINDOW_MS;
+  if (static_cast<long>(millis() - start) < 0) {
+    start -= ESPNOW_DUTY_PERIOD_MS;
+  }
+  dutyPeriodStart = start;
+  nextBroadcastAt = start + ESPNOW_DUTY_PERIOD_MS +
+                    random(ESPNOW_DUTY_WINDOW_MS / 4);
+}
+
+//==============================================================================
+// PAIRING HANDSHAKE
+//==============================================================================
+
+/**
+ * @brief Find the handshake with a device
+ * @param mac Device address
+ * @return Handshake or nullptr
+ */
+static Handshake *findHandshake(const uint8_t *mac) {
+  for (Handshake &handshake : handshakes) {
+    if (handshake.state != HandshakeState::NONE &&
+        memcmp(handshake.mac, mac, 6) == 0) {
+      return &handshake;
+    }
+  }
+  return nullptr;
+}
+
+/**
+ * @brief Check whether another device fits next to peers and handshakes
+ * @return true if a new handshake may start
+ */
+static bool pairingRoom() {
+  uint8_t reserved = peerCount;
+  for (const Handshake &handshake : handshakes) {
+    if (handshake.state != HandshakeState::NONE) {
+      reserved++;
+    }
+  }
+  return reserved < ESPNOW_MAX_PEERS;
+}
+
+/**
+ * @brief Start a handshake with a device
+ * @param mac Device address
+ * @param state First state
+ * @param dueAt First send or give-up time
+ * @return New handshake or nullptr if all are busy
+ */
+static Handshake *startHandshake(const uint8_t *mac, HandshakeState state,
+                                 unsigned long dueAt) {
+  for (Handshake &handshake : handshakes) {
+    if (handshake.state == HandshakeState::NONE) {
+      memcpy(handshake.mac, mac, 6);
+      handshake.state = state;
+      handshake.attempts = 0;
+      handshake.dueAt = dueAt;
+      discoveryStats.handshakesStarted++;
+      return &handshake;
+    }
+  }
+  return nullptr;
+}
+
+/**
+ * @brief End a handshake that did not pair
+ * @param handshake Handshake to end
+ */
+static void dropHandshake(Handshake &handshake) {
+  if (!findPeer(handshake.mac)) {
+    transport->removePeer(handshake.mac);
+  }
+  discoveryStats.handshakesFailed++;
+  handshake.state = HandshakeState::NONE;
+}
+
+/**
+ * @brief Abandon every handshake in progress
+ */
+static void clearHandshakes() {
+  for (Handshake &handshake : handshakes) {
+    if (handshake.state != HandshakeState::NONE) {
+      transport->removePeer(handshake.mac);
+      handshake.state = HandshakeState::NONE;
+    }
+  }
+}
+
+/**
+ * @brief Send a payload-less handshake record on its own
+ * @param mac Destination
+ * @param type PAIR_REQUEST or PAIR_ACCEPT
+ * @return true if ESP-NOW accepted the frame
+ */
+static bool sendHandshakeRecord(const uint8_t *mac, FrameRecordType type) {
+  if (!setupPeer(mac))
+    return false;
+  FrameBatch frame;
+  beginFrame(frame);
+  appendRecord(frame, type, nullptr, 0, false);
+  return sendFrame(mac, frame, nullptr);
+}
 
-  esp_now_peer_info_t peerInfo = {};
-  memcpy(peerInfo.peer_addr, mac, 6);
-  peerInfo.channel = 0;
-  peerInfo.encrypt = false;
+/**
+ * @brief Wait for an accept after a request, doubling per attempt
+ * @param attempts Requests sent before this one
+ * @return Wait (ms)
+ */
+static unsigned long handshakeTimeout(uint8_t attempts) {
+  return (ESPNOW_HANDSHAKE_TIMEOUT_MS << attempts) +
+         random(ESPNOW_HANDSHAKE_TIMEOUT_MS);
+}
 
-  return esp_now_add_peer(&peerInfo) == ESP_OK;
+/**
+ * @brief Wait for a confirm, long enough for its retransmissions
+ */
+static unsigned long acceptTimeout() {
+  return ESPNOW_ACK_TIMEOUT_MS * (ESPNOW_MAX_RETRIES + 1) +
+         handshakeTimeout(ESPNOW_HANDSHAKE_RETRIES);
 }
 
 /**
- * @brief Initialize ESP-NOW communication
- * @return true if initialization successful
+ * @brief Add the other device to the peer table and end the handshake
+ * @param mac Other device
+ * @param requester true to send the confirm
  */
-bool initializeESPNOW() {
-  // Make sure we're in station mode for ESP-NOW
-  if (WiFi.getMode() != WIFI_MODE_STA) {
-    WiFi.mode(WIFI_MODE_STA);
-    WiFi.disconnect();
+static void completeHandshake(const uint8_t *mac, bool requester) {
+  Handshake *handshake = findHandshake(mac);
+  if (handshake) {
+    handshake->state = HandshakeState::NONE;
   }
 
-  if (esp_now_init() != ESP_OK) {
-    ESP_LOGE(ESPNOW_LOG, "ESP-NOW init failed!");
-    return false;
+  PeerEntry *peer = findPeer(mac);
+  if (!peer) {
+    peer = handlePairing(mac);
+    if (!peer) {
+      transport->removePeer(mac);
+      discoveryStats.handshakesFailed++;
+      return;
+    }
+    discoveryStats.handshakesCompleted++;
   }
 
-  esp_now_register_send_cb(Send_data_cb);
-  esp_now_register_recv_cb(Receive_data_cb);
-  // ESP_LOGI log removed
-  return true;
+  // Reliable, the other side only pairs once it arrives
+  if (requester) {
+    appendRecord(peer->batch, FrameRecordType::PAIR_CONFIRM, nullptr, 0,
+                 true);
+  }
 }
 
 /**
- * @brief Callback function to receive data from ESP-NOW protocol
+ * @brief Advance the handshakes whose timer ran out
  */
-static void Receive_data_cb(const uint8_t *mac, const uint8_t *data, int len) {
-  // Validate message size before processing
-  if (len != sizeof(Message)) {
-    ESP_LOGE(ESPNOW_LOG, "Invalid message size: received %d bytes, expected %d",
-             len, sizeof(Message));
-    return;
-  }
-  // Cast received data and check if App signature matches to accept data
-  Message *msg = (Message *)data;
-  if (msg->signature != APP_SIGNATURE) {
-    ESP_LOGE(ESPNOW_LOG, "App signature mismatch: received v%d, expected v%d",
-             msg->signature, APP_SIGNATURE);
-    return;
-  }
+static void serviceHandshakes() {
+  unsigned long now = millis();
+  for (Handshake &handshake : handshakes) {
+    if (handshake.state == HandshakeState::NONE ||
+        static_cast<long>(now - handshake.dueAt) < 0) {
+      continue;
+    }
 
-  // Handle discovery mode separately
-  if (currentStatus == ComStatus::DISCOVERY) {
-    handlePairing(mac);
-  }
-  // Update animation path based on message type
-  currentAnimationPath = getAnimationPath(msg->type);
-  // Response animations, Ensure special animation types get priority
-  if (msg->type == ConversationType::SHOCK ||
-      msg->type == ConversationType::ZONE) {
-    currentComState = ComState::PROCESSING;
-  } else if (currentAnimationPath != nullptr) {
-    currentComState = ComState::PROCESSING;
+    if (handshake.state == HandshakeState::ACCEPTED ||
+        handshake.attempts >= ESPNOW_HANDSHAKE_RETRIES) {
+      dropHandshake(handshake);
+      continue;
+    }
+
+    sendHandshakeRecord(handshake.mac, FrameRecordType::PAIR_REQUEST);
+    handshake.state = HandshakeState::REQUESTED;
+    handshake.dueAt = now + handshakeTimeout(handshake.attempts++);
   }
 }
 
 /**
- * @brief Callback function to send data from ESP-NOW protocol
+ * @brief Act on a discovery or pairing record
+ *
+ * Requests that cross are settled by MAC address: the smaller address's
+ * request goes ahead and the other device answers it.
+ *
+ * @param mac Sender
+ * @param type Record type
+ * @param peer Sender's peer entry, nullptr if it is not a peer
+ * @param payload Record payload
+ * @param length Payload length
+ * @param frame Frame carrying the record
  */
-static void Send_data_cb(const uint8_t *mac, esp_now_send_status_t status) {
-  char macStr[18];
-  formatMacAddress(mac, macStr);
-  if (status == ESP_NOW_SEND_SUCCESS) {
-    consecutiveFailures = 0;
-  } else {
-    ESP_LOGE(ESPNOW_LOG, "::Delivery failed to:: %s", macStr);
-    if (++consecutiveFailures >= MAX_FAILURES) {
-      // If too many fail attempts disconnect and restart ESPNOW communications
-      handleConnectionLost();
+static void handleHandshakeRecord(const uint8_t *mac, FrameRecordType type,
+                                  PeerEntry *peer, const uint8_t *payload,
+                                  uint8_t length, const ReceivedFrame &frame) {
+  Handshake *handshake = findHandshake(mac);
+
+  switch (type) {
+  case FrameRecordType::DISCOVERY: {
+    // Answers are spread out so a broadcast heard by many isn't answered
+    // by all of them at once, the last peer is answered right away
+    unsigned long closesAt = 0;
+    if (!peer && length >= sizeof(uint16_t)) {
+      uint16_t awakeMs;
+      memcpy(&awakeMs, payload, sizeof(awakeMs));
+      // Longer than any window is a broken sender, not a schedule to follow
+      if (awakeMs > 0 && awakeMs <= ESPNOW_DUTY_AWAKE_MS) {
+        closesAt = frame.receivedAt + awakeMs;
+        alignDutyCycle(mac, closesAt);
+      }
     }
+    if (!peer && !handshake && pairingRoom()) {
+      bool lastPeer = hasLastKnownPeer && memcmp(mac, lastKnownPeerMac, 6) == 0;
+      unsigned long dueAt =
+          millis() + (lastPeer ? 0 : random(ESPNOW_REQUEST_JITTER_MS));
+      if (closesAt) {
+        // The sender duty cycles, the request must find it awake
+        dueAt = dutyAnswerTime(closesAt, dueAt);
+      }
+      startHandshake(mac, HandshakeState::REQUEST_DUE, dueAt);
+    }
+    break;
+  }
+
+  case FrameRecordType::PAIR_REQUEST:
+    if (peer) {
+      // It forgot us, e.g. after a reboot, and numbers frames from scratch
+      peer->rxSequenceValid = false;
+      sendHandshakeRecord(mac, FrameRecordType::PAIR_ACCEPT);
+      break;
+    }
+    if (handshake && handshake->state != HandshakeState::ACCEPTED &&
+        memcmp(ownMac, mac, 6) < 0) {
+      break;
+    }
+    if (!handshake) {
+      if (!pairingRoom())
+        break;
+      handshake = startHandshake(mac, HandshakeState::ACCEPTED, 0);
+      if (!handshake)
+        break;
+    }
+    handshake->state = HandshakeState::ACCEPTED;
+    handshake->dueAt = millis() + acceptTimeout();
+    sendHandshakeRecord(mac, FrameRecordType::PAIR_ACCEPT);
+    break;
+
+  case FrameRecordType::PAIR_ACCEPT:
+    // Only accepts of our own requests count
+    if (peer ||
+        (handshake && handshake->state == HandshakeState::REQUESTED)) {
+      completeHandshake(mac, true);
+    }
+    break;
+
+  case FrameRecordType::PAIR_CONFIRM:
+    if (!peer && (handshake || pairingRoom())) {
+      completeHandshake(mac, false);
+    }
+    break;
+
+  default:
+    break;
   }
 }
 
 //==============================================================================
-// CONNECTION MANAGEMENT
+// MESSAGE HANDLING
 //==============================================================================
 
 /**
- * @brief Check if device is paired with another device
- * @return true if paired and ESP-NOW is active
+ * @brief Act on one record of a received frame
+ *
+ * Replies are only noted here and sent once the question has had time to
+ * play.
+ *
+ * @param peer Sender of the frame
+ * @param type Record type
+ * @param payload Record payload
+ * @param length Payload length
+ * @param frame Frame carrying the record
  */
-bool isPaired() {
-  ESPNowState espnowState = getCurrentESPNowState();
-  return espnowState == ESPNowState::ON && currentStatus == ComStatus::PAIRED;
+static void handleRecord(PeerEntry &peer, FrameRecordType type,
+                         const uint8_t *payload, uint8_t length,
+                         const ReceivedFrame &frame) {
+  switch (type) {
+  case FrameRecordType::CONVERSATION:
+    if (length >= 1) {
+      // Update animation based on message type
+      currentAnimation =
+          getConversationEmote(static_cast<ConversationType>(payload[0]));
+      if (currentAnimation != EmoteId::NONE) {
+        currentComState = ComState::PROCESSING;
+      }
+      if (length >= 2 && (payload[1] & CONVERSATION_FLAG_REPLY)) {
+        peer.replyRequestAt = frame.receivedAt;
+        peer.replyRequested = true;
+      }
+      // Without a shared clock the emote plays as soon as possible
+      startScheduled = false;
+      if (length >= CONVERSATION_PAYLOAD_MAX && hasSharedClock()) {
+        uint32_t startShared;
+        memcpy(&startShared, payload + 2, sizeof(startShared));
+        scheduledStart = sharedToLocal(startShared);
+        startScheduled = true;
+      }
+    }
+    break;
+  case FrameRecordType::TIME_REQUEST:
+    handleTimeRequest(peer, payload, length, frame.receivedAtUs);
+    break;
+  case FrameRecordType::TIME_RESPONSE:
+    handleTimeResponse(peer, payload, length, frame.receivedAtUs);
+    break;
+  case FrameRecordType::TURN:
+    if (length >= 1 && payload[0] < CONVERSATION_COUNT) {
+      speakToGroup(static_cast<ConversationType>(payload[0]));
+    }
+    break;
+  case FrameRecordType::ACK:
+    if (length >= sizeof(uint16_t)) {
+      uint16_t sequence;
+      memcpy(&sequence, payload, sizeof(sequence));
+      handleAck(peer, sequence, frame.receivedAt);
+    }
+    break;
+  case FrameRecordType::DISCOVERY:
+  case FrameRecordType::PAIR_REQUEST:
+  case FrameRecordType::PAIR_ACCEPT:
+  case FrameRecordType::PAIR_CONFIRM:
+    handleHandshakeRecord(frame.mac, type, &peer, payload, length, frame);
+    break;
+  default:
+    // Unknown types are skipped
+    break;
+  }
 }
 
 /**
- * @brief Start discovery mode to find other devices
- * @return true if discovery mode started successfully
+ * @brief Act on a frame handed over by the receive callback
+ * @param frame Validated frame
  */
-bool startDiscovery() {
-  if (getCurrentESPNowState() == ESPNowState::OFF) {
-    // ESP_LOGI log removed
-    return false;
+static void handleReceivedFrame(const ReceivedFrame &frame) {
+  FrameHeader header;
+  memcpy(&header, frame.data, sizeof(header));
+  stats.framesReceived++;
+
+  // Duplicates are acked again since the first ack may have been lost
+  if (header.flags & FRAME_FLAG_RELIABLE) {
+    sendAck(frame.mac, header.sequence);
   }
 
-  uint8_t broadcastAddr[] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
-  if (!setupPeer(broadcastAddr)) {
-    ESP_LOGE(ESPNOW_LOG, "ESPNOW Discovery setup failed!");
-    return false;
+  PeerEntry *peer = findPeer(frame.mac);
+  if (peer) {
+    peer->lastSeen = frame.receivedAt;
+    if ((header.flags & FRAME_FLAG_RELIABLE) &&
+        !acceptSequence(*peer, header.sequence)) {
+      stats.duplicates++;
+      return;
+    }
   }
 
-  // ESP_LOGI log removed
-  return true;
-}
-
-/**
- * @brief Handle lost connection to paired device
- */
-static void handleConnectionLost() {
-  // Store current peer MAC before resetting if we're paired
-  if (isPaired()) {
-    memcpy(lastKnownPeerMac, peerMac, 6);
-    hasLastKnownPeer = true;
+  const uint8_t *body = frame.data + sizeof(header);
+  size_t offset = 0;
+  for (uint8_t i = 0; i < header.recordCount; i++) {
+    const uint8_t *record = body + offset;
+    FrameRecordType type = static_cast<FrameRecordType>(record[0]);
+    uint8_t length = record[1];
+    if (peer) {
+      if (!peer->used)
+        break;
+      handleRecord(*peer, type, record + sizeof(FrameRecordHeader), length,
+                   frame);
+    } else {
+      // Devices that aren't peers can only take part in the handshake
+      handleHandshakeRecord(frame.mac, type, nullptr,
+                            record + sizeof(FrameRecordHeader), length, frame);
+    }
+    offset += sizeof(FrameRecordHeader) + length;
   }
 
-  currentStatus = ComStatus::DISCOVERY;
-  currentRole = DeviceRole::UNKNOWN;
-  ESP_LOGW(ESPNOW_LOG, "Connection reset - returning to discovery mode");
-
-  if (isPaired()) {
-    esp_now_del_peer(peerMac);
+  // A confirm just paired the sender, its sequence numbering starts here
+  if (!peer && (header.flags & FRAME_FLAG_RELIABLE)) {
+    peer = findPeer(frame.mac);
+    if (peer) {
+      peer->lastSeen = frame.receivedAt;
+      acceptSequence(*peer, header.sequence);
+    }
   }
+}
 
-  memset(peerMac, 0, 6);
-
-  resetAnimationPath();
-  consecutiveFailures = 0;
-  broadcastAttempts = 0;
-  lastBroadcastTime = 0;
-  lastMessageTime = 0;
-
-  if (!startDiscovery()) {
-    ESP_LOGE(ESPNOW_LOG, "Failed to return to discovery mode");
-    return;
+/**
+ * @brief Process every frame queued by the receive callback
+ */
+static void processReceivedFrames() {
+  ReceivedFrame frame;
+  while (rxQueue.pop(frame)) {
+    handleReceivedFrame(frame);
   }
 }
 
 /**
- * @brief Handle pairing with another device
- * @param mac MAC address of device to pair with
+ * @brief Broadcast a discovery frame
+ *
+ * Paired devices keep broadcasting every ESPNOW_PRESENCE_INTERVAL, which
+ * lets new bots join the group and keeps every peer's lastSeen fresh.
+ *
+ * @return true if ESP-NOW accepted the frame
  */
-static void handlePairing(const uint8_t *mac) {
-  // First, check if we're already paired with this MAC
-  if (currentStatus == ComStatus::PAIRED && memcmp(peerMac, mac, 6) == 0) {
-    ESP_LOGW(ESPNOW_LOG, "Already paired with this device");
-    return;
+static bool broadcastDiscovery() {
+  lastBroadcastTime = millis();
+
+  FrameBatch discovery;
+  beginFrame(discovery);
+  long awakeMs = static_cast<long>(dutyAwakeUntil() - millis());
+  if (dutyCycling && awakeMs > 0) {
+    // Tells listeners how long they have to answer
+    uint16_t payload = min<long>(awakeMs, ESPNOW_DUTY_AWAKE_MS);
+    appendRecord(discovery, FrameRecordType::DISCOVERY,
+                 reinterpret_cast<const uint8_t *>(&payload), sizeof(payload),
+                 false);
+  } else {
+    // Not duty cycling, or kept awake past the window by a handshake
+    appendRecord(discovery, FrameRecordType::DISCOVERY, nullptr, 0, false);
   }
 
-  // Clear last known peer data if pairing with a different device
-  if (hasLastKnownPeer && memcmp(lastKnownPeerMac, mac, 6) != 0) {
-    hasLastKnownPeer = false;
-    memset(lastKnownPeerMac, 0, 6);
-  }
+  return sendFrame(TRANSPORT_BROADCAST_MAC, discovery, nullptr);
+}
 
-  memcpy(peerMac, mac, 6);
-  if (!setupPeer(mac)) {
-    ESP_LOGE(ESPNOW_LOG, "Failed to add peer!");
-    return;
-  }
-  // Update status to PAIRED
-  currentStatus = ComStatus::PAIRED;
+/**
+ * @brief Restart the broadcast backoff and ask the last peer first
+ */
+static void resetDiscovery() {
+  stopDutyCycle();
+  discoveryStartedAt = millis();
+  discoveryInterval = ComsInterval::DISCOVERY_INTERVAL;
+  broadcastAttempts = 0;
+  // Bots switched on together don't start broadcasting in step
+  nextBroadcastAt = millis() + random(ESPNOW_REQUEST_JITTER_MS);
 
-  // Get our MAC address
-  uint8_t myMac[6];
-  WiFi.macAddress(myMac);
-  // Compare full MAC addresses - larger becomes INITIATOR
-  if (memcmp(myMac, mac, 6) > 0) {
-    currentRole = DeviceRole::INITIATOR;
-  } else {
-    currentRole = DeviceRole::RESPONDER;
+  if (hasLastKnownPeer && !findHandshake(lastKnownPeerMac)) {
+    startHandshake(lastKnownPeerMac, HandshakeState::REQUEST_DUE, millis());
   }
-
-  char macStr[18];
-  formatMacAddress(mac, macStr);
-  // ESP_LOGI log removed
 }
 
-//==============================================================================
-// MESSAGE HANDLING
-//==============================================================================
-
 /**
  * @brief Send a discovery broadcast message
+ *
+ * Broadcasts back off exponentially up to ESPNOW_DISCOVERY_MAX_MS, each
+ * wait drawn from the upper half of the current interval. On the duty
+ * cycle there is one broadcast early in every window instead.
+ *
  * @return true if message was sent successfully
  */
 static bool sendDiscoveryMessage() {
@@ -378,94 +1874,128 @@ static bool sendDiscoveryMessage() {
   }
 
   unsigned long currentTime = millis();
-  unsigned long previousMessageTime = lastMessageTime;
-
-  // Try direct reconnection on first attempt if we have a known peer
-  if (hasLastKnownPeer && broadcastAttempts == 0) {
-    char macStr[18];
-    formatMacAddress(lastKnownPeerMac, macStr);
-    // Use existing setupPeer function to establish connection
-    if (setupPeer(lastKnownPeerMac)) {
-      // Use existing sendDataMessage for the reconnection attempt
-      if (sendDataMessage("RECONNECT", ConversationType::HELLO)) {
-        delay(1000);
-
-        if (currentStatus == ComStatus::PAIRED) {
-          // ESP_LOGI log removed
-          broadcastAttempts = 0;
-          return true;
-        }
-      }
-    }
-  }
-
-  if (currentTime - lastMessageTime < ComsInterval::DISCOVERY_INTERVAL)
-    return false;
-
-  if (currentTime - lastBroadcastTime < ComsInterval::DISCOVERY_INTERVAL) {
+  if (static_cast<long>(currentTime - nextBroadcastAt) < 0)
     return false;
-  }
 
-  lastMessageTime = currentTime;
-  lastBroadcastTime = currentTime;
   broadcastAttempts++;
+  discoveryStats.broadcasts++;
+  if (dutyCycling) {
+    nextBroadcastAt = dutyPeriodStart + ESPNOW_DUTY_PERIOD_MS +
+                      random(ESPNOW_DUTY_WINDOW_MS / 4);
+  } else {
+    nextBroadcastAt =
+        currentTime + discoveryInterval / 2 + random(discoveryInterval / 2 + 1);
+    discoveryInterval =
+        min(discoveryInterval * 2, (unsigned long)ESPNOW_DISCOVERY_MAX_MS);
+  }
 
-  Message msg = {};
-  msg.signature = APP_SIGNATURE;
-  WiFi.macAddress(msg.mac);
-  strcpy(msg.text, "SEARCHING PEERS");
-  msg.type = ConversationType::HELLO;
+  bool sent = broadcastDiscovery();
+  if (!sent && dutyCycling) {
+    // The radio may still be waking up at the start of the window
+    nextBroadcastAt = currentTime + ESPNOW_DUTY_GUARD_MS;
+  }
+  return sent;
+}
 
-  uint8_t broadcastAddr[] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
-  // ESP_LOGI log removed
+/**
+ * @brief Check if a conversation type asks the group something
+ * @param type Conversation type
+ * @return true for the question types
+ */
+static bool isQuestion(ConversationType type) {
+  return type == ConversationType::QUESTION_01 ||
+         type == ConversationType::QUESTION_02 ||
+         type == ConversationType::QUESTION_03;
+}
 
-  // If we've reached max attempts with no response, reinitialize
-  if (broadcastAttempts >= MAX_BROADCAST_ATTEMPTS) {
-    hasLastKnownPeer = false;
-    memset(lastKnownPeerMac, 0, 6);
-    handleConnectionLost();
-    broadcastAttempts = 0;
+/**
+ * @brief Pick the next used peer entry after a cursor
+ * @param cursor Entry index to start after
+ * @return Next used entry index, wrapping around, or -1 if none
+ */
+static int nextPeerAfter(int cursor) {
+  for (int step = 1; step <= ESPNOW_MAX_PEERS; step++) {
+    int index = (cursor + step) % ESPNOW_MAX_PEERS;
+    if (peers[index].used)
+      return index;
   }
-
-  return esp_now_send(broadcastAddr, (uint8_t *)&msg, sizeof(Message)) ==
-         ESP_OK;
+  return -1;
 }
 
 /**
- * @brief Send a data message to the paired device
- * @param text Message text content
+ * @brief Say something to every peer and play it locally
+ *
+ * The message is queued as a reliable record for each peer and goes out
+ * right away unless a frame to that peer is still waiting for its ack, in
+ * which case it is batched into the next frame. Questions ask one listener,
+ * chosen round-robin, to answer.
+ *
  * @param type Conversation type for animation selection
- * @return true if message was sent successfully
+ * @return true if the message was queued for at least one peer
  */
-static bool sendDataMessage(const char *text,
-                            ConversationType type = ConversationType::HELLO) {
+static bool speakToGroup(ConversationType type) {
   if (!isPaired())
     return false;
 
-  unsigned long currentTime = millis();
-  unsigned long previousMessageTime = lastMessageTime;
+  int listener = -1;
+  if (isQuestion(type)) {
+    listener = nextPeerAfter(replyCursor);
+    if (listener >= 0) {
+      replyCursor = listener;
+    }
+  }
 
-  if (currentTime - lastMessageTime < ComsInterval::MESSAGE_INTERVAL)
+  // Every listener gets the same start time, only the reply flag differs
+  uint8_t payload[CONVERSATION_PAYLOAD_MAX];
+  uint8_t length = buildConversationPayload(payload, type, 0);
+  bool queued = false;
+  for (int i = 0; i < ESPNOW_MAX_PEERS; i++) {
+    if (!peers[i].used)
+      continue;
+    payload[1] = (i == listener) ? CONVERSATION_FLAG_REPLY : 0;
+    queued |= appendRecord(peers[i].batch, FrameRecordType::CONVERSATION,
+                           payload, length, true);
+  }
+  if (!queued)
     return false;
 
-  lastMessageTime = currentTime;
+  lastMessageTime = millis();
+  currentAnimation = getConversationEmote(type);
+  currentComState = ComState::PROCESSING;
+  flushPeers();
+  return true;
+}
 
-  Message msg = {};
-  msg.signature = APP_SIGNATURE;
-  WiFi.macAddress(msg.mac);
-  strncpy(msg.text, text, sizeof(msg.text) - 1);
-  msg.text[sizeof(msg.text) - 1] = '\0';
-  msg.type = type;
+/**
+ * @brief Hand the next speaking turn to a peer or take it
+ * @param type Conversation type the speaker says
+ */
+static void handOutTurn(ConversationType type) {
+  int next = nextPeerAfter(turnCursor == SELF_TURN ? -1 : turnCursor);
+  // This device speaks once after every round through the peers
+  if (turnCursor != SELF_TURN && next <= turnCursor) {
+    next = SELF_TURN;
+  }
+  turnCursor = next < 0 ? SELF_TURN : next;
 
-  currentAnimationPath = getAnimationPath(msg.type);
-  currentComState = ComState::PROCESSING;
-  return esp_now_send(peerMac, (uint8_t *)&msg, sizeof(Message)) == ESP_OK;
+  if (turnCursor == SELF_TURN) {
+    speakToGroup(type);
+    return;
+  }
+
+  uint8_t payload = static_cast<uint8_t>(type);
+  appendRecord(peers[turnCursor].batch, FrameRecordType::TURN, &payload,
+               sizeof(payload), true);
+  flushPeers();
 }
 
 /**
- * @brief Handle sequential conversation between paired devices
+ * @brief Handle the group conversation between paired devices
+ *
+ * Only the coordinator decides who speaks next, the others wait for a
+ * TURN record. Orientation reactions go to the whole group from any bot.
  */
-static void handleSequentialConversation() {
+static void handleGroupConversation() {
   static unsigned long lastConversationTime = 0;
   static int sequenceIndex = 0;
   static bool orientationTriggered = false;
@@ -477,41 +2007,73 @@ static void handleSequentialConversation() {
 
   // Check for orientation changes first
   if (motionOriented()) {
-    if (!orientationTriggered) {
-      if (sendDataMessage("ORIENTATION_CHANGE", ConversationType::SHOCK)) {
-        orientationTriggered = true;
-        lastConversationTime = millis();
-      }
-    } else {
-      if (sendDataMessage("ORIENTATION_ZONED", ConversationType::ZONE)) {
-        orientationTriggered = false;
-        lastConversationTime = millis();
-      }
+    ConversationType type = orientationTriggered ? ConversationType::ZONE
+                                                 : ConversationType::SHOCK;
+    if (speakToGroup(type)) {
+      orientationTriggered = !orientationTriggered;
+      lastConversationTime = millis();
     }
     return;
   }
 
   // Reset orientation trigger if no orientation detected
   orientationTriggered = false;
-  // Normal sequential conversation logic
-  if (millis() - lastConversationTime > ComsInterval::MESSAGE_INTERVAL) {
-    const size_t sequenceLength =
-        sizeof(CONVERSATIONS) / sizeof(CONVERSATIONS[0]);
-
-    bool activeSender =
-        (currentRole == DeviceRole::INITIATOR && sequenceIndex % 2 == 0) ||
-        (currentRole == DeviceRole::RESPONDER && sequenceIndex % 2 == 1);
+  currentComState = ComState::WAITING;
 
-    currentComState = ComState::WAITING;
+  if (!isCoordinator())
+    return;
 
-    if (activeSender) {
-      delay(random(100, 500));
-      if (sendDataMessage("CONVERSE", CONVERSATIONS[sequenceIndex].type)) {
-        lastConversationTime = millis();
-      }
-    }
+  handOutTurn(static_cast<ConversationType>(sequenceIndex));
+  sequenceIndex = (sequenceIndex + 1) % CONVERSATION_COUNT;
+  lastConversationTime = millis();
+}
 
-    sequenceIndex = (sequenceIndex + 1) % sequenceLength;
+/**
+ * @brief Log delivery and airtime statistics every ESPNOW_STATS_LOG_INTERVAL
+ */
+static void logEspNowStats() {
+  if (millis() - lastStatsLog < ESPNOW_STATS_LOG_INTERVAL ||
+      stats.framesSent == 0) {
+    return;
+  }
+  lastStatsLog = millis();
+
+  uint32_t reliable = stats.delivered + stats.undelivered;
+  ESP_LOGI(ESPNOW_LOG,
+           "Peers %u | frames tx=%u (%u records, %u retries) rx=%u dup=%u "
+           "bad=%u overflow=%u | delivered %u/%u, avg ack %ums | airtime "
+           "%ums, link failures %u",
+           peerCount, stats.framesSent, stats.recordsSent,
+           stats.retransmissions, stats.framesReceived, stats.duplicates,
+           stats.malformed, stats.rxOverflows,
+           stats.delivered, reliable,
+           stats.delivered ? stats.totalAckMillis / stats.delivered : 0,
+           stats.airtimeMicros / 1000, stats.linkFailures);
+
+  ESP_LOGI(ESPNOW_LOG, "Passes %u, avg %uus max %uus, %u over %uus",
+           stats.passes, stats.passes ? stats.totalPassMicros / stats.passes : 0,
+           stats.maxPassMicros, stats.slowPasses, ESPNOW_PASS_BUDGET_US);
+
+  ESP_LOGI(ESPNOW_LOG,
+           "Discovery %u broadcasts | handshakes %u started, %u paired, %u "
+           "failed | time to pair last %ums avg %ums | radio off %u%% of "
+           "duty cycle",
+           discoveryStats.broadcasts, discoveryStats.handshakesStarted,
+           discoveryStats.handshakesCompleted, discoveryStats.handshakesFailed,
+           discoveryStats.lastTimeToPairMs,
+           discoveryStats.pairings
+               ? discoveryStats.totalTimeToPairMs / discoveryStats.pairings
+               : 0,
+           radioOffPercent());
+
+  if (syncedStarts > 0 || hasClockRef) {
+    ESP_LOGI(ESPNOW_LOG,
+             "Clock %s offset %dus drift %.2fppm rtt %uus | synced starts "
+             "%u, error avg %uus max %uus",
+             isCoordinator() ? "reference" : (clockSynced() ? "synced" : "syncing"),
+             clockOffset, clockDrift * 1e6f, clockDelay, syncedStarts,
+             syncedStarts ? (uint32_t)(totalStartErrorUs / syncedStarts) : 0,
+             maxStartErrorUs);
   }
 }
 
@@ -519,23 +2081,83 @@ static void handleSequentialConversation() {
 // COMMUNICATION MANAGEMENT
 //==============================================================================
 
+/**
+ * @brief Set the next conversation turn, jittered so bots don't align
+ */
+static void scheduleConversation() {
+  nextConversationAt =
+      millis() + ComsInterval::STATUS_INTERVAL +
+      random(ESPNOW_TURN_JITTER_MIN_MS, ESPNOW_TURN_JITTER_MAX_MS + 1);
+}
+
+/**
+ * @brief Account one handleCommunication() pass
+ * @param elapsedUs Duration of the pass (us)
+ */
+static void recordPass(uint32_t elapsedUs) {
+  stats.passes++;
+  stats.totalPassMicros += elapsedUs;
+  if (elapsedUs <= ESPNOW_PASS_BUDGET_US) {
+    if (elapsedUs > stats.maxPassMicros) {
+      stats.maxPassMicros = elapsedUs;
+    }
+    return;
+  }
+
+  stats.slowPasses++;
+  // Only new worst cases, logging every slow pass would slow more of them
+  if (elapsedUs > stats.maxPassMicros) {
+    stats.maxPassMicros = elapsedUs;
+    ESP_LOGW(ESPNOW_LOG, "Slow communication pass: %uus", elapsedUs);
+  }
+}
+
+/**
+ * @brief One pass of the communication state machines
+ */
+static void serviceCommunication() {
+  // Between discovery windows there is nothing to send or receive
+  if (serviceDutyCycle())
+    return;
+
+  // Acks waiting in the queue must land before retransmission is decided
+  processReceivedFrames();
+  collectCallbackStats();
+  serviceRetransmission();
+  expirePeers();
+  serviceHandshakes();
+  flushPeers();
+  requestClockSync();
+  handleTransfer();
+  logEspNowStats();
+
+  if (currentStatus == ComStatus::DISCOVERY) {
+    sendDiscoveryMessage();
+  } else if (static_cast<long>(millis() - nextBroadcastAt) >= 0) {
+    // Presence, jittered so a group's broadcasts drift apart
+    broadcastDiscovery();
+    nextBroadcastAt = millis() + ESPNOW_PRESENCE_INTERVAL -
+                      random(ESPNOW_PRESENCE_INTERVAL / 10);
+  }
+
+  if (currentStatus == ComStatus::PAIRED &&
+      static_cast<long>(millis() - nextConversationAt) >= 0) {
+    handleGroupConversation();
+    scheduleConversation();
+  }
+}
+
 /**
  * @brief Main communication handling function
  */
 void handleCommunication() {
-  static unsigned long lastAttempt = 0;
   // Don't process anything if we're disconnected
   if (getCurrentESPNowState() == ESPNowState::OFF)
     return;
 
-  if (millis() - lastAttempt > ComsInterval::STATUS_INTERVAL) {
-    if (currentStatus == ComStatus::DISCOVERY) {
-      sendDiscoveryMessage();
-    } else if (currentStatus == ComStatus::PAIRED) {
-      handleSequentialConversation();
-    }
-    lastAttempt = millis();
-  }
+  uint32_t passStart = micros();
+  serviceCommunication();
+  recordPass(micros() - passStart);
 }
 
 /**
@@ -562,13 +2184,13 @@ void forceDisconnect() {
 void shutdownCommunication() {
   // ESP_LOGI log removed
   // First disconnect from any peers
+  abortTransfer();
   forceDisconnect();
+  stopDutyCycle();
   // Deinitialize ESP-NOW
-  esp_now_deinit();
-  // Disconnect Wi-Fi
-  if (getCurrentMode() == SystemMode::ESP_MODE) {
-    WiFi.disconnect(true); // true = disable station mode
-  }
+  transport->end();
+  // Frames still queued belong to the old session
+  rxQueue.clear();
   currentESPNowState = ESPNowState::OFF;
   currentStatus = ComStatus::DISCOVERY;
   ESP_LOGW(ESPNOW_LOG, "ESPNOW is turned off");
@@ -580,8 +2202,8 @@ void shutdownCommunication() {
  */
 bool restartCommunication() {
   // Only initialize if necessary
-  if (currentESPNowState == ESPNowState::OFF) {
-    initializeESPNOW();
+  if (currentESPNowState == ESPNowState::OFF && !initializeESPNOW()) {
+    return false;
   }
   // Update state before starting discovery
   currentESPNowState = ESPNowState::ON;
@@ -619,15 +2241,9 @@ bool toggleESPNow() {
   }
 
   // Initialize ESP-NOW
-  if (esp_now_init() != ESP_OK) {
-    ESP_LOGE(ESPNOW_LOG, "ESP-NOW init failed!");
-    espNowToggled = false;
-    return espNowToggled;
-  }
-
+  espNowToggled = restartCommunication();
   // ESP_LOGI log removed
-  espNowToggled = true;
-  return restartCommunication();
+  return espNowToggled;
 }
 
 /**
@@ -651,4 +2267,129 @@ ComState getCurrentComState() { return currentComState; }
 /**
  * @brief Reset ESP-NOW toggle state
  */
-void resetEspNowToggleState() { espNowToggled = false; }
\ No newline at end of file
+void resetEspNowToggleState() { espNowToggled = false; }
+
+/**
+ * @brief Get the number of paired peers
+ * @return Peers in the peer table
+ */
+uint8_t getPeerCount() { return peerCount; }
+
+/**
+ * @brief Get a snapshot of a paired peer
+ * @param index Peer index, 0 to getPeerCount() - 1
+ * @param status Receives the peer snapshot
+ * @return true if the index names a peer
+ */
+bool getPeerStatus(uint8_t index, PeerStatus &status) {
+  for (const PeerEntry &peer : peers) {
+    if (!peer.used)
+      continue;
+    if (index-- > 0)
+      continue;
+    memcpy(status.mac, peer.mac, 6);
+    status.role = peer.role;
+    status.lastSeenAge = millis() - peer.lastSeen;
+    status.linkQuality = peer.linkQuality;
+    return true;
+  }
+  return false;
+}
+
+/**
+ * @brief Current time on the clock shared by the group
+ * @return Shared clock (us), this device's micros() if unsynced
+ */
+uint32_t sharedClockMicros() { return localToShared(micros()); }
+
+/**
+ * @brief Take the scheduled start of the current conversation emote
+ * @param startMicros Receives the start as a local micros() time
+ * @return true if the emote has a scheduled start
+ */
+bool takeScheduledStart(uint32_t &startMicros) {
+  if (!startScheduled)
+    return false;
+  startScheduled = false;
+  startMicros = scheduledStart;
+  return true;
+}
+
+/**
+ * @brief Record how far from its scheduled start an emote began
+ * @param errorUs First pixel time minus scheduled start (us)
+ */
+void recordSyncedStart(int32_t errorUs) {
+  uint32_t error = errorUs < 0 ? -errorUs : errorUs;
+  syncedStarts++;
+  totalStartErrorUs += error;
+  maxStartErrorUs = max(maxStartErrorUs, error);
+}
+
+/**
+ * @brief Get the shared clock estimate and achieved skew
+ * @return Clock sync snapshot
+ */
+ClockSyncStatus getClockSyncStatus() {
+  ClockSyncStatus status;
+  status.reference = isCoordinator();
+  status.synced = hasSharedClock();
+  status.offsetUs = clockSynced() ? clockOffsetAt(micros()) : 0;
+  status.driftPpm = clockDrift * 1e6f;
+  status.delayUs = clockDelay;
+  status.syncedStarts = syncedStarts;
+  status.meanStartErrorUs =
+      syncedStarts ? static_cast<uint32_t>(totalStartErrorUs / syncedStarts)
+                   : 0;
+  status.maxStartErrorUs = maxStartErrorUs;
+  return status;
+}
+
+/**
+ * @brief Get discovery and time-to-pair counters
+ * @return Copy of the counters since boot
+ */
+DiscoveryStats getDiscoveryStats() { return discoveryStats; }
+
+/**
+ * @brief Check if received frames are waiting for handleCommunication()
+ * @return true if the receive queue is not empty
+ */
+bool commsFramesPending() { return !rxQueue.empty(); }
+
+/**
+ * @brief Check whether a device is in the peer table
+ * @param mac Device address
+ * @return true if the device is a paired peer
+ */
+bool isKnownPeer(const uint8_t *mac) { return findPeer(mac) != nullptr; }
+
+/**
+ * @brief Send a frame of another protocol over the ESP-NOW link
+ * @param mac Paired peer or broadcast address
+ * @param data Frame bytes
+ * @param length Frame length
+ * @return true if the transport accepted the frame
+ */
+bool sendEspNowFrame(const uint8_t *mac, const uint8_t *data, size_t length) {
+  if (currentESPNowState == ESPNowState::OFF)
+    return false;
+  return transmitFrame(mac, data, length);
+}
+
+/**
+ * @brief Get ESP-NOW delivery and airtime statistics
+ * @return Copy of the statistics since boot or the last reset
+ */
+EspNowStats getEspNowStats() {
+  collectCallbackStats();
+  return stats;
+}
+
+/**
+ * @brief Clear ESP-NOW statistics
+ */
+void resetEspNowStats() {
+  collectCallbackStats();
+  stats = {};
+}
\ No newline at end of file
@@ -0,0 +1,597 @@
+/**
+ * @file eyes_module.cpp
+ * @brief Implementation of the procedural parametric eye renderer
+ *
+ * Every frame the current behavior turns elapsed time and the latest
+ * tilt state into eye parameters. Each eye whose parameters changed
+ * gets its old and new bounds redrawn row by row: the row is cleared to the
+ * face color, the eye spans and pupil span are filled, effects are applied
+ * and the row is written to the display.
+ */
+
+#include "eyes_module.h"
+#include "display_module.h"
+#include "effects_module.h"
+#include "tilt_module.h"
+
+//==============================================================================
+// TYPE DEFINITIONS
+//==============================================================================
+
+/**
+ * @brief Horizontal run of pixels, end exclusive
+ */
+struct EyeSpan {
+  int16_t start; /**< First column */
+  int16_t end;   /**< Column after the last one */
+};
+
+/**
+ * @brief Screen area covered by an eye, end exclusive
+ */
+struct EyeBounds {
+  int16_t left;   /**< First column */
+  int16_t top;    /**< First row */
+  int16_t right;  /**< Column after the last one */
+  int16_t bottom; /**< Row after the last one */
+};
+
+//==============================================================================
+// GLOBAL VARIABLES
+//==============================================================================
+
+/** @brief Names used after EYES_PATH_PREFIX, indexed by EyeBehavior */
+static const char *BEHAVIOR_NAMES[] = {
+    "idle", "blink", "wink", "look_left_right", "look_up", "look_down",
+    "happy",
+};
+
+/** @brief Length of each behavior (ms), indexed by EyeBehavior */
+static const unsigned long BEHAVIOR_DURATIONS_MS[] = {
+    4000, 1500, 1000, 2800, 1800, 1800, 1500,
+};
+
+/** @brief Number of eye behaviors */
+const size_t EYE_BEHAVIOR_TOTAL =
+    static_cast<size_t>(EyeBehavior::EYE_BEHAVIOR_COUNT);
+
+static_assert(sizeof(BEHAVIOR_NAMES) / sizeof(BEHAVIOR_NAMES[0]) ==
+                  EYE_BEHAVIOR_TOTAL,
+              "Eye behavior names out of sync");
+static_assert(sizeof(BEHAVIOR_DURATIONS_MS) /
+                      sizeof(BEHAVIOR_DURATIONS_MS[0]) ==
+                  EYE_BEHAVIOR_TOTAL,
+              "Eye behavior durations out of sync");
+
+//------------------------------------------------------------------------------
+// Blink timing (ms)
+//------------------------------------------------------------------------------
+const unsigned long BLINK_CLOSE_MS = 80;
+const unsigned long BLINK_HOLD_MS = 20;
+const unsigned long BLINK_OPEN_MS = 120;
+const unsigned long BLINK_TOTAL_MS =
+    BLINK_CLOSE_MS + BLINK_HOLD_MS + BLINK_OPEN_MS;
+const unsigned long IDLE_BLINK_MIN_MS = 1800;
+const unsigned long IDLE_BLINK_MAX_MS = 3500;
+
+/** @brief Eyes as last drawn, left then right */
+static EyeParams eyes[2];
+/** @brief Screen area each eye covered when last drawn */
+static EyeBounds drawnBounds[2];
+/** @brief Eyes have been set up */
+static bool eyesInitialized = false;
+/** @brief Redraw the whole screen on the next frame */
+static bool fullRedraw = true;
+/** @brief Behavior being played */
+static EyeBehavior currentBehavior = EyeBehavior::IDLE;
+/** @brief Time the behavior started (ms) */
+static unsigned long behaviorStart = 0;
+/** @brief Time of the next idle blink (ms) */
+static unsigned long nextIdleBlink = 0;
+/** @brief Row being composed */
+static uint16_t lineBuffer[DISPLAY_WIDTH];
+
+//==============================================================================
+// FIXED-POINT HELPERS
+//==============================================================================
+
+/**
+ * @brief Integer square root
+ *
+ * @param value Input
+ * @return floor(sqrt(value))
+ */
+static uint32_t isqrt32(uint32_t value) {
+  uint32_t result = 0;
+  uint32_t bit = 1UL << 30;
+  while (bit > value) {
+    bit >>= 2;
+  }
+  while (bit != 0) {
+    if (value >= result + bit) {
+      value -= result + bit;
+      result = (result >> 1) + bit;
+    } else {
+      result >>= 1;
+    }
+    bit >>= 2;
+  }
+  return result;
+}
+
+/**
+ * @brief Half width of an ellipse at a vertical offset
+ *
+ * @param rx Horizontal radius
+ * @param ry Vertical radius
+ * @param dy Offset from the center row
+ * @return Half width, negative if the row misses the ellipse
+ */
+static int32_t ellipseHalfWidth(int32_t rx, int32_t ry, int32_t dy) {
+  if (dy < 0)
+    dy = -dy;
+  if (ry <= 0 || dy >= ry)
+    return -1;
+  // Both squares are Q16, so the root is back in EYE_FIXED units
+  int32_t root = isqrt32(ry * ry - dy * dy);
+  return rx * root / ry;
+}
+
+/**
+ * @brief Half width of a rounded rectangle at a vertical offset
+ *
+ * @param rx Horizontal radius
+ * @param ry Vertical radius
+ * @param dy Offset from the center row
+ * @return Half width, negative if the row misses the rectangle
+ */
+static int32_t roundedRectHalfWidth(int32_t rx, int32_t ry, int32_t dy) {
+  if (dy < 0)
+    dy = -dy;
+  if (ry <= 0 || dy >= ry)
+    return -1;
+  int32_t corner = min(rx, ry) / 2;
+  if (dy <= ry - corner)
+    return rx;
+  int32_t cornerDy = dy - (ry - corner);
+  return rx - corner + isqrt32(corner * corner - cornerDy * cornerDy);
+}
+
+/**
+ * @brief Smoothly interpolate between two values
+ *
+ * @param from Value at the start
+ * @param to Value at the end
+ * @param elapsed Time into the move (ms)
+ * @param duration Length of the move (ms)
+ * @return Interpolated value with ease in and out
+ */
+static int32_t ease(int32_t from, int32_t to, unsigned long elapsed,
+                    unsigned long duration) {
+  int32_t p = (elapsed >= duration) ? 256 : (int32_t)(elapsed * 256 / duration);
+  int32_t s = (p * p * (768 - 2 * p)) >> 16;
+  return from + (((to - from) * s) >> 8);
+}
+
+/**
+ * @brief Convert a span around a center to pixel columns
+ *
+ * A pixel is covered when its center lies inside the span.
+ *
+ * @param center Span center
+ * @param halfWidth Span half width
+ * @return Pixel span clipped to the screen
+ */
+static EyeSpan toPixels(int32_t center, int32_t halfWidth) {
+  const int32_t half = EYE_FIXED(1) / 2;
+  int32_t start = (center - halfWidth - half + EYE_FIXED(1) - 1) >>
+                  EYE_FIXED_SHIFT;
+  int32_t end = ((center + halfWidth - half) >> EYE_FIXED_SHIFT) + 1;
+  return {static_cast<int16_t>(constrain(start, 0, DISPLAY_WIDTH)),
+          static_cast<int16_t>(constrain(end, 0, DISPLAY_WIDTH))};
+}
+
+//==============================================================================
+// RASTERIZATION
+//==============================================================================
+
+/**
+ * @brief Vertical radius after applying the lid
+ */
+static int32_t openRadiusY(const EyeParams &eye) {
+  return (eye.radiusY * eye.openness) >> EYE_FIXED_SHIFT;
+}
+
+/**
+ * @brief Spans of an eye's fill on one row
+ *
+ * @param eye Eye to rasterize
+ * @param row Screen row
+ * @param spans Receives up to two spans
+ * @return Number of spans
+ */
+static int eyeSpans(const EyeParams &eye, int16_t row, EyeSpan spans[2]) {
+  int32_t dy = EYE_FIXED(row) + EYE_FIXED(1) / 2 - eye.centerY;
+  int32_t ry = openRadiusY(eye);
+
+  // A nearly closed eye is drawn as a lid line
+  if (ry < EYE_FIXED(2)) {
+    if (dy < -EYE_FIXED(1) || dy >= EYE_FIXED(1))
+      return 0;
+    spans[0] = toPixels(eye.centerX, eye.radiusX * 3 / 4);
+    return 1;
+  }
+
+  int32_t half;
+  switch (eye.shape) {
+  case EyeShape::SQUARE:
+    half = roundedRectHalfWidth(eye.radiusX, ry, dy);
+    break;
+
+  case EyeShape::HAPPY: {
+    if (dy > 0)
+      return 0;
+    half = ellipseHalfWidth(eye.radiusX, ry, dy);
+    if (half < 0)
+      return 0;
+    int32_t inner = ellipseHalfWidth(eye.radiusX * 5 / 8, ry * 5 / 8, dy);
+    if (inner < 0)
+      break;
+    spans[0] = toPixels(eye.centerX - (half + inner) / 2, (half - inner) / 2);
+    spans[1] = toPixels(eye.centerX + (half + inner) / 2, (half - inner) / 2);
+    return 2;
+  }
+
+  case EyeShape::ROUND:
+  default:
+    half = ellipseHalfWidth(eye.radiusX, ry, dy);
+    break;
+  }
+
+  if (half < 0)
+    return 0;
+  spans[0] = toPixels(eye.centerX, half);
+  return 1;
+}
+
+/**
+ * @brief Span of an eye's pupil on one row, clipped to the eye fill
+ *
+ * @param eye Eye to rasterize
+ * @param row Screen row
+ * @param fill Eye fill span on the same row
+ * @param span Receives the pupil span
+ * @return true if the pupil covers part of the row
+ */
+static bool pupilSpan(const EyeParams &eye, int16_t row, const EyeSpan &fill,
+                      EyeSpan &span) {
+  if (eye.shape == EyeShape::HAPPY || openRadiusY(eye) < EYE_FIXED(2))
+    return false;
+
+  // The pupil follows the lid so it stays inside a half closed eye
+  int32_t centerY =
+      eye.centerY + ((eye.pupilY * eye.openness) >> EYE_FIXED_SHIFT);
+  int32_t dy = EYE_FIXED(row) + EYE_FIXED(1) / 2 - centerY;
+  int32_t half = ellipseHalfWidth(eye.pupilRadius, eye.pupilRadius, dy);
+  if (half < 0)
+    return false;
+
+  span = toPixels(eye.centerX + eye.pupilX, half);
+  span.start = max(span.start, fill.start);
+  span.end = min(span.end, fill.end);
+  return span.start < span.end;
+}
+
+/**
+ * @brief Check whether two eyes would draw the same pixels
+ */
+static bool sameEye(const EyeParams &a, const EyeParams &b) {
+  return a.centerX == b.centerX && a.centerY == b.centerY &&
+         a.radiusX == b.radiusX && a.radiusY == b.radiusY &&
+         a.openness == b.openness && a.pupilX == b.pupilX &&
+         a.pupilY == b.pupilY && a.pupilRadius == b.pupilRadius &&
+         a.shape == b.shape;
+}
+
+/**
+ * @brief Screen area an eye covers, with a one pixel margin
+ */
+static EyeBounds eyeBounds(const EyeParams &eye) {
+  int32_t left = ((eye.centerX - eye.radiusX) >> EYE_FIXED_SHIFT) - 1;
+  int32_t right = ((eye.centerX + eye.radiusX) >> EYE_FIXED_SHIFT) + 2;
+  int32_t top = ((eye.centerY - eye.radiusY) >> EYE_FIXED_SHIFT) - 1;
+  int32_t bottom = ((eye.centerY + eye.radiusY) >> EYE_FIXED_SHIFT) + 2;
+  return {static_cast<int16_t>(constrain(left, 0, DISPLAY_WIDTH)),
+          static_cast<int16_t>(constrain(top, 0, DISPLAY_HEIGHT)),
+          static_cast<int16_t>(constrain(right, 0, DISPLAY_WIDTH)),
+          static_cast<int16_t>(constrain(bottom, 0, DISPLAY_HEIGHT))};
+}
+
+/**
+ * @brief Fill part of the line buffer
+ *
+ * @param span Columns to fill
+ * @param left First column held by the line buffer
+ * @param width Columns held by the line buffer
+ * @param color RGB565 color
+ */
+static void fillSpan(const EyeSpan &span, int16_t left, int16_t width,
+                     uint16_t color) {
+  int16_t start = max<int16_t>(span.start, left);
+  int16_t end = min<int16_t>(span.end, left + width);
+  for (int16_t x = start; x < end; x++) {
+    lineBuffer[x - left] = color;
+  }
+}
+
+/**
+ * @brief Draw both eyes into a screen area
+ *
+ * @param area Area to redraw
+ * @return Number of pixels written
+ */
+static uint32_t drawArea(const EyeBounds &area) {
+  int16_t width = area.right - area.left;
+  int16_t height = area.bottom - area.top;
+  if (width <= 0 || height <= 0)
+    return 0;
+
+  startWrite();
+  setAddrWindow(area.left, area.top, width, height);
+  for (int16_t row = area.top; row < area.bottom; row++) {
+    for (int16_t i = 0; i < width; i++) {
+      lineBuffer[i] = EYE_BACKGROUND;
+    }
+
+    for (const EyeParams &eye : eyes) {
+      EyeSpan spans[2];
+      int count = eyeSpans(eye, row, spans);
+      for (int s = 0; s < count; s++) {
+        fillSpan(spans[s], area.left, width, EYE_COLOR);
+      }
+
+      EyeSpan pupil;
+      if (count == 1 && pupilSpan(eye, row, spans[0], pupil)) {
+        fillSpan(pupil, area.left, width, EYE_PUPIL_COLOR);
+      }
+    }
+
+    applyEffectsToScanline(lineBuffer, width, row);
+    writePixels(lineBuffer, width);
+  }
+  endWrite();
+  return width * height;
+}
+
+//==============================================================================
+// BEHAVIORS
+//==============================================================================
+
+/**
+ * @brief Lid openness during a blink
+ *
+ * @param elapsed Time since the blink started (ms)
+ * @return Openness, EYE_OPEN outside the blink
+ */
+static int32_t blinkOpenness(unsigned long elapsed) {
+  if (elapsed < BLINK_CLOSE_MS)
+    return ease(EYE_OPEN, 0, elapsed, BLINK_CLOSE_MS);
+  elapsed -= BLINK_CLOSE_MS;
+  if (elapsed < BLINK_HOLD_MS)
+    return 0;
+  elapsed -= BLINK_HOLD_MS;
+  return ease(0, EYE_OPEN, elapsed, BLINK_OPEN_MS);
+}
+
+/**
+ * @brief Reset both eyes to the neutral pose
+ */
+static void initializeEyes() {
+  for (int i = 0; i < 2; i++) {
+    EyeParams &eye = eyes[i];
+    eye.centerX = EYE_FIXED(i == 0 ? EYE_LEFT_X : EYE_RIGHT_X);
+    eye.centerY = EYE_FIXED(EYE_CENTER_Y);
+    eye.radiusX = EYE_FIXED(EYE_RADIUS_X);
+    eye.radiusY = EYE_FIXED(EYE_RADIUS_Y);
+    eye.openness = EYE_OPEN;
+    eye.pupilX = 0;
+    eye.pupilY = 0;
+    eye.pupilRadius = EYE_FIXED(EYE_PUPIL_RADIUS);
+    eye.shape = EyeShape::ROUND;
+    drawnBounds[i] = eyeBounds(eye);
+  }
+  eyesInitialized = true;
+}
+
+/**
+ * @brief Compute the parameters of both eyes for the current time
+ *
+ * @param now Current time (ms)
+ * @param next Receives left and right eye parameters
+ */
+static void updateBehavior(unsigned long now, EyeParams next[2]) {
+  unsigned long t = now - behaviorStart;
+  unsigned long duration =
+      BEHAVIOR_DURATIONS_MS[static_cast<size_t>(currentBehavior)];
+  // Pupils follow the tilt directly, the eyes themselves slosh behind it
+  TiltState tilt = getTiltState();
+  int32_t gazeX = (int32_t)(tilt.tiltX * EYE_FIXED(EYE_GAZE_RANGE_X));
+  int32_t gazeY = (int32_t)(tilt.tiltY * EYE_FIXED(EYE_GAZE_RANGE_Y));
+  int32_t sloshX = (int32_t)(tilt.sloshX * EYE_FIXED(EYE_PARALLAX_RANGE));
+  int32_t sloshY = (int32_t)(tilt.sloshY * EYE_FIXED(EYE_PARALLAX_RANGE));
+  int32_t openLeft = EYE_OPEN;
+  int32_t openRight = EYE_OPEN;
+  EyeShape shape = EyeShape::ROUND;
+
+  switch (currentBehavior) {
+  case EyeBehavior::IDLE:
+    if ((long)(now - nextIdleBlink) >= 0) {
+      unsigned long blinkTime = now - nextIdleBlink;
+      openLeft = openRight = blinkOpenness(blinkTime);
+      if (blinkTime >= BLINK_TOTAL_MS) {
+        nextIdleBlink = now + random(IDLE_BLINK_MIN_MS, IDLE_BLINK_MAX_MS);
+      }
+    }
+    break;
+
+  case EyeBehavior::BLINK:
+    if (t + BLINK_TOTAL_MS >= duration) {
+      openLeft = openRight = blinkOpenness(t + BLINK_TOTAL_MS - duration);
+    }
+    break;
+
+  case EyeBehavior::WINK:
+    if (t >= 200 && t < 500) {
+      openRight = ease(EYE_OPEN, 0, t - 200, 150);
+    } else if (t >= 500) {
+      openRight = ease(0, EYE_OPEN, t - 500, 200);
+    }
+    break;
+
+  case EyeBehavior::LOOK_LEFT_RIGHT: {
+    const int32_t range = EYE_FIXED(EYE_GAZE_RANGE_X);
+    gazeY = 0;
+    if (t < 400) {
+      gazeX = ease(0, -range, t, 400);
+    } else if (t < 1000) {
+      gazeX = -range;
+    } else if (t < 1600) {
+      gazeX = ease(-range, range, t - 1000, 600);
+    } else if (t < 2200) {
+      gazeX = range;
+    } else {
+      gazeX = ease(range, 0, t - 2200, 400);
+    }
+    break;
+  }
+
+  case EyeBehavior::LOOK_UP:
+  case EyeBehavior::LOOK_DOWN: {
+    int32_t target = EYE_FIXED(EYE_GAZE_RANGE_Y);
+    if (currentBehavior == EyeBehavior::LOOK_UP)
+      target = -target;
+    gazeX = 0;
+    if (t < 300) {
+      gazeY = ease(0, target, t, 300);
+    } else if (t < 1300) {
+      gazeY = target;
+    } else {
+      gazeY = ease(target, 0, t - 1300, 300);
+    }
+    break;
+  }
+
+  case EyeBehavior::HAPPY:
+    shape = EyeShape::HAPPY;
+    break;
+
+  default:
+    break;
+  }
+
+  for (int i = 0; i < 2; i++) {
+    next[i] = eyes[i];
+    next[i].shape = shape;
+    next[i].openness = (i == 0) ? openLeft : openRight;
+    next[i].pupilX = gazeX;
+    next[i].pupilY = gazeY;
+    // Shift the whole eye a little with the pupil for a sense of depth
+    next[i].centerX =
+        EYE_FIXED(i == 0 ? EYE_LEFT_X : EYE_RIGHT_X) + gazeX / 4 + sloshX;
+    next[i].centerY = EYE_FIXED(EYE_CENTER_Y) + gazeY / 4 + sloshY;
+  }
+}
+
+//==============================================================================
+// PUBLIC API FUNCTIONS
+//==============================================================================
+
+/**
+ * @brief Check whether a path names a procedural eye emote
+ *
+ * @param path Emote path
+ * @return true if the path starts with EYES_PATH_PREFIX
+ */
+bool isProceduralEyes(const char *path) {
+  return path && strncmp(path, EYES_PATH_PREFIX,
+                         strlen(EYES_PATH_PREFIX)) == 0;
+}
+
+/**
+ * @brief Start the eye behavior named by a path
+ *
+ * @param path Emote path, e.g. "/eyes/blink"
+ * @param durationMs Receives the behavior length (ms)
+ * @return true if the behavior exists
+ */
+bool loadEyeBehavior(const char *path, unsigned long *durationMs) {
+  if (!isProceduralEyes(path))
+    return false;
+
+  const char *name = path + strlen(EYES_PATH_PREFIX);
+  for (size_t i = 0; i < EYE_BEHAVIOR_TOTAL; i++) {
+    if (strcmp(name, BEHAVIOR_NAMES[i]) == 0) {
+      if (!eyesInitialized) {
+        initializeEyes();
+      }
+      currentBehavior = static_cast<EyeBehavior>(i);
+      behaviorStart = millis();
+      nextIdleBlink = behaviorStart + random(IDLE_BLINK_MIN_MS, IDLE_BLINK_MAX_MS);
+      *durationMs = BEHAVIOR_DURATIONS_MS[i];
+      // The previous emote may have drawn anywhere on screen
+      fullRedraw = true;
+      return true;
+    }
+  }
+
+  ESP_LOGE(EYES_LOG, "ERROR: Unknown eye behavior: %s", path);
+  return false;
+}
+
+/**
+ * @brief Advance the current behavior and draw the eyes
+ *
+ * @return Number of pixels written this frame
+ */
+uint32_t renderEyesFrame() {
+  if (!eyesInitialized) {
+    initializeEyes();
+  }
+
+  EyeParams next[2];
+  updateBehavior(millis(), next);
+
+  bool changed[2];
+  EyeBounds areas[2];
+  for (int i = 0; i < 2; i++) {
+    changed[i] = !sameEye(next[i], eyes[i]);
+    EyeBounds bounds = eyeBounds(next[i]);
+    areas[i] = {min(bounds.left, drawnBounds[i].left),
+                min(bounds.top, drawnBounds[i].top),
+                max(bounds.right, drawnBounds[i].right),
+                max(bounds.bottom, drawnBounds[i].bottom)};
+    eyes[i] = next[i];
+    drawnBounds[i] = bounds;
+  }
+
+  if (fullRedraw) {
+    fullRedraw = false;
+    return drawArea({0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT});
+  }
+
+  uint32_t pixelsWritten = 0;
+  for (int i = 0; i < 2; i++) {
+    if (changed[i]) {
+      pixelsWritten += drawArea(areas[i]);
+    }
+  }
+  return pixelsWritten;
+}
+
+/**
+ * @brief Current parameters of an eye
+ *
+ * @param right true for the right eye
+ * @return Eye parameters as last drawn
+ */
+EyeParams getEyeParams(bool right) { return eyes[right ? 1 : 0]; }
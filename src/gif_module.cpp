@@ -26,6 +26,12 @@ const size_t frameBufferSize = GIF_WIDTH * GIF_HEIGHT * 2;
 bool isInitialized = false;
 /** @brief File handle for current GIF */
 File gifFile;
+/** @brief File handle opened ahead of time by prefetchGIF() */
+static File prefetchFile;
+/** @brief Path of prefetchFile, nullptr if nothing is warm */
+static const char *prefetchPath = nullptr;
+/** @brief micros() when the first scanline of the current GIF was written */
+static uint32_t firstPixelTime = 0;
 
 //==============================================================================
 // FILE I/O CALLBACKS FOR ANIMATEDGIF LIBRARY
@@ -39,7 +45,14 @@ File gifFile;
  * @return Pointer to file handle or NULL if failed
  */
 void *GIFOpenFile(const char *fname, int32_t *pSize) {
-  gifFile = LittleFS.open(fname);
+  if (prefetchPath && prefetchFile && strcmp(fname, prefetchPath) == 0) {
+    gifFile = prefetchFile;
+    gifFile.seek(0);
+    prefetchFile = File();
+    prefetchPath = nullptr;
+  } else {
+    gifFile = LittleFS.open(fname);
+  }
   if (gifFile) {
     *pSize = gifFile.size();
     return (void *)&gifFile;
@@ -113,6 +126,9 @@ static void GIFDraw(GIFDRAW *pDraw) {
 
   // If neither is enabled, pixels remain unchanged
   writePixels(pixels, pDraw->iWidth);
+  if (firstPixelTime == 0) {
+    firstPixelTime = micros();
+  }
   if (pDraw->y == pDraw->iHeight - 1) {
     endWrite();
   }
@@ -162,8 +178,17 @@ void stopGifPlayback() {
     gifContext.sharedFrameBuffer = nullptr;
   }
   gif.close();
+  prefetchGIF(nullptr);
 }
 
+/**
+ * @brief Close the current GIF but keep the frame buffer allocated
+ *
+ * Used between emotes so the next loadGIF() starts warm instead of
+ * re-allocating the PSRAM frame buffer.
+ */
+void closeGIF() { gif.close(); }
+
 /**
  * @brief Initialize the GIF player
  *
@@ -205,6 +230,7 @@ bool initializeGIFPlayer() {
  * @return true if GIF was loaded successfully
  */
 bool loadGIF(const char *filename) {
+  firstPixelTime = 0;
   if (!gif.open(filename, GIFOpenFile, GIFCloseFile, GIFReadFile, GIFSeekFile,
                 GIFDraw)) {
     ESP_LOGE(GIF_LOG, "ERROR: Failed to open GIF: %s", filename);
@@ -232,6 +258,30 @@ bool loadGIF(const char *filename) {
   return true;
 }
 
+/**
+ * @brief Open a GIF file ahead of time
+ *
+ * @param filename Path to the GIF file, nullptr to drop the warm handle
+ */
+void prefetchGIF(const char *filename) {
+  if (filename && prefetchPath && strcmp(filename, prefetchPath) == 0)
+    return;
+
+  if (prefetchFile) {
+    prefetchFile.close();
+  }
+  prefetchFile = File();
+  prefetchPath = nullptr;
+
+  if (!filename)
+    return;
+
+  prefetchFile = LittleFS.open(filename);
+  if (prefetchFile) {
+    prefetchPath = filename;
+  }
+}
+
 /**
  * @brief Play a single frame of the current GIF
  *
@@ -243,6 +293,13 @@ int playGIFFrame(bool bSync, int *delayMilliseconds) {
   return gif.playFrame(bSync, delayMilliseconds);
 }
 
+/**
+ * @brief Time the first scanline of the current GIF reached the display
+ *
+ * @return micros() timestamp, or 0 if nothing was drawn since loadGIF()
+ */
+uint32_t getFirstPixelTime() { return firstPixelTime; }
+
 /**
  * @brief Check if the GIF player is initialized
  *
@@ -0,0 +1,448 @@
+/**
+ * @file inflate_module.cpp
+ * @brief Implementation of streaming decompression of update images
+ *
+ * tinfl from the ROM decodes into a 32 KB ring that doubles as the deflate
+ * history, every time it fills or the input runs out the new bytes are
+ * handed to Update. tinfl parses zlib streams itself, the gzip header in
+ * front of a raw deflate stream is parsed here one byte at a time.
+ *
+ * tinfl in ROM reads ahead of the deflate stream and keeps the bytes it took
+ * when the stream ends, so the gzip trailer can't be read from what it left
+ * over. The last GZIP_TRAILER_SIZE bytes seen are held back from it instead
+ * and are the trailer once the stream has ended.
+ */
+
+#include "inflate_module.h"
+#include <Update.h>
+#include <esp_rom_crc.h>
+#include <rom/miniz.h>
+
+//==============================================================================
+// TYPE DEFINITIONS
+//==============================================================================
+
+/**
+ * @brief Parts of a gzip member, in stream order
+ */
+enum class GzipStage : uint8_t {
+  FIXED,        /**< Magic, method, flags, time, extra flags and OS */
+  EXTRA_LENGTH, /**< FEXTRA: uint16 length */
+  EXTRA,        /**< FEXTRA: skipped bytes */
+  NAME,         /**< FNAME: zero terminated */
+  COMMENT,      /**< FCOMMENT: zero terminated */
+  HEADER_CRC,   /**< FHCRC: uint16 */
+  BODY,         /**< Raw deflate stream, trailer held back at its end */
+  DONE          /**< Nothing more may follow */
+};
+
+//==============================================================================
+// CONSTANTS
+//==============================================================================
+
+/** @brief Size of the fixed gzip header (bytes) */
+#define GZIP_FIXED_SIZE 10
+/** @brief Size of the gzip trailer (bytes) */
+#define GZIP_TRAILER_SIZE 8
+
+// gzip header flags
+#define GZIP_FLAG_HCRC 0x02
+#define GZIP_FLAG_EXTRA 0x04
+#define GZIP_FLAG_NAME 0x08
+#define GZIP_FLAG_COMMENT 0x10
+#define GZIP_FLAG_RESERVED 0xE0
+
+//==============================================================================
+// GLOBAL VARIABLES
+//==============================================================================
+
+/** @brief Decompressor state, allocated by beginInflate() */
+static tinfl_decompressor *decompressor = nullptr;
+/** @brief Output ring and deflate history, TINFL_LZ_DICT_SIZE bytes */
+static uint8_t *history = nullptr;
+/** @brief Position of the next output byte in history */
+static size_t historyPos = 0;
+/** @brief Encoding of the image being inflated */
+static ImageEncoding activeEncoding = ImageEncoding::NONE;
+/** @brief Called after each block of output */
+static InflateProgressHandler progressHandler = nullptr;
+/** @brief Takes the output instead of Update if set */
+static InflateOutputHandler outputHandler = nullptr;
+/** @brief The deflate stream has ended */
+static bool streamDone = false;
+/** @brief Image bytes written to Update */
+static size_t inflatedSize = 0;
+/** @brief CRC32 of the image bytes, checked against the gzip trailer */
+static uint32_t inflatedCrc = 0;
+/** @brief Why inflating failed */
+static const char *inflateError = "";
+
+/** @brief gzip part being parsed */
+static GzipStage gzipStage = GzipStage::FIXED;
+/** @brief gzip header flags */
+static uint8_t gzipFlags = 0;
+/** @brief Bytes of the current gzip part seen so far */
+static uint16_t gzipCount = 0;
+/** @brief FEXTRA length */
+static uint16_t gzipExtraLength = 0;
+/** @brief Last bytes seen, kept from tinfl, the trailer once the body ends */
+static uint8_t gzipTail[GZIP_TRAILER_SIZE];
+/** @brief Bytes in gzipTail */
+static size_t gzipTailLength = 0;
+
+//==============================================================================
+// UTILITY FUNCTIONS
+//==============================================================================
+
+/**
+ * @brief Record why inflating failed
+ *
+ * @param message Error message
+ * @return false, for use in a return statement
+ */
+static bool fail(const char *message) {
+  inflateError = message;
+  ESP_LOGE(INFLATE_LOG, "%s after %u image bytes", message,
+           (unsigned)inflatedSize);
+  return false;
+}
+
+/**
+ * @brief Read a little endian uint32
+ *
+ * @param in Four bytes
+ * @return Value
+ */
+static uint32_t getUint32(const uint8_t *in) {
+  return in[0] | (in[1] << 8) | (in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+//==============================================================================
+// GZIP FRAMING
+//==============================================================================
+
+/**
+ * @brief Whether a gzip part is present in this member
+ *
+ * @param stage Part to check
+ * @return true if the part has to be parsed
+ */
+static bool gzipStageUsed(GzipStage stage) {
+  switch (stage) {
+  case GzipStage::EXTRA_LENGTH:
+    return gzipFlags & GZIP_FLAG_EXTRA;
+  case GzipStage::EXTRA:
+    return (gzipFlags & GZIP_FLAG_EXTRA) && gzipExtraLength > 0;
+  case GzipStage::NAME:
+    return gzipFlags & GZIP_FLAG_NAME;
+  case GzipStage::COMMENT:
+    return gzipFlags & GZIP_FLAG_COMMENT;
+  case GzipStage::HEADER_CRC:
+    return gzipFlags & GZIP_FLAG_HCRC;
+  default:
+    return true;
+  }
+}
+
+/**
+ * @brief Move on to the next gzip part present
+ */
+static void nextGzipStage() {
+  gzipCount = 0;
+  do {
+    gzipStage = static_cast<GzipStage>(static_cast<uint8_t>(gzipStage) + 1);
+  } while (!gzipStageUsed(gzipStage));
+}
+
+/**
+ * @brief Parse one byte of the gzip header
+ *
+ * @param byte Next header byte
+ * @return false if the header is not a deflate gzip member
+ */
+static bool gzipHeaderByte(uint8_t byte) {
+  switch (gzipStage) {
+  case GzipStage::FIXED:
+    if ((gzipCount == 0 && byte != 0x1F) || (gzipCount == 1 && byte != 0x8B) ||
+        (gzipCount == 2 && byte != 8)) {
+      return fail("Not a gzip image");
+    }
+    if (gzipCount == 3) {
+      if (byte & GZIP_FLAG_RESERVED) {
+        return fail("Unsupported gzip flags");
+      }
+      gzipFlags = byte;
+    }
+    if (++gzipCount == GZIP_FIXED_SIZE) {
+      nextGzipStage();
+    }
+    return true;
+  case GzipStage::EXTRA_LENGTH:
+    gzipExtraLength |= byte << (8 * gzipCount);
+    if (++gzipCount == 2) {
+      nextGzipStage();
+    }
+    return true;
+  case GzipStage::EXTRA:
+    if (++gzipCount == gzipExtraLength) {
+      nextGzipStage();
+    }
+    return true;
+  case GzipStage::NAME:
+  case GzipStage::COMMENT:
+    if (byte == 0) {
+      nextGzipStage();
+    }
+    return true;
+  case GzipStage::HEADER_CRC:
+    if (++gzipCount == 2) {
+      nextGzipStage();
+    }
+    return true;
+  default:
+    return false;
+  }
+}
+
+//==============================================================================
+// INFLATING
+//==============================================================================
+
+/**
+ * @brief Inflate as much of the input as possible
+ *
+ * Stops when the input is used up or the deflate stream ends, data and
+ * length are advanced past the bytes consumed.
+ *
+ * @param data Compressed bytes
+ * @param length Number of bytes
+ * @return false on corrupt data or a flash write error
+ */
+static bool inflateBody(const uint8_t *&data, size_t &length) {
+  mz_uint32 flags = TINFL_FLAG_HAS_MORE_INPUT;
+  if (activeEncoding == ImageEncoding::DEFLATE) {
+    flags |= TINFL_FLAG_PARSE_ZLIB_HEADER | TINFL_FLAG_COMPUTE_ADLER32;
+  }
+
+  while (true) {
+    size_t inSize = length;
+    size_t outSize = TINFL_LZ_DICT_SIZE - historyPos;
+    tinfl_status status =
+        tinfl_decompress(decompressor, data, &inSize, history,
+                         history + historyPos, &outSize, flags);
+    data += inSize;
+    length -= inSize;
+
+    if (outSize > 0) {
+      uint8_t *out = history + historyPos;
+      if (outputHandler) {
+        if (!outputHandler(out, outSize)) {
+          return fail("Output rejected");
+        }
+      } else if (Update.write(out, outSize) != outSize) {
+        return fail("Flash write failed");
+      }
+      inflatedCrc = esp_rom_crc32_le(inflatedCrc, out, outSize);
+      inflatedSize += outSize;
+      historyPos = (historyPos + outSize) & (TINFL_LZ_DICT_SIZE - 1);
+      if (progressHandler) {
+        progressHandler(inflatedSize);
+      }
+    }
+
+    if (status == TINFL_STATUS_ADLER32_MISMATCH) {
+      return fail("Image checksum mismatch");
+    }
+    if (status < TINFL_STATUS_DONE) {
+      return fail("Corrupt compressed data");
+    }
+    if (status == TINFL_STATUS_DONE) {
+      streamDone = true;
+      return true;
+    }
+    if (status == TINFL_STATUS_NEEDS_MORE_INPUT && length == 0) {
+      return true;
+    }
+  }
+}
+
+/**
+ * @brief Inflate gzip body bytes that can't be part of the trailer
+ *
+ * @param data Compressed bytes
+ * @param length Number of bytes
+ * @return false on corrupt data, a flash write error or bytes between the
+ *         deflate stream and the trailer
+ */
+static bool inflateGzipBody(const uint8_t *data, size_t length) {
+  if (length == 0) {
+    return true;
+  }
+  if (streamDone) {
+    return fail("Data after the end of the image");
+  }
+  if (!inflateBody(data, length)) {
+    return false;
+  }
+  // Only the end of the stream leaves input unconsumed
+  if (length > 0) {
+    return fail("Data after the end of the image");
+  }
+  return true;
+}
+
+/**
+ * @brief Take the next gzip body bytes, holding back the possible trailer
+ *
+ * @param data Compressed bytes
+ * @param length Number of bytes, all of them are used
+ * @return false on corrupt data or a flash write error
+ */
+static bool gzipBodyBytes(const uint8_t *data, size_t length) {
+  size_t total = gzipTailLength + length;
+  size_t ready = total > GZIP_TRAILER_SIZE ? total - GZIP_TRAILER_SIZE : 0;
+
+  // Held back bytes go first, they are older than the new ones
+  size_t fromTail = min(ready, gzipTailLength);
+  if (!inflateGzipBody(gzipTail, fromTail)) {
+    return false;
+  }
+  memmove(gzipTail, gzipTail + fromTail, gzipTailLength - fromTail);
+  gzipTailLength -= fromTail;
+
+  size_t fromData = ready - fromTail;
+  if (!inflateGzipBody(data, fromData)) {
+    return false;
+  }
+  memcpy(gzipTail + gzipTailLength, data + fromData, length - fromData);
+  gzipTailLength += length - fromData;
+
+  if (streamDone) {
+    nextGzipStage();
+  }
+  return true;
+}
+
+//==============================================================================
+// PUBLIC API FUNCTIONS
+//==============================================================================
+
+bool parseImageEncoding(const String &name, ImageEncoding &encoding) {
+  if (name.length() == 0 || name == "none") {
+    encoding = ImageEncoding::NONE;
+  } else if (name == "gzip") {
+    encoding = ImageEncoding::GZIP;
+  } else if (name == "deflate") {
+    encoding = ImageEncoding::DEFLATE;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+const char *getImageEncodingName(ImageEncoding encoding) {
+  switch (encoding) {
+  case ImageEncoding::GZIP:
+    return "gzip";
+  case ImageEncoding::DEFLATE:
+    return "deflate";
+  default:
+    return "none";
+  }
+}
+
+bool beginInflate(ImageEncoding encoding, InflateProgressHandler onProgress,
+                  InflateOutputHandler onOutput) {
+  abortInflate();
+  if (encoding == ImageEncoding::NONE) {
+    return fail("Image is not compressed");
+  }
+
+  decompressor =
+      static_cast<tinfl_decompressor *>(malloc(sizeof(tinfl_decompressor)));
+  history = static_cast<uint8_t *>(malloc(TINFL_LZ_DICT_SIZE));
+  if (!decompressor || !history) {
+    abortInflate();
+    return fail("No memory for decompression");
+  }
+
+  tinfl_init(decompressor);
+  historyPos = 0;
+  activeEncoding = encoding;
+  progressHandler = onProgress;
+  outputHandler = onOutput;
+  streamDone = false;
+  inflatedSize = 0;
+  inflatedCrc = 0;
+  inflateError = "";
+  gzipStage = (encoding == ImageEncoding::GZIP) ? GzipStage::FIXED
+                                                : GzipStage::BODY;
+  gzipFlags = 0;
+  gzipCount = 0;
+  gzipExtraLength = 0;
+  gzipTailLength = 0;
+
+  ESP_LOGI(INFLATE_LOG, "Inflating %s image, %u bytes of buffers",
+           getImageEncodingName(encoding),
+           (unsigned)(sizeof(tinfl_decompressor) + TINFL_LZ_DICT_SIZE));
+  return true;
+}
+
+bool inflateWrite(const uint8_t *data, size_t length) {
+  if (!decompressor) {
+    return fail("Not inflating");
+  }
+
+  while (length > 0) {
+    if (gzipStage < GzipStage::BODY) {
+      if (!gzipHeaderByte(*data)) {
+        return false;
+      }
+      data++;
+      length--;
+    } else if (gzipStage == GzipStage::BODY &&
+               activeEncoding == ImageEncoding::GZIP) {
+      return gzipBodyBytes(data, length);
+    } else if (gzipStage == GzipStage::BODY && !streamDone) {
+      if (!inflateBody(data, length)) {
+        return false;
+      }
+    } else {
+      return fail("Data after the end of the image");
+    }
+  }
+  return true;
+}
+
+bool endInflate() {
+  bool ok = true;
+  if (!decompressor) {
+    ok = fail("Not inflating");
+  } else if (!streamDone || (activeEncoding == ImageEncoding::GZIP &&
+                             gzipTailLength < GZIP_TRAILER_SIZE)) {
+    ok = fail("Compressed image is incomplete");
+  } else if (activeEncoding == ImageEncoding::GZIP &&
+             (getUint32(gzipTail) != inflatedCrc ||
+              getUint32(gzipTail + 4) != (uint32_t)inflatedSize)) {
+    ok = fail("Image checksum mismatch");
+  }
+
+  if (ok) {
+    ESP_LOGI(INFLATE_LOG, "Inflated %u image bytes", (unsigned)inflatedSize);
+  }
+  abortInflate();
+  return ok;
+}
+
+void abortInflate() {
+  free(decompressor);
+  free(history);
+  decompressor = nullptr;
+  history = nullptr;
+  progressHandler = nullptr;
+  outputHandler = nullptr;
+}
+
+size_t getInflatedSize() { return inflatedSize; }
+
+const char *getInflateError() { return inflateError; }
@@ -0,0 +1,280 @@
+/**
+ * @file loopback_transport.cpp
+ * @brief Implementation of the in-process transport used on a host
+ *
+ * Plain C++ without Arduino dependencies. Frame copies wait in a fixed
+ * queue until run() reaches their arrival time, lost copies stay queued
+ * too so a unicast sender learns of the failure when the frame would have
+ * arrived, like a missing MAC-layer ack.
+ */
+
+#include "loopback_transport.h"
+#include <string.h>
+
+//==============================================================================
+// LOOPBACK BUS
+//==============================================================================
+
+/**
+ * @brief Create a lossless bus without delay
+ * @param seed Seed of the loss and jitter generator
+ */
+LoopbackBus::LoopbackBus(uint32_t seed)
+    : endpoints(), queuedCount(0), link(), stats(), busTime(0),
+      randomState(seed ? seed : 1) {}
+
+/**
+ * @brief Change loss and latency for frames sent from now on
+ * @param config Link behavior
+ */
+void LoopbackBus::configure(const LoopbackLinkConfig &config) {
+  link = config;
+}
+
+/**
+ * @brief Next value of the xorshift generator
+ * @return Pseudo-random 32-bit value
+ */
+uint32_t LoopbackBus::nextRandom() {
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  return randomState;
+}
+
+/**
+ * @brief Connect an endpoint
+ * @param endpoint Endpoint to connect
+ * @return true if there was room
+ */
+bool LoopbackBus::attach(LoopbackTransport *endpoint) {
+  for (LoopbackTransport *&slot : endpoints) {
+    if (slot == endpoint)
+      return true;
+  }
+  for (LoopbackTransport *&slot : endpoints) {
+    if (!slot) {
+      slot = endpoint;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Disconnect an endpoint and drop every copy addressed to it
+ * @param endpoint Endpoint to disconnect
+ */
+void LoopbackBus::detach(LoopbackTransport *endpoint) {
+  for (LoopbackTransport *&slot : endpoints) {
+    if (slot == endpoint) {
+      slot = nullptr;
+    }
+  }
+  size_t kept = 0;
+  for (size_t i = 0; i < queuedCount; i++) {
+    if (queue[i].receiver != endpoint) {
+      queue[kept++] = queue[i];
+    }
+  }
+  queuedCount = kept;
+}
+
+/**
+ * @brief Queue one copy of a frame for one receiver
+ * @param sender Sending endpoint
+ * @param receiver Receiving endpoint, nullptr if nobody has the address
+ * @param to Address the frame was sent to
+ * @param data Frame bytes
+ * @param length Frame length
+ * @param reportStatus true if this copy reports the send result
+ * @return true if the copy was queued
+ */
+bool LoopbackBus::enqueue(LoopbackTransport &sender,
+                          LoopbackTransport *receiver, const uint8_t *to,
+                          const uint8_t *data, size_t length,
+                          bool reportStatus) {
+  if (queuedCount == LOOPBACK_QUEUE_SIZE) {
+    stats.overflows++;
+    return false;
+  }
+
+  QueuedFrame &frame = queue[queuedCount++];
+  memcpy(frame.from, sender.address, 6);
+  memcpy(frame.to, to, 6);
+  frame.receiver = receiver;
+  frame.length = length;
+  memcpy(frame.data, data, length);
+  frame.reportStatus = reportStatus;
+  frame.lost = !receiver || nextRandom() % 1000 < link.lossPermille;
+  frame.deliverAt = busTime + link.latencyUs +
+                    (link.jitterUs ? nextRandom() % (link.jitterUs + 1) : 0);
+  stats.sent++;
+  return true;
+}
+
+/**
+ * @brief Put a frame on the bus
+ *
+ * Broadcasts reach every other endpoint that is up, each copy with its own
+ * loss and delay, and always report success like ESP-NOW does.
+ *
+ * @param sender Sending endpoint
+ * @param to Destination or TRANSPORT_BROADCAST_MAC
+ * @param data Frame bytes
+ * @param length Frame length
+ * @return true if at least one copy was queued
+ */
+bool LoopbackBus::send(LoopbackTransport &sender, const uint8_t *to,
+                       const uint8_t *data, size_t length) {
+  if (memcmp(to, TRANSPORT_BROADCAST_MAC, 6) == 0) {
+    bool queued = false;
+    for (LoopbackTransport *endpoint : endpoints) {
+      if (endpoint && endpoint != &sender && endpoint->up) {
+        queued |= enqueue(sender, endpoint, to, data, length, !queued);
+      }
+    }
+    return queued;
+  }
+
+  LoopbackTransport *receiver = nullptr;
+  for (LoopbackTransport *endpoint : endpoints) {
+    if (endpoint && endpoint->up && memcmp(endpoint->address, to, 6) == 0) {
+      receiver = endpoint;
+    }
+  }
+  return enqueue(sender, receiver, to, data, length, true);
+}
+
+/**
+ * @brief Advance bus time and hand out every frame due by then
+ *
+ * Copies are handed out in arrival order. Copies queued by a handler are
+ * handed out in the same call if they are already due.
+ *
+ * @param nowUs New bus time (us)
+ */
+void LoopbackBus::run(uint32_t nowUs) {
+  busTime = nowUs;
+
+  while (true) {
+    // Earliest due copy, queues are short enough for a linear scan
+    size_t next = queuedCount;
+    for (size_t i = 0; i < queuedCount; i++) {
+      if (static_cast<int32_t>(queue[i].deliverAt - busTime) <= 0 &&
+          (next == queuedCount ||
+           static_cast<int32_t>(queue[i].deliverAt - queue[next].deliverAt) <
+               0)) {
+        next = i;
+      }
+    }
+    if (next == queuedCount)
+      return;
+
+    QueuedFrame frame = queue[next];
+    queue[next] = queue[--queuedCount];
+
+    LoopbackTransport *receiver = frame.receiver;
+    bool delivered =
+        !frame.lost && receiver && receiver->up && receiver->awake;
+    if (delivered) {
+      stats.delivered++;
+      if (receiver->receiveHandler) {
+        receiver->receiveHandler(frame.from, frame.data, frame.length);
+      }
+    } else if (frame.lost) {
+      stats.lost++;
+    }
+
+    if (!frame.reportStatus)
+      continue;
+    // The sender may have gone since, look it up again
+    for (LoopbackTransport *endpoint : endpoints) {
+      if (endpoint && endpoint->up && endpoint->sendHandler &&
+          memcmp(endpoint->address, frame.from, 6) == 0) {
+        bool broadcast = memcmp(frame.to, TRANSPORT_BROADCAST_MAC, 6) == 0;
+        endpoint->sendHandler(frame.to, broadcast || delivered);
+      }
+    }
+  }
+}
+
+//==============================================================================
+// LOOPBACK TRANSPORT
+//==============================================================================
+
+/**
+ * @brief Create an endpoint, it joins the bus on begin()
+ * @param bus Bus to join
+ * @param mac Address of the endpoint
+ */
+LoopbackTransport::LoopbackTransport(LoopbackBus &bus, const uint8_t *mac)
+    : bus(bus), peers(), peerCount(0), receiveHandler(nullptr),
+      sendHandler(nullptr), up(false), awake(true) {
+  memcpy(address, mac, 6);
+}
+
+LoopbackTransport::~LoopbackTransport() { bus.detach(this); }
+
+bool LoopbackTransport::begin(TransportReceiveHandler onReceive,
+                              TransportSendHandler onSend) {
+  if (!bus.attach(this))
+    return false;
+  receiveHandler = onReceive;
+  sendHandler = onSend;
+  up = true;
+  awake = true;
+  return true;
+}
+
+void LoopbackTransport::end() {
+  up = false;
+  peerCount = 0;
+  bus.detach(this);
+}
+
+bool LoopbackTransport::send(const uint8_t *mac, const uint8_t *data,
+                             size_t length) {
+  if (!up || !awake || length > TRANSPORT_MAX_FRAME_SIZE)
+    return false;
+  // Like ESP-NOW, unicast needs the destination added first
+  if (findPeer(mac) < 0)
+    return false;
+  return bus.send(*this, mac, data, length);
+}
+
+bool LoopbackTransport::addPeer(const uint8_t *mac) {
+  if (findPeer(mac) >= 0)
+    return true;
+  if (peerCount == LOOPBACK_MAX_ENDPOINTS)
+    return false;
+  memcpy(peers[peerCount++], mac, 6);
+  return true;
+}
+
+void LoopbackTransport::removePeer(const uint8_t *mac) {
+  int index = findPeer(mac);
+  if (index < 0)
+    return;
+  memcpy(peers[index], peers[--peerCount], 6);
+}
+
+void LoopbackTransport::macAddress(uint8_t *mac) { memcpy(mac, address, 6); }
+
+bool LoopbackTransport::setAwake(bool state) {
+  awake = state;
+  return true;
+}
+
+/**
+ * @brief Index of an added peer
+ * @param mac Peer address
+ * @return Index in peers or -1
+ */
+int LoopbackTransport::findPeer(const uint8_t *mac) const {
+  for (int i = 0; i < peerCount; i++) {
+    if (memcmp(peers[i], mac, 6) == 0)
+      return i;
+  }
+  return -1;
+}
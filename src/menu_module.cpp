@@ -21,6 +21,7 @@
 #include "gif_module.h"
 #include "motion_module.h"
 #include "system_module.h"
+#include "transfer_module.h"
 
 // External display object from display_module
 extern Adafruit_SSD1351 oled;
@@ -297,8 +298,9 @@ static void handleSingleClick() {
     break;
 
   case ESP_NOW_MENU:
-    // Cycle through: ENABLE/DISABLE -> GO BACK
-    selectedESPNowItem = (selectedESPNowItem + 1) % 2;
+    // Cycle through: ENABLE/DISABLE -> SHARE FIRMWARE -> ACCEPT FIRMWARE ->
+    // GO BACK
+    selectedESPNowItem = (selectedESPNowItem + 1) % 4;
     break;
 
   case UPDATE_MENU:
@@ -403,7 +405,17 @@ static void handleDoubleClick() {
         }
         exitToNormalOperation();
         break;
-      case 1: // GO BACK
+      case 1: // Offer this firmware to every paired bot
+        if (!seedFirmware()) {
+          ESP_LOGW(MENU_LOG, "Firmware sharing needs a paired group");
+        }
+        exitToNormalOperation();
+        break;
+      case 2: // Let a paired bot update this one for a while
+        allowFirmwareTransfer();
+        exitToNormalOperation();
+        break;
+      case 3: // GO BACK
         currentMenuState = MENU_SELECTION;
         selectedESPNowItem = 0; // Reset to toggle option
         break;
@@ -621,7 +633,9 @@ void menu_updateDisplay() {
     // Show current state reversed to signal the immediate action
     String espStatus = menu_getESPNowStatus() ? LABEL_DISABLE : LABEL_ENABLE;
     drawMenuItem(0, espStatus.c_str(), selectedESPNowItem == 0);
-    drawMenuItem(1, MENU_LABEL_GO_BACK, selectedESPNowItem == 1);
+    drawMenuItem(1, LABEL_SHARE_FIRMWARE, selectedESPNowItem == 1);
+    drawMenuItem(2, LABEL_ACCEPT_FIRMWARE, selectedESPNowItem == 2);
+    drawMenuItem(3, MENU_LABEL_GO_BACK, selectedESPNowItem == 3);
     break;
   }
 
@@ -15,20 +15,37 @@
 #include "display_module.h"
 #include "emotes_module.h"
 #include "espnow_module.h"
+#include "spsc_queue.h"
 
 //==============================================================================
 // GLOBAL VARIABLES
 //==============================================================================
 
-/** @brief Storage for current motion states */
-static bool g_motionStates[static_cast<size_t>(
-    MotionStateType::MOTION_STATE_COUNT)] = {false};
+/** @brief Capacity of the motion event queue, must be a power of two */
+static const size_t MOTION_EVENT_QUEUE_SIZE = 16;
+/** @brief Pending motion events, produced by ADXLDataPolling() */
+static SPSCQueue<MotionEvent, MOTION_EVENT_QUEUE_SIZE> g_motionEvents;
+/** @brief Minimum time between queue overflow warnings (ms) */
+static const unsigned long MOTION_DROP_LOG_INTERVAL_MS = 5000;
+/** @brief Drop count at the last overflow warning */
+static uint32_t g_motionDropsLogged = 0;
+/** @brief Time of the last overflow warning (ms) */
+static unsigned long g_lastMotionDropLog = 0;
+/** @brief Level motion state from the latest poll */
+static MotionSnapshot g_motionSnapshot = {
+    DeviceOrientation::UPRIGHT, false, false, 0, 0, SENSORS_GRAVITY_EARTH, 0};
+/** @brief Per-sample filtered gravity for motion-reactive rendering */
+static GravityVector g_filteredGravity = {0, 0, SENSORS_GRAVITY_EARTH, 0};
+/** @brief Last time a renderer asked for motion tracking (ms) */
+static unsigned long lastTrackingRequest = 0;
 
 //------------------------------------------------------------------------------
 // Sensor Thresholds
 //------------------------------------------------------------------------------
 /** @brief Threshold for shake detection (m/s²) */
 const float SHAKE_THRESHOLD = 8.0;
+/** @brief Magnitude below which a shake is considered over (m/s²) */
+const float SHAKE_RELEASE_THRESHOLD = SHAKE_THRESHOLD / 2;
 /** @brief Threshold for inactivity detection (m/s²) */
 const float INACTIVITY_THRESHOLD = 1.5;
 /** @brief Threshold for tilt detection (m/s²) */
@@ -37,6 +54,10 @@ const float TILT_THRESHOLD = 9.0;
 const float HALF_TILT_THRESHOLD = 4.2;  // About half of full tilt
 /** @brief Threshold for flip detection (m/s²) */
 const float FLIP_THRESHOLD = -8;
+/** @brief Dynamic magnitude that switches sampling to the interactive rate (m/s²) */
+const float INTERACTIVE_THRESHOLD = 4.0;
+/** @brief Weight of each new sample in the filtered gravity vector */
+const float GRAVITY_FILTER_ALPHA = 0.4;
 
 //------------------------------------------------------------------------------
 // Timing Constants
@@ -49,6 +70,10 @@ const unsigned long INACTIVITY_TIMEOUT = timeToMillis(1, 30);
 const unsigned long DISPLAY_TIMEOUT = timeToMillis(0, 30);
 /** @brief Time of inactivity before entering idle mode (ms), triggers SLEEP animations for idle */
 const unsigned long IDLE_TIMEOUT = timeToMillis(1, 00);
+/** @brief Time a lower sampling profile must be requested before stepping down (ms) */
+const unsigned long PROFILE_STEP_DOWN_DELAY = 3000;
+/** @brief Time a motion tracking request keeps the sampling rate up (ms) */
+const unsigned long MOTION_TRACKING_HOLD_MS = 500;
 
 //------------------------------------------------------------------------------
 // Runtime Variables
@@ -59,84 +84,107 @@ unsigned long INACTIVITY_TIME = 0;
 unsigned long DISPLAY_TIME = 0;
 /** @brief Timestamp for idle timeout tracking */
 unsigned long IDLE_TIME = 0;
+/** @brief Timestamp of the last tap or double tap event */
+static unsigned long lastTapTime = 0;
+/** @brief Timestamp of the last tap, shake or ongoing shake */
+static unsigned long lastInteractionTime = 0;
+/** @brief Shake in progress, cleared once below SHAKE_RELEASE_THRESHOLD */
+static bool shakeActive = false;
 
 //==============================================================================
-// MOTION STATE MANAGEMENT FUNCTIONS
+// MOTION EVENT QUEUE FUNCTIONS
 //==============================================================================
 
 /**
- * @brief Set a specific motion state
+ * @brief Queue a motion event for the animation layer
  *
- * @param state The motion state to set
- * @param value The boolean value to set (true/false)
+ * @param type Kind of event
+ * @param magnitude Smoothed dynamic magnitude at detection (m/s²)
  */
-void setMotionState(MotionStateType state, bool value) {
-  g_motionStates[static_cast<size_t>(state)] = value;
-  // Clear interrupts after state update
-  clearInterrupts();
+static void pushMotionEvent(MotionEventType type, float magnitude) {
+  MotionEvent event = {type, static_cast<uint32_t>(micros()), magnitude};
+  g_motionEvents.push(event);
 }
 
 /**
- * @brief Check if a specific motion state is active
+ * @brief Warn about events dropped on a full queue, at most every
+ * MOTION_DROP_LOG_INTERVAL_MS
  *
- * @param state The motion state to check
- * @return true if the state is active, false otherwise
+ * A consumer that falls behind drops events on every poll, one line per
+ * drop would flood the log.
  */
-bool checkMotionState(MotionStateType state) {
-  return g_motionStates[static_cast<size_t>(state)];
+static void logDroppedMotionEvents() {
+  uint32_t dropped = g_motionEvents.dropped();
+  if (dropped == g_motionDropsLogged ||
+      millis() - g_lastMotionDropLog < MOTION_DROP_LOG_INTERVAL_MS) {
+    return;
+  }
+  ESP_LOGW(MOTION_LOG, "Motion event queue full, dropped %u events (%u total)",
+           dropped - g_motionDropsLogged, dropped);
+  g_motionDropsLogged = dropped;
+  g_lastMotionDropLog = millis();
 }
 
 /**
- * @brief Check if any states in a given list are active
+ * @brief Remove the oldest pending motion event
  *
- * @param states Array of motion states to check
- * @param count Number of states in the array
- * @return true if any state in the array is active
+ * @param event Receives the event
+ * @return true if an event was available, false if the queue is empty
  */
-static bool checkAnyMotionStates(const MotionStateType *states, int count) {
-  for (int i = 0; i < count; i++) {
-    if (g_motionStates[static_cast<size_t>(states[i])]) {
-      return true;
-    }
-  }
-  return false;
-}
+bool pollMotionEvent(MotionEvent &event) { return g_motionEvents.pop(event); }
 
 /**
- * @brief Reset all motion states to inactive
+ * @brief Read the oldest pending motion event without consuming it
+ *
+ * @param event Receives the event
+ * @return true if an event was available, false if the queue is empty
  */
-void resetMotionState() {
-  // ESP_LOGI log removed
-  for (size_t i = 0;
-       i < static_cast<size_t>(MotionStateType::MOTION_STATE_COUNT); i++) {
-    g_motionStates[i] = false;
-  }
-}
+bool peekMotionEvent(MotionEvent &event) { return g_motionEvents.peek(event); }
 
-//==============================================================================
-// MOTION STATE ACCESSOR FUNCTIONS
-//==============================================================================
+/**
+ * @brief Check whether any motion event is waiting to be consumed
+ * @return true if the queue is not empty
+ */
+bool hasPendingMotionEvent() { return !g_motionEvents.empty(); }
 
 /**
- * @brief Check if device was tapped
- * @return true if tapped, false otherwise
+ * @brief Discard all pending motion events
  */
-bool motionTapped() { return checkMotionState(MotionStateType::TAPPED); }
+void clearMotionEvents() { g_motionEvents.clear(); }
 
 /**
- * @brief Check if device was double-tapped
- * @return true if double-tapped, false otherwise
+ * @brief Number of motion events dropped because the queue was full
+ * @return Overflow count since boot
  */
-bool motionDoubleTapped() {
-  return checkMotionState(MotionStateType::DOUBLE_TAPPED);
-}
+uint32_t getDroppedMotionEvents() { return g_motionEvents.dropped(); }
+
+/**
+ * @brief Get the level motion state from the latest poll
+ * @return Copy of the current snapshot
+ */
+MotionSnapshot getMotionSnapshot() { return g_motionSnapshot; }
+
+/**
+ * @brief Get the per-sample filtered gravity vector
+ * @return Copy of the filtered gravity and its sample time
+ */
+GravityVector getFilteredGravity() { return g_filteredGravity; }
+
+/**
+ * @brief Keep the sampling rate high enough for motion-reactive rendering
+ */
+void requestMotionTracking() { lastTrackingRequest = max(millis(), 1UL); }
+
+//==============================================================================
+// MOTION STATE ACCESSOR FUNCTIONS
+//==============================================================================
 
 /**
  * @brief Check if device is upside down
  * @return true if upside down, false otherwise
  */
 bool motionUpsideDown() {
-  return checkMotionState(MotionStateType::UPSIDE_DOWN);
+  return g_motionSnapshot.orientation == DeviceOrientation::UPSIDE_DOWN;
 }
 
 /**
@@ -144,7 +192,7 @@ bool motionUpsideDown() {
  * @return true if tilted left, false otherwise
  */
 bool motionTiltedLeft() {
-  return checkMotionState(MotionStateType::TILTED_LEFT);
+  return g_motionSnapshot.orientation == DeviceOrientation::TILTED_LEFT;
 }
 
 /**
@@ -152,7 +200,7 @@ bool motionTiltedLeft() {
  * @return true if tilted right, false otherwise
  */
 bool motionTiltedRight() {
-  return checkMotionState(MotionStateType::TILTED_RIGHT);
+  return g_motionSnapshot.orientation == DeviceOrientation::TILTED_RIGHT;
 }
 
 /**
@@ -160,7 +208,7 @@ bool motionTiltedRight() {
  * @return true if half tilted left, false otherwise
  */
 bool motionHalfTiltedLeft() {
-  return checkMotionState(MotionStateType::HALF_TILTED_LEFT);
+  return g_motionSnapshot.orientation == DeviceOrientation::HALF_TILTED_LEFT;
 }
 
 /**
@@ -168,19 +216,7 @@ bool motionHalfTiltedLeft() {
  * @return true if half tilted right, false otherwise
  */
 bool motionHalfTiltedRight() {
-  return checkMotionState(MotionStateType::HALF_TILTED_RIGHT);
-}
-
-/**
- * @brief Check if device has been interacted with (tapped, double-tapped, or
- * shaking)
- * @return true if interacted with, false otherwise
- */
-bool motionInteracted() {
-  static const MotionStateType interactedStates[] = {
-      MotionStateType::SHAKING, MotionStateType::TAPPED,
-      MotionStateType::DOUBLE_TAPPED, MotionStateType::SUDDEN_ACCELERATION};
-  return checkAnyMotionStates(interactedStates, 4);
+  return g_motionSnapshot.orientation == DeviceOrientation::HALF_TILTED_RIGHT;
 }
 
 /**
@@ -188,30 +224,20 @@ bool motionInteracted() {
  * @return true if tilted left/right or upside down, false otherwise
  */
 bool motionOriented() {
-  static const MotionStateType orientedStates[] = {
-      MotionStateType::TILTED_LEFT, MotionStateType::TILTED_RIGHT,
-      MotionStateType::HALF_TILTED_LEFT, MotionStateType::HALF_TILTED_RIGHT,
-      MotionStateType::UPSIDE_DOWN};
-  return checkAnyMotionStates(orientedStates, 5);
+  return g_motionSnapshot.orientation != DeviceOrientation::UPRIGHT;
 }
 
 /**
  * @brief Check if device is in sleep mode
  * @return true if in sleep mode, false otherwise
  */
-bool motionSleep() { return checkMotionState(MotionStateType::SLEEP); }
+bool motionSleep() { return g_motionSnapshot.sleeping; }
 
 /**
  * @brief Check if device is in deep sleep mode
  * @return true if in deep sleep mode, false otherwise
  */
-bool motionDeepSleep() { return checkMotionState(MotionStateType::DEEP_SLEEP); }
-
-/**
- * @brief Check if device is being shaken
- * @return true if being shaken, false otherwise
- */
-bool motionShaking() { return checkMotionState(MotionStateType::SHAKING); }
+bool motionDeepSleep() { return g_motionSnapshot.deepSleep; }
 
 //==============================================================================
 // DEVICE MODE AND SLEEP FUNCTIONS
@@ -241,6 +267,8 @@ static void checkDeviceModes() {
  * Dims the display, shows the appropriate mode image, and enters deep sleep.
  */
 void handleDeepSleep() {
+  // Tap wake-up relies on the tap engine, which needs the full 100 Hz rate
+  setADXLPowerProfile(ADXLPowerProfile::ACTIVE);
   // Change depending on the device
   setDisplayBrightness(DISPLAY_BRIGHTNESS_DIM);
   // Display mode static image
@@ -252,14 +280,30 @@ void handleDeepSleep() {
 // MOTION DETECTION FUNCTIONS
 //==============================================================================
 
+/**
+ * @brief Queue a tap event and start the shake/acceleration lockout
+ *
+ * @param type TAPPED or DOUBLE_TAPPED
+ * @param batch Samples drained from the FIFO for this poll
+ */
+static void pushTapEvent(MotionEventType type,
+                         const MotionSampleBatch &batch) {
+  lastTapTime = millis();
+  lastInteractionTime = lastTapTime;
+  pushMotionEvent(type, batch.lastMagnitude);
+}
+
 /**
  * @brief Detect tap and double-tap events using the accelerometer
+ *
+ * @param batch Samples drained from the FIFO for this poll
  */
-void detectTapping() {
-  // Detect tapping interactions and set proper states to relay GIF animations
+void detectTapping(const MotionSampleBatch &batch) {
+  // Detect tapping interactions and queue events to relay GIF animations
   if (digitalRead(INTERRUPT_PIN_D1) != HIGH)
     return;
 
+  // Reading INT_SOURCE also clears the latched interrupts
   uint8_t intSource = readRegister(ADXL345_REG_INT_SOURCE);
   uint8_t tapStatus = readRegister(ADXL345_REG_ACT_TAP_STATUS);
 
@@ -277,31 +321,31 @@ void detectTapping() {
   // You can handle specific interaction a tap interaction for Y or X axis
   if (tapStatus & ADXL345_TAP_SOURCE_Y) {
     if (intSource & ADXL345_INT_SOURCE_DOUBLETAP) {
-      setMotionState(MotionStateType::DOUBLE_TAPPED, true);
+      pushTapEvent(MotionEventType::DOUBLE_TAPPED, batch);
       return;
     }
   }
 
   if (tapStatus & ADXL345_TAP_SOURCE_X) {
     if (intSource & ADXL345_INT_SOURCE_DOUBLETAP) {
-      setMotionState(MotionStateType::DOUBLE_TAPPED, true);
+      pushTapEvent(MotionEventType::DOUBLE_TAPPED, batch);
       return;
     }
 
     if (intSource & ADXL345_INT_SOURCE_SINGLETAP) {
-      setMotionState(MotionStateType::TAPPED, true);
+      pushTapEvent(MotionEventType::TAPPED, batch);
       return;
     }
   }
 
   // Handle taps on any axis
   if (intSource & ADXL345_INT_SOURCE_DOUBLETAP) {
-    setMotionState(MotionStateType::DOUBLE_TAPPED, true);
+    pushTapEvent(MotionEventType::DOUBLE_TAPPED, batch);
     return;
   }
 
   if (intSource & ADXL345_INT_SOURCE_SINGLETAP) {
-    setMotionState(MotionStateType::TAPPED, true);
+    pushTapEvent(MotionEventType::TAPPED, batch);
   }
 }
 
@@ -311,12 +355,12 @@ void detectTapping() {
  * This function analyzes accelerometer data to detect rapid changes in movement
  * that exceed a specified threshold within a short time window.
  *
- * @param samples Number of samples to analyze
+ * @param batch Samples drained from the FIFO for this poll
  * @return true if sudden acceleration detected, false otherwise
  */
-bool detectSuddenAcceleration(uint8_t samples) {
+bool detectSuddenAcceleration(const MotionSampleBatch &batch) {
   // Minimum samples needed for detection
-  if (samples < 2)
+  if (batch.count < 2)
     return false;
 
   // Constants
@@ -324,29 +368,16 @@ bool detectSuddenAcceleration(uint8_t samples) {
   const float ACCELERATION_CHANGE_THRESHOLD =
       4.0; // m/s² change between readings
 
-  // Prevent false detection if Tapping was a recent interaction
-  static unsigned long accelLockoutTime = 0;
+  // Prevent false detection if Tapping or Shaking was a recent interaction
   const unsigned long ACCEL_LOCKOUT_PERIOD = 600; // ms
 
-  if (checkMotionState(MotionStateType::DOUBLE_TAPPED) ||
-      checkMotionState(MotionStateType::TAPPED) ||
-      checkMotionState(MotionStateType::SHAKING)) {
-    accelLockoutTime = millis();
-    return false;
-  }
-
-  if (millis() - accelLockoutTime < ACCEL_LOCKOUT_PERIOD) {
+  if (shakeActive || millis() - lastInteractionTime < ACCEL_LOCKOUT_PERIOD) {
     return false;
   }
 
   // Track previous magnitude to detect changes
   static float prevMagnitude = 0;
-  float currentMagnitude = 0;
-
-  // Get current acceleration magnitude
-  sensors_event_t event = getSensorData();
-  currentMagnitude = calculateCombinedMagnitude(
-      event.acceleration.x, event.acceleration.y, event.acceleration.z);
+  float currentMagnitude = batch.lastMagnitude;
 
   // Calculate change in magnitude
   float magnitudeChange = abs(currentMagnitude - prevMagnitude);
@@ -365,97 +396,81 @@ bool detectSuddenAcceleration(uint8_t samples) {
     ESP_LOGI(MOTION_LOG,
              "Sudden acceleration detected! Magnitude: %.2f, Change: %.2f",
              currentMagnitude, magnitudeChange);
-    setMotionState(MotionStateType::SUDDEN_ACCELERATION, true);
+    pushMotionEvent(MotionEventType::SUDDEN_ACCELERATION, currentMagnitude);
     return true;
   }
 
-  // Reset motion state if no sudden acceleration
-  setMotionState(MotionStateType::SUDDEN_ACCELERATION, false);
   return false;
 }
 
 /**
  * @brief Detect shaking motion using the accelerometer
  *
- * @param samples Number of samples to analyze
+ * A shake queues one event when it starts and is held until the magnitude
+ * drops below SHAKE_RELEASE_THRESHOLD, so a sustained shake is not reported
+ * on every poll.
+ *
+ * @param batch Samples drained from the FIFO for this poll
  */
-void detectShakes(uint8_t samples) {
+void detectShakes(const MotionSampleBatch &batch) {
   // Prevent false detection if Tapping was a recent interaction
-  static unsigned long tapLockoutTime = 0; // Renamed to avoid shadowing
   const unsigned long TAP_LOCKOUT_PERIOD = 500;
 
-  if (checkMotionState(MotionStateType::TAPPED) ||
-      checkMotionState(MotionStateType::DOUBLE_TAPPED)) {
-    tapLockoutTime = millis();
+  if (millis() - lastTapTime < TAP_LOCKOUT_PERIOD) {
     return;
   }
 
-  if (millis() - tapLockoutTime < TAP_LOCKOUT_PERIOD) {
+  if (shakeActive) {
+    if (batch.avgMagnitude < SHAKE_RELEASE_THRESHOLD) {
+      shakeActive = false;
+    } else {
+      lastInteractionTime = millis();
+    }
     return;
   }
 
-  float totalMagnitude = 0;
-  for (int i = 0; i < samples; i++) {
-    sensors_event_t event = getSensorData();
-    totalMagnitude += calculateCombinedMagnitude(
-        event.acceleration.x, event.acceleration.y, event.acceleration.z);
-  }
-
-  float avgMagnitude = totalMagnitude / samples;
-  if (avgMagnitude >= SHAKE_THRESHOLD) {
-    setMotionState(MotionStateType::SHAKING, true);
+  if (batch.avgMagnitude >= SHAKE_THRESHOLD) {
+    shakeActive = true;
+    lastInteractionTime = millis();
+    pushMotionEvent(MotionEventType::SHAKING, batch.avgMagnitude);
   }
 }
 
 /**
  * @brief Detect device orientation changes
  *
- * @param samples Number of samples to analyze
+ * @param batch Samples drained from the FIFO for this poll
  */
-void detectOrientation(uint8_t samples) {
-  if (samples == 0)
+void detectOrientation(const MotionSampleBatch &batch) {
+  if (batch.count == 0)
     return;
 
-  float avgX = 0, avgY = 0, avgZ = 0;
-
-  // Take multiple samples to reduce noise
-  for (int i = 0; i < samples; i++) {
-    sensors_event_t event = getSensorData();
-    avgX += event.acceleration.x;
-    avgY += event.acceleration.y;
-    avgZ += event.acceleration.z;
-  }
-
-  avgX /= samples;
-  avgY /= samples;
-  avgZ /= samples;
+  // Averaging the whole batch reduces noise
+  float avgY = batch.avgY;
+  float avgZ = batch.avgZ;
 
   // ESP_LOGI(ADXL_LOG, "Orientation averages - X: %.2f, Y: %.2f, Z: %.2f", avgX, avgY, avgZ); 
-  // Reset all orientation states first
-  setMotionState(MotionStateType::UPSIDE_DOWN, false);
-  setMotionState(MotionStateType::TILTED_LEFT, false);
-  setMotionState(MotionStateType::TILTED_RIGHT, false);
-  setMotionState(MotionStateType::HALF_TILTED_LEFT, false);
-  setMotionState(MotionStateType::HALF_TILTED_RIGHT, false);
+  DeviceOrientation orientation = DeviceOrientation::UPRIGHT;
 
   // Check orientation relative to normal Z-axis resting position
   // NOTE: in earlier PCB design, ADXL345 was mounted upside down, so the
   // FLIP_THRESHOLD was inverted
   if (avgZ <= FLIP_THRESHOLD) {
-    setMotionState(MotionStateType::UPSIDE_DOWN, true);
+    orientation = DeviceOrientation::UPSIDE_DOWN;
   } else if (avgY >= TILT_THRESHOLD) {
-    setMotionState(MotionStateType::TILTED_RIGHT, true);
+    orientation = DeviceOrientation::TILTED_RIGHT;
   } else if (avgY <= -TILT_THRESHOLD) {
-    setMotionState(MotionStateType::TILTED_LEFT, true);
+    orientation = DeviceOrientation::TILTED_LEFT;
   } else if (avgY >= HALF_TILT_THRESHOLD && avgY < TILT_THRESHOLD) {
-    setMotionState(MotionStateType::HALF_TILTED_RIGHT, true);
+    orientation = DeviceOrientation::HALF_TILTED_RIGHT;
     // ESP_LOGI(MOTION_LOG, "HALF_TILTED_RIGHT detected: Y=%.2f (threshold range=%.2f to %.2f)", 
     //   avgY, HALF_TILT_THRESHOLD, TILT_THRESHOLD);
   } else if (avgY <= -HALF_TILT_THRESHOLD && avgY > -TILT_THRESHOLD) {
-    setMotionState(MotionStateType::HALF_TILTED_LEFT, true);
+    orientation = DeviceOrientation::HALF_TILTED_LEFT;
     // ESP_LOGI(MOTION_LOG, "HALF_TILTED_LEFT detected: Y=%.2f (threshold range=%.2f to %.2f)", 
     //   avgY, -HALF_TILT_THRESHOLD, -TILT_THRESHOLD);
   }
+  g_motionSnapshot.orientation = orientation;
 }
 
 /**
@@ -465,32 +480,24 @@ void detectOrientation(uint8_t samples) {
  * does not work well with Deep Sleep. This gives us more control on how to
  * handle activity detection.
  *
- * @param samples Number of samples to analyze
+ * @param batch Samples drained from the FIFO for this poll
  * @return true if device should enter deep sleep
  */
-bool detectInactivity(uint8_t samples) {
-  if (samples == 0)
+bool detectInactivity(const MotionSampleBatch &batch) {
+  if (batch.count == 0)
     return false;
 
-  float totalMagnitude = 0;
-  for (int i = 0; i < samples; i++) {
-    sensors_event_t event = getSensorData();
-    totalMagnitude += calculateCombinedMagnitude(
-        event.acceleration.x, event.acceleration.y, event.acceleration.z);
-  }
-
-  float avgMagnitude = totalMagnitude / samples;
-  if (avgMagnitude < INACTIVITY_THRESHOLD) {
+  if (batch.avgMagnitude < INACTIVITY_THRESHOLD) {
     if (INACTIVITY_TIME == 0) {
       INACTIVITY_TIME = millis();
     } else if (millis() - INACTIVITY_TIME >= INACTIVITY_TIMEOUT) {
-      setMotionState(MotionStateType::DEEP_SLEEP, true);
+      g_motionSnapshot.deepSleep = true;
       return true;
     }
   } else {
     INACTIVITY_TIME = 0;
     // Reset deep sleep state when we start polling again
-    setMotionState(MotionStateType::DEEP_SLEEP, false);
+    g_motionSnapshot.deepSleep = false;
   }
   return false;
 }
@@ -498,26 +505,18 @@ bool detectInactivity(uint8_t samples) {
 /**
  * @brief Automatically adjust display brightness based on activity
  *
- * @param samples Number of samples to analyze
+ * @param batch Samples drained from the FIFO for this poll
  */
-static void autoDimDisplay(uint8_t samples) {
-  if (samples == 0)
+static void autoDimDisplay(const MotionSampleBatch &batch) {
+  if (batch.count == 0)
     return;
 
-  float totalMagnitude = 0;
-
-  for (int i = 0; i < samples; i++) {
-    sensors_event_t event = getSensorData();
-    totalMagnitude += calculateCombinedMagnitude(
-        event.acceleration.x, event.acceleration.y, event.acceleration.z);
-  }
-
-  float avgMagnitude = totalMagnitude / samples;
   // Check for activity to wake display
-  if (avgMagnitude > INACTIVITY_THRESHOLD && debounce(DISPLAY_TIME, 200)) {
+  if (batch.avgMagnitude > INACTIVITY_THRESHOLD &&
+      debounce(DISPLAY_TIME, 200)) {
     setDisplayBrightness(DISPLAY_BRIGHTNESS_FULL);
     DISPLAY_TIME = millis();
-    setMotionState(MotionStateType::SLEEP, false);
+    g_motionSnapshot.sleeping = false;
     return;
   }
   // Check for display timeout
@@ -526,10 +525,10 @@ static void autoDimDisplay(uint8_t samples) {
     // amount of time. Sleep state and Deep sleep are two different states, this
     // is more of idling inactivity. Only transition to sleep if we're not
     // already sleeping
-    if (!checkMotionState(MotionStateType::SLEEP) &&
+    if (!g_motionSnapshot.sleeping &&
         setTimeout(IDLE_TIME, IDLE_TIMEOUT)) {
       setDisplayBrightness(DISPLAY_BRIGHTNESS_LOW);
-      setMotionState(MotionStateType::SLEEP, true);
+      g_motionSnapshot.sleeping = true;
     }
   }
 }
@@ -537,12 +536,12 @@ static void autoDimDisplay(uint8_t samples) {
 /**
  * @brief Monitor and handle sleep state transitions
  *
- * @param samples Number of samples to analyze
+ * @param batch Samples drained from the FIFO for this poll
  */
-static void monitorSleep(uint8_t samples) {
+static void monitorSleep(const MotionSampleBatch &batch) {
   static unsigned long lastInactivityTime = 0;
 
-  if (detectInactivity(samples)) {
+  if (detectInactivity(batch)) {
     if (lastInactivityTime == 0) {
       lastInactivityTime = millis();
     }
@@ -558,12 +557,92 @@ static void monitorSleep(uint8_t samples) {
   }
 }
 
+//==============================================================================
+// SAMPLING GOVERNOR
+//==============================================================================
+
+/**
+ * @brief Drain the accelerometer FIFO into a single batch
+ *
+ * The sensor does not timestamp samples, so each one is placed back from the
+ * FIFO status read by its depth in the FIFO times the output data period.
+ *
+ * @param samples Number of samples available in the FIFO
+ * @param statusTime micros() when the FIFO status was read
+ * @return Aggregated batch used by every detector in this poll
+ */
+static MotionSampleBatch readSampleBatch(uint8_t samples,
+                                         uint32_t statusTime) {
+  MotionSampleBatch batch = {0, 0, 0, 0, 0, 0};
+  float totalMagnitude = 0;
+  uint32_t samplePeriod = static_cast<uint32_t>(1e6f / getADXLSampleRate());
+
+  for (uint8_t i = 0; i < samples; i++) {
+    sensors_event_t event = getSensorData();
+    batch.avgX += event.acceleration.x;
+    batch.avgY += event.acceleration.y;
+    batch.avgZ += event.acceleration.z;
+    g_filteredGravity.x +=
+        GRAVITY_FILTER_ALPHA * (event.acceleration.x - g_filteredGravity.x);
+    g_filteredGravity.y +=
+        GRAVITY_FILTER_ALPHA * (event.acceleration.y - g_filteredGravity.y);
+    g_filteredGravity.z +=
+        GRAVITY_FILTER_ALPHA * (event.acceleration.z - g_filteredGravity.z);
+    // Drained oldest first, the sample read last is one period old
+    g_filteredGravity.sampleTime = statusTime - (samples - i) * samplePeriod;
+    batch.lastMagnitude = calculateCombinedMagnitude(
+        event.acceleration.x, event.acceleration.y, event.acceleration.z);
+    totalMagnitude += batch.lastMagnitude;
+  }
+
+  batch.count = samples;
+  if (samples > 0) {
+    batch.avgX /= samples;
+    batch.avgY /= samples;
+    batch.avgZ /= samples;
+    batch.avgMagnitude = totalMagnitude / samples;
+  }
+  return batch;
+}
+
 /**
- * @brief Check if device detected sudden acceleration
- * @return true if sudden acceleration detected, false otherwise
+ * @brief Select the accelerometer sampling profile from the motion state
+ *
+ * Interactions step the rate up immediately. Stepping down only happens once
+ * the lower profile has been requested for PROFILE_STEP_DOWN_DELAY, so short
+ * pauses in a shake or between taps do not make the rate oscillate.
+ *
+ * @param batch Samples drained from the FIFO for this poll
  */
-bool motionSuddenAcceleration() {
-  return checkMotionState(MotionStateType::SUDDEN_ACCELERATION);
+static void updateSamplingProfile(const MotionSampleBatch &batch) {
+  static unsigned long lastDemandTime = 0;
+
+  ADXLPowerProfile target = ADXLPowerProfile::ACTIVE;
+  if (hasPendingMotionEvent() || shakeActive ||
+      batch.avgMagnitude >= INTERACTIVE_THRESHOLD) {
+    target = ADXLPowerProfile::INTERACTIVE;
+  } else if (lastTrackingRequest != 0 &&
+             millis() - lastTrackingRequest < MOTION_TRACKING_HOLD_MS) {
+    // A renderer follows gravity, keep samples fresh enough for one frame
+    target = ADXLPowerProfile::ACTIVE;
+  } else if (motionSleep() && batch.avgMagnitude < INACTIVITY_THRESHOLD) {
+    // Only idle once the display has dimmed, wake is detected by magnitude
+    target = ADXLPowerProfile::RESTING;
+  }
+
+  ADXLPowerProfile current = getADXLPowerProfile();
+  if (target >= current) {
+    if (target > current) {
+      setADXLPowerProfile(target);
+    }
+    lastDemandTime = millis();
+    return;
+  }
+
+  if (millis() - lastDemandTime >= PROFILE_STEP_DOWN_DELAY) {
+    setADXLPowerProfile(target);
+    lastDemandTime = millis();
+  }
 }
 
 //==============================================================================
@@ -578,22 +657,37 @@ bool motionSuddenAcceleration() {
  * interactions.
  */
 void ADXLDataPolling() {
+  static unsigned long lastFifoRead = 0;
   // Poll button events first
   // handleClickEvents();
   menu_update();
 
   if (!isSensorEnabled())
     return;
+  // Low sampling profiles fill the FIFO slowly, skip the I2C traffic until
+  // enough samples have accumulated
+  if (millis() - lastFifoRead < getADXLPollInterval())
+    return;
+  lastFifoRead = millis();
   // Read FIFO status once for all detections
+  uint32_t statusTime = static_cast<uint32_t>(micros());
   uint8_t samplesAvailable = getFifoSampleData();
   if (samplesAvailable == 0)
     return;
+  MotionSampleBatch batch = readSampleBatch(samplesAvailable, statusTime);
+  g_motionSnapshot.gravityX = batch.avgX;
+  g_motionSnapshot.gravityY = batch.avgY;
+  g_motionSnapshot.gravityZ = batch.avgZ;
+  g_motionSnapshot.timestamp = static_cast<uint32_t>(micros());
   // Add orientation detection to the processing pipeline
   // Process in order of priority
-  detectShakes(samplesAvailable);
-  if (!checkMotionState(MotionStateType::SHAKING)) {
-    detectTapping();
-    detectInactivity(samplesAvailable);
+  detectShakes(batch);
+  if (!shakeActive) {
+    detectTapping(batch);
+    detectInactivity(batch);
+  } else if (digitalRead(INTERRUPT_PIN_D1) == HIGH) {
+    // Taps latched by the shake itself are discarded
+    clearInterrupts();
   }
   // IMPORTANT: Order of interaction is important here, tap detection gets
   // interrupted if not the first check priority
@@ -601,8 +695,10 @@ void ADXLDataPolling() {
   // Tapping detection is next, but it should not interrupt shaking detection
   // Acceleration and Orientation detection should be checked last
   // This is to prevent false positives when the device is in motion
-  detectSuddenAcceleration(samplesAvailable);
-  detectOrientation(samplesAvailable);
-  monitorSleep(samplesAvailable);
-  autoDimDisplay(samplesAvailable);
+  detectSuddenAcceleration(batch);
+  detectOrientation(batch);
+  monitorSleep(batch);
+  autoDimDisplay(batch);
+  updateSamplingProfile(batch);
+  logDroppedMotionEvents();
 }
\ No newline at end of file
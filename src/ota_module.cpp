@@ -9,6 +9,8 @@
  #include "common.h"
  #include "ota_module.h"
  #include "display_module.h"
+ #include "inflate_module.h"
+ #include "resume_module.h"
  
  //==============================================================================
  // GLOBAL VARIABLES
@@ -24,6 +26,8 @@
  static int fileSize = 0;
  /** @brief Name of the file currently being uploaded */
  static String currentFilename = "";
+ /** @brief Encoding of the file being uploaded, gzip for a .bin.gz name */
+ static ImageEncoding uploadEncoding = ImageEncoding::NONE;
  
  //==============================================================================
  // UTILITY FUNCTIONS
@@ -128,13 +132,43 @@
    // Determine if this is a filesystem update
    bool isFileSystem = upload.filename.indexOf(FILESYSTEM_BIN) >= 0;
    int command = isFileSystem ? U_SPIFFS : U_FLASH;
+   uploadEncoding = upload.filename.endsWith(INFLATE_GZIP_SUFFIX)
+                        ? ImageEncoding::GZIP
+                        : ImageEncoding::NONE;
+   // A ranged upload carries the image from offset on, sha256 names the
+   // image so an interrupted upload can be resumed
+   String imageHash = webServer.arg("sha256");
+   String offset = webServer.arg("offset");
  
    // ESP_LOGI log removed
  
-   if (!Update.begin(UPDATE_SIZE_UNKNOWN, command)) {
+   if (offset.length() > 0) {
+     if (!resumeUpdateSession(command, imageHash, offset.toInt())) {
+       otaState = OTAState::ERROR;
+       otaMessage = "Error: " + String(getSessionError());
+       return false;
+     }
+   } else {
+     clearUpdateSession();
+     if (!Update.begin(UPDATE_SIZE_UNKNOWN, command)) {
+       otaState = OTAState::ERROR;
+       otaMessage = "Error: " + String(Update.errorString());
+       ESP_LOGE(OTA_LOG, "%s", otaMessage.c_str());
+       return false;
+     }
+     if (!beginUpdateSession(command, imageHash)) {
+       Update.abort();
+       otaState = OTAState::ERROR;
+       otaMessage = "Error: " + String(getSessionError());
+       return false;
+     }
+   }
+
+   if (uploadEncoding != ImageEncoding::NONE &&
+       !beginInflate(uploadEncoding, nullptr, sessionWrite)) {
+     suspendUpdateSession();
      otaState = OTAState::ERROR;
-     otaMessage = "Error: " + String(Update.errorString());
-     ESP_LOGE(OTA_LOG, "%s", otaMessage.c_str());
+     otaMessage = "Error: " + String(getInflateError());
      return false;
    }
    return true;
@@ -148,21 +182,26 @@
   */
  static int handleUploadWrite(HTTPUpload &upload) {
    int progress = 0;
-   if (Update.write(upload.buf, upload.currentSize) != upload.currentSize) {
-     Update.abort();
+   bool written = (uploadEncoding == ImageEncoding::NONE)
+                      ? sessionWrite(upload.buf, upload.currentSize)
+                      : inflateWrite(upload.buf, upload.currentSize);
+   if (!written) {
+     otaMessage = "Error: " + String(*getSessionError() ? getSessionError()
+                                                        : getInflateError());
+     abortInflate();
+     suspendUpdateSession();
      otaState = OTAState::ERROR;
-     otaMessage = "Error: Flash write failed";
      return progress;
    }
    
    otaState = OTAState::UPLOADING;
-   uploadTotal = Update.size();
-   fileSize = Update.size();
+   uploadTotal = getSessionCapacity();
+   fileSize = getSessionCapacity();
  
-   progress = (Update.progress() * 100) / Update.size();
+   progress = (getSessionWritten() * 100) / getSessionCapacity();
    otaMessage = "Progress: " + String(progress) + "%";
    ESP_LOGW(OTA_LOG, "Progress: %d%% (Written: %d, Total: %d)\n", progress,
-                 Update.progress(), uploadTotal);
+                 getSessionWritten(), uploadTotal);
  
    return progress;
  }
@@ -176,15 +215,22 @@
  static bool finalizeUpload(HTTPUpload &upload) {
    otaState = OTAState::UPDATING;
    otaMessage = "BYTE-90 is updates are being applied.";
+
+   if (uploadEncoding != ImageEncoding::NONE && !endInflate()) {
+     suspendUpdateSession();
+     otaState = OTAState::ERROR;
+     otaMessage = "Error: " + String(getInflateError());
+     return false;
+   }
  
-   if (Update.end(true)) {
+   if (endUpdateSession()) {
      // ESP_LOGI log removed
      otaState = OTAState::SUCCESS;
      otaMessage = "Update successful! Device will restart in a moment.";
      return true;
    } else {
      otaState = OTAState::ERROR;
-     otaMessage = "Error: " + String(Update.errorString());
+     otaMessage = "Error: " + String(getSessionError());
      return false;
    }
  }
@@ -199,7 +245,8 @@
  
    switch (upload.status) {
    case UPLOAD_FILE_START:
-     if (!upload.filename.endsWith(".bin")) {
+     if (!upload.filename.endsWith(".bin") &&
+         !upload.filename.endsWith(".bin" INFLATE_GZIP_SUFFIX)) {
        otaState = OTAState::ERROR;
        otaMessage = "Invalid file type, please choose the correct firmware files.";
        return;
@@ -229,9 +276,11 @@
      break;
  
    case UPLOAD_FILE_ABORTED:
+     // Keep what reached flash, uploading the same file again resumes
      otaState = OTAState::ERROR;
-     otaMessage = "Device has timed out, upload aborted.";
-     Update.abort();
+     otaMessage = "Device has timed out, upload interrupted.";
+     abortInflate();
+     suspendUpdateSession();
      break;
    }
  }
@@ -272,8 +321,8 @@
    // Add status endpoint
    webServer.on("/update/status", HTTP_GET, []() {
      int progress = 0;
-     if (Update.size() > 0) {
-       progress = (Update.progress() * 100) / Update.size();
+     if (getSessionCapacity() > 0) {
+       progress = (getSessionWritten() * 100) / getSessionCapacity();
      }
      
      String jsonResponse = createJsonResponse(
@@ -283,4 +332,9 @@
      );
      webServer.send(200, "application/json", jsonResponse);
    });
+   // Session an interrupted upload can resume from, see resume_module.h
+   webServer.on("/update/session", HTTP_GET, []() {
+     webServer.send(200, "application/json",
+                    "{\"session\":" + getUpdateSessionJson() + "}");
+   });
  }
\ No newline at end of file
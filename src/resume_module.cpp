@@ -0,0 +1,492 @@
+/**
+ * @file resume_module.cpp
+ * @brief Implementation of resumable update sessions
+ *
+ * Image bytes are hashed as they are written, and at every sector boundary
+ * the hash so far is snapshotted. Update only writes a sector once the next
+ * byte arrives, so the snapshot of the previous boundary is the one known
+ * to be in flash. That offset and digest are what gets persisted, as one
+ * NVS blob so a power cut can't leave them out of step.
+ */
+
+#include "resume_module.h"
+#include <Preferences.h>
+#include <Update.h>
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+#include <mbedtls/sha256.h>
+
+//==============================================================================
+// TYPE DEFINITIONS
+//==============================================================================
+
+/**
+ * @brief Where session bytes go
+ */
+enum class SessionWriter : uint8_t {
+  NONE,     /**< No session running */
+  UPDATE,   /**< New image, through Update */
+  PARTITION /**< Resumed image, straight to the partition */
+};
+
+/**
+ * @brief An image offset and the SHA-256 of the image up to it
+ */
+struct SessionCommit {
+  uint32_t offset;                /**< Image bytes */
+  uint8_t digest[RESUME_HASH_SIZE]; /**< SHA-256 of those bytes */
+};
+
+//==============================================================================
+// GLOBAL VARIABLES
+//==============================================================================
+
+/** @brief NVS access for the persisted session */
+static Preferences sessionStore;
+/** @brief Where session bytes go */
+static SessionWriter writer = SessionWriter::NONE;
+/** @brief U_FLASH or U_SPIFFS */
+static int sessionCommand = U_FLASH;
+/** @brief SHA-256 of the whole image in hex, empty if not persisted */
+static String sessionHash = "";
+/** @brief Random session ID, reported to hosts */
+static uint32_t sessionId = 0;
+/** @brief Partition being written */
+static const esp_partition_t *sessionPartition = nullptr;
+/** @brief Image bytes written, including those before a resume */
+static size_t written = 0;
+/** @brief SHA-256 of the image bytes written */
+static mbedtls_sha256_context hashContext;
+/** @brief First firmware bytes, flash only gets them once the image is done */
+static uint8_t imageHeader[RESUME_HEADER_SIZE];
+/** @brief Furthest offset known to be in flash */
+static SessionCommit committed = {0, {0}};
+/** @brief Last sector boundary, may still wait in Update's buffer */
+static SessionCommit pending = {0, {0}};
+/** @brief Offset last saved to NVS */
+static uint32_t persistedOffset = 0;
+/** @brief Sector being filled by the PARTITION writer */
+static uint8_t *sectorBuffer = nullptr;
+/** @brief Why the last session call failed */
+static const char *sessionError = "";
+
+//==============================================================================
+// UTILITY FUNCTIONS
+//==============================================================================
+
+/**
+ * @brief Record why a session call failed
+ *
+ * @param message Error message
+ * @return false, for use in a return statement
+ */
+static bool fail(const char *message) {
+  sessionError = message;
+  ESP_LOGE(RESUME_LOG, "%s at image offset %u", message, (unsigned)written);
+  return false;
+}
+
+/**
+ * @brief Partition an update command writes
+ *
+ * @param command U_FLASH or U_SPIFFS
+ * @return Partition or nullptr
+ */
+static const esp_partition_t *findPartition(int command) {
+  if (command == U_SPIFFS) {
+    return esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                    ESP_PARTITION_SUBTYPE_DATA_SPIFFS, NULL);
+  }
+  return esp_ota_get_next_update_partition(NULL);
+}
+
+/**
+ * @brief Format a digest as lowercase hex
+ *
+ * @param digest RESUME_HASH_SIZE bytes
+ * @return 64 hex digits
+ */
+static String toHex(const uint8_t *digest) {
+  char hex[RESUME_HASH_SIZE * 2 + 1];
+  for (int i = 0; i < RESUME_HASH_SIZE; i++) {
+    sprintf(hex + i * 2, "%02x", digest[i]);
+  }
+  return String(hex);
+}
+
+/**
+ * @brief Check an image hash given by a host
+ *
+ * @param hash Expected 64 lowercase hex digits
+ * @return true if well formed
+ */
+static bool isImageHash(const String &hash) {
+  if (hash.length() != RESUME_HASH_SIZE * 2) {
+    return false;
+  }
+  for (size_t i = 0; i < hash.length(); i++) {
+    if (!isdigit(hash[i]) && (hash[i] < 'a' || hash[i] > 'f')) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Stop the writer and release its buffers
+ *
+ * @param abortUpdate Also abort Update if it was being written
+ */
+static void stopWriter(bool abortUpdate) {
+  if (writer == SessionWriter::UPDATE && abortUpdate) {
+    Update.abort();
+  }
+  if (writer != SessionWriter::NONE) {
+    mbedtls_sha256_free(&hashContext);
+  }
+  free(sectorBuffer);
+  sectorBuffer = nullptr;
+  writer = SessionWriter::NONE;
+}
+
+//==============================================================================
+// COMMITS
+//==============================================================================
+
+/**
+ * @brief Record the image hash up to the current offset
+ *
+ * @param commit Receives the offset and digest
+ */
+static void snapshot(SessionCommit &commit) {
+  mbedtls_sha256_context copy;
+  mbedtls_sha256_init(&copy);
+  mbedtls_sha256_clone(&copy, &hashContext);
+  mbedtls_sha256_finish(&copy, commit.digest);
+  mbedtls_sha256_free(&copy);
+  commit.offset = written;
+}
+
+/**
+ * @brief Promote the pending boundary once Update has written it
+ */
+static void advanceCommit() {
+  if (pending.offset > committed.offset && Update.progress() >= pending.offset) {
+    committed = pending;
+  }
+}
+
+/**
+ * @brief Save the committed offset to NVS if it moved
+ */
+static void persistCommit() {
+  if (sessionHash.isEmpty() || committed.offset <= persistedOffset) {
+    return;
+  }
+  sessionStore.begin(RESUME_NVS_NAMESPACE, false);
+  if (persistedOffset == 0 && sessionCommand == U_FLASH) {
+    sessionStore.putBytes("header", imageHeader, RESUME_HEADER_SIZE);
+  }
+  sessionStore.putBytes("commit", &committed, sizeof(committed));
+  sessionStore.end();
+  persistedOffset = committed.offset;
+}
+
+//==============================================================================
+// PARTITION WRITER
+//==============================================================================
+
+/**
+ * @brief Erase a sector and write the buffered bytes to it
+ *
+ * @param offset Sector offset in the partition
+ * @param length Bytes of sectorBuffer to write
+ * @return true on success
+ */
+static bool flushSector(size_t offset, size_t length) {
+  return esp_partition_erase_range(sessionPartition, offset,
+                                   RESUME_SECTOR_SIZE) == ESP_OK &&
+         esp_partition_write(sessionPartition, offset, sectorBuffer, length) ==
+             ESP_OK;
+}
+
+/**
+ * @brief Write the last sector and make the image active
+ *
+ * @return true if the image was accepted
+ */
+static bool finishPartition() {
+  size_t fill = written % RESUME_SECTOR_SIZE;
+  if (fill > 0 && !flushSector(written - fill, fill)) {
+    return fail("Flash write failed");
+  }
+  if (sessionCommand != U_FLASH) {
+    return true;
+  }
+  // The held back header makes the image bootable, validated on activation
+  if (esp_partition_write(sessionPartition, 0, imageHeader,
+                          RESUME_HEADER_SIZE) != ESP_OK) {
+    return fail("Flash write failed");
+  }
+  if (esp_ota_set_boot_partition(sessionPartition) != ESP_OK) {
+    return fail("Firmware image is not valid");
+  }
+  return true;
+}
+
+/**
+ * @brief Write bytes that don't cross a sector boundary
+ *
+ * @param data Image bytes
+ * @param length Number of bytes
+ * @return true on success
+ */
+static bool writeBytes(uint8_t *data, size_t length) {
+  if (writer == SessionWriter::UPDATE) {
+    return Update.write(data, length) == length;
+  }
+  size_t fill = written % RESUME_SECTOR_SIZE;
+  memcpy(sectorBuffer + fill, data, length);
+  if (fill + length < RESUME_SECTOR_SIZE) {
+    return true;
+  }
+  return flushSector(written - fill, RESUME_SECTOR_SIZE);
+}
+
+//==============================================================================
+// PUBLIC API FUNCTIONS
+//==============================================================================
+
+bool beginUpdateSession(int command, const String &imageHash) {
+  stopWriter(false);
+  sessionError = "";
+  if (!imageHash.isEmpty() && !isImageHash(imageHash)) {
+    return fail("Invalid image hash");
+  }
+
+  writer = SessionWriter::UPDATE;
+  sessionCommand = command;
+  sessionHash = imageHash;
+  sessionId = esp_random();
+  sessionPartition = findPartition(command);
+  written = 0;
+  committed = {0, {0}};
+  pending = {0, {0}};
+  persistedOffset = 0;
+  mbedtls_sha256_init(&hashContext);
+  mbedtls_sha256_starts(&hashContext, 0);
+
+  sessionStore.begin(RESUME_NVS_NAMESPACE, false);
+  sessionStore.clear();
+  if (!sessionHash.isEmpty() && sessionPartition) {
+    sessionStore.putUInt("id", sessionId);
+    sessionStore.putString("hash", sessionHash);
+    sessionStore.putUInt("cmd", command);
+    sessionStore.putUInt("part", sessionPartition->address);
+  }
+  sessionStore.end();
+  return true;
+}
+
+bool resumeUpdateSession(int command, const String &imageHash, size_t offset) {
+  suspendUpdateSession();
+  sessionError = "";
+
+  SessionCommit commit = {0, {0}};
+  String storedHash = "";
+  uint32_t storedCommand = 0;
+  uint32_t storedPartition = 0;
+  if (sessionStore.begin(RESUME_NVS_NAMESPACE, true)) {
+    storedHash = sessionStore.getString("hash", "");
+    storedCommand = sessionStore.getUInt("cmd", 0);
+    storedPartition = sessionStore.getUInt("part", 0);
+    sessionId = sessionStore.getUInt("id", 0);
+    if (sessionStore.getBytes("commit", &commit, sizeof(commit)) !=
+        sizeof(commit)) {
+      commit.offset = 0;
+    }
+    sessionStore.getBytes("header", imageHeader, RESUME_HEADER_SIZE);
+    sessionStore.end();
+  }
+
+  if (storedHash.isEmpty() || commit.offset == 0) {
+    return fail("No update to resume");
+  }
+  if (storedHash != imageHash) {
+    return fail("Update session is for a different image");
+  }
+  if ((int)storedCommand != command) {
+    return fail("Update session is for the other partition");
+  }
+  if (commit.offset != offset) {
+    return fail("Update session continues at a different offset");
+  }
+  sessionPartition = findPartition(command);
+  if (!sessionPartition || sessionPartition->address != storedPartition) {
+    clearUpdateSession();
+    return fail("Update partition changed");
+  }
+  sectorBuffer = static_cast<uint8_t *>(malloc(RESUME_SECTOR_SIZE));
+  if (!sectorBuffer) {
+    return fail("No memory for resuming");
+  }
+
+  // Hash what is in flash, with the header Update held back
+  written = 0;
+  writer = SessionWriter::PARTITION;
+  mbedtls_sha256_init(&hashContext);
+  mbedtls_sha256_starts(&hashContext, 0);
+  for (size_t at = 0; at < commit.offset; at += RESUME_SECTOR_SIZE) {
+    size_t length = min<size_t>(RESUME_SECTOR_SIZE, commit.offset - at);
+    if (esp_partition_read(sessionPartition, at, sectorBuffer, length) !=
+        ESP_OK) {
+      stopWriter(false);
+      return fail("Reading the partition failed");
+    }
+    if (at == 0 && command == U_FLASH) {
+      memcpy(sectorBuffer, imageHeader, RESUME_HEADER_SIZE);
+    }
+    mbedtls_sha256_update(&hashContext, sectorBuffer, length);
+    written += length;
+  }
+  snapshot(pending);
+  if (memcmp(pending.digest, commit.digest, RESUME_HASH_SIZE) != 0) {
+    clearUpdateSession();
+    return fail("Written image does not match, start over");
+  }
+
+  sessionCommand = command;
+  sessionHash = imageHash;
+  committed = commit;
+  persistedOffset = commit.offset;
+  ESP_LOGI(RESUME_LOG, "Resuming session %08x at %u bytes", sessionId,
+           (unsigned)offset);
+  return true;
+}
+
+bool sessionWrite(uint8_t *data, size_t length) {
+  if (writer == SessionWriter::NONE) {
+    return fail("No update session");
+  }
+
+  while (length > 0) {
+    size_t count =
+        min<size_t>(length, RESUME_SECTOR_SIZE - written % RESUME_SECTOR_SIZE);
+    if (written < RESUME_HEADER_SIZE) {
+      memcpy(imageHeader + written, data,
+             min<size_t>(count, RESUME_HEADER_SIZE - written));
+    }
+    if (!writeBytes(data, count)) {
+      return fail("Flash write failed");
+    }
+    mbedtls_sha256_update(&hashContext, data, count);
+    written += count;
+
+    if (written % RESUME_SECTOR_SIZE == 0) {
+      if (writer == SessionWriter::UPDATE) {
+        advanceCommit();
+        snapshot(pending);
+      } else {
+        snapshot(committed);
+      }
+      if (committed.offset >= persistedOffset + RESUME_COMMIT_INTERVAL) {
+        persistCommit();
+      }
+    }
+    data += count;
+    length -= count;
+  }
+  return true;
+}
+
+bool endUpdateSession() {
+  if (writer == SessionWriter::NONE) {
+    return fail("No update session");
+  }
+
+  uint8_t digest[RESUME_HASH_SIZE];
+  mbedtls_sha256_finish(&hashContext, digest);
+  bool ok = true;
+  if (!sessionHash.isEmpty() && toHex(digest) != sessionHash) {
+    ok = fail("Image hash mismatch");
+  } else if (writer == SessionWriter::UPDATE) {
+    ok = Update.end(true) || fail(Update.errorString());
+  } else {
+    ok = finishPartition();
+  }
+
+  if (ok) {
+    ESP_LOGI(RESUME_LOG, "Image of %u bytes complete", (unsigned)written);
+    // Update is done, aborting it now would flag an error
+    stopWriter(false);
+  }
+  clearUpdateSession();
+  return ok;
+}
+
+void suspendUpdateSession() {
+  if (writer == SessionWriter::NONE) {
+    return;
+  }
+  if (writer == SessionWriter::UPDATE) {
+    advanceCommit();
+  }
+  persistCommit();
+  stopWriter(true);
+  if (!sessionHash.isEmpty()) {
+    ESP_LOGI(RESUME_LOG, "Session %08x suspended at %u bytes", sessionId,
+             (unsigned)committed.offset);
+  }
+}
+
+void clearUpdateSession() {
+  stopWriter(true);
+  sessionStore.begin(RESUME_NVS_NAMESPACE, false);
+  sessionStore.clear();
+  sessionStore.end();
+  sessionHash = "";
+  persistedOffset = 0;
+}
+
+String getUpdateSessionJson() {
+  uint32_t id = sessionId;
+  uint32_t command = sessionCommand;
+  String hash = sessionHash;
+  uint32_t offset = 0;
+
+  if (writer != SessionWriter::NONE) {
+    if (writer == SessionWriter::UPDATE) {
+      advanceCommit();
+    }
+    offset = committed.offset;
+  } else if (sessionStore.begin(RESUME_NVS_NAMESPACE, true)) {
+    SessionCommit commit;
+    id = sessionStore.getUInt("id", 0);
+    command = sessionStore.getUInt("cmd", 0);
+    hash = sessionStore.getString("hash", "");
+    if (sessionStore.getBytes("commit", &commit, sizeof(commit)) ==
+        sizeof(commit)) {
+      offset = commit.offset;
+    }
+    sessionStore.end();
+  }
+
+  if (hash.isEmpty() || offset == 0) {
+    return "null";
+  }
+  char idText[9];
+  snprintf(idText, sizeof(idText), "%08x", (unsigned)id);
+  return "{\"id\":\"" + String(idText) + "\",\"type\":\"" +
+         String(command == U_SPIFFS ? "filesystem" : "firmware") +
+         "\",\"sha256\":\"" + hash + "\",\"offset\":" + String(offset) + "}";
+}
+
+size_t getSessionWritten() { return written; }
+
+size_t getSessionCapacity() {
+  return (writer != SessionWriter::NONE && sessionPartition)
+             ? sessionPartition->size
+             : 0;
+}
+
+const char *getSessionError() { return sessionError; }
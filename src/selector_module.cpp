@@ -0,0 +1,244 @@
+/**
+ * @file selector_module.cpp
+ * @brief Implementation of weighted, history-aware emote selection
+ *
+ * Every pool owns a fixed shuffle bag. An emote leaves the bag when it is
+ * selected and the bag refills once empty, so every emote of a pool plays
+ * before any repeats. Within the bag the pick is weighted and avoids
+ * emotes that are cooling down or appear in the recent history.
+ */
+
+#include "selector_module.h"
+
+//==============================================================================
+// TYPE DEFINITIONS
+//==============================================================================
+
+/**
+ * @brief Selection state of a registered pool
+ */
+struct EmotePool {
+  const EmoteId *emotes;                       /**< Emote handles */
+  uint8_t count;                               /**< Number of emotes */
+  uint8_t weights[EMOTE_POOL_MAX_SIZE];        /**< Relative weights */
+  uint8_t bag[EMOTE_POOL_MAX_SIZE];            /**< Unplayed emote indices */
+  uint8_t remaining;                           /**< Entries left in bag */
+  int8_t peeked;                               /**< Peeked emote, -1 if none */
+  uint32_t cooldownMs[EMOTE_POOL_MAX_SIZE];     /**< Re-selection cooldowns */
+  unsigned long lastPlayed[EMOTE_POOL_MAX_SIZE]; /**< Last selection time */
+};
+
+//==============================================================================
+// GLOBAL VARIABLES
+//==============================================================================
+
+/** @brief Preallocated pool storage */
+static EmotePool pools[EMOTE_POOL_MAX_COUNT];
+/** @brief Number of registered pools */
+static size_t poolCount = 0;
+/** @brief Most recently selected emotes, shared by all pools */
+static EmoteId history[EMOTE_HISTORY_SIZE] = {EmoteId::NONE, EmoteId::NONE,
+                                              EmoteId::NONE};
+/** @brief Next write position in history */
+static size_t historyIndex = 0;
+
+//==============================================================================
+// INTERNAL FUNCTIONS
+//==============================================================================
+
+/**
+ * @brief Check whether an emote was selected recently
+ *
+ * @param id Emote handle
+ * @return true if the emote is in the recent history
+ */
+static bool inHistory(EmoteId id) {
+  for (size_t i = 0; i < EMOTE_HISTORY_SIZE; i++) {
+    if (history[i] == id) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Check whether an emote may be picked under the strict rules
+ *
+ * @param pool Pool the emote belongs to
+ * @param emote Emote index within the pool
+ * @param now Current time (ms)
+ * @return true if the emote is neither recent nor cooling down
+ */
+static bool isEligible(const EmotePool &pool, uint8_t emote,
+                       unsigned long now) {
+  if (inHistory(pool.emotes[emote]))
+    return false;
+  return pool.lastPlayed[emote] == 0 ||
+         now - pool.lastPlayed[emote] >= pool.cooldownMs[emote];
+}
+
+/**
+ * @brief Put every weighted emote of a pool back in its bag
+ *
+ * @param pool Pool to refill
+ */
+static void refillBag(EmotePool &pool) {
+  pool.remaining = 0;
+  for (uint8_t i = 0; i < pool.count; i++) {
+    if (pool.weights[i] > 0) {
+      pool.bag[pool.remaining++] = i;
+    }
+  }
+  // A pool with every weight at zero still plays, uniformly
+  if (pool.remaining == 0) {
+    for (uint8_t i = 0; i < pool.count; i++) {
+      pool.bag[pool.remaining++] = i;
+    }
+  }
+}
+
+/**
+ * @brief Weighted pick from the bag, honoring history and cooldowns
+ *
+ * Constraints are dropped rather than failing when they exclude every
+ * remaining entry, so a pick is always made.
+ *
+ * @param pool Pool to pick from
+ * @return Emote index within the pool
+ */
+static uint8_t pickFromBag(EmotePool &pool) {
+  if (pool.remaining == 0) {
+    refillBag(pool);
+  }
+
+  unsigned long now = millis();
+  for (int strict = 1; strict >= 0; strict--) {
+    uint32_t totalWeight = 0;
+    for (uint8_t i = 0; i < pool.remaining; i++) {
+      uint8_t emote = pool.bag[i];
+      if (!strict || isEligible(pool, emote, now)) {
+        totalWeight += max<uint8_t>(pool.weights[emote], 1);
+      }
+    }
+    if (totalWeight == 0)
+      continue;
+
+    uint32_t target = random(totalWeight);
+    for (uint8_t i = 0; i < pool.remaining; i++) {
+      uint8_t emote = pool.bag[i];
+      if (strict && !isEligible(pool, emote, now))
+        continue;
+      uint8_t weight = max<uint8_t>(pool.weights[emote], 1);
+      if (target < weight) {
+        return emote;
+      }
+      target -= weight;
+    }
+  }
+  return pool.bag[0];
+}
+
+/**
+ * @brief Remove a selected emote from the bag and record it
+ *
+ * @param pool Pool the emote belongs to
+ * @param emote Emote index within the pool
+ */
+static void consumeEmote(EmotePool &pool, uint8_t emote) {
+  for (uint8_t i = 0; i < pool.remaining; i++) {
+    if (pool.bag[i] == emote) {
+      pool.bag[i] = pool.bag[pool.remaining - 1];
+      pool.remaining--;
+      break;
+    }
+  }
+  pool.lastPlayed[emote] = max<unsigned long>(millis(), 1);
+  pool.peeked = -1;
+
+  history[historyIndex] = pool.emotes[emote];
+  historyIndex = (historyIndex + 1) % EMOTE_HISTORY_SIZE;
+}
+
+//==============================================================================
+// PUBLIC API FUNCTIONS
+//==============================================================================
+
+/**
+ * @brief Register a pool of emotes, or find it if already registered
+ *
+ * @param emotes Array of emote handles, must outlive the pool
+ * @param count Number of emotes in the array
+ * @param weights Per-emote weights, nullptr for uniform selection
+ * @param cooldownsMs Per-emote re-selection cooldowns, nullptr for none
+ * @return Pool handle, or EMOTE_POOL_INVALID if the pool cannot be stored
+ */
+int registerEmotePool(const EmoteId *emotes, size_t count,
+                      const uint8_t *weights, const uint32_t *cooldownsMs) {
+  for (size_t i = 0; i < poolCount; i++) {
+    if (pools[i].emotes == emotes && pools[i].count == count) {
+      return i;
+    }
+  }
+
+  if (!emotes || count == 0 || count > EMOTE_POOL_MAX_SIZE ||
+      poolCount >= EMOTE_POOL_MAX_COUNT) {
+    ESP_LOGE(SELECTOR_LOG, "ERROR: Cannot register pool of %u emotes", count);
+    return EMOTE_POOL_INVALID;
+  }
+
+  EmotePool &pool = pools[poolCount];
+  memset(&pool, 0, sizeof(pool));
+  pool.emotes = emotes;
+  pool.count = count;
+  pool.peeked = -1;
+  for (size_t i = 0; i < count; i++) {
+    pool.weights[i] = weights ? weights[i] : 1;
+    pool.cooldownMs[i] = cooldownsMs ? cooldownsMs[i] : 0;
+  }
+  refillBag(pool);
+  return poolCount++;
+}
+
+/**
+ * @brief Select the next emote from a pool
+ *
+ * @param pool Pool handle
+ * @return Emote handle, or EmoteId::NONE if the pool handle is invalid
+ */
+EmoteId selectEmote(int pool) {
+  if (pool < 0 || (size_t)pool >= poolCount)
+    return EmoteId::NONE;
+
+  EmotePool &p = pools[pool];
+  uint8_t emote = (p.peeked >= 0) ? p.peeked : pickFromBag(p);
+  consumeEmote(p, emote);
+  return p.emotes[emote];
+}
+
+/**
+ * @brief Decide the next emote of a pool without consuming it
+ *
+ * @param pool Pool handle
+ * @return Emote the next selectEmote() call will return
+ */
+EmoteId peekNextEmote(int pool) {
+  if (pool < 0 || (size_t)pool >= poolCount)
+    return EmoteId::NONE;
+
+  EmotePool &p = pools[pool];
+  if (p.peeked < 0) {
+    p.peeked = pickFromBag(p);
+  }
+  return p.emotes[p.peeked];
+}
+
+/**
+ * @brief Forget all registered pools and selection history
+ */
+void resetEmotePools() {
+  poolCount = 0;
+  for (size_t i = 0; i < EMOTE_HISTORY_SIZE; i++) {
+    history[i] = EmoteId::NONE;
+  }
+  historyIndex = 0;
+}
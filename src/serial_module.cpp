@@ -10,11 +10,15 @@
 
 #include "serial_module.h"
 #include "common.h"
+#include "delta_module.h"
 #include "flash_module.h"
+#include "inflate_module.h"
 #include "ota_module.h"
+#include "resume_module.h"
 #include "system_module.h"
 #include "wifi_module.h"
 #include <esp_ota_ops.h>
+#include <esp_rom_crc.h>
 
 //==============================================================================
 // GLOBAL VARIABLES
@@ -34,6 +38,52 @@ static size_t expectedFirmwareSize = 0;
 static int currentUpdateCommand = U_FLASH;
 /** @brief Total bytes written for size validation */
 static size_t total_written = 0;
+/** @brief Progress percentage last reported to the host */
+static int lastReportedPercent = -1;
+/** @brief Encoding of the image being received */
+static ImageEncoding updateEncoding = ImageEncoding::NONE;
+/** @brief The bytes received are a patch against the running firmware */
+static bool updateDelta = false;
+/** @brief Time the current chunk started or progress was last sent (ms) */
+static unsigned long lastKeepaliveTime = 0;
+
+/** @brief Whether input and output are COBS frames instead of text lines */
+static bool binaryMode = false;
+/** @brief Encoded bytes of the frame being received and its delimiter */
+static uint8_t frameBuffer[SERIAL_FRAME_MAX_ENCODED + 1];
+/** @brief Encoded bytes received since the last delimiter */
+static size_t frameLength = 0;
+/** @brief Buffered bytes already searched for a delimiter */
+static size_t frameScanned = 0;
+/** @brief Frame outgrew the buffer, dropped at the next delimiter */
+static bool frameOverflow = false;
+/** @brief Time of the last valid frame (ms) */
+static unsigned long lastFrameTime = 0;
+/** @brief Chunks written, the low 16 bits are the next DATA sequence */
+static uint32_t chunksWritten = 0;
+/** @brief DATA frames the host may have in flight */
+static uint8_t windowSize = 1;
+/** @brief Chunks held beyond a gap, windowSize - 1 payload slots */
+static uint8_t *windowSlots = nullptr;
+/** @brief Payload length of each held chunk */
+static uint16_t windowLengths[SERIAL_WINDOW_MAX];
+/** @brief Bit i set when chunk chunksWritten + 1 + i is held */
+static uint32_t windowHeld = 0;
+/** @brief Frame bytes read since binary mode started */
+static uint32_t rxConsumed = 0;
+/** @brief Sequence echoed in RESPONSE frames */
+static uint16_t responseSeq = 0;
+/** @brief Frames dropped for a bad CRC or length */
+static uint32_t framesCorrupt = 0;
+/** @brief DATA frames received again after they were written */
+static uint32_t framesDuplicate = 0;
+
+/** @brief COBS block being sent, byte 0 is filled with its code */
+static uint8_t txBlock[255];
+/** @brief Bytes used in txBlock including the code byte */
+static uint8_t txBlockLength = 1;
+/** @brief CRC32 of the frame being sent so far */
+static uint32_t txCrc = 0;
 
 //==============================================================================
 // BASE64 DECODING
@@ -74,15 +124,8 @@ static size_t simpleBase64Decode(const String &input, uint8_t *output,
     return 0;
   }
 
-  // Basic character validation
-  for (size_t i = 0; i < input.length(); i++) {
-    char c = input[i];
-    if (!((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') ||
-          (c >= '0' && c <= '9') || c == '+' || c == '/' || c == '=')) {
-      return 0;
-    }
-  }
-
+  // The table marks invalid characters with 255 and padding with 254, so
+  // characters are validated while decoding
   size_t outputLen = 0;
   size_t inputLen = input.length();
 
@@ -92,7 +135,7 @@ static size_t simpleBase64Decode(const String &input, uint8_t *output,
     uint8_t c = base64_decode_table[(uint8_t)input[i + 2]];
     uint8_t d = base64_decode_table[(uint8_t)input[i + 3]];
 
-    if (a == 255 || b == 255) {
+    if (a >= 254 || b >= 254 || c == 255 || d == 255) {
       return 0;
     }
 
@@ -110,6 +153,167 @@ static size_t simpleBase64Decode(const String &input, uint8_t *output,
   return outputLen;
 }
 
+//==============================================================================
+// BINARY FRAMING
+//==============================================================================
+
+/**
+ * @brief Decode a COBS frame in place
+ *
+ * @param buffer Encoded bytes without the delimiter, decoded bytes on return
+ * @param length Encoded length
+ * @return Decoded length, or 0 if the encoding is broken
+ */
+static size_t cobsDecode(uint8_t *buffer, size_t length) {
+  size_t read = 0;
+  size_t written = 0;
+
+  while (read < length) {
+    uint8_t code = buffer[read++];
+    if (code == 0 || read + code - 1 > length) {
+      return 0;
+    }
+    // Output never overtakes input, each block loses its code byte
+    for (uint8_t i = 1; i < code; i++) {
+      buffer[written++] = buffer[read++];
+    }
+    if (code != 0xFF && read < length) {
+      buffer[written++] = 0;
+    }
+  }
+
+  return written;
+}
+
+/**
+ * @brief Encode bytes into the frame being sent
+ *
+ * Blocks go out as soon as they are complete, so a frame of any length
+ * needs no more than one block of RAM.
+ *
+ * @param data Bytes to add
+ * @param length Number of bytes
+ */
+static void framePut(const uint8_t *data, size_t length) {
+  txCrc = esp_rom_crc32_le(txCrc, data, length);
+
+  for (size_t i = 0; i < length; i++) {
+    if (data[i] != 0) {
+      txBlock[txBlockLength++] = data[i];
+    }
+    if (data[i] == 0 || txBlockLength == 0xFF) {
+      txBlock[0] = txBlockLength;
+      Serial.write(txBlock, txBlockLength);
+      txBlockLength = 1;
+    }
+  }
+}
+
+/**
+ * @brief Send one frame
+ *
+ * @param type Frame type
+ * @param seq Sequence number
+ * @param payload Payload bytes, may be nullptr if length is 0
+ * @param length Payload length
+ */
+static void sendFrame(SerialFrameType type, uint16_t seq,
+                      const uint8_t *payload, size_t length) {
+  if (length > SERIAL_FRAME_MAX_PAYLOAD) {
+    length = SERIAL_FRAME_MAX_PAYLOAD;
+  }
+
+  uint8_t header[SERIAL_FRAME_HEADER_SIZE] = {
+      static_cast<uint8_t>(type), static_cast<uint8_t>(seq & 0xFF),
+      static_cast<uint8_t>(seq >> 8), static_cast<uint8_t>(length & 0xFF),
+      static_cast<uint8_t>(length >> 8)};
+
+  txCrc = 0;
+  txBlockLength = 1;
+  framePut(header, sizeof(header));
+  framePut(payload, length);
+
+  uint32_t crc = txCrc;
+  uint8_t trailer[SERIAL_FRAME_CRC_SIZE] = {
+      static_cast<uint8_t>(crc & 0xFF), static_cast<uint8_t>(crc >> 8),
+      static_cast<uint8_t>(crc >> 16), static_cast<uint8_t>(crc >> 24)};
+  framePut(trailer, sizeof(trailer));
+
+  txBlock[0] = txBlockLength;
+  Serial.write(txBlock, txBlockLength);
+  Serial.write(static_cast<uint8_t>(0));
+}
+
+/**
+ * @brief Store a value little endian
+ *
+ * @param out Destination, 4 bytes
+ * @param value Value to store
+ */
+static void putUint32(uint8_t *out, uint32_t value) {
+  out[0] = value & 0xFF;
+  out[1] = (value >> 8) & 0xFF;
+  out[2] = (value >> 16) & 0xFF;
+  out[3] = value >> 24;
+}
+
+/**
+ * @brief Frame bytes the host may have sent in total right now
+ *
+ * Everything read so far plus what still fits in the RX buffer.
+ *
+ * @return Receive limit for ACK and NAK frames
+ */
+static uint32_t receiveLimit() {
+  int buffered = Serial.available();
+  return rxConsumed + SERIAL_RX_BUFFER_SIZE - (buffered > 0 ? buffered : 0);
+}
+
+/**
+ * @brief Acknowledge every chunk written and every chunk held
+ */
+static void sendAck() {
+  uint8_t payload[8];
+  putUint32(payload, windowHeld);
+  putUint32(payload + 4, receiveLimit());
+  sendFrame(SerialFrameType::ACK, chunksWritten & 0xFFFF, payload,
+            sizeof(payload));
+}
+
+/**
+ * @brief Ask the host to resend from the next expected chunk
+ *
+ * @param reason Why the frame was not accepted
+ */
+static void sendNak(SerialNakReason reason) {
+  uint8_t payload[5];
+  payload[0] = static_cast<uint8_t>(reason);
+  putUint32(payload + 1, receiveLimit());
+  sendFrame(SerialFrameType::NAK, chunksWritten & 0xFFFF, payload,
+            sizeof(payload));
+}
+
+/**
+ * @brief Drop held chunks and their slots, back to one frame in flight
+ */
+static void releaseWindow() {
+  free(windowSlots);
+  windowSlots = nullptr;
+  windowSize = 1;
+  windowHeld = 0;
+}
+
+/**
+ * @brief Leave binary mode and forget any partial frame
+ */
+static void stopBinaryMode() {
+  binaryMode = false;
+  frameLength = 0;
+  frameScanned = 0;
+  frameOverflow = false;
+  releaseWindow();
+}
+
 //==============================================================================
 // UTILITY FUNCTIONS
 //==============================================================================
@@ -203,7 +407,18 @@ static String createDeviceInfoResponse(bool success, String message) {
       ",\"current_mode\":\"" +
       String((getCurrentMode() == SystemMode::UPDATE_MODE) ? "Update Mode"
                                                            : "Standby Mode") +
-      "\"";
+      "\"" + ",\"encodings\":" INFLATE_ENCODINGS_JSON +
+      ",\"resume\":true,\"session\":" + getUpdateSessionJson();
+
+  // Delta patches name the firmware they apply to by its hash
+  const uint8_t *firmwareHash = getRunningFirmwareHash();
+  if (firmwareHash) {
+    char hex[DELTA_HASH_SIZE * 2 + 1];
+    for (int i = 0; i < DELTA_HASH_SIZE; i++) {
+      sprintf(hex + i * 2, "%02x", firmwareHash[i]);
+    }
+    response += ",\"firmware_sha256\":\"" + String(hex) + "\"";
+  }
 
   // Add partition information
   const esp_partition_t *running = esp_ota_get_running_partition();
@@ -245,7 +460,27 @@ static String createStatusResponse(bool success, String message) {
                                                                 : "false") +
          ",\"progress\":" + String(updateProgress.percentage) +
          ",\"received\":" + String(updateProgress.receivedSize) +
-         ",\"total\":" + String(updateProgress.totalSize) + "}";
+         ",\"total\":" + String(updateProgress.totalSize) +
+         ",\"encoding\":\"" + String(getImageEncodingName(updateEncoding)) +
+         "\"" + ",\"inflated\":" + String(getInflatedSize()) +
+         ",\"delta\":" + String(updateDelta ? "true" : "false") +
+         ",\"binary\":" + String(binaryMode ? "true" : "false") +
+         ",\"frames_corrupt\":" + String(framesCorrupt) +
+         ",\"frames_duplicate\":" + String(framesDuplicate) + "}";
+}
+
+/**
+ * @brief Send one protocol line as text or as a RESPONSE frame
+ *
+ * @param line Line without the newline
+ */
+static void sendSerialLine(const String &line) {
+  if (binaryMode) {
+    sendFrame(SerialFrameType::RESPONSE, responseSeq,
+              reinterpret_cast<const uint8_t *>(line.c_str()), line.length());
+  } else {
+    Serial.println(line);
+  }
 }
 
 /**
@@ -256,7 +491,7 @@ static String createStatusResponse(bool success, String message) {
  */
 static void sendSerialResponse(const String &jsonResponse,
                                bool isError = false) {
-  Serial.println((isError ? RESP_ERROR : RESP_OK) + jsonResponse);
+  sendSerialLine((isError ? RESP_ERROR : RESP_OK) + jsonResponse);
 }
 
 /**
@@ -269,7 +504,7 @@ static void sendProgressUpdate(int percentage, const String &message) {
   String jsonResponse = createSerialJsonResponse(
       (currentSerialState != SerialUpdateState::ERROR), message,
       (currentSerialState == SerialUpdateState::SUCCESS), percentage);
-  Serial.println(RESP_PROGRESS + jsonResponse);
+  sendSerialLine(RESP_PROGRESS + jsonResponse);
 }
 
 /**
@@ -321,39 +556,155 @@ static void handleGetStatus() {
   sendSerialResponse(jsonResponse);
 }
 
+/**
+ * @brief Keep the host waiting while one chunk inflates to many sectors
+ *
+ * A long run of equal bytes compresses to almost nothing, so a single
+ * chunk can take seconds to write. Progress sent every SERIAL_KEEPALIVE_MS
+ * tells the host the device is busy rather than gone.
+ *
+ * @param inflated Image bytes written so far
+ */
+static void keepSerialAlive(size_t inflated) {
+  if (millis() - lastKeepaliveTime < SERIAL_KEEPALIVE_MS) {
+    return;
+  }
+  lastKeepaliveTime = millis();
+  sendProgressUpdate(updateProgress.percentage,
+                     "Writing image, " + formatBytes(inflated) + " done");
+}
+
+/**
+ * @brief Write image bytes to the update session, or apply them as a patch
+ *
+ * Also takes the output of inflate when the image is compressed.
+ *
+ * @param data Image or patch bytes
+ * @param length Number of bytes
+ * @return true if all bytes were used
+ */
+static bool writeImageBytes(uint8_t *data, size_t length) {
+  if (updateDelta) {
+    return deltaWrite(data, length);
+  }
+  return sessionWrite(data, length);
+}
+
+/**
+ * @brief Why writeImageBytes() or the inflate feeding it failed
+ *
+ * @return Error message
+ */
+static const char *getImageWriteError() {
+  if (updateDelta && *getDeltaError()) {
+    return getDeltaError();
+  }
+  if (!updateDelta && *getSessionError()) {
+    return getSessionError();
+  }
+  if (updateEncoding != ImageEncoding::NONE) {
+    return getInflateError();
+  }
+  return "Flash write failed";
+}
+
+/**
+ * @brief Stop inflating and patching, safe when idle
+ */
+static void abortImageDecoding() {
+  abortInflate();
+  abortDelta();
+}
+
+/**
+ * @brief Stop writing the image, keeping what is in flash for a resume
+ *
+ * Delta updates can't be resumed and are simply aborted.
+ */
+static void stopImageWrite() {
+  abortImageDecoding();
+  if (updateDelta) {
+    Update.abort();
+  } else {
+    suspendUpdateSession();
+  }
+}
+
+/**
+ * @brief Split command data at commas
+ *
+ * @param data Command data
+ * @param fields Receives up to maxFields fields, missing ones are empty
+ * @param maxFields Size of fields
+ * @return Number of fields found
+ */
+static int splitFields(const String &data, String *fields, int maxFields) {
+  int count = 0;
+  int start = 0;
+  while (count < maxFields) {
+    int comma = data.indexOf(',', start);
+    fields[count++] = data.substring(start, comma == -1 ? data.length() : comma);
+    if (comma == -1) {
+      break;
+    }
+    start = comma + 1;
+  }
+  for (int i = count; i < maxFields; i++) {
+    fields[i] = "";
+  }
+  return count;
+}
+
 /**
  * @brief Initialize file upload for serial update
  *
- * @param cmd Command with firmware size and type parameters
+ * @param cmd Command with firmware size, type and optional encoding
  * @return true if initialization was successful
  */
 static bool initializeSerialUpdate(const SerialCommand &cmd) {
-  // Parse parameters: size,type (e.g., "1048576,firmware" or
-  // "3087360,filesystem")
-  int commaPos = cmd.data.indexOf(',');
-  if (commaPos == -1) {
+  // Parse parameters: size,type[,encoding[,sha256]] (e.g., "1048576,firmware"
+  // or "3087360,filesystem" or "412160,filesystem,gzip" or
+  // "61440,delta,gzip"), size is the number of bytes sent and sha256 names
+  // the image so the update can be resumed
+  String fields[4];
+  if (splitFields(cmd.data, fields, 4) < 2) {
     String jsonResponse = createSerialJsonResponse(
-        false, "Invalid START_UPDATE format. Expected: size,type");
+        false,
+        "Invalid START_UPDATE format. Expected: size,type[,encoding[,sha256]]");
     sendSerialResponse(jsonResponse, true);
     return false;
   }
 
-  String sizeStr = cmd.data.substring(0, commaPos);
-  String typeStr = cmd.data.substring(commaPos + 1);
+  String typeStr = fields[1];
+  String encodingStr = fields[2];
+  String imageHash = fields[3];
 
-  expectedFirmwareSize = sizeStr.toInt();
+  expectedFirmwareSize = fields[0].toInt();
 
   // Determine update type and size limits
   size_t maxAllowedSize;
+  updateDelta = false;
   if (typeStr == "filesystem") {
     currentUpdateCommand = U_SPIFFS;
     maxAllowedSize = 3 * 1024 * 1024; // 3MB for SPIFFS partition
   } else if (typeStr == "firmware") {
     currentUpdateCommand = U_FLASH;
     maxAllowedSize = 1536 * 1024; // 1.5MB for OTA partitions
+  } else if (typeStr == "delta") {
+    // A patch against the running firmware, never larger than the image
+    currentUpdateCommand = U_FLASH;
+    maxAllowedSize = 1536 * 1024;
+    updateDelta = true;
   } else {
     String jsonResponse = createSerialJsonResponse(
-        false, "Invalid update type. Expected: firmware or filesystem");
+        false, "Invalid update type. Expected: firmware, filesystem or delta");
+    sendSerialResponse(jsonResponse, true);
+    return false;
+  }
+
+  if (!parseImageEncoding(encodingStr, updateEncoding)) {
+    String jsonResponse = createSerialJsonResponse(
+        false, "Unsupported encoding. Expected: gzip or deflate");
     sendSerialResponse(jsonResponse, true);
     return false;
   }
@@ -387,17 +738,63 @@ static bool initializeSerialUpdate(const SerialCommand &cmd) {
     return false;
   }
 
-  // Initialize update
-  if (!Update.begin(expectedFirmwareSize, currentUpdateCommand)) {
+  // Initialize update, the size of a compressed or patched image is only
+  // known once it is produced so the whole partition is made available.
+  // Whatever was written before is gone once Update starts
+  clearUpdateSession();
+  bool compressed = updateEncoding != ImageEncoding::NONE;
+  if (!Update.begin((compressed || updateDelta) ? UPDATE_SIZE_UNKNOWN
+                                                : expectedFirmwareSize,
+                    currentUpdateCommand)) {
     String jsonResponse = createSerialJsonResponse(
         false, "Failed to initialize update: " + String(Update.errorString()));
     sendSerialResponse(jsonResponse, true);
     return false;
   }
 
+  if (!updateDelta && !beginUpdateSession(currentUpdateCommand, imageHash)) {
+    Update.abort();
+    String jsonResponse = createSerialJsonResponse(false, getSessionError());
+    sendSerialResponse(jsonResponse, true);
+    return false;
+  }
+
+  if (compressed &&
+      !beginInflate(updateEncoding, keepSerialAlive, writeImageBytes)) {
+    stopImageWrite();
+    String jsonResponse = createSerialJsonResponse(false, getInflateError());
+    sendSerialResponse(jsonResponse, true);
+    return false;
+  }
+  if (updateDelta) {
+    beginDelta();
+  }
+
   return true;
 }
 
+/**
+ * @brief Reset progress tracking and wait for image data
+ *
+ * @param message Reply to the command that started the transfer
+ */
+static void beginReceiving(const String &message) {
+  updateProgress.totalSize = expectedFirmwareSize;
+  updateProgress.receivedSize = 0;
+  updateProgress.percentage = 0;
+  updateProgress.message = "Update started";
+  total_written = 0;
+  lastReportedPercent = 0;
+  chunksWritten = 0;
+  windowHeld = 0;
+
+  currentSerialState = SerialUpdateState::RECEIVING;
+
+  String jsonResponse = createSerialJsonResponse(true, message);
+  sendSerialResponse(jsonResponse);
+  sendProgressUpdate(0, "Ready to receive firmware data");
+}
+
 /**
  * @brief Handle START_UPDATE command
  *
@@ -408,9 +805,7 @@ static bool initializeSerialUpdate(const SerialCommand &cmd) {
 static void handleStartUpdate(const SerialCommand &cmd) {
   // If already in progress, abort and reset
   if (currentSerialState != SerialUpdateState::IDLE) {
-    if (Update.isRunning()) {
-      Update.abort();
-    }
+    stopImageWrite();
     currentSerialState = SerialUpdateState::IDLE;
     updateProgress = {0, 0, 0, ""};
   }
@@ -419,63 +814,161 @@ static void handleStartUpdate(const SerialCommand &cmd) {
     return;
   }
 
-  // Reset progress tracking
-  updateProgress.totalSize = expectedFirmwareSize;
-  updateProgress.receivedSize = 0;
-  updateProgress.percentage = 0;
-  updateProgress.message = "Update started";
-  total_written = 0;
+  beginReceiving("Update initialized. Ready to receive data.");
+}
 
-  currentSerialState = SerialUpdateState::RECEIVING;
+/**
+ * @brief Continue an interrupted update from its persisted session
+ *
+ * @param cmd Command with size,type,encoding,sha256,offset: the bytes sent
+ *            encode the image from offset on
+ * @return true if the session could be resumed
+ */
+static bool initializeSerialResume(const SerialCommand &cmd) {
+  String fields[5];
+  if (splitFields(cmd.data, fields, 5) < 5) {
+    String jsonResponse = createSerialJsonResponse(
+        false, "Invalid RESUME_UPDATE format. Expected: "
+               "size,type,encoding,sha256,offset");
+    sendSerialResponse(jsonResponse, true);
+    return false;
+  }
 
-  String jsonResponse = createSerialJsonResponse(
-      true, "Update initialized. Ready to receive data.");
-  sendSerialResponse(jsonResponse);
-  sendProgressUpdate(0, "Ready to receive firmware data");
+  expectedFirmwareSize = fields[0].toInt();
+  updateDelta = false;
+  if (fields[1] == "filesystem") {
+    currentUpdateCommand = U_SPIFFS;
+  } else if (fields[1] == "firmware") {
+    currentUpdateCommand = U_FLASH;
+  } else {
+    String jsonResponse = createSerialJsonResponse(
+        false, "Invalid update type. Expected: firmware or filesystem");
+    sendSerialResponse(jsonResponse, true);
+    return false;
+  }
+
+  if (!parseImageEncoding(fields[2], updateEncoding)) {
+    String jsonResponse = createSerialJsonResponse(
+        false, "Unsupported encoding. Expected: gzip or deflate");
+    sendSerialResponse(jsonResponse, true);
+    return false;
+  }
+
+  if (expectedFirmwareSize == 0) {
+    String jsonResponse = createSerialJsonResponse(false, "Invalid file size");
+    sendSerialResponse(jsonResponse, true);
+    return false;
+  }
+
+  if (!resumeUpdateSession(currentUpdateCommand, fields[3],
+                           fields[4].toInt())) {
+    String jsonResponse = createSerialJsonResponse(false, getSessionError());
+    sendSerialResponse(jsonResponse, true);
+    return false;
+  }
+
+  if (updateEncoding != ImageEncoding::NONE &&
+      !beginInflate(updateEncoding, keepSerialAlive, writeImageBytes)) {
+    stopImageWrite();
+    String jsonResponse = createSerialJsonResponse(false, getInflateError());
+    sendSerialResponse(jsonResponse, true);
+    return false;
+  }
+
+  return true;
 }
 
 /**
- * @brief Handle the writing of uploaded data during serial update
+ * @brief Handle RESUME_UPDATE command
  *
- * @param cmd Command containing base64-encoded firmware chunk
- * @return Current progress percentage
+ * Picks up an update that stopped early, also after a reboot. The host
+ * learns the offset from the session in GET_INFO and sends the rest of the
+ * image, the part already in flash is checked by hash first.
+ *
+ * @param cmd Command with size,type,encoding,sha256,offset
  */
-static int handleChunkWrite(const SerialCommand &cmd) {
-  static uint8_t decodedBuffer[2048];
-  size_t decodedSize =
-      simpleBase64Decode(cmd.data, decodedBuffer, sizeof(decodedBuffer));
+static void handleResumeUpdate(const SerialCommand &cmd) {
+  if (currentSerialState != SerialUpdateState::IDLE) {
+    stopImageWrite();
+    currentSerialState = SerialUpdateState::IDLE;
+    updateProgress = {0, 0, 0, ""};
+  }
 
-  if (decodedSize == 0) {
-    Serial.println("ERROR:{\"success\":false,\"message\":\"Decode failed\"}");
-    return -1;
+  if (!initializeSerialResume(cmd)) {
+    return;
   }
 
+  beginReceiving("Update resumed at " + formatBytes(getSessionWritten()) +
+                 ". Ready to receive data.");
+}
+
+/**
+ * @brief Write one chunk of image data
+ *
+ * @param data Raw image bytes
+ * @param length Number of bytes
+ * @return Current progress percentage, or -1 after an error
+ */
+static int writeChunk(uint8_t *data, size_t length) {
   // Size overflow protection
-  if (total_written + decodedSize > expectedFirmwareSize) {
+  if (total_written + length > expectedFirmwareSize) {
     currentSerialState = SerialUpdateState::ERROR;
-    Update.abort();
-    Serial.println(
+    stopImageWrite();
+    sendSerialLine(
         "ERROR:{\"success\":false,\"message\":\"Data exceeds expected size\"}");
     return -1;
   }
 
-  size_t written = Update.write(decodedBuffer, decodedSize);
-  if (written != decodedSize) {
+  lastKeepaliveTime = millis();
+  bool written = (updateEncoding == ImageEncoding::NONE)
+                     ? writeImageBytes(data, length)
+                     : inflateWrite(data, length);
+  if (!written) {
+    const char *reason = getImageWriteError();
     currentSerialState = SerialUpdateState::ERROR;
-    Update.abort();
-    Serial.println(
-        "ERROR:{\"success\":false,\"message\":\"Flash write failed\"}");
+    stopImageWrite();
+    sendSerialLine("ERROR:{\"success\":false,\"message\":\"" +
+                   String(reason) + "\"}");
     return -1;
   }
 
-  total_written += written;
-  updateProgress.receivedSize += written;
+  total_written += length;
+  updateProgress.receivedSize += length;
   updateProgress.percentage =
       (updateProgress.receivedSize * 100) / updateProgress.totalSize;
 
   return updateProgress.percentage;
 }
 
+/**
+ * @brief Handle the writing of uploaded data during serial update
+ *
+ * @param cmd Command containing base64-encoded firmware chunk
+ * @return Current progress percentage
+ */
+static int handleChunkWrite(const SerialCommand &cmd) {
+  static uint8_t decodedBuffer[2048];
+  size_t decodedSize =
+      simpleBase64Decode(cmd.data, decodedBuffer, sizeof(decodedBuffer));
+
+  if (decodedSize == 0) {
+    sendSerialLine("ERROR:{\"success\":false,\"message\":\"Decode failed\"}");
+    return -1;
+  }
+
+  return writeChunk(decodedBuffer, decodedSize);
+}
+
+/**
+ * @brief Report progress every 10%
+ */
+static void reportChunkProgress() {
+  if (updateProgress.percentage >= lastReportedPercent + 10) {
+    lastReportedPercent = updateProgress.percentage;
+    sendProgressUpdate(updateProgress.percentage, "Uploading firmware...");
+  }
+}
+
 /**
  * @brief Handle SEND_CHUNK command
  *
@@ -485,12 +978,12 @@ static int handleChunkWrite(const SerialCommand &cmd) {
  */
 static void handleSendChunk(const SerialCommand &cmd) {
   if (currentSerialState != SerialUpdateState::RECEIVING) {
-    Serial.println("ERROR:{\"success\":false,\"message\":\"Not receiving\"}");
+    sendSerialLine("ERROR:{\"success\":false,\"message\":\"Not receiving\"}");
     return;
   }
 
   if (cmd.data.length() == 0) {
-    Serial.println("ERROR:{\"success\":false,\"message\":\"Empty chunk\"}");
+    sendSerialLine("ERROR:{\"success\":false,\"message\":\"Empty chunk\"}");
     return;
   }
 
@@ -499,14 +992,86 @@ static void handleSendChunk(const SerialCommand &cmd) {
     return; // Error already handled in handleChunkWrite
   }
 
-  Serial.println("OK:{\"success\":true}");
+  sendSerialLine("OK:{\"success\":true}");
+  reportChunkProgress();
+}
 
-  // Progress updates only every 10%
-  static int lastPercent = -1;
-  if (updateProgress.percentage >= lastPercent + 10) {
-    lastPercent = updateProgress.percentage;
-    sendProgressUpdate(updateProgress.percentage, "Uploading firmware...");
+/**
+ * @brief Payload slot of a chunk held beyond a gap
+ *
+ * @param chunk Chunk index, at most windowSize - 1 past chunksWritten
+ * @return Slot of SERIAL_FRAME_MAX_PAYLOAD bytes
+ */
+static uint8_t *windowSlot(uint32_t chunk) {
+  return windowSlots + (chunk % (windowSize - 1)) * SERIAL_FRAME_MAX_PAYLOAD;
+}
+
+/**
+ * @brief Handle a DATA frame in binary mode
+ *
+ * The next expected chunk is written straight from the frame buffer along
+ * with any chunks held right behind it. A chunk further ahead but inside
+ * the window is held until the gap is filled. A chunk already written or
+ * held is only acknowledged again, its first ack was lost. A chunk beyond
+ * the window is refused.
+ *
+ * @param seq Chunk sequence number
+ * @param payload Raw image bytes
+ * @param length Number of bytes
+ */
+static void handleDataFrame(uint16_t seq, uint8_t *payload, size_t length) {
+  if (currentSerialState != SerialUpdateState::RECEIVING) {
+    sendSerialLine("ERROR:{\"success\":false,\"message\":\"Not receiving\"}");
+    return;
   }
+
+  // Serial arithmetic, sequences wrap after 65536 chunks
+  int16_t offset = static_cast<int16_t>(seq - (chunksWritten & 0xFFFF));
+  if (offset < 0) {
+    framesDuplicate++;
+    sendAck();
+    return;
+  }
+  if (offset >= windowSize) {
+    sendNak(SerialNakReason::OUT_OF_ORDER);
+    return;
+  }
+  if (length == 0) {
+    sendNak(SerialNakReason::CORRUPT);
+    return;
+  }
+
+  if (offset > 0) {
+    uint32_t bit = 1UL << (offset - 1);
+    if (windowHeld & bit) {
+      framesDuplicate++;
+    } else {
+      memcpy(windowSlot(chunksWritten + offset), payload, length);
+      windowLengths[(chunksWritten + offset) % (windowSize - 1)] = length;
+      windowHeld |= bit;
+    }
+    sendAck();
+    return;
+  }
+
+  if (writeChunk(payload, length) < 0) {
+    return; // Error already reported by writeChunk
+  }
+  chunksWritten++;
+
+  // Bit 0 is now the next expected chunk until the final shift
+  while (windowHeld & 1) {
+    windowHeld >>= 1;
+    if (writeChunk(windowSlot(chunksWritten),
+                   windowLengths[chunksWritten % (windowSize - 1)]) < 0) {
+      return;
+    }
+    chunksWritten++;
+  }
+  windowHeld >>= 1;
+
+  sendAck();
+  reportChunkProgress();
 }
 
 /**
@@ -518,7 +1083,7 @@ static bool finalizeSerialUpdate() {
   // Verify expected size was received
   if (total_written != expectedFirmwareSize) {
     currentSerialState = SerialUpdateState::ERROR;
-    Update.abort();
+    stopImageWrite();
     String jsonResponse = createSerialJsonResponse(
         false, "Size mismatch - Expected: " + String(expectedFirmwareSize) +
                    ", Received: " + String(total_written));
@@ -528,16 +1093,31 @@ static bool finalizeSerialUpdate() {
     return false;
   }
 
-  if (Update.end(true)) {
+  if ((updateEncoding != ImageEncoding::NONE && !endInflate()) ||
+      (updateDelta && !endDelta())) {
+    currentSerialState = SerialUpdateState::ERROR;
+    String jsonResponse = createSerialJsonResponse(
+        false, "Update failed: " + String(getImageWriteError()));
+    stopImageWrite();
+    sendSerialResponse(jsonResponse, true);
+    return false;
+  }
+
+  // The session checks the image hash and activates the partition
+  bool finished = updateDelta ? Update.end(true) : endUpdateSession();
+  if (finished) {
     currentSerialState = SerialUpdateState::SUCCESS;
     updateProgress.message = "Update completed successfully";
     return true;
   } else {
     currentSerialState = SerialUpdateState::ERROR;
     String jsonResponse = createSerialJsonResponse(
-        false, "Update failed: " + String(Update.errorString()));
+        false, "Update failed: " + String(updateDelta ? Update.errorString()
+                                                      : getSessionError()));
     sendSerialResponse(jsonResponse, true);
-    Update.abort();
+    if (updateDelta) {
+      Update.abort();
+    }
     return false;
   }
 }
@@ -570,9 +1150,12 @@ static void handleFinishUpdate() {
 /**
  * @brief Handle ABORT_UPDATE command
  *
- * Safely cancels any ongoing update process and resets state.
+ * Safely cancels any ongoing update process and resets state, the update
+ * can't be resumed afterwards.
  */
 static void handleAbortUpdate() {
+  // An explicit abort also drops a session kept for resuming
+  clearUpdateSession();
   if (currentSerialState == SerialUpdateState::IDLE) {
     String jsonResponse =
         createSerialJsonResponse(true, "No update in progress");
@@ -580,9 +1163,12 @@ static void handleAbortUpdate() {
     return;
   }
 
+  abortImageDecoding();
   Update.abort();
   currentSerialState = SerialUpdateState::IDLE;
   updateProgress = {0, 0, 0, "Update aborted"};
+  chunksWritten = 0;
+  windowHeld = 0;
 
   String jsonResponse = createSerialJsonResponse(true, "Update aborted");
   sendSerialResponse(jsonResponse);
@@ -612,6 +1198,57 @@ static void handleGetLogs() {
   sendSerialResponse(jsonResponse);
 }
 
+/**
+ * @brief Handle BINARY command
+ *
+ * BINARY:1[,window] switches to frames after the text reply, BINARY:0
+ * switches back after the framed reply. The reply carries the largest
+ * payload and window accepted and the RX buffer size, which is also the
+ * first receive limit.
+ *
+ * @param cmd Command with 1 and an optional window, or 0
+ */
+static void handleBinaryMode(const SerialCommand &cmd) {
+  bool enable = cmd.data.startsWith("1");
+  int window = 1;
+  int commaPos = cmd.data.indexOf(',');
+  if (enable && commaPos != -1) {
+    window = constrain(cmd.data.substring(commaPos + 1).toInt(), 1,
+                       SERIAL_WINDOW_MAX);
+  }
+
+  // Held chunks are dropped, the host resends what wasn't acknowledged
+  releaseWindow();
+  if (window > 1) {
+    windowSlots = static_cast<uint8_t *>(
+        malloc((window - 1) * SERIAL_FRAME_MAX_PAYLOAD));
+    if (windowSlots) {
+      windowSize = window;
+    } else {
+      ESP_LOGW(SERIAL_LOG, "No memory for a window of %d, using 1", window);
+    }
+  }
+
+  String jsonResponse =
+      "{\"success\":true,\"message\":\"Binary framing " +
+      String(enable ? "enabled" : "disabled") + "\",\"max_payload\":" +
+      String(SERIAL_FRAME_MAX_PAYLOAD) + ",\"window\":" +
+      String(windowSize) + ",\"rx_buffer\":" + String(SERIAL_RX_BUFFER_SIZE) +
+      "}";
+  sendSerialResponse(jsonResponse);
+
+  if (enable && !binaryMode) {
+    binaryMode = true;
+    frameLength = 0;
+    frameScanned = 0;
+    frameOverflow = false;
+    rxConsumed = 0;
+    lastFrameTime = millis();
+  } else if (!enable) {
+    stopBinaryMode();
+  }
+}
+
 //==============================================================================
 // SERIAL COMMAND PROCESSING
 //==============================================================================
@@ -630,6 +1267,8 @@ static void processCommand(const String &commandBuffer) {
     handleGetStatus();
   } else if (cmd.command == CMD_START_UPDATE) {
     handleStartUpdate(cmd);
+  } else if (cmd.command == CMD_RESUME_UPDATE) {
+    handleResumeUpdate(cmd);
   } else if (cmd.command == CMD_SEND_CHUNK) {
     handleSendChunk(cmd);
   } else if (cmd.command == CMD_FINISH_UPDATE) {
@@ -640,6 +1279,8 @@ static void processCommand(const String &commandBuffer) {
     handleRestart();
   } else if (cmd.command == CMD_GET_LOGS) {
     handleGetLogs();
+  } else if (cmd.command == CMD_BINARY_MODE) {
+    handleBinaryMode(cmd);
   } else if (cmd.command == "VERBOSE") {
     verboseLogging = (cmd.data == "1" || cmd.data.equalsIgnoreCase("true"));
     String jsonResponse = createSerialJsonResponse(
@@ -653,6 +1294,115 @@ static void processCommand(const String &commandBuffer) {
   }
 }
 
+/**
+ * @brief Check and dispatch one received frame
+ *
+ * Corrupt frames are answered with a NAK for the next expected chunk, their
+ * own header can't be trusted.
+ *
+ * @param buffer Encoded frame without the delimiter
+ * @param length Encoded length
+ */
+static void processFrame(uint8_t *buffer, size_t length) {
+  size_t size = cobsDecode(buffer, length);
+  if (size < SERIAL_FRAME_HEADER_SIZE + SERIAL_FRAME_CRC_SIZE) {
+    framesCorrupt++;
+    sendNak(SerialNakReason::CORRUPT);
+    return;
+  }
+
+  size_t payloadLength = buffer[3] | (buffer[4] << 8);
+  size_t crcOffset = size - SERIAL_FRAME_CRC_SIZE;
+  uint32_t crc = buffer[crcOffset] | (buffer[crcOffset + 1] << 8) |
+                 (buffer[crcOffset + 2] << 16) |
+                 (static_cast<uint32_t>(buffer[crcOffset + 3]) << 24);
+
+  if (payloadLength != crcOffset - SERIAL_FRAME_HEADER_SIZE ||
+      esp_rom_crc32_le(0, buffer, crcOffset) != crc) {
+    framesCorrupt++;
+    sendNak(SerialNakReason::CORRUPT);
+    return;
+  }
+
+  SerialFrameType type = static_cast<SerialFrameType>(buffer[0]);
+  uint16_t seq = buffer[1] | (buffer[2] << 8);
+  uint8_t *payload = buffer + SERIAL_FRAME_HEADER_SIZE;
+
+  switch (type) {
+  case SerialFrameType::COMMAND:
+    // The CRC is checked, its first byte terminates the command string
+    payload[payloadLength] = '\0';
+    responseSeq = seq;
+    processCommand(String(reinterpret_cast<const char *>(payload)));
+    break;
+  case SerialFrameType::DATA:
+    handleDataFrame(seq, payload, payloadLength);
+    break;
+  default:
+    ESP_LOGW(SERIAL_LOG, "Unexpected frame type %d", buffer[0]);
+    break;
+  }
+
+  // Timed from the end, a compressed chunk can take seconds to write and
+  // the host is silent while it waits
+  lastFrameTime = millis();
+}
+
+/**
+ * @brief Collect frames from the serial input in binary mode
+ *
+ * Reads straight into the frame buffer and stops after one frame is handled
+ * so a long burst of data can't starve the main loop. Bytes after the
+ * delimiter stay buffered for the next pass.
+ */
+static void handleBinaryInput() {
+  while (binaryMode) {
+    uint8_t *delimiter = static_cast<uint8_t *>(
+        memchr(frameBuffer + frameScanned, 0, frameLength - frameScanned));
+
+    if (delimiter) {
+      size_t length = delimiter - frameBuffer;
+      size_t rest = frameLength - length - 1;
+
+      if (frameOverflow) {
+        framesCorrupt++;
+        sendNak(SerialNakReason::CORRUPT);
+      } else if (length > 0) {
+        processFrame(frameBuffer, length);
+        if (!binaryMode) {
+          return; // BINARY:0, the host waits for the reply before sending
+        }
+      }
+
+      memmove(frameBuffer, delimiter + 1, rest);
+      frameLength = rest;
+      frameScanned = 0;
+      frameOverflow = false;
+      return;
+    }
+    frameScanned = frameLength;
+
+    // No delimiter in a full buffer, drop up to the next one
+    if (frameLength == sizeof(frameBuffer)) {
+      frameOverflow = true;
+      frameLength = 0;
+      frameScanned = 0;
+    }
+
+    int available = Serial.available();
+    if (available <= 0) {
+      return;
+    }
+    size_t count = sizeof(frameBuffer) - frameLength;
+    if (static_cast<size_t>(available) < count) {
+      count = available;
+    }
+    count = Serial.readBytes(frameBuffer + frameLength, count);
+    frameLength += count;
+    rxConsumed += count;
+  }
+}
+
 //==============================================================================
 // PUBLIC API IMPLEMENTATION
 //==============================================================================
@@ -665,7 +1415,7 @@ static void processCommand(const String &commandBuffer) {
  * @return true if initialization was successful
  */
 bool initSerial() {
-  Serial.setRxBufferSize(8192); // Increased from 4096
+  Serial.setRxBufferSize(SERIAL_RX_BUFFER_SIZE);
   Serial.setTxBufferSize(4096); // Increased from 2048
   Serial.begin(SERIAL_BAUD_RATE);
 
@@ -698,8 +1448,20 @@ bool initSerial() {
  * Should be called regularly in main loop.
  */
 void handleSerialCommands() {
+  if (binaryMode) {
+    if (millis() - lastFrameTime > SERIAL_BINARY_IDLE_MS) {
+      ESP_LOGI(SERIAL_LOG, "No frames for %d ms, back to text",
+               SERIAL_BINARY_IDLE_MS);
+      stopBinaryMode();
+    } else {
+      handleBinaryInput();
+      return;
+    }
+  }
+
   int processed = 0;
-  while (Serial.available() && processed < 128) {
+  // BINARY:1 ends the text loop, the next byte already belongs to a frame
+  while (!binaryMode && Serial.available() && processed < 128) {
     char c = Serial.read();
     processed++;
 
@@ -731,14 +1493,17 @@ void handleSerialCommands() {
 void cleanupSerial() {
   if (currentSerialState != SerialUpdateState::IDLE) {
     ESP_LOGI(SERIAL_LOG,
-             "Aborting active serial update during mode transition");
-    abortSerialUpdate();
+             "Suspending active serial update during mode transition");
+    stopImageWrite();
   }
 
   currentSerialState = SerialUpdateState::IDLE;
   commandBuffer = "";
   verboseLogging = false;
   updateProgress = {0, 0, 0, ""};
+  stopBinaryMode();
+  framesCorrupt = 0;
+  framesDuplicate = 0;
 
   ESP_LOGI(SERIAL_LOG, "Serial interface cleaned up for mode transition");
 }
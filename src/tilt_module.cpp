@@ -0,0 +1,135 @@
+/**
+ * @file tilt_module.cpp
+ * @brief Implementation of the low-latency motion-reactive render path
+ *
+ * The slosh offset is a damped spring pulled toward the current tilt and
+ * integrated over the real time between samples, so it overshoots when the
+ * device is tipped and settles like liquid in a glass.
+ */
+
+#include "tilt_module.h"
+#include "motion_module.h"
+
+//==============================================================================
+// GLOBAL VARIABLES
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// Slosh Spring
+//------------------------------------------------------------------------------
+/** @brief Spring stiffness (1/s²) */
+const float SLOSH_STIFFNESS = 90.0f;
+/** @brief Velocity damping (1/s), below critical so the spring overshoots */
+const float SLOSH_DAMPING = 7.0f;
+/** @brief Longest step integrated at once (s), avoids blow-ups after pauses */
+const float SLOSH_MAX_STEP = 0.05f;
+
+/** @brief State of the current frame */
+static TiltState tiltState = {0, 0, 0, 0, 0};
+/** @brief Slosh velocity */
+static float sloshVelocityX = 0, sloshVelocityY = 0;
+/** @brief Sample time the slosh simulation has advanced to */
+static uint32_t lastSampleTime = 0;
+/** @brief Latency statistics */
+static MotionToPhotonStats latencyStats = {0, 0, 0, 0};
+
+//==============================================================================
+// INTERNAL FUNCTIONS
+//==============================================================================
+
+/**
+ * @brief Advance one slosh axis
+ *
+ * @param position Spring position
+ * @param velocity Spring velocity
+ * @param target Current tilt
+ * @param dt Step (s)
+ */
+static void stepSlosh(float &position, float &velocity, float target,
+                      float dt) {
+  float acceleration =
+      SLOSH_STIFFNESS * (target - position) - SLOSH_DAMPING * velocity;
+  velocity += acceleration * dt;
+  position += velocity * dt;
+  position = constrain(position, -1.5f, 1.5f);
+}
+
+//==============================================================================
+// PUBLIC API FUNCTIONS
+//==============================================================================
+
+/**
+ * @brief Fetch fresh motion data for the frame about to be rendered
+ *
+ * @return Tilt state to render with
+ */
+TiltState beginMotionReactiveFrame() {
+  requestMotionTracking();
+  ADXLDataPolling();
+
+  GravityVector gravity = getFilteredGravity();
+  // Y is the lateral axis, X tips the face up and down
+  tiltState.tiltX = constrain(gravity.y / TILT_FULL_SCALE, -1.0f, 1.0f);
+  tiltState.tiltY = constrain(gravity.x / TILT_FULL_SCALE, -1.0f, 1.0f);
+
+  if (gravity.sampleTime != lastSampleTime) {
+    float dt = (lastSampleTime == 0)
+                   ? 0
+                   : (uint32_t)(gravity.sampleTime - lastSampleTime) / 1e6f;
+    dt = min(dt, SLOSH_MAX_STEP);
+    stepSlosh(tiltState.sloshX, sloshVelocityX, tiltState.tiltX, dt);
+    stepSlosh(tiltState.sloshY, sloshVelocityY, tiltState.tiltY, dt);
+    lastSampleTime = gravity.sampleTime;
+  }
+  tiltState.sampleTime = gravity.sampleTime;
+  return tiltState;
+}
+
+/**
+ * @brief Finish a motion-reactive frame and record its latency
+ *
+ * @param pixelsWritten Pixels sent this frame, 0 skips the measurement
+ */
+void endMotionReactiveFrame(uint32_t pixelsWritten) {
+  if (pixelsWritten == 0 || tiltState.sampleTime == 0)
+    return;
+
+  uint32_t latency = static_cast<uint32_t>(micros()) - tiltState.sampleTime;
+  latencyStats.count++;
+  latencyStats.totalMicros += latency;
+  if (latency > latencyStats.maxMicros) {
+    latencyStats.maxMicros = latency;
+  }
+  if (latency > TILT_LATENCY_BUDGET_US) {
+    latencyStats.overBudget++;
+  }
+
+  if (latencyStats.count % TILT_LATENCY_LOG_INTERVAL == 0) {
+    ESP_LOGI(TILT_LOG,
+             "Sample-to-pixel latency: n=%u avg=%.1fms max=%.1fms "
+             "over %dms: %u",
+             latencyStats.count,
+             latencyStats.totalMicros / 1000.0f / latencyStats.count,
+             latencyStats.maxMicros / 1000.0f, TILT_LATENCY_BUDGET_US / 1000,
+             latencyStats.overBudget);
+  }
+}
+
+/**
+ * @brief Tilt state of the current frame
+ *
+ * @return Copy of the state returned by beginMotionReactiveFrame()
+ */
+TiltState getTiltState() { return tiltState; }
+
+/**
+ * @brief Sample-to-pixel latency statistics since the last reset
+ *
+ * @return Copy of the statistics
+ */
+MotionToPhotonStats getMotionToPhotonStats() { return latencyStats; }
+
+/**
+ * @brief Clear the latency statistics
+ */
+void resetMotionToPhotonStats() { latencyStats = {0, 0, 0, 0}; }
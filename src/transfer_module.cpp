@@ -0,0 +1,1127 @@
+/**
+ * @file transfer_module.cpp
+ * @brief Implementation of bulk file and firmware transfers between bots
+ *
+ * One transfer runs at a time, so sender and receiver share one window of
+ * chunk buffers. The sender reads each chunk from flash once into its slot
+ * and resends it from there until the receiver's selective ack covers it.
+ * The receiver parks out-of-order chunks in their slot and writes the
+ * in-order prefix to the sink as soon as it is complete, hashing as it goes.
+ * Whole files, the one to seed and the local copy of an offered one, are
+ * hashed a few chunks per pass so no pass stalls on flash reads.
+ *
+ * Frames arrive in the ESP-NOW receive callback and are only copied into an
+ * SPSC queue there; everything else runs in handleTransfer() on the main
+ * loop, which keeps emotes paused while a transfer is active.
+ */
+
+#include "transfer_module.h"
+#include "compositor_module.h"
+#include "delta_module.h"
+#include "espnow_module.h"
+#include "flash_module.h"
+#include "ota_module.h"
+#include "spsc_queue.h"
+#include "vector_module.h"
+#include <LittleFS.h>
+#include <Update.h>
+#include <esp_ota_ops.h>
+#include <mbedtls/sha256.h>
+
+//==============================================================================
+// TYPE DEFINITIONS
+//==============================================================================
+
+/**
+ * @brief A transfer frame handed from the receive callback to the main loop
+ */
+struct TransferFrame {
+  uint8_t mac[6];                         /**< Sender */
+  uint8_t length;                         /**< Frame length */
+  uint8_t data[TRANSPORT_MAX_FRAME_SIZE]; /**< Frame bytes */
+};
+
+/**
+ * @brief Outcome of one slice of file hashing
+ */
+enum class HashProgress {
+  RUNNING, /**< More of the file is left */
+  DONE,    /**< Digest is ready */
+  FAILED   /**< The file could not be read */
+};
+
+static_assert(TRANSFER_WINDOW == 32, "Acks carry the window as 32 bits");
+
+//==============================================================================
+// GLOBAL VARIABLES
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// Session
+//------------------------------------------------------------------------------
+/** @brief Progress of the current or last transfer */
+static TransferStatus status = {};
+/** @brief Id of the current session, chosen by the sender */
+static uint16_t session = 0;
+/** @brief SHA-256 the image must match */
+static uint8_t imageHash[TRANSFER_HASH_SIZE];
+/** @brief File path or firmware version of the image */
+static char imageName[TRANSFER_MAX_NAME];
+/** @brief Chunks in the image */
+static uint32_t chunkCount = 0;
+/** @brief Time the offer was accepted */
+static unsigned long startedAt = 0;
+/** @brief Time of the last frame from the peer */
+static unsigned long lastHeard = 0;
+/** @brief Time of the last offer or finish request */
+static unsigned long lastControlAt = 0;
+/** @brief Offers or finish requests sent to the current peer */
+static uint8_t controlAttempts = 0;
+
+//------------------------------------------------------------------------------
+// Window, shared by both directions
+//------------------------------------------------------------------------------
+/** @brief Chunk bytes, chunk n lives in slot n % TRANSFER_WINDOW */
+static uint8_t windowData[TRANSFER_WINDOW][TRANSFER_CHUNK_SIZE];
+/** @brief Last send time of each slot (sender) */
+static unsigned long windowSentAt[TRANSFER_WINDOW];
+/** @brief First chunk not yet acked (sender) or written (receiver) */
+static uint32_t windowBase = 0;
+/** @brief Bit i set when chunk windowBase + i is acked or buffered */
+static uint32_t windowMask = 0;
+/** @brief First chunk never sent (sender) */
+static uint32_t nextChunk = 0;
+
+//------------------------------------------------------------------------------
+// Sender
+//------------------------------------------------------------------------------
+/** @brief Source of a file transfer */
+static File sourceFile;
+/** @brief Peers of the current seeding round */
+static uint8_t seedTargets[ESPNOW_MAX_PEERS][6];
+/** @brief Peers in seedTargets */
+static uint8_t seedTargetCount = 0;
+/** @brief Peer of seedTargets being served */
+static uint8_t seedCursor = 0;
+
+//------------------------------------------------------------------------------
+// Receiver
+//------------------------------------------------------------------------------
+/** @brief Destination of a file transfer, renamed on success */
+static File sinkFile;
+/** @brief Hash over the chunks written so far */
+static mbedtls_sha256_context sinkHash;
+/** @brief Chunks buffered since the last ack */
+static uint8_t unackedChunks = 0;
+/** @brief Time the first of them arrived */
+static unsigned long firstUnackedAt = 0;
+/** @brief Session finished last, its repeated finish requests are answered */
+static uint16_t lastSession = 0;
+/** @brief Sender of that session */
+static uint8_t lastPeer[6] = {0};
+/** @brief Reboot into new firmware at this time, 0 if none is due */
+static unsigned long restartAt = 0;
+/** @brief Time the owner allowed a firmware transfer, 0 if not allowed */
+static unsigned long firmwareAllowedAt = 0;
+
+//------------------------------------------------------------------------------
+// File hashing, spread over main loop passes
+//------------------------------------------------------------------------------
+/** @brief File being hashed while HASHING or CHECKING */
+static File hashSource;
+/** @brief Hash over the part of hashSource read so far */
+static mbedtls_sha256_context fileHash;
+
+/** @brief Frames waiting for handleTransfer() */
+static SPSCQueue<TransferFrame, TRANSFER_RX_QUEUE_SIZE> rxQueue;
+
+//==============================================================================
+// HELPERS
+//==============================================================================
+
+/**
+ * @brief Length of a chunk, only the last one may be short
+ * @param index Chunk index
+ * @return Chunk length (bytes)
+ */
+static size_t chunkLength(uint32_t index) {
+  if (index + 1 < chunkCount)
+    return TRANSFER_CHUNK_SIZE;
+  return status.totalBytes - index * TRANSFER_CHUNK_SIZE;
+}
+
+/**
+ * @brief Shift a window bitmap, shifting by 32 or more clears it
+ */
+static uint32_t shiftMask(uint32_t mask, uint32_t count) {
+  return count >= 32 ? 0 : mask >> count;
+}
+
+/**
+ * @brief Log a peer address with a message
+ */
+static void logPeer(const char *message, const uint8_t *mac) {
+  ESP_LOGI(TRANSFER_LOG, "%s %02X:%02X:%02X:%02X:%02X:%02X", message, mac[0],
+           mac[1], mac[2], mac[3], mac[4], mac[5]);
+}
+
+/**
+ * @brief Send a transfer frame
+ * @param mac Destination
+ * @param sessionId Session the frame belongs to
+ * @param type Frame type
+ * @param payload Bytes after the header, may be nullptr if length is 0
+ * @param length Payload length
+ * @return true if the transport accepted the frame
+ */
+static bool sendTransferFrame(const uint8_t *mac, uint16_t sessionId,
+                              TransferFrameType type, const void *payload,
+                              size_t length) {
+  uint8_t frame[TRANSPORT_MAX_FRAME_SIZE];
+  uint16_t magic = TRANSFER_FRAME_MAGIC;
+  memcpy(frame, &magic, sizeof(magic));
+  frame[2] = TRANSFER_PROTOCOL_VERSION;
+  frame[3] = static_cast<uint8_t>(type);
+  memcpy(frame + 4, &sessionId, sizeof(sessionId));
+  if (length) {
+    memcpy(frame + TRANSFER_HEADER_SIZE, payload, length);
+  }
+  return sendEspNowFrame(mac, frame, TRANSFER_HEADER_SIZE + length);
+}
+
+/**
+ * @brief Send a one-byte result frame to the current peer
+ */
+static void sendResult(TransferFrameType type, TransferResult result) {
+  uint8_t code = static_cast<uint8_t>(result);
+  sendTransferFrame(status.peer, session, type, &code, sizeof(code));
+}
+
+/**
+ * @brief Update elapsed time and throughput from the bytes done so far
+ */
+static void updateThroughput() {
+  status.elapsedMs = millis() - startedAt;
+  status.bytesPerSecond =
+      status.elapsedMs
+          ? static_cast<uint32_t>(status.doneBytes * 1000ULL /
+                                  status.elapsedMs)
+          : 0;
+}
+
+//==============================================================================
+// HASHING
+//==============================================================================
+
+/**
+ * @brief Read from the running app partition
+ */
+static bool readFirmware(void *context, uint32_t offset, uint8_t *buffer,
+                         size_t length) {
+  const esp_partition_t *partition =
+      static_cast<const esp_partition_t *>(context);
+  return esp_partition_read(partition, offset, buffer, length) == ESP_OK;
+}
+
+/**
+ * @brief Read the next bytes of an open file
+ */
+static bool readFile(void *context, uint32_t offset, uint8_t *buffer,
+                     size_t length) {
+  return static_cast<File *>(context)->read(buffer, length) == length;
+}
+
+/**
+ * @brief Start hashing a LittleFS file over the next passes
+ * @param path File path
+ * @return true if the file was opened
+ */
+static bool startFileHash(const char *path) {
+  hashSource = LittleFS.open(path, FILE_READ);
+  if (!hashSource)
+    return false;
+  mbedtls_sha256_init(&fileHash);
+  mbedtls_sha256_starts(&fileHash, 0);
+  return true;
+}
+
+/**
+ * @brief Drop the file hash in progress
+ */
+static void endFileHash() {
+  mbedtls_sha256_free(&fileHash);
+  hashSource.close();
+}
+
+/**
+ * @brief Hash up to TRANSFER_HASH_BURST more chunks of the file
+ *
+ * Uses the window as scratch, so only call while no chunks are in flight.
+ *
+ * @param digest Receives the hash once the whole file is read
+ * @return Whether the digest is ready
+ */
+static HashProgress stepFileHash(uint8_t *digest) {
+  for (int i = 0; i < TRANSFER_HASH_BURST; i++) {
+    size_t length = min<size_t>(TRANSFER_CHUNK_SIZE, hashSource.available());
+    if (length == 0) {
+      mbedtls_sha256_finish(&fileHash, digest);
+      endFileHash();
+      return HashProgress::DONE;
+    }
+    if (hashSource.read(windowData[0], length) != length) {
+      endFileHash();
+      return HashProgress::FAILED;
+    }
+    mbedtls_sha256_update(&fileHash, windowData[0], length);
+  }
+  return HashProgress::RUNNING;
+}
+
+//==============================================================================
+// RECEIVER
+//==============================================================================
+
+/**
+ * @brief Path a file is received under until its hash is checked
+ */
+static void partialPath(char *path) {
+  snprintf(path, TRANSFER_MAX_NAME + 5, "%s.part", imageName);
+}
+
+/**
+ * @brief Write the next in-order chunk to the sink
+ */
+static bool writeSink(uint8_t *data, size_t length) {
+  mbedtls_sha256_update(&sinkHash, data, length);
+  if (status.kind == TransferKind::FIRMWARE) {
+    return Update.write(data, length) == length;
+  }
+  return sinkFile.write(data, length) == length;
+}
+
+/**
+ * @brief Commit or discard the received image
+ * @param keep true to commit
+ * @return true if the image was committed
+ */
+static bool closeSink(bool keep) {
+  mbedtls_sha256_free(&sinkHash);
+
+  if (status.kind == TransferKind::FIRMWARE) {
+    if (keep && Update.end(true))
+      return true;
+    Update.abort();
+    return false;
+  }
+
+  char partial[TRANSFER_MAX_NAME + 5];
+  partialPath(partial);
+  sinkFile.close();
+  if (keep) {
+    LittleFS.remove(imageName);
+    if (LittleFS.rename(partial, imageName))
+      return true;
+  }
+  LittleFS.remove(partial);
+  return false;
+}
+
+/**
+ * @brief Tell the sender which chunks arrived
+ */
+static void sendAck() {
+  uint32_t payload[2] = {windowBase, windowMask};
+  sendTransferFrame(status.peer, session, TransferFrameType::ACK, payload,
+                    sizeof(payload));
+  unackedChunks = 0;
+}
+
+/**
+ * @brief End the current receive
+ * @param result Outcome, reported in the status
+ */
+static void endReceive(TransferResult result) {
+  updateThroughput();
+  status.lastResult = result;
+  status.state = TransferState::IDLE;
+  lastSession = session;
+  memcpy(lastPeer, status.peer, 6);
+}
+
+/** @brief Directories holding emote assets, the only ones files go into */
+static const char *const ASSET_DIRECTORIES[] = {"/gifs/", "/vectors/",
+                                                "/sprites/"};
+/** @brief Extensions of emote assets */
+static const char *const ASSET_EXTENSIONS[] = {
+    ".gif", VECTOR_EXTENSION, ".spr", SCENE_EXTENSION};
+
+/**
+ * @brief Check whether a file path names an emote asset that may be sent
+ *
+ * Only emote assets are exchanged. The web UI, the behavior graph and
+ * anything else on LittleFS are never written from a peer.
+ */
+static bool isTransferableFile(const char *path) {
+  if (strstr(path, ".."))
+    return false;
+  const char *name = nullptr;
+  for (const char *directory : ASSET_DIRECTORIES) {
+    if (strncmp(path, directory, strlen(directory)) == 0) {
+      name = path + strlen(directory);
+      break;
+    }
+  }
+  // One level below the asset directory, no subdirectories
+  if (!name || strchr(name, '/'))
+    return false;
+  size_t length = strlen(name);
+  for (const char *extension : ASSET_EXTENSIONS) {
+    size_t suffix = strlen(extension);
+    if (length > suffix && strcmp(name + length - suffix, extension) == 0)
+      return true;
+  }
+  return false;
+}
+
+/**
+ * @brief Open the partial file an offered file is received into
+ * @return OK once the sink is open, otherwise why the offer is declined
+ */
+static TransferResult openFileSink() {
+  char partial[TRANSFER_MAX_NAME + 5];
+  partialPath(partial);
+  if (status.totalBytes > getFreeSpace())
+    return TransferResult::NO_SPACE;
+  if (!(sinkFile = LittleFS.open(partial, FILE_WRITE)))
+    return TransferResult::WRITE_FAILED;
+  return TransferResult::OK;
+}
+
+/**
+ * @brief Accept or decline the offer held in the session
+ * @param result OK once the sink is open, otherwise why the offer is declined
+ */
+static void answerOffer(TransferResult result) {
+  if (result != TransferResult::OK) {
+    status.state = TransferState::IDLE;
+    sendResult(TransferFrameType::REJECT, result);
+    return;
+  }
+
+  status.state = TransferState::RECEIVING;
+  status.doneBytes = 0;
+  status.retransmissions = 0;
+  chunkCount =
+      (status.totalBytes + TRANSFER_CHUNK_SIZE - 1) / TRANSFER_CHUNK_SIZE;
+  windowBase = 0;
+  windowMask = 0;
+  unackedChunks = 0;
+  startedAt = lastHeard = millis();
+  mbedtls_sha256_init(&sinkHash);
+  mbedtls_sha256_starts(&sinkHash, 0);
+  if (status.kind == TransferKind::FIRMWARE) {
+    // One opt-in covers one image
+    firmwareAllowedAt = 0;
+  }
+
+  logPeer("Receiving image from", status.peer);
+  ESP_LOGI(TRANSFER_LOG, "%s, %u bytes", imageName, status.totalBytes);
+  sendTransferFrame(status.peer, session, TransferFrameType::ACCEPT, nullptr,
+                    0);
+}
+
+/**
+ * @brief Answer an offer
+ *
+ * An offered file that exists here is compared with the local copy over the
+ * next passes, the offer is answered once that is done.
+ *
+ * @param frame Offer frame
+ * @param sessionId Session proposed by the sender
+ */
+static void handleOffer(const TransferFrame &frame, uint16_t sessionId) {
+  const uint8_t *payload = frame.data + TRANSFER_HEADER_SIZE;
+  int length = frame.length - TRANSFER_HEADER_SIZE;
+  if (length < 1 + 4 + TRANSFER_HASH_SIZE)
+    return;
+
+  // Our accept was lost or we are still checking, the sender is asking again
+  if ((status.state == TransferState::RECEIVING ||
+       status.state == TransferState::CHECKING) &&
+      sessionId == session && memcmp(frame.mac, status.peer, 6) == 0) {
+    if (status.state == TransferState::RECEIVING) {
+      sendTransferFrame(frame.mac, session, TransferFrameType::ACCEPT, nullptr,
+                        0);
+    }
+    return;
+  }
+
+  // Only bots in the group may write to this one
+  if (!isKnownPeer(frame.mac))
+    return;
+
+  uint8_t reason = static_cast<uint8_t>(TransferResult::BUSY);
+  if (status.state != TransferState::IDLE || restartAt) {
+    sendTransferFrame(frame.mac, sessionId, TransferFrameType::REJECT, &reason,
+                      1);
+    return;
+  }
+
+  session = sessionId;
+  memcpy(status.peer, frame.mac, 6);
+  status.kind = static_cast<TransferKind>(payload[0]);
+  memcpy(&status.totalBytes, payload + 1, sizeof(status.totalBytes));
+  memcpy(imageHash, payload + 5, TRANSFER_HASH_SIZE);
+  int nameLength = min(length - 5 - TRANSFER_HASH_SIZE, TRANSFER_MAX_NAME - 1);
+  memcpy(imageName, payload + 5 + TRANSFER_HASH_SIZE, nameLength);
+  imageName[nameLength] = '\0';
+
+  TransferResult result = TransferResult::OK;
+  if (status.totalBytes == 0) {
+    result = TransferResult::ABORTED;
+  } else if (status.kind == TransferKind::FIRMWARE) {
+    const uint8_t *running = nullptr;
+    // The offered hash comes from the sender, only the owner can vouch for it
+    if (!isFirmwareTransferAllowed()) {
+      logPeer("Refused firmware without opt-in from", frame.mac);
+      result = TransferResult::NOT_ALLOWED;
+    } else if ((running = getRunningFirmwareHash()) &&
+               memcmp(running, imageHash, TRANSFER_HASH_SIZE) == 0) {
+      result = TransferResult::UP_TO_DATE;
+    } else if (!Update.begin(status.totalBytes, U_FLASH)) {
+      result = TransferResult::NO_SPACE;
+    }
+  } else if (status.kind == TransferKind::FILE &&
+             !isTransferableFile(imageName)) {
+    logPeer("Refused a file that is not an emote asset from", frame.mac);
+    result = TransferResult::NOT_ALLOWED;
+  } else if (status.kind == TransferKind::FILE) {
+    if (LittleFS.exists(imageName) && startFileHash(imageName)) {
+      status.state = TransferState::CHECKING;
+      return;
+    }
+    result = openFileSink();
+  } else {
+    result = TransferResult::ABORTED;
+  }
+  answerOffer(result);
+}
+
+/**
+ * @brief Hash more of the local copy of an offered file, answering the offer
+ * once all of it is compared
+ */
+static void checkLocalCopy() {
+  uint8_t existing[TRANSFER_HASH_SIZE];
+  HashProgress progress = stepFileHash(existing);
+  if (progress == HashProgress::RUNNING)
+    return;
+  if (progress == HashProgress::DONE &&
+      memcmp(existing, imageHash, TRANSFER_HASH_SIZE) == 0) {
+    answerOffer(TransferResult::UP_TO_DATE);
+  } else {
+    answerOffer(openFileSink());
+  }
+}
+
+/**
+ * @brief Buffer a chunk and write every chunk that is now in order
+ * @param payload Chunk index followed by the chunk bytes
+ * @param length Payload length
+ */
+static void handleChunk(const uint8_t *payload, int length) {
+  if (length < 4)
+    return;
+  uint32_t index;
+  memcpy(&index, payload, sizeof(index));
+  size_t bytes = length - 4;
+  if (index >= chunkCount || bytes != chunkLength(index))
+    return;
+
+  if (index < windowBase) {
+    // Written already, the ack covering it got lost
+    sendAck();
+    return;
+  }
+  uint32_t offset = index - windowBase;
+  if (offset >= TRANSFER_WINDOW)
+    return;
+
+  if (!(windowMask & (1UL << offset))) {
+    memcpy(windowData[index % TRANSFER_WINDOW], payload + 4, bytes);
+    windowMask |= 1UL << offset;
+    if (unackedChunks++ == 0) {
+      firstUnackedAt = millis();
+    }
+  }
+
+  while (windowMask & 1) {
+    size_t chunk = chunkLength(windowBase);
+    if (!writeSink(windowData[windowBase % TRANSFER_WINDOW], chunk)) {
+      ESP_LOGE(TRANSFER_LOG, "Write failed at chunk %u", windowBase);
+      sendResult(TransferFrameType::ABORT, TransferResult::WRITE_FAILED);
+      closeSink(false);
+      endReceive(TransferResult::WRITE_FAILED);
+      return;
+    }
+    status.doneBytes += chunk;
+    windowBase++;
+    windowMask >>= 1;
+  }
+
+  if (unackedChunks >= TRANSFER_ACK_EVERY || windowBase == chunkCount) {
+    sendAck();
+  }
+}
+
+/**
+ * @brief Check the hash once the sender is done and commit the image
+ */
+static void verifyImage() {
+  if (windowBase != chunkCount) {
+    // The sender thinks we have everything, tell it otherwise
+    sendAck();
+    return;
+  }
+
+  uint8_t digest[TRANSFER_HASH_SIZE];
+  mbedtls_sha256_finish(&sinkHash, digest);
+  TransferResult result = memcmp(digest, imageHash, TRANSFER_HASH_SIZE) == 0
+                              ? TransferResult::OK
+                              : TransferResult::HASH_MISMATCH;
+  if (!closeSink(result == TransferResult::OK) &&
+      result == TransferResult::OK) {
+    result = TransferResult::WRITE_FAILED;
+  }
+  endReceive(result);
+  sendResult(TransferFrameType::RESULT, result);
+
+  if (result != TransferResult::OK) {
+    ESP_LOGE(TRANSFER_LOG, "Received %s rejected (%u)", imageName,
+             static_cast<uint8_t>(result));
+    return;
+  }
+  ESP_LOGI(TRANSFER_LOG, "Received %s: %u bytes in %lu ms (%lu B/s)",
+           imageName, status.totalBytes, (unsigned long)status.elapsedMs,
+           (unsigned long)status.bytesPerSecond);
+  if (status.kind == TransferKind::FIRMWARE) {
+    // Keep answering repeated finish requests before rebooting
+    restartAt = millis() + TRANSFER_RESTART_DELAY_MS;
+    if (!restartAt)
+      restartAt = 1;
+  }
+}
+
+//==============================================================================
+// SENDER
+//==============================================================================
+
+/**
+ * @brief Read a chunk of the image being seeded into its slot
+ */
+static bool readChunk(uint32_t index) {
+  uint8_t *slot = windowData[index % TRANSFER_WINDOW];
+  size_t length = chunkLength(index);
+  uint32_t offset = index * TRANSFER_CHUNK_SIZE;
+  if (status.kind == TransferKind::FIRMWARE) {
+    return readFirmware((void *)esp_ota_get_running_partition(), offset, slot,
+                        length);
+  }
+  return readFile(&sourceFile, offset, slot, length);
+}
+
+/**
+ * @brief Send a chunk from its slot
+ * @return true if the transport accepted it
+ */
+static bool sendChunk(uint32_t index) {
+  uint8_t payload[TRANSFER_CHUNK_SIZE + 4];
+  size_t length = chunkLength(index);
+  memcpy(payload, &index, sizeof(index));
+  memcpy(payload + 4, windowData[index % TRANSFER_WINDOW], length);
+  windowSentAt[index % TRANSFER_WINDOW] = millis();
+  return sendTransferFrame(status.peer, session, TransferFrameType::DATA,
+                           payload, length + 4);
+}
+
+/**
+ * @brief Send the offer for the current image to the current peer
+ */
+static void sendOffer() {
+  uint8_t payload[1 + 4 + TRANSFER_HASH_SIZE + TRANSFER_MAX_NAME];
+  size_t nameLength = strlen(imageName);
+  payload[0] = static_cast<uint8_t>(status.kind);
+  memcpy(payload + 1, &status.totalBytes, sizeof(status.totalBytes));
+  memcpy(payload + 5, imageHash, TRANSFER_HASH_SIZE);
+  memcpy(payload + 5 + TRANSFER_HASH_SIZE, imageName, nameLength);
+  sendTransferFrame(status.peer, session, TransferFrameType::OFFER, payload,
+                    5 + TRANSFER_HASH_SIZE + nameLength);
+}
+
+/**
+ * @brief Offer the image to the next peer of the round, or end the round
+ */
+static void startSeedTarget() {
+  if (seedCursor >= seedTargetCount) {
+    ESP_LOGI(TRANSFER_LOG, "Seeding %s done, %u of %u peers updated",
+             imageName, status.seeded, seedTargetCount);
+    if (status.kind == TransferKind::FILE) {
+      sourceFile.close();
+    }
+    status.state = TransferState::IDLE;
+    return;
+  }
+
+  memcpy(status.peer, seedTargets[seedCursor], 6);
+  session = static_cast<uint16_t>(random(1, 0x10000));
+  status.state = TransferState::OFFERING;
+  status.doneBytes = 0;
+  status.retransmissions = 0;
+  controlAttempts = 0;
+  lastControlAt = millis() - TRANSFER_CONTROL_RETRY_MS;
+  if (status.kind == TransferKind::FILE) {
+    sourceFile.seek(0);
+  }
+}
+
+/**
+ * @brief Record the outcome for the current peer and move to the next
+ * @param result Outcome reported by the peer or decided locally
+ */
+static void finishSeedTarget(TransferResult result) {
+  status.lastResult = result;
+  if (result == TransferResult::OK) {
+    updateThroughput();
+    status.seeded++;
+    logPeer("Seeded", status.peer);
+    ESP_LOGI(TRANSFER_LOG,
+             "%u bytes in %lu ms (%lu B/s, %u retransmissions)",
+             status.totalBytes, (unsigned long)status.elapsedMs,
+             (unsigned long)status.bytesPerSecond, status.retransmissions);
+  } else {
+    logPeer("Not seeded", status.peer);
+    ESP_LOGW(TRANSFER_LOG, "Result %u", static_cast<uint8_t>(result));
+  }
+  seedCursor++;
+  startSeedTarget();
+}
+
+/**
+ * @brief Start streaming once the peer accepted
+ */
+static void startSending() {
+  status.state = TransferState::SENDING;
+  windowBase = 0;
+  windowMask = 0;
+  nextChunk = 0;
+  startedAt = millis();
+}
+
+/**
+ * @brief Apply a selective ack
+ * @param payload Next missing chunk and bitmap from there on
+ * @param length Payload length
+ */
+static void handleAck(const uint8_t *payload, int length) {
+  if (length < 8)
+    return;
+  uint32_t base, mask;
+  memcpy(&base, payload, sizeof(base));
+  memcpy(&mask, payload + 4, sizeof(mask));
+  if (base < windowBase || base > nextChunk)
+    return;
+
+  windowMask = shiftMask(windowMask, base - windowBase) | mask;
+  windowBase = base;
+  while (windowMask & 1) {
+    windowBase++;
+    windowMask >>= 1;
+  }
+  status.doneBytes =
+      min<uint32_t>(windowBase * TRANSFER_CHUNK_SIZE, status.totalBytes);
+}
+
+/**
+ * @brief Resend overdue chunks and fill the window with new ones
+ */
+static void pumpWindow() {
+  unsigned long now = millis();
+  int sent = 0;
+
+  for (uint32_t index = windowBase; index < nextChunk && sent < TRANSFER_BURST;
+       index++) {
+    if (windowMask & (1UL << (index - windowBase)))
+      continue;
+    if (now - windowSentAt[index % TRANSFER_WINDOW] < TRANSFER_CHUNK_RETRY_MS)
+      continue;
+    if (!sendChunk(index))
+      return;
+    status.retransmissions++;
+    sent++;
+  }
+
+  while (sent < TRANSFER_BURST && nextChunk < chunkCount &&
+         nextChunk - windowBase < TRANSFER_WINDOW) {
+    if (!readChunk(nextChunk)) {
+      ESP_LOGE(TRANSFER_LOG, "Read failed at chunk %u", nextChunk);
+      sendResult(TransferFrameType::ABORT, TransferResult::ABORTED);
+      seedCursor = seedTargetCount;
+      finishSeedTarget(TransferResult::ABORTED);
+      return;
+    }
+    // A refused frame waits for its retry like a lost one
+    bool accepted = sendChunk(nextChunk++);
+    sent++;
+    if (!accepted)
+      return;
+  }
+
+  if (windowBase == chunkCount) {
+    updateThroughput();
+    status.state = TransferState::FINISHING;
+    controlAttempts = 0;
+    lastControlAt = now - TRANSFER_CONTROL_RETRY_MS;
+  }
+}
+
+/**
+ * @brief Start a seeding round with every paired peer
+ * @return true if there is at least one peer
+ */
+static bool startSeeding() {
+  seedTargetCount = 0;
+  seedCursor = 0;
+  PeerStatus peer;
+  for (uint8_t i = 0; i < getPeerCount(); i++) {
+    if (getPeerStatus(i, peer)) {
+      memcpy(seedTargets[seedTargetCount++], peer.mac, 6);
+    }
+  }
+  if (seedTargetCount == 0)
+    return false;
+
+  status.seeded = 0;
+  chunkCount =
+      (status.totalBytes + TRANSFER_CHUNK_SIZE - 1) / TRANSFER_CHUNK_SIZE;
+  ESP_LOGI(TRANSFER_LOG, "Seeding %s (%u bytes) to %u peers", imageName,
+           status.totalBytes, seedTargetCount);
+  startSeedTarget();
+  return true;
+}
+
+/**
+ * @brief Hash more of the file to seed, starting the round once all of it is
+ * hashed
+ */
+static void continueSeedHash() {
+  HashProgress progress = stepFileHash(imageHash);
+  if (progress == HashProgress::RUNNING)
+    return;
+  status.state = TransferState::IDLE;
+  if (progress == HashProgress::FAILED) {
+    ESP_LOGE(TRANSFER_LOG, "Failed to read %s", imageName);
+    return;
+  }
+  sourceFile = LittleFS.open(imageName, FILE_READ);
+  if (!sourceFile || !startSeeding()) {
+    ESP_LOGW(TRANSFER_LOG, "Seeding %s cancelled", imageName);
+    sourceFile.close();
+  }
+}
+
+//==============================================================================
+// FRAME DISPATCH
+//==============================================================================
+
+/**
+ * @brief Act on one received transfer frame
+ */
+static void handleTransferFrame(const TransferFrame &frame) {
+  TransferFrameType type = static_cast<TransferFrameType>(frame.data[3]);
+  uint16_t sessionId;
+  memcpy(&sessionId, frame.data + 4, sizeof(sessionId));
+  const uint8_t *payload = frame.data + TRANSFER_HEADER_SIZE;
+  int length = frame.length - TRANSFER_HEADER_SIZE;
+
+  if (type == TransferFrameType::OFFER) {
+    handleOffer(frame, sessionId);
+    return;
+  }
+
+  // Hashing before a round involves no peer yet
+  bool current = status.state != TransferState::IDLE &&
+                 status.state != TransferState::HASHING &&
+                 sessionId == session && memcmp(frame.mac, status.peer, 6) == 0;
+  if (!current) {
+    // The sender missed our result and asks again
+    if (type == TransferFrameType::FINISH && sessionId == lastSession &&
+        memcmp(frame.mac, lastPeer, 6) == 0) {
+      uint8_t code = static_cast<uint8_t>(status.lastResult);
+      sendTransferFrame(frame.mac, sessionId, TransferFrameType::RESULT, &code,
+                        1);
+    }
+    return;
+  }
+  lastHeard = millis();
+
+  switch (type) {
+  case TransferFrameType::ACCEPT:
+    if (status.state == TransferState::OFFERING) {
+      startSending();
+    }
+    break;
+  case TransferFrameType::REJECT:
+  case TransferFrameType::RESULT:
+    if (length >= 1 && (status.state == TransferState::OFFERING ||
+                        status.state == TransferState::FINISHING)) {
+      finishSeedTarget(static_cast<TransferResult>(payload[0]));
+    }
+    break;
+  case TransferFrameType::DATA:
+    if (status.state == TransferState::RECEIVING) {
+      handleChunk(payload, length);
+    }
+    break;
+  case TransferFrameType::ACK:
+    if (status.state == TransferState::SENDING) {
+      handleAck(payload, length);
+    }
+    break;
+  case TransferFrameType::FINISH:
+    if (status.state == TransferState::RECEIVING) {
+      verifyImage();
+    }
+    break;
+  case TransferFrameType::ABORT:
+    if (status.state == TransferState::RECEIVING) {
+      closeSink(false);
+      endReceive(TransferResult::ABORTED);
+    } else if (status.state == TransferState::CHECKING) {
+      endFileHash();
+      status.state = TransferState::IDLE;
+    } else {
+      finishSeedTarget(TransferResult::ABORTED);
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+//==============================================================================
+// PUBLIC API FUNCTIONS
+//==============================================================================
+
+/**
+ * @brief Check whether a received frame belongs to the transfer protocol
+ */
+bool isTransferFrame(const uint8_t *data, int len) {
+  if (len < TRANSFER_HEADER_SIZE)
+    return false;
+  uint16_t magic;
+  memcpy(&magic, data, sizeof(magic));
+  return magic == TRANSFER_FRAME_MAGIC &&
+         data[2] == TRANSFER_PROTOCOL_VERSION;
+}
+
+/**
+ * @brief Queue a received transfer frame for handleTransfer()
+ *
+ * Runs in the WiFi task. Frames dropped on overflow are recovered by the
+ * selective repeat like lost ones.
+ */
+void transferFrameReceived(const uint8_t *mac, const uint8_t *data, int len) {
+  if (len > TRANSPORT_MAX_FRAME_SIZE)
+    return;
+  TransferFrame frame;
+  memcpy(frame.mac, mac, 6);
+  frame.length = len;
+  memcpy(frame.data, data, len);
+  rxQueue.push(frame);
+}
+
+/**
+ * @brief Run the transfer engine, called from handleCommunication()
+ */
+void handleTransfer() {
+  TransferFrame frame;
+  while (rxQueue.pop(frame)) {
+    handleTransferFrame(frame);
+  }
+
+  unsigned long now = millis();
+  if (restartAt && static_cast<long>(now - restartAt) >= 0) {
+    ESP_LOGW(TRANSFER_LOG, "Restarting into received firmware");
+    ESP.restart();
+  }
+
+  switch (status.state) {
+  case TransferState::HASHING:
+    continueSeedHash();
+    break;
+
+  case TransferState::CHECKING:
+    checkLocalCopy();
+    break;
+
+  case TransferState::OFFERING:
+  case TransferState::FINISHING:
+    if (now - lastControlAt < TRANSFER_CONTROL_RETRY_MS)
+      break;
+    if (controlAttempts++ >= TRANSFER_CONTROL_RETRIES) {
+      finishSeedTarget(TransferResult::TIMEOUT);
+      break;
+    }
+    lastControlAt = now;
+    if (status.state == TransferState::OFFERING) {
+      sendOffer();
+    } else {
+      sendTransferFrame(status.peer, session, TransferFrameType::FINISH,
+                        nullptr, 0);
+    }
+    break;
+
+  case TransferState::SENDING:
+    if (now - lastHeard > TRANSFER_STALL_TIMEOUT_MS) {
+      sendResult(TransferFrameType::ABORT, TransferResult::TIMEOUT);
+      finishSeedTarget(TransferResult::TIMEOUT);
+      break;
+    }
+    pumpWindow();
+    break;
+
+  case TransferState::RECEIVING:
+    if (now - lastHeard > TRANSFER_STALL_TIMEOUT_MS) {
+      logPeer("Transfer stalled from", status.peer);
+      closeSink(false);
+      endReceive(TransferResult::TIMEOUT);
+      break;
+    }
+    if (unackedChunks && now - firstUnackedAt >= TRANSFER_ACK_DELAY_MS) {
+      sendAck();
+    }
+    break;
+
+  default:
+    break;
+  }
+}
+
+/**
+ * @brief Offer the running firmware to every paired peer in turn
+ * @return true if seeding started
+ */
+bool seedFirmware() {
+  if (status.state != TransferState::IDLE || !isPaired())
+    return false;
+
+  const uint8_t *hash = getRunningFirmwareHash();
+  if (!hash) {
+    ESP_LOGE(TRANSFER_LOG, "Can't read the running firmware");
+    return false;
+  }
+  status.kind = TransferKind::FIRMWARE;
+  status.totalBytes = ESP.getSketchSize();
+  memcpy(imageHash, hash, TRANSFER_HASH_SIZE);
+  snprintf(imageName, sizeof(imageName), "%s", FIRMWARE_VERSION);
+  return startSeeding();
+}
+
+/**
+ * @brief Offer a LittleFS file to every paired peer in turn
+ * @param path Emote asset path, shorter than TRANSFER_MAX_NAME
+ * @return true if seeding started
+ */
+bool seedFile(const char *path) {
+  if (status.state != TransferState::IDLE || !isPaired())
+    return false;
+  if (strlen(path) >= TRANSFER_MAX_NAME || !isTransferableFile(path) ||
+      !fileExists(path))
+    return false;
+
+  snprintf(imageName, sizeof(imageName), "%s", path);
+  if (!startFileHash(imageName))
+    return false;
+  status.kind = TransferKind::FILE;
+  status.totalBytes = hashSource.size();
+  if (status.totalBytes == 0) {
+    endFileHash();
+    return false;
+  }
+  // Offers go out once handleTransfer() has hashed the whole file
+  status.state = TransferState::HASHING;
+  return true;
+}
+
+/**
+ * @brief Take the next firmware offer from a paired peer
+ */
+void allowFirmwareTransfer() {
+  // Hash the running image now rather than in the pass answering the offer
+  getRunningFirmwareHash();
+  firmwareAllowedAt = max(millis(), 1UL);
+  ESP_LOGI(TRANSFER_LOG, "Firmware offers accepted for %u s",
+           TRANSFER_FIRMWARE_OPT_IN_MS / 1000);
+}
+
+/**
+ * @brief Check if firmware offers are currently taken
+ */
+bool isFirmwareTransferAllowed() {
+  return firmwareAllowedAt != 0 &&
+         millis() - firmwareAllowedAt < TRANSFER_FIRMWARE_OPT_IN_MS;
+}
+
+/**
+ * @brief Cancel the current transfer and the rest of a seeding round
+ */
+void abortTransfer() {
+  switch (status.state) {
+  case TransferState::IDLE:
+    break;
+  case TransferState::HASHING:
+    endFileHash();
+    status.state = TransferState::IDLE;
+    break;
+  case TransferState::CHECKING:
+    sendResult(TransferFrameType::REJECT, TransferResult::ABORTED);
+    endFileHash();
+    status.state = TransferState::IDLE;
+    break;
+  case TransferState::RECEIVING:
+    sendResult(TransferFrameType::ABORT, TransferResult::ABORTED);
+    closeSink(false);
+    endReceive(TransferResult::ABORTED);
+    break;
+  default:
+    sendResult(TransferFrameType::ABORT, TransferResult::ABORTED);
+    seedCursor = seedTargetCount;
+    finishSeedTarget(TransferResult::ABORTED);
+    break;
+  }
+  rxQueue.clear();
+}
+
+/**
+ * @brief Check if a transfer is in progress
+ */
+bool isTransferActive() {
+  return status.state != TransferState::IDLE || restartAt;
+}
+
+/**
+ * @brief Check if transfer frames wait for handleTransfer()
+ */
+bool transferFramesPending() { return !rxQueue.empty(); }
+
+/**
+ * @brief Get progress and throughput of the current or last transfer
+ */
+TransferStatus getTransferStatus() {
+  if (status.state == TransferState::SENDING ||
+      status.state == TransferState::RECEIVING) {
+    updateThroughput();
+  }
+  return status;
+}
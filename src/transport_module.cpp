@@ -0,0 +1,182 @@
+/**
+ * @file transport_module.cpp
+ * @brief Implementation of the ESP-NOW radio transport
+ */
+
+#include "transport_module.h"
+#include "common.h"
+#include "system_module.h"
+#include <WiFi.h>
+#include <atomic>
+#include <esp_now.h>
+#include <esp_wifi.h>
+
+static_assert(TRANSPORT_MAX_FRAME_SIZE == ESP_NOW_MAX_DATA_LEN,
+              "Transport frames must fit ESP-NOW");
+
+//==============================================================================
+// GLOBAL VARIABLES
+//==============================================================================
+
+/** @brief Handler for received frames */
+static TransportReceiveHandler receiveHandler = nullptr;
+/** @brief Handler for send results */
+static TransportSendHandler sendHandler = nullptr;
+/** @brief Radio state the power task switches to */
+static std::atomic<bool> radioWanted{true};
+/** @brief Radio state the power task last switched to */
+static std::atomic<bool> radioPowered{true};
+/** @brief Task switching the radio, created by the first setAwake() */
+static TaskHandle_t powerTask = nullptr;
+
+//==============================================================================
+// ESP-NOW CALLBACKS
+//==============================================================================
+
+/**
+ * @brief Forward a received frame
+ */
+static void radioReceive(const uint8_t *mac, const uint8_t *data, int len) {
+  if (receiveHandler) {
+    receiveHandler(mac, data, len);
+  }
+}
+
+/**
+ * @brief Forward the MAC-layer result of a sent frame
+ */
+static void radioSent(const uint8_t *mac, esp_now_send_status_t status) {
+  if (sendHandler) {
+    sendHandler(mac, status == ESP_NOW_SEND_SUCCESS);
+  }
+}
+
+//==============================================================================
+// RADIO POWER TASK
+//==============================================================================
+
+/**
+ * @brief Switch the Wi-Fi driver to the wanted state whenever notified
+ *
+ * esp_wifi_start() and esp_wifi_stop() take milliseconds, here they don't
+ * hold up the communication pass that asked for them.
+ */
+static void radioPowerLoop(void *) {
+  while (true) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    bool awake = radioWanted;
+    if (awake == radioPowered)
+      continue;
+    // Without an AP to follow modem sleep doesn't apply, the Wi-Fi driver
+    // is stopped instead, ESP-NOW and its peer list survive
+    esp_err_t result = awake ? esp_wifi_start() : esp_wifi_stop();
+    if (result == ESP_OK) {
+      radioPowered = awake;
+    } else {
+      ESP_LOGE(TRANSPORT_LOG, "Radio failed to %s: %s",
+               awake ? "wake" : "sleep", esp_err_to_name(result));
+    }
+  }
+}
+
+/**
+ * @brief Give the power task time to finish a switch it was asked for
+ */
+static void settleRadioPower() {
+  unsigned long start = millis();
+  while (powerTask && radioPowered != radioWanted &&
+         millis() - start < TRANSPORT_POWER_SETTLE_MS) {
+    vTaskDelay(1);
+  }
+}
+
+//==============================================================================
+// RADIO TRANSPORT
+//==============================================================================
+
+/**
+ * @brief EspNowTransport backed by the ESP-NOW radio
+ */
+class RadioTransport : public EspNowTransport {
+public:
+  bool begin(TransportReceiveHandler onReceive,
+             TransportSendHandler onSend) override {
+    // Make sure we're in station mode for ESP-NOW
+    if (WiFi.getMode() != WIFI_MODE_STA) {
+      WiFi.mode(WIFI_MODE_STA);
+      WiFi.disconnect();
+    }
+
+    if (esp_now_init() != ESP_OK) {
+      ESP_LOGE(TRANSPORT_LOG, "ESP-NOW init failed!");
+      return false;
+    }
+
+    receiveHandler = onReceive;
+    sendHandler = onSend;
+    esp_now_register_send_cb(radioSent);
+    esp_now_register_recv_cb(radioReceive);
+    return true;
+  }
+
+  void end() override {
+    // A wake-up still pending would restart Wi-Fi behind the disconnect
+    settleRadioPower();
+    esp_now_deinit();
+    receiveHandler = nullptr;
+    sendHandler = nullptr;
+    // Disconnect Wi-Fi
+    if (getCurrentMode() == SystemMode::ESP_MODE) {
+      WiFi.disconnect(true); // true = disable station mode
+    }
+  }
+
+  bool send(const uint8_t *mac, const uint8_t *data, size_t length) override {
+    return esp_now_send(mac, data, length) == ESP_OK;
+  }
+
+  bool addPeer(const uint8_t *mac) override {
+    // First check if peer already exists
+    if (esp_now_is_peer_exist(mac)) {
+      return true;
+    }
+
+    esp_now_peer_info_t peerInfo = {};
+    memcpy(peerInfo.peer_addr, mac, 6);
+    peerInfo.channel = 0;
+    peerInfo.encrypt = false;
+
+    return esp_now_add_peer(&peerInfo) == ESP_OK;
+  }
+
+  void removePeer(const uint8_t *mac) override { esp_now_del_peer(mac); }
+
+  void macAddress(uint8_t *mac) override { WiFi.macAddress(mac); }
+
+  bool setAwake(bool awake) override {
+    if (!powerTask &&
+        xTaskCreate(radioPowerLoop, "radio_power", TRANSPORT_POWER_TASK_STACK,
+                    nullptr, TRANSPORT_POWER_TASK_PRIORITY,
+                    &powerTask) != pdPASS) {
+      powerTask = nullptr;
+      return false;
+    }
+    radioWanted = awake;
+    xTaskNotifyGive(powerTask);
+    return true;
+  }
+};
+
+//==============================================================================
+// PUBLIC API FUNCTIONS
+//==============================================================================
+
+/**
+ * @brief The ESP-NOW radio transport
+ *
+ * @return Transport backed by esp_now_*
+ */
+EspNowTransport &espNowRadioTransport() {
+  static RadioTransport radio;
+  return radio;
+}
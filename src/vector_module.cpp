@@ -0,0 +1,594 @@
+/**
+ * @file vector_module.cpp
+ * @brief Implementation of the vector animation renderer
+ *
+ * Each frame every visible shape is positioned from its keyframes,
+ * flattened into polygon edges in screen space (4 fractional bits) and
+ * appended to one edge list. The affected rows are then rasterized: for
+ * every shape the edges crossing the row center are intersected, sorted,
+ * and filled pairwise (even-odd rule) into a line buffer.
+ */
+
+#include "vector_module.h"
+#include "compositor_module.h"
+#include "display_module.h"
+#include "effects_module.h"
+#include "flash_module.h"
+
+//==============================================================================
+// TYPE DEFINITIONS
+//==============================================================================
+
+/**
+ * @brief Non-horizontal polygon edge in screen space
+ */
+struct VectorEdge {
+  int16_t yTop;    /**< Upper end, VECTOR_COORD_SHIFT bits */
+  int16_t yBottom; /**< Lower end, VECTOR_COORD_SHIFT bits */
+  int32_t xTop;    /**< X at yTop, 20 fractional bits */
+  int32_t slope;   /**< dx/dy, 16 fractional bits */
+};
+
+/**
+ * @brief A shape of the current frame
+ */
+struct VectorDrawShape {
+  uint16_t firstEdge; /**< Index of the first edge */
+  uint16_t edgeCount; /**< Number of edges */
+  uint16_t color;     /**< RGB565 fill */
+  uint8_t alpha;      /**< Opacity */
+  int16_t top;        /**< First covered row */
+  int16_t bottom;     /**< Row after the last covered one */
+};
+
+/**
+ * @brief Parsed view into the loaded file
+ */
+struct VectorShapeView {
+  const VectorShapeRecord *record; /**< Shape record */
+  const VectorPoint *points;       /**< Polygon vertices */
+  const VectorKeyframe *keyframes; /**< Keyframes, sorted by time */
+  bool drawable;                   /**< Outline fits in the edge table */
+};
+
+//==============================================================================
+// GLOBAL VARIABLES
+//==============================================================================
+
+/** @brief sin() of 32 steps around the circle, 14 fractional bits */
+static const int16_t SINE_TABLE[32] = {
+    0,      3196,   6270,   9102,   11585,  13623,  15137,  16069,
+    16384,  16069,  15137,  13623,  11585,  9102,   6270,   3196,
+    0,      -3196,  -6270,  -9102,  -11585, -13623, -15137, -16069,
+    -16384, -16069, -15137, -13623, -11585, -9102,  -6270,  -3196,
+};
+
+/** @brief Raw file contents */
+static uint8_t *vectorData = nullptr;
+/** @brief Header of the loaded file */
+static const VectorHeader *vectorHeader = nullptr;
+/** @brief Shapes of the loaded file */
+static VectorShapeView shapes[VECTOR_MAX_SHAPES];
+/** @brief Design units to screen units, 8 fractional bits */
+static int32_t designScale = 256;
+/** @brief Edges of the current frame */
+static VectorEdge edges[VECTOR_MAX_EDGES];
+/** @brief Number of entries in edges */
+static uint16_t edgeCount = 0;
+/** @brief Visible shapes of the current frame */
+static VectorDrawShape drawShapes[VECTOR_MAX_SHAPES];
+/** @brief Number of entries in drawShapes */
+static uint8_t drawShapeCount = 0;
+/** @brief Rows covered by shapes in the previous frame, end exclusive */
+static int16_t previousTop = 0, previousBottom = 0;
+/** @brief Redraw the whole screen on the next frame */
+static bool fullRedraw = true;
+/** @brief Row being composed */
+static uint16_t lineBuffer[DISPLAY_WIDTH];
+
+//==============================================================================
+// FIXED-POINT HELPERS
+//==============================================================================
+
+/**
+ * @brief Cosine from the sine table
+ */
+static inline int32_t tableCos(int step) { return SINE_TABLE[(step + 8) & 31]; }
+
+/**
+ * @brief Sine from the sine table
+ */
+static inline int32_t tableSin(int step) { return SINE_TABLE[step & 31]; }
+
+/**
+ * @brief Apply an easing curve
+ *
+ * @param easing Easing type
+ * @param p Progress, 8 fractional bits
+ * @return Eased progress, 8 fractional bits
+ */
+static int32_t applyEasing(VectorEasing easing, int32_t p) {
+  switch (easing) {
+  case VectorEasing::EASE_IN:
+    return (p * p) >> 8;
+  case VectorEasing::EASE_OUT:
+    return 256 - (((256 - p) * (256 - p)) >> 8);
+  case VectorEasing::EASE_IN_OUT:
+    return (p * p * (768 - 2 * p)) >> 16;
+  case VectorEasing::STEP:
+    return p >= 256 ? 256 : 0;
+  case VectorEasing::LINEAR:
+  default:
+    return p;
+  }
+}
+
+/**
+ * @brief Interpolate a shape's keyframes
+ *
+ * @param shape Shape to evaluate
+ * @param elapsedMs Time since the animation started
+ * @param frame Receives the interpolated transform
+ */
+static void evaluateKeyframes(const VectorShapeView &shape,
+                              unsigned long elapsedMs, VectorKeyframe &frame) {
+  const VectorKeyframe *keys = shape.keyframes;
+  uint8_t count = shape.record->keyframeCount;
+
+  if (elapsedMs <= keys[0].timeMs || count == 1) {
+    frame = keys[0];
+    return;
+  }
+
+  uint8_t next = 1;
+  while (next < count && keys[next].timeMs <= elapsedMs) {
+    next++;
+  }
+  if (next == count) {
+    frame = keys[count - 1];
+    return;
+  }
+
+  const VectorKeyframe &a = keys[next - 1];
+  const VectorKeyframe &b = keys[next];
+  int32_t span = b.timeMs - a.timeMs;
+  int32_t p = span > 0 ? (int32_t)((elapsedMs - a.timeMs) * 256 / span) : 256;
+  int32_t e = applyEasing(static_cast<VectorEasing>(b.easing), p);
+
+  frame.timeMs = elapsedMs;
+  frame.easing = b.easing;
+  frame.alpha = a.alpha + (((b.alpha - a.alpha) * e) >> 8);
+  frame.x = a.x + (((b.x - a.x) * e) >> 8);
+  frame.y = a.y + (((b.y - a.y) * e) >> 8);
+  frame.scale = a.scale + (((b.scale - a.scale) * e) >> 8);
+}
+
+//==============================================================================
+// EDGE LIST CONSTRUCTION
+//==============================================================================
+
+/**
+ * @brief Convert a design-space length to screen units
+ */
+static inline int32_t toScreen(int32_t design) {
+  return (design * designScale) >> 8;
+}
+
+/**
+ * @brief Append one edge to the frame's edge list
+ *
+ * Horizontal edges never cross a row center and are dropped.
+ *
+ * @param x0 Start X, VECTOR_COORD_SHIFT bits
+ * @param y0 Start Y, VECTOR_COORD_SHIFT bits
+ * @param x1 End X, VECTOR_COORD_SHIFT bits
+ * @param y1 End Y, VECTOR_COORD_SHIFT bits
+ */
+static void addEdge(int32_t x0, int32_t y0, int32_t x1, int32_t y1) {
+  // Keep far off-screen geometry from overflowing the 20 bit fractions
+  const int32_t LIMIT = 512 << VECTOR_COORD_SHIFT;
+  x0 = constrain(x0, -LIMIT, LIMIT);
+  x1 = constrain(x1, -LIMIT, LIMIT);
+  y0 = constrain(y0, -LIMIT, LIMIT);
+  y1 = constrain(y1, -LIMIT, LIMIT);
+  if (y0 == y1 || edgeCount >= VECTOR_MAX_EDGES)
+    return;
+  if (y0 > y1) {
+    std::swap(x0, x1);
+    std::swap(y0, y1);
+  }
+  VectorEdge &edge = edges[edgeCount++];
+  edge.yTop = y0;
+  edge.yBottom = y1;
+  edge.xTop = x0 << 16;
+  edge.slope = ((x1 - x0) << 16) / (y1 - y0);
+}
+
+/**
+ * @brief Flatten a closed outline given point by point
+ */
+class OutlineBuilder {
+public:
+  OutlineBuilder() : first(true), x0(0), y0(0), lastX(0), lastY(0) {}
+
+  /** @brief Add the next outline point */
+  void add(int32_t x, int32_t y) {
+    if (first) {
+      x0 = x;
+      y0 = y;
+      first = false;
+    } else {
+      addEdge(lastX, lastY, x, y);
+    }
+    lastX = x;
+    lastY = y;
+  }
+
+  /** @brief Connect the last point back to the first */
+  void close() {
+    if (!first) {
+      addEdge(lastX, lastY, x0, y0);
+    }
+  }
+
+private:
+  bool first;
+  int32_t x0, y0, lastX, lastY;
+};
+
+/**
+ * @brief Most edges a shape can add to a frame
+ *
+ * @param record Shape record
+ * @return One edge per outline point, the closing edge included
+ */
+static uint16_t maxShapeEdges(const VectorShapeRecord &record) {
+  switch (static_cast<VectorShapeType>(record.type)) {
+  case VectorShapeType::CIRCLE:
+    return 32;
+  case VectorShapeType::ROUNDED_RECT:
+    return 4 * 9;
+  case VectorShapeType::POLYGON:
+    return record.pointCount;
+  default:
+    return 0;
+  }
+}
+
+/**
+ * @brief Build the edges of one shape for the current frame
+ *
+ * @param shape Shape to flatten
+ * @param frame Interpolated transform
+ */
+static void buildShapeEdges(const VectorShapeView &shape,
+                            const VectorKeyframe &frame) {
+  const VectorShapeRecord &record = *shape.record;
+  int32_t cx = toScreen(frame.x);
+  int32_t cy = toScreen(frame.y);
+  int32_t scale = (designScale * frame.scale) >> 8;
+  OutlineBuilder outline;
+
+  switch (static_cast<VectorShapeType>(record.type)) {
+  case VectorShapeType::CIRCLE: {
+    int32_t radius = (record.size[0] * scale) >> 8;
+    for (int step = 0; step < 32; step++) {
+      outline.add(cx + ((radius * tableCos(step)) >> 14),
+                  cy + ((radius * tableSin(step)) >> 14));
+    }
+    break;
+  }
+
+  case VectorShapeType::ROUNDED_RECT: {
+    int32_t halfW = (record.size[0] * scale) >> 9;
+    int32_t halfH = (record.size[1] * scale) >> 9;
+    int32_t corner = min<int32_t>((record.size[2] * scale) >> 8,
+                                  min(halfW, halfH));
+    // Corner centers, clockwise from bottom right to match the table
+    const int32_t centers[4][2] = {
+        {cx + halfW - corner, cy + halfH - corner},
+        {cx - halfW + corner, cy + halfH - corner},
+        {cx - halfW + corner, cy - halfH + corner},
+        {cx + halfW - corner, cy - halfH + corner},
+    };
+    for (int quadrant = 0; quadrant < 4; quadrant++) {
+      for (int step = quadrant * 8; step <= quadrant * 8 + 8; step++) {
+        outline.add(centers[quadrant][0] + ((corner * tableCos(step)) >> 14),
+                    centers[quadrant][1] + ((corner * tableSin(step)) >> 14));
+      }
+    }
+    break;
+  }
+
+  case VectorShapeType::POLYGON:
+    for (uint8_t i = 0; i < record.pointCount; i++) {
+      outline.add(cx + ((shape.points[i].x * scale) >> 8),
+                  cy + ((shape.points[i].y * scale) >> 8));
+    }
+    break;
+
+  default:
+    break;
+  }
+  outline.close();
+}
+
+/**
+ * @brief Build the edge list and shape table for a frame
+ *
+ * @param elapsedMs Time since the animation started
+ */
+static void buildFrame(unsigned long elapsedMs) {
+  edgeCount = 0;
+  drawShapeCount = 0;
+
+  for (uint8_t s = 0; s < vectorHeader->shapeCount; s++) {
+    VectorKeyframe frame;
+    if (!shapes[s].drawable)
+      continue;
+    evaluateKeyframes(shapes[s], elapsedMs, frame);
+    if (frame.alpha == 0 || frame.scale == 0)
+      continue;
+
+    uint16_t firstEdge = edgeCount;
+    buildShapeEdges(shapes[s], frame);
+    if (edgeCount == firstEdge)
+      continue;
+
+    VectorDrawShape &draw = drawShapes[drawShapeCount++];
+    draw.firstEdge = firstEdge;
+    draw.edgeCount = edgeCount - firstEdge;
+    draw.color = shapes[s].record->color;
+    draw.alpha = frame.alpha;
+
+    int32_t top = INT16_MAX, bottom = INT16_MIN;
+    for (uint16_t e = firstEdge; e < edgeCount; e++) {
+      top = min<int32_t>(top, edges[e].yTop);
+      bottom = max<int32_t>(bottom, edges[e].yBottom);
+    }
+    draw.top = constrain(top >> VECTOR_COORD_SHIFT, 0, DISPLAY_HEIGHT);
+    draw.bottom =
+        constrain((bottom >> VECTOR_COORD_SHIFT) + 1, 0, DISPLAY_HEIGHT);
+  }
+}
+
+//==============================================================================
+// RASTERIZATION
+//==============================================================================
+
+/**
+ * @brief Fill one shape's spans on a row
+ *
+ * @param shape Shape to fill
+ * @param row Screen row
+ */
+static void fillShapeRow(const VectorDrawShape &shape, int16_t row) {
+  const int32_t ONE = 1 << 20;
+  const int32_t HALF = 1 << 19;
+  int32_t rowCenter = (row << VECTOR_COORD_SHIFT) + (1 << (VECTOR_COORD_SHIFT - 1));
+  const int MAX_CROSSINGS = 64;
+  int32_t crossings[MAX_CROSSINGS];
+  int count = 0;
+
+  for (uint16_t e = shape.firstEdge; e < shape.firstEdge + shape.edgeCount;
+       e++) {
+    const VectorEdge &edge = edges[e];
+    if (rowCenter < edge.yTop || rowCenter >= edge.yBottom)
+      continue;
+    if (count == MAX_CROSSINGS)
+      break;
+
+    // Insertion sort, a row crosses only a handful of edges
+    int32_t x = edge.xTop + (rowCenter - edge.yTop) * edge.slope;
+    int i = count++;
+    while (i > 0 && crossings[i - 1] > x) {
+      crossings[i] = crossings[i - 1];
+      i--;
+    }
+    crossings[i] = x;
+  }
+
+  for (int i = 0; i + 1 < count; i += 2) {
+    // Cover pixels whose centers lie inside the span
+    int32_t start = constrain((crossings[i] - HALF + ONE - 1) >> 20, 0,
+                              DISPLAY_WIDTH);
+    int32_t end = constrain((crossings[i + 1] - HALF + ONE - 1) >> 20, 0,
+                            DISPLAY_WIDTH);
+    if (shape.alpha == 0xFF) {
+      for (int32_t x = start; x < end; x++) {
+        lineBuffer[x] = shape.color;
+      }
+    } else {
+      for (int32_t x = start; x < end; x++) {
+        lineBuffer[x] = blendRGB565(shape.color, lineBuffer[x], shape.alpha);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Rasterize and send a band of full-width rows
+ *
+ * @param top First row
+ * @param bottom Row after the last one
+ * @return Number of pixels written
+ */
+static uint32_t drawRows(int16_t top, int16_t bottom) {
+  if (bottom <= top)
+    return 0;
+
+  startWrite();
+  setAddrWindow(0, top, DISPLAY_WIDTH, bottom - top);
+  for (int16_t row = top; row < bottom; row++) {
+    for (int16_t x = 0; x < DISPLAY_WIDTH; x++) {
+      lineBuffer[x] = vectorHeader->background;
+    }
+    for (uint8_t s = 0; s < drawShapeCount; s++) {
+      if (row >= drawShapes[s].top && row < drawShapes[s].bottom) {
+        fillShapeRow(drawShapes[s], row);
+      }
+    }
+    applyEffectsToScanline(lineBuffer, DISPLAY_WIDTH, row);
+    writePixels(lineBuffer, DISPLAY_WIDTH);
+  }
+  endWrite();
+  return (bottom - top) * DISPLAY_WIDTH;
+}
+
+//==============================================================================
+// PUBLIC API FUNCTIONS
+//==============================================================================
+
+/**
+ * @brief Check whether a path names a vector animation
+ *
+ * @param path Emote path
+ * @return true if the path ends with VECTOR_EXTENSION
+ */
+bool isVectorAnimation(const char *path) {
+  if (!path)
+    return false;
+  size_t length = strlen(path);
+  size_t extensionLength = strlen(VECTOR_EXTENSION);
+  return length > extensionLength &&
+         strcmp(path + length - extensionLength, VECTOR_EXTENSION) == 0;
+}
+
+/**
+ * @brief Load and validate a vector animation
+ *
+ * @param path Vector file path
+ * @param durationMs Receives the animation length (ms)
+ * @return true if loaded
+ */
+bool loadVectorAnimation(const char *path, unsigned long *durationMs) {
+  unloadVectorAnimation();
+
+  File file = LittleFS.open(path, "r");
+  if (!file) {
+    ESP_LOGE(VECTOR_LOG, "ERROR: Vector animation not found: %s", path);
+    return false;
+  }
+
+  size_t size = file.size();
+  if (size < sizeof(VectorHeader) || size > VECTOR_MAX_FILE_SIZE) {
+    ESP_LOGE(VECTOR_LOG, "ERROR: Invalid vector file size %u: %s", size, path);
+    file.close();
+    return false;
+  }
+
+  vectorData = (uint8_t *)malloc(size);
+  if (!vectorData) {
+    ESP_LOGE(VECTOR_LOG, "ERROR: Failed to allocate %u bytes", size);
+    file.close();
+    return false;
+  }
+  size_t bytesRead = file.read(vectorData, size);
+  file.close();
+
+  const VectorHeader *header =
+      reinterpret_cast<const VectorHeader *>(vectorData);
+  if (bytesRead != size || memcmp(header->magic, VECTOR_MAGIC, 4) != 0 ||
+      header->version != VECTOR_VERSION || header->designSize == 0 ||
+      header->shapeCount > VECTOR_MAX_SHAPES) {
+    ESP_LOGE(VECTOR_LOG, "ERROR: Invalid vector header: %s", path);
+    unloadVectorAnimation();
+    return false;
+  }
+
+  // Walk the shape records, checking every section stays inside the file
+  size_t offset = sizeof(VectorHeader);
+  uint16_t totalEdges = 0;
+  for (uint8_t s = 0; s < header->shapeCount; s++) {
+    if (offset + sizeof(VectorShapeRecord) > size) {
+      break;
+    }
+    const VectorShapeRecord *record =
+        reinterpret_cast<const VectorShapeRecord *>(vectorData + offset);
+    offset += sizeof(VectorShapeRecord);
+    shapes[s].record = record;
+    shapes[s].points = reinterpret_cast<const VectorPoint *>(vectorData + offset);
+    offset += record->pointCount * sizeof(VectorPoint);
+    shapes[s].keyframes =
+        reinterpret_cast<const VectorKeyframe *>(vectorData + offset);
+    offset += record->keyframeCount * sizeof(VectorKeyframe);
+
+    if (record->keyframeCount == 0 || offset > size) {
+      offset = size + 1;
+      break;
+    }
+
+    // Drop a shape whose outline could overflow the edge table as a whole,
+    // rather than letting it render with edges missing
+    uint16_t shapeEdges = maxShapeEdges(*record);
+    shapes[s].drawable = totalEdges + shapeEdges <= VECTOR_MAX_EDGES;
+    if (shapes[s].drawable) {
+      totalEdges += shapeEdges;
+    } else {
+      ESP_LOGW(VECTOR_LOG, "Skipping shape %u of %s: needs %u edges, %u left",
+               s, path, shapeEdges, VECTOR_MAX_EDGES - totalEdges);
+    }
+  }
+  if (offset != size) {
+    ESP_LOGE(VECTOR_LOG, "ERROR: Corrupt vector shape table: %s", path);
+    unloadVectorAnimation();
+    return false;
+  }
+
+  vectorHeader = header;
+  designScale = (DISPLAY_WIDTH << 8) / header->designSize;
+  previousTop = previousBottom = 0;
+  fullRedraw = true;
+  *durationMs = header->durationMs;
+  ESP_LOGI(VECTOR_LOG, "Loaded %s: %u shapes, %u bytes", path,
+           header->shapeCount, size);
+  return true;
+}
+
+/**
+ * @brief Render the loaded animation at a point in time
+ *
+ * @param elapsedMs Time since the animation started (ms)
+ * @return Number of pixels written
+ */
+uint32_t renderVectorFrame(unsigned long elapsedMs) {
+  if (!vectorHeader)
+    return 0;
+
+  buildFrame(elapsedMs);
+
+  int16_t top = DISPLAY_HEIGHT, bottom = 0;
+  for (uint8_t s = 0; s < drawShapeCount; s++) {
+    top = min(top, drawShapes[s].top);
+    bottom = max(bottom, drawShapes[s].bottom);
+  }
+
+  uint32_t pixelsWritten;
+  if (fullRedraw) {
+    fullRedraw = false;
+    pixelsWritten = drawRows(0, DISPLAY_HEIGHT);
+  } else if (top >= bottom) {
+    // Nothing visible now, clear whatever was drawn last frame
+    pixelsWritten = drawRows(previousTop, previousBottom);
+  } else if (previousTop >= previousBottom) {
+    pixelsWritten = drawRows(top, bottom);
+  } else {
+    pixelsWritten =
+        drawRows(min(top, previousTop), max(bottom, previousBottom));
+  }
+
+  previousTop = top;
+  previousBottom = bottom;
+  return pixelsWritten;
+}
+
+/**
+ * @brief Release the loaded animation
+ */
+void unloadVectorAnimation() {
+  free(vectorData);
+  vectorData = nullptr;
+  vectorHeader = nullptr;
+  edgeCount = 0;
+  drawShapeCount = 0;
+}
@@ -0,0 +1,50 @@
+/**
+ * @file Arduino.h
+ * @brief Host stand-in for the Arduino core, just what the tested modules need
+ *
+ * Time is a variable the tests advance, randomness is seeded by the test.
+ */
+
+#ifndef HOST_TEST_ARDUINO_H
+#define HOST_TEST_ARDUINO_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+
+using std::max;
+using std::min;
+
+/** @brief Current time returned by millis() and micros(), set by tests (ms) */
+extern unsigned long hostMillis;
+
+inline unsigned long millis() { return hostMillis; }
+inline unsigned long micros() { return hostMillis * 1000; }
+inline long random(long howbig) { return howbig > 0 ? rand() % howbig : 0; }
+inline long random(long howsmall, long howbig) {
+  return howsmall + random(howbig - howsmall);
+}
+
+/**
+ * @brief Just enough of Arduino's String for module interfaces
+ */
+class String {
+public:
+  String(const char *text = "") : value(text) {}
+  size_t length() const { return value.size(); }
+  bool isEmpty() const { return value.empty(); }
+  const char *c_str() const { return value.c_str(); }
+  bool operator==(const char *other) const { return value == other; }
+  bool operator==(const String &other) const { return value == other.value; }
+  bool operator!=(const String &other) const { return value != other.value; }
+
+private:
+  std::string value;
+};
+
+#endif /* HOST_TEST_ARDUINO_H */
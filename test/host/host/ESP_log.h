@@ -0,0 +1,24 @@
+/**
+ * @file ESP_log.h
+ * @brief Host stand-in for the ESP-IDF log macros, printed when VERBOSE is set
+ */
+
+#ifndef HOST_TEST_ESP_LOG_H
+#define HOST_TEST_ESP_LOG_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define HOST_LOG(level, tag, format, ...)                                      \
+  do {                                                                         \
+    if (getenv("VERBOSE"))                                                     \
+      fprintf(stderr, level " %s " format "\n", tag, ##__VA_ARGS__);           \
+  } while (0)
+
+#define ESP_LOGE(tag, format, ...) HOST_LOG("E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) HOST_LOG("W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) HOST_LOG("I", tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) HOST_LOG("D", tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) HOST_LOG("V", tag, format, ##__VA_ARGS__)
+
+#endif /* HOST_TEST_ESP_LOG_H */
@@ -0,0 +1,31 @@
+/**
+ * @file Update.h
+ * @brief Host stand-in for the Arduino Update library, collects the image
+ */
+
+#ifndef HOST_TEST_UPDATE_H
+#define HOST_TEST_UPDATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+/**
+ * @brief Keeps every byte written so tests can compare the image
+ */
+class UpdateClass {
+public:
+  size_t write(uint8_t *data, size_t length) {
+    image.insert(image.end(), data, data + length);
+    return length;
+  }
+
+  /** @brief Bytes written so far */
+  std::vector<uint8_t> image;
+};
+
+/** @brief Defined by the test */
+extern UpdateClass Update;
+
+#endif /* HOST_TEST_UPDATE_H */
@@ -0,0 +1,18 @@
+/**
+ * @file esp_rom_crc.h
+ * @brief Host stand-in for the ROM CRC routines, backed by zlib
+ */
+
+#ifndef HOST_TEST_ESP_ROM_CRC_H
+#define HOST_TEST_ESP_ROM_CRC_H
+
+#include <stdint.h>
+#include <zlib.h>
+
+/** @brief Same polynomial and conditioning as zlib's crc32() */
+inline uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf,
+                                 uint32_t len) {
+  return crc32(crc, buf, len);
+}
+
+#endif /* HOST_TEST_ESP_ROM_CRC_H */
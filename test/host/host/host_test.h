@@ -0,0 +1,32 @@
+/**
+ * @file host_test.h
+ * @brief Minimal check macros shared by the host tests
+ */
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+
+/** @brief Failed checks in this test binary */
+extern int hostTestFailures;
+
+/** @brief Record a failure with its location unless cond holds */
+#define CHECK(cond)                                                            \
+  do {                                                                         \
+    if (!(cond)) {                                                             \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__,        \
+              #cond);                                                          \
+      hostTestFailures++;                                                      \
+    }                                                                          \
+  } while (0)
+
+/** @brief Run a test function and report it */
+#define RUN_TEST(test)                                                         \
+  do {                                                                         \
+    int before = hostTestFailures;                                             \
+    test();                                                                    \
+    printf("%s %s\n", hostTestFailures == before ? "PASS" : "FAIL", #test);    \
+  } while (0)
+
+#endif /* HOST_TEST_H */
@@ -0,0 +1,99 @@
+/**
+ * @file miniz.h
+ * @brief Host stand-in for the ROM tinfl, backed by zlib
+ *
+ * Reproduces what matters about the ROM version: the output goes into a
+ * 32 KB ring, and when the deflate stream ends up to TINFL_HOST_READ_AHEAD
+ * bytes after it are reported as consumed, the way the ROM keeps the bytes
+ * it read ahead into its bit buffer.
+ */
+
+#ifndef HOST_TEST_ROM_MINIZ_H
+#define HOST_TEST_ROM_MINIZ_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <zlib.h>
+
+typedef uint32_t mz_uint32;
+
+#define TINFL_LZ_DICT_SIZE 32768
+#define TINFL_FLAG_PARSE_ZLIB_HEADER 1
+#define TINFL_FLAG_HAS_MORE_INPUT 2
+#define TINFL_FLAG_COMPUTE_ADLER32 8
+
+/** @brief Bytes past the end of the stream reported as consumed */
+#define TINFL_HOST_READ_AHEAD 4
+
+enum tinfl_status {
+  TINFL_STATUS_BAD_PARAM = -3,
+  TINFL_STATUS_ADLER32_MISMATCH = -2,
+  TINFL_STATUS_FAILED = -1,
+  TINFL_STATUS_DONE = 0,
+  TINFL_STATUS_NEEDS_MORE_INPUT = 1,
+  TINFL_STATUS_HAS_MORE_OUTPUT = 2
+};
+
+/**
+ * @brief Decompressor state, set up on the first call after tinfl_init()
+ */
+struct tinfl_decompressor {
+  z_stream stream;
+  bool started;
+  bool done;
+};
+
+#define tinfl_init(r) memset((r), 0, sizeof(tinfl_decompressor))
+
+inline tinfl_status tinfl_decompress(tinfl_decompressor *r,
+                                     const uint8_t *pIn_buf_next,
+                                     size_t *pIn_buf_size,
+                                     uint8_t *pOut_buf_start,
+                                     uint8_t *pOut_buf_next,
+                                     size_t *pOut_buf_size,
+                                     const mz_uint32 decomp_flags) {
+  (void)pOut_buf_start;
+  if (r->done) {
+    *pIn_buf_size = 0;
+    *pOut_buf_size = 0;
+    return TINFL_STATUS_DONE;
+  }
+  if (!r->started) {
+    int bits = (decomp_flags & TINFL_FLAG_PARSE_ZLIB_HEADER) ? 15 : -15;
+    if (inflateInit2(&r->stream, bits) != Z_OK)
+      return TINFL_STATUS_BAD_PARAM;
+    r->started = true;
+  }
+
+  size_t inSize = *pIn_buf_size;
+  size_t outSize = *pOut_buf_size;
+  r->stream.next_in = const_cast<uint8_t *>(pIn_buf_next);
+  r->stream.avail_in = inSize;
+  r->stream.next_out = pOut_buf_next;
+  r->stream.avail_out = outSize;
+  int result = inflate(&r->stream, Z_NO_FLUSH);
+  size_t consumed = inSize - r->stream.avail_in;
+  *pOut_buf_size = outSize - r->stream.avail_out;
+
+  if (result == Z_STREAM_END) {
+    r->done = true;
+    inflateEnd(&r->stream);
+    consumed = consumed + TINFL_HOST_READ_AHEAD < inSize
+                   ? consumed + TINFL_HOST_READ_AHEAD
+                   : inSize;
+    *pIn_buf_size = consumed;
+    return TINFL_STATUS_DONE;
+  }
+  *pIn_buf_size = consumed;
+  if (result == Z_DATA_ERROR) {
+    bool adler = r->stream.msg && strstr(r->stream.msg, "data check");
+    return adler ? TINFL_STATUS_ADLER32_MISMATCH : TINFL_STATUS_FAILED;
+  }
+  if (result != Z_OK && result != Z_BUF_ERROR)
+    return TINFL_STATUS_FAILED;
+  return r->stream.avail_out == 0 ? TINFL_STATUS_HAS_MORE_OUTPUT
+                                  : TINFL_STATUS_NEEDS_MORE_INPUT;
+}
+
+#endif /* HOST_TEST_ROM_MINIZ_H */
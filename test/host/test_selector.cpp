@@ -0,0 +1,116 @@
+/**
+ * @file test_selector.cpp
+ * @brief Host tests for weighted, cooldown-aware emote selection
+ */
+
+#include "host_test.h"
+#include "selector_module.h"
+
+unsigned long hostMillis = 0;
+int hostTestFailures = 0;
+
+/** @brief Pool used by every test, five distinct emotes */
+static const EmoteId pool[] = {EmoteId::ZONED, EmoteId::TALK, EmoteId::SCAN,
+                               EmoteId::GLEE, EmoteId::UWU};
+/** @brief Number of emotes in pool */
+static const size_t POOL_SIZE = sizeof(pool) / sizeof(pool[0]);
+/** @brief Independent runs behind each statistical check */
+static const int TRIALS = 4000;
+
+/**
+ * @brief Position of the first emote of the pool within one bag, 0 based
+ *
+ * @param handle Pool handle
+ * @return Picks before pool[0] came up in the next POOL_SIZE selections
+ */
+static size_t positionInBag(int handle) {
+  size_t position = POOL_SIZE;
+  for (size_t i = 0; i < POOL_SIZE; i++) {
+    hostMillis += 100;
+    if (selectEmote(handle) == pool[0] && position == POOL_SIZE) {
+      position = i;
+    }
+  }
+  return position;
+}
+
+/**
+ * @brief A heavier emote comes first in a fresh bag in proportion to its
+ * weight
+ */
+static void testWeightsBiasTheOrder() {
+  static const uint8_t weights[] = {6, 1, 1, 1, 1};
+  int first = 0;
+  for (int trial = 0; trial < TRIALS; trial++) {
+    resetEmotePools();
+    hostMillis = 1000;
+    int handle = registerEmotePool(pool, POOL_SIZE, weights);
+    first += selectEmote(handle) == pool[0];
+  }
+  // Expected 6 / 10
+  CHECK(first > TRIALS * 55 / 100 && first < TRIALS * 65 / 100);
+}
+
+/**
+ * @brief A weight of 0 keeps an emote out of selection
+ */
+static void testZeroWeightIsNeverPicked() {
+  static const uint8_t weights[] = {0, 1, 1, 1, 1};
+  resetEmotePools();
+  hostMillis = 1000;
+  int handle = registerEmotePool(pool, POOL_SIZE, weights);
+  for (int i = 0; i < TRIALS; i++) {
+    hostMillis += 100;
+    CHECK(selectEmote(handle) != pool[0]);
+  }
+}
+
+/**
+ * @brief An emote cooling down is held back until nothing else is left,
+ * and plays normally again once the cooldown has passed
+ */
+static void testCooldownHoldsEmoteBack() {
+  static const uint32_t cooldowns[] = {10000, 0, 0, 0, 0};
+  int last = 0;
+  int lastAfterCooldown = 0;
+  for (int trial = 0; trial < TRIALS; trial++) {
+    resetEmotePools();
+    hostMillis = 1000;
+    int handle = registerEmotePool(pool, POOL_SIZE, nullptr, cooldowns);
+    positionInBag(handle);
+    // The next bag starts well within the cooldown
+    last += positionInBag(handle) == POOL_SIZE - 1;
+
+    hostMillis += 20000;
+    lastAfterCooldown += positionInBag(handle) == POOL_SIZE - 1;
+  }
+  CHECK(last == TRIALS);
+  // Only the history of three holds it back now, it comes up fourth or
+  // fifth with even odds
+  CHECK(lastAfterCooldown > TRIALS * 4 / 10 &&
+        lastAfterCooldown < TRIALS * 6 / 10);
+}
+
+/**
+ * @brief Weights and cooldowns are kept from the first registration
+ */
+static void testFirstRegistrationKeepsTuning() {
+  static const uint8_t weights[] = {0, 1, 1, 1, 1};
+  resetEmotePools();
+  hostMillis = 1000;
+  int handle = registerEmotePool(pool, POOL_SIZE, weights);
+  CHECK(registerEmotePool(pool, POOL_SIZE) == handle);
+  for (int i = 0; i < TRIALS; i++) {
+    hostMillis += 100;
+    CHECK(selectEmote(registerEmotePool(pool, POOL_SIZE)) != pool[0]);
+  }
+}
+
+int main() {
+  srand(1);
+  RUN_TEST(testWeightsBiasTheOrder);
+  RUN_TEST(testZeroWeightIsNeverPicked);
+  RUN_TEST(testCooldownHoldsEmoteBack);
+  RUN_TEST(testFirstRegistrationKeepsTuning);
+  return hostTestFailures ? 1 : 0;
+}
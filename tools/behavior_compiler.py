@@ -0,0 +1,260 @@
+#!/usr/bin/env python3
+"""
+Behavior graph compiler
+
+Compiles a readable behavior source file (.bhv) into the binary graph loaded
+by behavior_module from LittleFS (/behavior.bin).
+
+Usage:
+    python3 tools/behavior_compiler.py behavior/default.bhv data/behavior.bin
+
+Source syntax (one statement per line, '#' starts a comment):
+
+    emote <name> <path>                 Declare an emote GIF
+    pool <name> <emote> [<emote> ...]   Declare a random pool of emotes,
+                                        repeating a pool name appends to it
+    state <name> [play <emote> | pool <pool>] [priority <level>]
+                 [timer <ms>] [transient]
+        on <trigger> -> <state> | return
+    any                                 Transitions shared by every state
+        on <trigger> -> <state> | return
+    initial <state>
+
+A state's own transitions override the ones declared under 'any'. A
+transition to the state itself keeps the state and still consumes the
+trigger. 'return' resumes the state a transient state interrupted.
+"""
+
+import struct
+import sys
+
+# Must match BehaviorTrigger in include/behavior_module.h
+TRIGGERS = [
+    "tapped",
+    "double_tapped",
+    "shaking",
+    "sudden_acceleration",
+    "tilted",
+    "half_tilted",
+    "upright",
+    "sleep",
+    "awake",
+    "comms_on",
+    "comms_off",
+    "timer",
+    "done",
+]
+
+# Must match EmotePriority in include/animation_module.h
+PRIORITIES = ["idle", "comms", "orientation", "interaction"]
+
+GRAPH_VERSION = 1
+NO_TRANSITION = 0xFF
+RETURN = 0xFE
+NO_EMOTE = 0xFF
+FLAG_TRANSIENT = 0x01
+FLAG_POOL = 0x02
+MAX_ITEMS = 0xFD
+
+
+class CompileError(Exception):
+    def __init__(self, line, message):
+        super().__init__(f"line {line}: {message}")
+
+
+class State:
+    def __init__(self, name, line):
+        self.name = name
+        self.line = line
+        self.emote = None
+        self.pool = None
+        self.priority = 0
+        self.timer = 0
+        self.transient = False
+        self.transitions = {}
+
+
+def parse(text):
+    emotes = {}
+    pools = {}
+    states = {}
+    shared = {}
+    initial = None
+    block = None
+
+    for number, raw in enumerate(text.splitlines(), 1):
+        tokens = raw.split("#", 1)[0].split()
+        if not tokens:
+            continue
+        keyword = tokens[0]
+
+        if keyword == "emote":
+            if len(tokens) != 3:
+                raise CompileError(number, "expected: emote <name> <path>")
+            if tokens[1] in emotes:
+                raise CompileError(number, f"duplicate emote '{tokens[1]}'")
+            emotes[tokens[1]] = tokens[2]
+            block = None
+        elif keyword == "pool":
+            if len(tokens) < 3:
+                raise CompileError(number, "expected: pool <name> <emote>...")
+            for member in tokens[2:]:
+                if member not in emotes:
+                    raise CompileError(number, f"unknown emote '{member}'")
+            pools.setdefault(tokens[1], []).extend(tokens[2:])
+            block = None
+        elif keyword == "state":
+            if len(tokens) < 2 or tokens[1] in states:
+                raise CompileError(number, "missing or duplicate state name")
+            block = State(tokens[1], number)
+            states[block.name] = block
+            parse_state_options(block, tokens[2:], emotes, pools, number)
+        elif keyword == "any":
+            block = shared
+        elif keyword == "on":
+            if block is None:
+                raise CompileError(number, "'on' outside of a state or 'any'")
+            if len(tokens) != 4 or tokens[2] != "->":
+                raise CompileError(number, "expected: on <trigger> -> <target>")
+            if tokens[1] not in TRIGGERS:
+                raise CompileError(number, f"unknown trigger '{tokens[1]}'")
+            target = (tokens[3], number)
+            if block is shared:
+                shared[tokens[1]] = target
+            else:
+                block.transitions[tokens[1]] = target
+        elif keyword == "initial":
+            if len(tokens) != 2:
+                raise CompileError(number, "expected: initial <state>")
+            initial = (tokens[1], number)
+            block = None
+        else:
+            raise CompileError(number, f"unknown statement '{keyword}'")
+
+    if not states:
+        raise CompileError(0, "no states declared")
+    if initial is None:
+        raise CompileError(0, "missing 'initial <state>'")
+    return emotes, pools, states, shared, initial
+
+
+def parse_state_options(state, options, emotes, pools, number):
+    i = 0
+    while i < len(options):
+        option = options[i]
+        if option == "transient":
+            state.transient = True
+            i += 1
+            continue
+        if i + 1 >= len(options):
+            raise CompileError(number, f"'{option}' needs a value")
+        value = options[i + 1]
+        if option == "play":
+            if value not in emotes:
+                raise CompileError(number, f"unknown emote '{value}'")
+            state.emote = value
+        elif option == "pool":
+            if value not in pools:
+                raise CompileError(number, f"unknown pool '{value}'")
+            state.pool = value
+        elif option == "priority":
+            if value not in PRIORITIES:
+                raise CompileError(number, f"unknown priority '{value}'")
+            state.priority = PRIORITIES.index(value)
+        elif option == "timer":
+            state.timer = int(value)
+        else:
+            raise CompileError(number, f"unknown state option '{option}'")
+        i += 2
+    if state.emote and state.pool:
+        raise CompileError(number, "a state plays either an emote or a pool")
+
+
+def resolve_target(target, state_index):
+    name, number = target
+    if name == "return":
+        return RETURN
+    if name not in state_index:
+        raise CompileError(number, f"unknown state '{name}'")
+    return state_index[name]
+
+
+def build(emotes, pools, states, shared, initial):
+    emote_names = list(emotes)
+    emote_index = {name: i for i, name in enumerate(emote_names)}
+    pool_names = list(pools)
+    state_names = list(states)
+    state_index = {name: i for i, name in enumerate(state_names)}
+
+    if max(len(emote_names), len(pool_names), len(state_names)) > MAX_ITEMS:
+        raise CompileError(0, f"at most {MAX_ITEMS} emotes, pools and states")
+
+    state_records = b""
+    transitions = b""
+    for name in state_names:
+        state = states[name]
+        flags = FLAG_TRANSIENT if state.transient else 0
+        emote = NO_EMOTE
+        if state.pool:
+            flags |= FLAG_POOL
+            emote = pool_names.index(state.pool)
+        elif state.emote:
+            emote = emote_index[state.emote]
+        state_records += struct.pack("<BBBBI", flags, emote, state.priority, 0,
+                                     state.timer)
+        row = bytearray([NO_TRANSITION] * len(TRIGGERS))
+        for trigger, target in list(shared.items()) + list(
+                state.transitions.items()):
+            row[TRIGGERS.index(trigger)] = resolve_target(target, state_index)
+        transitions += bytes(row)
+
+    pool_table = b""
+    members = b""
+    for name in pool_names:
+        pool_table += struct.pack("<BB", len(members), len(pools[name]))
+        members += bytes(emote_index[m] for m in pools[name])
+    if len(members) > 0xFF:
+        raise CompileError(0, "pools hold more than 255 members in total")
+
+    strings = b""
+    offsets = b""
+    for name in emote_names:
+        offsets += struct.pack("<H", len(strings))
+        strings += emotes[name].encode("ascii") + b"\0"
+
+    initial_name, initial_line = initial
+    if initial_name not in state_index:
+        raise CompileError(initial_line, f"unknown state '{initial_name}'")
+
+    body = (state_records + transitions + pool_table + members + offsets +
+            strings)
+    total = 16 + len(body)
+    if total > 0xFFFF:
+        raise CompileError(0, "graph too large")
+    header = struct.pack("<4sBBBBBBBBHH", b"BHVG", GRAPH_VERSION,
+                         len(state_names), len(TRIGGERS), len(emote_names),
+                         len(pool_names), len(members),
+                         state_index[initial_name], 0, len(strings), total)
+    return header + body
+
+
+def main(argv):
+    if len(argv) != 3:
+        print(__doc__.strip().splitlines()[0])
+        print(f"usage: {argv[0]} <source.bhv> <output.bin>")
+        return 2
+    with open(argv[1], "r", encoding="utf-8") as source:
+        text = source.read()
+    try:
+        graph = build(*parse(text))
+    except CompileError as error:
+        print(f"{argv[1]}: {error}", file=sys.stderr)
+        return 1
+    with open(argv[2], "wb") as output:
+        output.write(graph)
+    print(f"Wrote {argv[2]} ({len(graph)} bytes)")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
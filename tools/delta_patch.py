@@ -0,0 +1,202 @@
+#!/usr/bin/env python3
+"""
+Delta patch generator
+
+Makes a patch that turns one firmware image into another, for a delta update
+of a BYTE-90 running the old image (serial_update.py --type delta).
+
+Usage:
+    python3 tools/delta_patch.py <old.bin> <new.bin> <patch.delta>
+
+The old image must be the exact .bin the device runs, the patch names it by
+its SHA-256 and the device refuses patches made for anything else.
+
+Matching follows bsdiff: an exact match found through an index of 8 byte
+seeds fixes an alignment of the new image against the old one, and that
+alignment is kept for as long as at least half of the bytes agree. Aligned
+bytes are stored as bytewise differences, which are mostly zero when code
+only moved, and everything else as extra bytes. The patch itself is not
+compressed, it is sent gzip compressed like any other image.
+
+Patch format, little endian, see delta_module.h:
+    "B90D", uint32 old size, old SHA-256, uint32 new size, new SHA-256
+    then records: uint32 diff length, uint32 extra length, int32 seek,
+    diff bytes, extra bytes
+"""
+
+import gzip
+import hashlib
+import struct
+import sys
+
+MAGIC = b"B90D"
+SEED = 8          # bytes hashed to find match candidates
+CANDIDATES = 16   # old positions kept per seed
+MIN_GAIN = 8      # bytes a new alignment must win by to start a record
+
+
+def build_index(old):
+    """Map every SEED byte string of the old image to where it occurs."""
+    index = {}
+    for pos in range(len(old) - SEED + 1):
+        positions = index.setdefault(old[pos:pos + SEED], [])
+        if len(positions) < CANDIDATES:
+            positions.append(pos)
+    return index
+
+
+def match_length(old, pos, new, scan):
+    """Length of the exact match of new[scan:] at old[pos:]."""
+    limit = min(len(old) - pos, len(new) - scan)
+    low, step = 0, 16
+    # Grow in doubling steps, then narrow down the first mismatch
+    while low < limit:
+        high = min(low + step, limit)
+        if old[pos + low:pos + high] != new[scan + low:scan + high]:
+            break
+        low = high
+        step *= 2
+    else:
+        return limit
+    high = min(low + step, limit)
+    while high - low > 1:
+        mid = (low + high) // 2
+        if old[pos + low:pos + mid] == new[scan + low:scan + mid]:
+            low = mid
+        else:
+            high = mid
+    if low < limit and old[pos + low] == new[scan + low]:
+        low += 1
+    return low
+
+
+def agreeing(old, pos, new, scan, length):
+    """Bytes of new[scan:scan+length] equal to old at the same offset."""
+    if pos < 0 or pos + length > len(old):
+        return 0
+    return sum(a == b for a, b in
+               zip(old[pos:pos + length], new[scan:scan + length]))
+
+
+def best_match(index, old, new, scan, aligned):
+    """Longest exact match at scan as (old position, length)."""
+    candidates = list(index.get(new[scan:scan + SEED], ()))
+    if 0 <= aligned < len(old):
+        candidates.append(aligned)
+    best_pos, best_len = 0, 0
+    for pos in candidates:
+        length = match_length(old, pos, new, scan)
+        if length > best_len:
+            best_pos, best_len = pos, length
+    return best_pos, best_len
+
+
+def extend_forward(old, last_pos, new, last_scan, scan):
+    """Bytes after last_scan worth keeping in the old alignment."""
+    score = best_score = length = 0
+    i = 0
+    while last_scan + i < scan and last_pos + i < len(old):
+        if old[last_pos + i] == new[last_scan + i]:
+            score += 1
+        i += 1
+        if score * 2 - i > best_score * 2 - length:
+            best_score, length = score, i
+    return length
+
+
+def extend_backward(old, pos, new, last_scan, scan):
+    """Bytes before scan worth taking into the new alignment."""
+    score = best_score = length = 0
+    i = 1
+    while scan - i >= last_scan and pos - i >= 0:
+        if old[pos - i] == new[scan - i]:
+            score += 1
+        if score * 2 - i > best_score * 2 - length:
+            best_score, length = score, i
+        i += 1
+    return length
+
+
+def make_patch(old, new):
+    """Build the patch records, returns (records bytes, record count)."""
+    index = build_index(old)
+    out = bytearray()
+    records = 0
+    scan = last_scan = last_pos = 0
+
+    def emit(diff_length, extra_start, extra_end, seek):
+        nonlocal records
+        out.extend(struct.pack("<IIi", diff_length, extra_end - extra_start,
+                               seek))
+        out.extend((new[last_scan + i] - old[last_pos + i]) & 0xFF
+                   for i in range(diff_length))
+        out.extend(new[extra_start:extra_end])
+        records += 1
+
+    while scan < len(new):
+        aligned = scan + (last_pos - last_scan)
+        pos, length = best_match(index, old, new, scan, aligned)
+        if length < SEED:
+            scan += 1
+            continue
+
+        # Keep the current alignment if it covers this stretch about as well
+        kept = agreeing(old, aligned, new, scan, length)
+        if kept + MIN_GAIN >= length:
+            scan += length
+            continue
+
+        forward = extend_forward(old, last_pos, new, last_scan, scan)
+        backward = extend_backward(old, pos, new, last_scan, scan)
+
+        # Both extensions claim the same bytes, split where it scores best
+        overlap = last_scan + forward - (scan - backward)
+        if overlap > 0:
+            score = best_score = split = 0
+            for i in range(overlap):
+                at = last_scan + forward - overlap + i
+                if new[at] == old[last_pos + forward - overlap + i]:
+                    score += 1
+                if new[at] == old[pos - backward + i]:
+                    score -= 1
+                if score > best_score:
+                    best_score, split = score, i + 1
+            forward += split - overlap
+            backward -= split
+
+        emit(forward, last_scan + forward, scan - backward,
+             (pos - backward) - (last_pos + forward))
+        last_scan, last_pos = scan - backward, pos - backward
+        scan += length
+
+    forward = extend_forward(old, last_pos, new, last_scan, len(new))
+    emit(forward, last_scan + forward, len(new), 0)
+    return bytes(out), records
+
+
+def main(argv):
+    if len(argv) != 3:
+        print(__doc__.strip().split("\n\n")[1], file=sys.stderr)
+        return 1
+
+    with open(argv[0], "rb") as f:
+        old = f.read()
+    with open(argv[1], "rb") as f:
+        new = f.read()
+
+    records, count = make_patch(old, new)
+    header = (MAGIC + struct.pack("<I", len(old)) + hashlib.sha256(old).digest()
+              + struct.pack("<I", len(new)) + hashlib.sha256(new).digest())
+    patch = header + records
+    with open(argv[2], "wb") as f:
+        f.write(patch)
+
+    image_gz = len(gzip.compress(new, 9, mtime=0))
+    patch_gz = len(gzip.compress(patch, 9, mtime=0))
+    print(f"{argv[2]}: {len(patch)} bytes in {count} records, "
+          f"{patch_gz} gzipped against {image_gz} for the gzipped image")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
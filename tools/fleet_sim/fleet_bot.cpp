@@ -0,0 +1,118 @@
+/**
+ * @file fleet_bot.cpp
+ * @brief Host glue linked into every bot library of the fleet simulator
+ *
+ * Provides the Arduino calls and the neighbouring modules espnow_module
+ * uses, backed by the simulator instead of hardware. Modules the
+ * simulation leaves out behave as on an idle bot: no transfers, no motion,
+ * no display.
+ */
+
+#include "fleet_bot.h"
+#include "system_module.h"
+#include "transfer_module.h"
+#include <stdarg.h>
+
+//==============================================================================
+// GLOBAL VARIABLES
+//==============================================================================
+
+/** @brief What the simulator lent this bot */
+static FleetBotHost host = {};
+/** @brief State of the xorshift generator behind random() */
+static uint32_t randomState = 1;
+
+//==============================================================================
+// ARDUINO CORE
+//==============================================================================
+
+unsigned long micros() { return host.nowMicros() - host.bootMicros; }
+
+unsigned long millis() { return micros() / 1000; }
+
+long random(long howbig) {
+  if (howbig <= 0)
+    return 0;
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  return randomState % howbig;
+}
+
+long random(long howsmall, long howbig) {
+  return howbig > howsmall ? howsmall + random(howbig - howsmall) : howsmall;
+}
+
+// The module never waits on the simulated clock, a delay would stall it
+void delay(unsigned long) {}
+
+void fleetLog(char level, const char *tag, const char *format, ...) {
+  char message[192];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(message, sizeof(message), format, args);
+  va_end(args);
+  host.log(host.bot, level, tag, message);
+}
+
+//==============================================================================
+// NEIGHBOURING MODULES
+//==============================================================================
+
+SystemMode getCurrentMode() { return SystemMode::ESP_MODE; }
+
+bool motionOriented() { return false; }
+
+bool isTransferFrame(const uint8_t *, int) { return false; }
+
+void transferFrameReceived(const uint8_t *, const uint8_t *, int) {}
+
+void handleTransfer() {}
+
+void abortTransfer() {}
+
+/**
+ * @brief Stand-in for the radio, the module starts with it until bound
+ */
+class NoRadioTransport : public EspNowTransport {
+public:
+  bool begin(TransportReceiveHandler, TransportSendHandler) override {
+    return false;
+  }
+  void end() override {}
+  bool send(const uint8_t *, const uint8_t *, size_t) override { return false; }
+  bool addPeer(const uint8_t *) override { return false; }
+  void removePeer(const uint8_t *) override {}
+  void macAddress(uint8_t *mac) override { memset(mac, 0, 6); }
+  bool setAwake(bool) override { return true; }
+};
+
+EspNowTransport &espNowRadioTransport() {
+  static NoRadioTransport noRadio;
+  return noRadio;
+}
+
+//==============================================================================
+// SIMULATOR ENTRY
+//==============================================================================
+
+/**
+ * @brief Bind this bot to the simulator
+ * @param bot Clock, seed and transport of the bot
+ * @param api Filled with the module functions
+ * @return true if the transport was taken
+ */
+extern "C" bool fleetBotBind(const FleetBotHost *bot, FleetBotApi *api) {
+  host = *bot;
+  randomState = bot->seed ? bot->seed : 1;
+  setEspNowTransport(bot->transport);
+
+  api->restartCommunication = restartCommunication;
+  api->shutdownCommunication = shutdownCommunication;
+  api->handleCommunication = handleCommunication;
+  api->isPaired = isPaired;
+  api->getPeerStatus = getPeerStatus;
+  api->getDiscoveryStats = getDiscoveryStats;
+  api->getEspNowStats = getEspNowStats;
+  return true;
+}
@@ -0,0 +1,49 @@
+/**
+ * @file fleet_bot.h
+ * @brief Interface between the fleet simulator and one bot library
+ *
+ * Every bot is a private copy of a shared library built from the real
+ * espnow_module.cpp and fleet_bot.cpp, so each has its own module globals.
+ * The simulator binds it to a clock, a seed and a transport on the shared
+ * medium, then drives it through the function table it gets back.
+ */
+
+#ifndef FLEET_BOT_H
+#define FLEET_BOT_H
+
+#include "espnow_module.h"
+
+/** @brief Symbol the simulator looks up in every bot library */
+#define FLEET_BOT_BIND_SYMBOL "fleetBotBind"
+
+/**
+ * @brief What the simulator lends a bot
+ */
+struct FleetBotHost {
+  uint32_t (*nowMicros)(); /**< Simulated time since the simulator started */
+  void (*log)(int bot, char level, const char *tag,
+              const char *message); /**< Log sink */
+  int bot;                          /**< Index of this bot */
+  uint32_t bootMicros;              /**< Simulated time the bot powers up */
+  uint32_t seed;                    /**< Seed of the bot's random() */
+  EspNowTransport *transport;       /**< Bot's endpoint on the medium */
+};
+
+/**
+ * @brief Module functions the simulator drives
+ */
+struct FleetBotApi {
+  bool (*restartCommunication)();
+  void (*shutdownCommunication)();
+  void (*handleCommunication)();
+  bool (*isPaired)();
+  bool (*getPeerStatus)(uint8_t index, PeerStatus &status);
+  DiscoveryStats (*getDiscoveryStats)();
+  EspNowStats (*getEspNowStats)();
+};
+
+/** @brief Signature of fleetBotBind() */
+typedef bool (*FleetBotBindFunction)(const FleetBotHost *host,
+                                     FleetBotApi *api);
+
+#endif /* FLEET_BOT_H */
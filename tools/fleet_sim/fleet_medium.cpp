@@ -0,0 +1,335 @@
+/**
+ * @file fleet_medium.cpp
+ * @brief Implementation of the fleet simulator's shared radio channel
+ *
+ * The channel is run as a sequence of events, the next one being either
+ * the end of a frame on air or a radio trying to send its oldest queued
+ * frame. A radio that senses the channel busy waits for it to clear, then
+ * DIFS and a random backoff. Carrier sense needs a slot to settle, so a
+ * radio starting within a slot of another one doesn't hear it and both
+ * frames collide.
+ */
+
+#include "fleet_medium.h"
+#include "espnow_module.h"
+#include <string.h>
+
+//==============================================================================
+// HELPERS
+//==============================================================================
+
+/**
+ * @brief Time a frame holds the channel
+ * @param length Payload length
+ * @param unicast true if the receiver answers with a MAC-layer ack
+ * @return Airtime (us), same estimate the module uses for its statistics
+ */
+static uint32_t frameAirtime(size_t length, bool unicast) {
+  uint32_t airtime = ESPNOW_PHY_OVERHEAD_US +
+                     (length + ESPNOW_MAC_OVERHEAD_BYTES) * ESPNOW_US_PER_BYTE;
+  return unicast ? airtime + FLEET_SIFS_US + FLEET_ACK_US : airtime;
+}
+
+/**
+ * @brief Check for the broadcast address
+ * @param mac Address to check
+ * @return true if it is TRANSPORT_BROADCAST_MAC
+ */
+static bool isBroadcast(const uint8_t *mac) {
+  return memcmp(mac, TRANSPORT_BROADCAST_MAC, 6) == 0;
+}
+
+//==============================================================================
+// FLEET MEDIUM
+//==============================================================================
+
+/**
+ * @brief Create an idle channel
+ * @param seed Seed of the backoff and loss generator
+ * @param lossPermille Surviving copies lost per 1000
+ */
+FleetMedium::FleetMedium(uint32_t seed, uint16_t lossPermille)
+    : stats(), lossPermille(lossPermille), clock(0), busySince(0),
+      randomState(seed ? seed : 1) {}
+
+/**
+ * @brief Next value of the xorshift generator
+ * @return Pseudo-random 32-bit value
+ */
+uint32_t FleetMedium::nextRandom() {
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  return randomState;
+}
+
+/**
+ * @brief Connect a radio
+ * @param radio Radio to connect
+ */
+void FleetMedium::attach(FleetRadio *radio) {
+  for (FleetRadio *attached : radios) {
+    if (attached == radio)
+      return;
+  }
+  radios.push_back(radio);
+}
+
+/**
+ * @brief Disconnect a radio, a frame it has on air is cut off
+ * @param radio Radio to disconnect
+ */
+void FleetMedium::detach(FleetRadio *radio) {
+  for (size_t i = 0; i < radios.size(); i++) {
+    if (radios[i] == radio) {
+      radios.erase(radios.begin() + i);
+      break;
+    }
+  }
+  for (size_t i = 0; i < onAir.size(); i++) {
+    if (onAir[i].sender == radio) {
+      onAir.erase(onAir.begin() + i);
+      if (onAir.empty()) {
+        stats.busyMicros += clock - busySince;
+      }
+      break;
+    }
+  }
+}
+
+/**
+ * @brief Set when a radio next tries to send
+ * @param radio Radio with a queued frame
+ * @param earliest Time the radio may start contending (us)
+ * @param backoff true to add a random number of slots
+ */
+void FleetMedium::schedule(FleetRadio &radio, uint64_t earliest,
+                           bool backoff) {
+  radio.attemptAt = earliest + FLEET_DIFS_US;
+  if (backoff) {
+    radio.attemptAt += (nextRandom() % FLEET_CONTENTION_WINDOW) * FLEET_SLOT_US;
+  }
+}
+
+/**
+ * @brief Put a radio's oldest queued frame on air
+ * @param radio Radio whose attempt is due and found the channel clear
+ */
+void FleetMedium::startTransmission(FleetRadio &radio) {
+  const FleetRadio::QueuedFrame &frame = radio.queue.front();
+  uint32_t airtime = frameAirtime(frame.length, !isBroadcast(frame.to));
+
+  bool collided = !onAir.empty();
+  for (Transmission &transmission : onAir) {
+    transmission.collided = true;
+  }
+  if (onAir.empty()) {
+    busySince = clock;
+  }
+
+  onAir.push_back({&radio, clock, clock + airtime, collided});
+  radio.transmitting = true;
+  radio.airtime += airtime;
+  stats.transmissions++;
+}
+
+/**
+ * @brief Take a frame off air and hand its copies out
+ * @param index Entry in onAir
+ */
+void FleetMedium::finishTransmission(size_t index) {
+  Transmission transmission = onAir[index];
+  onAir.erase(onAir.begin() + index);
+  if (onAir.empty()) {
+    stats.busyMicros += clock - busySince;
+  }
+
+  FleetRadio &sender = *transmission.sender;
+  FleetRadio::QueuedFrame frame = sender.queue.front();
+  sender.queue.pop_front();
+  sender.transmitting = false;
+  if (!sender.queue.empty()) {
+    schedule(sender, clock, true);
+  }
+  if (transmission.collided) {
+    stats.collisions++;
+  }
+
+  // Handlers may send, which only touches queues, never the radio list
+  bool broadcast = isBroadcast(frame.to);
+  bool delivered = false;
+  for (size_t i = 0; i < radios.size(); i++) {
+    FleetRadio &receiver = *radios[i];
+    if (&receiver == &sender || !receiver.up || !receiver.awake ||
+        (!broadcast && memcmp(receiver.address, frame.to, 6) != 0)) {
+      continue;
+    }
+    if (transmission.collided)
+      continue;
+    if (nextRandom() % 1000 < lossPermille) {
+      stats.copiesLost++;
+      continue;
+    }
+    stats.copiesDelivered++;
+    delivered = true;
+    if (receiver.receiveHandler) {
+      receiver.receiveHandler(sender.address, frame.data, frame.length);
+    }
+  }
+
+  if (sender.up && sender.sendHandler) {
+    // ESP-NOW reports every broadcast as sent
+    sender.sendHandler(frame.to, broadcast || delivered);
+  }
+}
+
+/**
+ * @brief Run the channel up to a point in time
+ * @param untilUs Virtual time to stop at (us)
+ */
+void FleetMedium::run(uint64_t untilUs) {
+  while (true) {
+    size_t ending = onAir.size();
+    for (size_t i = 0; i < onAir.size(); i++) {
+      if (ending == onAir.size() || onAir[i].end < onAir[ending].end) {
+        ending = i;
+      }
+    }
+    FleetRadio *attempting = nullptr;
+    for (FleetRadio *radio : radios) {
+      if (radio->up && radio->awake && !radio->transmitting &&
+          !radio->queue.empty() &&
+          (!attempting || radio->attemptAt < attempting->attemptAt)) {
+        attempting = radio;
+      }
+    }
+
+    uint64_t endAt = ending < onAir.size() ? onAir[ending].end : UINT64_MAX;
+    uint64_t attemptAt = attempting ? attempting->attemptAt : UINT64_MAX;
+    if (endAt > untilUs && attemptAt > untilUs)
+      break;
+
+    // A frame ending frees the channel for an attempt at the same time
+    if (endAt <= attemptAt) {
+      clock = endAt;
+      finishTransmission(ending);
+      continue;
+    }
+
+    clock = attemptAt;
+    uint64_t busyUntil = 0;
+    for (const Transmission &transmission : onAir) {
+      if (transmission.start + FLEET_SLOT_US <= clock) {
+        busyUntil = max(busyUntil, transmission.end);
+      }
+    }
+    if (busyUntil) {
+      schedule(*attempting, busyUntil, true);
+    } else {
+      startTransmission(*attempting);
+    }
+  }
+  clock = max(clock, untilUs);
+}
+
+//==============================================================================
+// FLEET RADIO
+//==============================================================================
+
+/**
+ * @brief Create a radio, it joins the channel on begin()
+ * @param medium Channel to join
+ * @param mac Address of the radio
+ */
+FleetRadio::FleetRadio(FleetMedium &medium, const uint8_t *mac)
+    : medium(medium), attemptAt(0), transmitting(false), up(false),
+      awake(true), airtime(0), receiveHandler(nullptr), sendHandler(nullptr) {
+  memcpy(address, mac, 6);
+}
+
+FleetRadio::~FleetRadio() { medium.detach(this); }
+
+bool FleetRadio::begin(TransportReceiveHandler onReceive,
+                       TransportSendHandler onSend) {
+  medium.attach(this);
+  receiveHandler = onReceive;
+  sendHandler = onSend;
+  up = true;
+  awake = true;
+  return true;
+}
+
+void FleetRadio::end() {
+  up = false;
+  peers.clear();
+  queue.clear();
+  transmitting = false;
+  medium.detach(this);
+}
+
+bool FleetRadio::send(const uint8_t *mac, const uint8_t *data,
+                      size_t length) {
+  if (!up || !awake || length > TRANSPORT_MAX_FRAME_SIZE)
+    return false;
+  // Like ESP-NOW, unicast needs the destination added first
+  if (!isBroadcast(mac) && !hasPeer(mac))
+    return false;
+  if (queue.size() == FLEET_RADIO_QUEUE_SIZE) {
+    medium.stats.queueDrops++;
+    return false;
+  }
+
+  QueuedFrame frame;
+  memcpy(frame.to, mac, 6);
+  frame.length = length;
+  memcpy(frame.data, data, length);
+  queue.push_back(frame);
+
+  // Bots run their loops out of step, spread sends over a pass
+  if (queue.size() == 1 && !transmitting) {
+    medium.schedule(*this,
+                    medium.clock + medium.nextRandom() % FLEET_LOOP_PHASE_US,
+                    false);
+  }
+  return true;
+}
+
+bool FleetRadio::addPeer(const uint8_t *mac) {
+  if (!hasPeer(mac)) {
+    peers.insert(peers.end(), mac, mac + 6);
+  }
+  return true;
+}
+
+void FleetRadio::removePeer(const uint8_t *mac) {
+  for (size_t i = 0; i < peers.size(); i += 6) {
+    if (memcmp(&peers[i], mac, 6) == 0) {
+      peers.erase(peers.begin() + i, peers.begin() + i + 6);
+      return;
+    }
+  }
+}
+
+void FleetRadio::macAddress(uint8_t *mac) { memcpy(mac, address, 6); }
+
+bool FleetRadio::setAwake(bool state) {
+  // Frames queued before sleeping wait for the next wake-up
+  if (state && !awake && !queue.empty() && !transmitting) {
+    medium.schedule(*this, medium.clock, true);
+  }
+  awake = state;
+  return true;
+}
+
+/**
+ * @brief Check if an address was added with addPeer()
+ * @param mac Peer address
+ * @return true if added
+ */
+bool FleetRadio::hasPeer(const uint8_t *mac) const {
+  for (size_t i = 0; i < peers.size(); i += 6) {
+    if (memcmp(&peers[i], mac, 6) == 0)
+      return true;
+  }
+  return false;
+}
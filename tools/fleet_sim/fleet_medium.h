@@ -0,0 +1,171 @@
+/**
+ * @file fleet_medium.h
+ * @brief Shared radio channel of the fleet simulator
+ *
+ * Every FleetRadio sits in one collision domain, the way bots on a desk or
+ * a shelf hear each other. Frames occupy the channel for their ESP-NOW
+ * airtime, radios sense the carrier and back off before sending, and two
+ * frames starting within one slot of each other collide and are lost for
+ * every receiver. Copies that survive can still be lost at a configured
+ * rate. Unicast frames also hold the channel for the MAC-layer ack, the
+ * sender learns the result when the frame would have been acked.
+ *
+ * Time is virtual and only moves when run() is called.
+ */
+
+#ifndef FLEET_MEDIUM_H
+#define FLEET_MEDIUM_H
+
+#include "transport_module.h"
+#include <deque>
+#include <vector>
+
+//==============================================================================
+// CONSTANTS & DEFINITIONS
+//==============================================================================
+
+/** @brief 802.11b timing at the 1 Mbps ESP-NOW rate (us) */
+#define FLEET_SLOT_US 20
+#define FLEET_SIFS_US 10
+#define FLEET_DIFS_US (FLEET_SIFS_US + 2 * FLEET_SLOT_US)
+#define FLEET_ACK_US 304
+/** @brief Backoff window in slots */
+#define FLEET_CONTENTION_WINDOW 32
+/** @brief Frames a radio holds before send() fails, like a full ESP-NOW queue */
+#define FLEET_RADIO_QUEUE_SIZE 8
+/** @brief Spread of send times within one main loop pass (us) */
+#define FLEET_LOOP_PHASE_US 1000
+
+//==============================================================================
+// TYPE DEFINITIONS
+//==============================================================================
+
+class FleetRadio;
+
+/**
+ * @brief Channel counters
+ */
+struct FleetMediumStats {
+  uint32_t transmissions;   /**< Frames put on air */
+  uint32_t collisions;      /**< Frames lost to an overlapping frame */
+  uint32_t copiesDelivered; /**< Frame copies handed to a receiver */
+  uint32_t copiesLost;      /**< Frame copies dropped by the loss model */
+  uint32_t queueDrops;      /**< Frames refused on a full radio queue */
+  uint64_t busyMicros;      /**< Time anything was on air */
+};
+
+/**
+ * @brief Collision domain shared by all radios
+ */
+class FleetMedium {
+public:
+  /**
+   * @brief Create an idle channel
+   * @param seed Seed of the backoff and loss generator
+   * @param lossPermille Surviving copies lost per 1000
+   */
+  FleetMedium(uint32_t seed, uint16_t lossPermille);
+
+  /**
+   * @brief Run the channel up to a point in time
+   *
+   * Receive and send handlers run from inside this call, at the time of
+   * their event, and may send again.
+   *
+   * @param untilUs Virtual time to stop at (us)
+   */
+  void run(uint64_t untilUs);
+
+  /**
+   * @brief Current virtual time
+   * @return Time of the event being handled or the last run() (us)
+   */
+  uint64_t now() const { return clock; }
+
+  /**
+   * @brief Channel counters since creation
+   * @return Copy of the counters
+   */
+  FleetMediumStats getStats() const { return stats; }
+
+private:
+  friend class FleetRadio;
+
+  /** @brief One frame on air */
+  struct Transmission {
+    FleetRadio *sender;        /**< Radio sending it */
+    uint64_t start;            /**< Time it went on air */
+    uint64_t end;              /**< Time the channel is free again */
+    bool collided;             /**< Overlapped another frame */
+  };
+
+  void attach(FleetRadio *radio);
+  void detach(FleetRadio *radio);
+  void schedule(FleetRadio &radio, uint64_t earliest, bool backoff);
+  void startTransmission(FleetRadio &radio);
+  void finishTransmission(size_t index);
+  uint32_t nextRandom();
+
+  std::vector<FleetRadio *> radios;
+  std::vector<Transmission> onAir;
+  FleetMediumStats stats;
+  uint16_t lossPermille;
+  uint64_t clock;
+  uint64_t busySince;
+  uint32_t randomState;
+};
+
+/**
+ * @brief EspNowTransport endpoint on a FleetMedium
+ */
+class FleetRadio : public EspNowTransport {
+public:
+  /**
+   * @brief Create a radio, it joins the channel on begin()
+   * @param medium Channel to join
+   * @param mac Address of the radio
+   */
+  FleetRadio(FleetMedium &medium, const uint8_t *mac);
+  ~FleetRadio() override;
+
+  bool begin(TransportReceiveHandler onReceive,
+             TransportSendHandler onSend) override;
+  void end() override;
+  bool send(const uint8_t *mac, const uint8_t *data, size_t length) override;
+  bool addPeer(const uint8_t *mac) override;
+  void removePeer(const uint8_t *mac) override;
+  void macAddress(uint8_t *mac) override;
+  bool setAwake(bool awake) override;
+
+  /**
+   * @brief Time this radio held the channel
+   * @return Airtime of its frames, acks included (us)
+   */
+  uint64_t airtimeMicros() const { return airtime; }
+
+private:
+  friend class FleetMedium;
+
+  /** @brief Frame waiting for the channel */
+  struct QueuedFrame {
+    uint8_t to[6];
+    uint8_t length;
+    uint8_t data[TRANSPORT_MAX_FRAME_SIZE];
+  };
+
+  bool hasPeer(const uint8_t *mac) const;
+
+  FleetMedium &medium;
+  uint8_t address[6];
+  std::vector<uint8_t> peers;
+  std::deque<QueuedFrame> queue;
+  uint64_t attemptAt;
+  bool transmitting;
+  bool up;
+  bool awake;
+  uint64_t airtime;
+  TransportReceiveHandler receiveHandler;
+  TransportSendHandler sendHandler;
+};
+
+#endif /* FLEET_MEDIUM_H */
@@ -0,0 +1,526 @@
+/**
+ * @file fleet_sim.cpp
+ * @brief Fleet simulator for ESP-NOW discovery and pairing at scale
+ *
+ * Runs N virtual bots, each a private copy of the real espnow_module state
+ * machines, on one simulated radio channel with carrier sense, collisions,
+ * loss and a virtual clock (see fleet_medium.h). Bots power up spread over
+ * a few seconds and run their communication loop every millisecond. For
+ * each fleet size it reports:
+ *
+ *   paired      bots with at least one peer at the end
+ *   stuck       bots that never paired or lost every peer for good
+ *   groups      connected groups in the peer graph at the end
+ *   ttp         time from power-up to the first peer, p50/p90/p99/max (ms),
+ *               percentiles by nearest rank
+ *   frames/pair frames on air until the last bot first paired, per pairing
+ *   air         channel busy time over that same span (%)
+ *   coll        frames lost to collisions (%)
+ *   hs ok/fail  pairing handshakes completed and timed out, all bots
+ *   sleep       radio off share of duty-cycled discovery (%)
+ *   pass us     host wall time of one handleCommunication() call, mean/max
+ *
+ * Build and run from this directory:
+ *     make
+ *     ./build/fleet_sim [-n 2,5,10,20,50,100] [-t seconds] [-l loss_permille]
+ *                       [-s spread_ms] [-r seed] [-v] [-L library]
+ *
+ * -v prints every bot's log lines with the bot index and virtual time.
+ * A run is deterministic for a seed.
+ */
+
+#include "fleet_bot.h"
+#include "fleet_medium.h"
+#include <algorithm>
+#include <chrono>
+#include <dlfcn.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+//==============================================================================
+// CONSTANTS & DEFINITIONS
+//==============================================================================
+
+/** @brief Main loop period of a bot (us) */
+#define FLEET_LOOP_US 1000
+/** @brief Largest fleet, one library copy is loaded per bot */
+#define FLEET_MAX_BOTS 250
+/** @brief Longest run, bot clocks are 32-bit microseconds */
+#define FLEET_MAX_SECONDS 4000
+
+//==============================================================================
+// TYPE DEFINITIONS
+//==============================================================================
+
+/**
+ * @brief Command line settings
+ */
+struct FleetOptions {
+  std::vector<int> sizes;   /**< Fleet sizes to simulate */
+  uint32_t seconds;         /**< Virtual duration of each run */
+  uint16_t lossPermille;    /**< Surviving copies lost per 1000 */
+  uint32_t spreadMs;        /**< Power-up times spread over this span */
+  uint32_t seed;            /**< Seed of everything random */
+  bool verbose;             /**< Print bot log lines */
+  std::string library;      /**< Bot library to copy per bot */
+};
+
+/**
+ * @brief One simulated bot
+ */
+struct FleetBot {
+  void *library;      /**< Private copy of the bot library */
+  FleetBotApi api;    /**< Module functions */
+  FleetRadio *radio;  /**< Endpoint on the channel */
+  uint8_t mac[6];     /**< Radio address */
+  uint64_t bootAt;    /**< Virtual power-up time (us) */
+  uint64_t pairedAt;  /**< First time with a peer, 0 if never (us) */
+  bool booted;        /**< Power-up time has passed */
+  bool paired;        /**< Has a peer right now */
+};
+
+/**
+ * @brief Results of one run
+ */
+struct FleetResult {
+  int bots;                       /**< Fleet size */
+  int paired;                     /**< Bots with a peer at the end */
+  int stuck;                      /**< Bots without a peer at the end */
+  int groups;                     /**< Connected groups at the end */
+  std::vector<uint32_t> ttpMs;    /**< Time to first peer of each paired bot */
+  double framesPerPairing;        /**< Frames on air per pairing, settling */
+  double airtimePercent;          /**< Channel busy, settling */
+  double collisionPercent;        /**< Collided frames, whole run */
+  uint32_t handshakesCompleted;   /**< Summed over all bots */
+  uint32_t handshakesFailed;      /**< Summed over all bots */
+  double sleepPercent;            /**< Radio off in duty-cycled discovery */
+  double passMeanUs;              /**< Host time per handleCommunication() */
+  double passMaxUs;               /**< Longest handleCommunication() */
+};
+
+//==============================================================================
+// GLOBAL VARIABLES
+//==============================================================================
+
+/** @brief Channel of the running simulation, the bots' clock */
+static FleetMedium *activeMedium = nullptr;
+/** @brief Print bot log lines */
+static bool verboseLog = false;
+
+//==============================================================================
+// HOST HOOKS
+//==============================================================================
+
+/**
+ * @brief Virtual time lent to every bot
+ * @return Simulated time (us)
+ */
+static uint32_t simulatedMicros() {
+  return static_cast<uint32_t>(activeMedium->now());
+}
+
+/**
+ * @brief Log sink lent to every bot
+ */
+static void botLog(int bot, char level, const char *tag, const char *message) {
+  if (!verboseLog)
+    return;
+  printf("%10.3f bot%-3d %c %s %s\n", activeMedium->now() / 1000.0, bot, level,
+         tag, message);
+}
+
+//==============================================================================
+// BOT LIBRARIES
+//==============================================================================
+
+/**
+ * @brief Load a private copy of the bot library
+ *
+ * The dynamic loader shares a library opened twice under one path, so
+ * every bot gets its own file copy and with it its own module globals.
+ *
+ * @param image Bytes of the bot library
+ * @return Library handle or nullptr
+ */
+static void *loadBotCopy(const std::vector<char> &image) {
+  char path[] = "/tmp/fleet_bot_XXXXXX.so";
+  int fd = mkstemps(path, 3);
+  if (fd < 0)
+    return nullptr;
+  bool written = write(fd, image.data(), image.size()) ==
+                 static_cast<ssize_t>(image.size());
+  close(fd);
+
+  void *library = written ? dlopen(path, RTLD_NOW | RTLD_LOCAL) : nullptr;
+  if (!library) {
+    fprintf(stderr, "Can't load bot library: %s\n", dlerror());
+  }
+  unlink(path);
+  return library;
+}
+
+/**
+ * @brief Read a whole file
+ * @param path File to read
+ * @param image Filled with the file bytes
+ * @return true if the file was read
+ */
+static bool readFile(const std::string &path, std::vector<char> &image) {
+  FILE *file = fopen(path.c_str(), "rb");
+  if (!file)
+    return false;
+  char buffer[4096];
+  size_t count;
+  while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    image.insert(image.end(), buffer, buffer + count);
+  }
+  fclose(file);
+  return !image.empty();
+}
+
+//==============================================================================
+// SIMULATION
+//==============================================================================
+
+/**
+ * @brief Next value of a xorshift generator
+ * @param state Generator state
+ * @return Pseudo-random 32-bit value
+ */
+static uint32_t nextRandom(uint32_t &state) {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+/**
+ * @brief Count pairings and connected groups in the peer graph
+ * @param bots Fleet
+ * @param links Filled with the number of peer links
+ * @return Number of groups, unpaired bots count as their own group
+ */
+static int countGroups(std::vector<FleetBot> &bots, int &links) {
+  std::vector<int> group(bots.size());
+  for (size_t i = 0; i < bots.size(); i++) {
+    group[i] = i;
+  }
+  // Union-find over the peer tables
+  auto root = [&group](int i) {
+    while (group[i] != i) {
+      i = group[i] = group[group[i]];
+    }
+    return i;
+  };
+
+  int ends = 0;
+  for (size_t i = 0; i < bots.size(); i++) {
+    PeerStatus status;
+    for (uint8_t index = 0; bots[i].api.getPeerStatus(index, status);
+         index++) {
+      ends++;
+      for (size_t j = 0; j < bots.size(); j++) {
+        if (memcmp(bots[j].mac, status.mac, 6) == 0) {
+          group[root(i)] = root(j);
+        }
+      }
+    }
+  }
+  links = ends / 2;
+
+  int groups = 0;
+  for (size_t i = 0; i < bots.size(); i++) {
+    groups += root(i) == static_cast<int>(i);
+  }
+  return groups;
+}
+
+/**
+ * @brief Simulate one fleet
+ * @param options Command line settings
+ * @param image Bytes of the bot library
+ * @param size Number of bots
+ * @param result Filled with the measurements
+ * @return true if every bot could be loaded
+ */
+static bool simulateFleet(const FleetOptions &options,
+                          const std::vector<char> &image, int size,
+                          FleetResult &result) {
+  uint32_t randomState = options.seed * 2654435761u + size;
+  FleetMedium medium(nextRandom(randomState), options.lossPermille);
+  activeMedium = &medium;
+
+  std::vector<FleetBot> bots(size);
+  for (int i = 0; i < size; i++) {
+    FleetBot &bot = bots[i];
+    bot = FleetBot();
+    // Locally administered addresses in random order, roles depend on it
+    uint32_t address = nextRandom(randomState);
+    uint8_t mac[6] = {0x02, 0xB5, static_cast<uint8_t>(address >> 24),
+                      static_cast<uint8_t>(address >> 16),
+                      static_cast<uint8_t>(i >> 8), static_cast<uint8_t>(i)};
+    memcpy(bot.mac, mac, 6);
+    bot.radio = new FleetRadio(medium, mac);
+    bot.bootAt = options.spreadMs
+                     ? (nextRandom(randomState) % options.spreadMs) * 1000ull
+                     : 0;
+
+    bot.library = loadBotCopy(image);
+    FleetBotBindFunction bind =
+        bot.library ? reinterpret_cast<FleetBotBindFunction>(
+                          dlsym(bot.library, FLEET_BOT_BIND_SYMBOL))
+                    : nullptr;
+    FleetBotHost host = {simulatedMicros,
+                         botLog,
+                         i,
+                         static_cast<uint32_t>(bot.bootAt),
+                         nextRandom(randomState),
+                         bot.radio};
+    if (!bind || !bind(&host, &bot.api)) {
+      fprintf(stderr, "Can't bind bot %d\n", i);
+      return false;
+    }
+  }
+
+  uint64_t endAt = options.seconds * 1000000ull;
+  uint64_t settledAt = 0;
+  FleetMediumStats settledStats = {};
+  int settledLinks = 0;
+  int pairedOnce = 0;
+  double passTotalUs = 0;
+  double passMaxUs = 0;
+  uint64_t passes = 0;
+
+  for (uint64_t now = 0; now <= endAt; now += FLEET_LOOP_US) {
+    medium.run(now);
+    for (FleetBot &bot : bots) {
+      if (!bot.booted) {
+        if (now < bot.bootAt)
+          continue;
+        bot.booted = true;
+        bot.api.restartCommunication();
+      }
+      auto passStart = std::chrono::steady_clock::now();
+      bot.api.handleCommunication();
+      double passUs = std::chrono::duration<double, std::micro>(
+                          std::chrono::steady_clock::now() - passStart)
+                          .count();
+      passTotalUs += passUs;
+      passMaxUs = std::max(passMaxUs, passUs);
+      passes++;
+
+      bot.paired = bot.api.isPaired();
+      if (bot.paired && !bot.pairedAt) {
+        bot.pairedAt = now;
+        pairedOnce++;
+      }
+    }
+    if (!settledAt && pairedOnce == size) {
+      settledAt = now;
+      settledStats = medium.getStats();
+      countGroups(bots, settledLinks);
+    }
+  }
+  if (!settledAt) {
+    settledAt = endAt;
+    settledStats = medium.getStats();
+    countGroups(bots, settledLinks);
+  }
+
+  FleetMediumStats stats = medium.getStats();
+  int links = 0;
+  result = FleetResult();
+  result.bots = size;
+  result.groups = countGroups(bots, links);
+  for (FleetBot &bot : bots) {
+    result.paired += bot.paired;
+    if (bot.pairedAt) {
+      result.ttpMs.push_back((bot.pairedAt - bot.bootAt) / 1000);
+    }
+  }
+  result.stuck = size - result.paired;
+  result.framesPerPairing =
+      settledLinks ? settledStats.transmissions / (double)settledLinks : 0;
+  result.airtimePercent =
+      settledAt ? 100.0 * settledStats.busyMicros / settledAt : 0;
+  result.collisionPercent =
+      stats.transmissions ? 100.0 * stats.collisions / stats.transmissions : 0;
+  result.passMeanUs = passes ? passTotalUs / passes : 0;
+  result.passMaxUs = passMaxUs;
+  std::sort(result.ttpMs.begin(), result.ttpMs.end());
+
+  // Shutting down closes the duty cycle totals
+  uint64_t awakeMs = 0;
+  uint64_t asleepMs = 0;
+  for (FleetBot &bot : bots) {
+    bot.api.shutdownCommunication();
+    DiscoveryStats discovery = bot.api.getDiscoveryStats();
+    result.handshakesCompleted += discovery.handshakesCompleted;
+    result.handshakesFailed += discovery.handshakesFailed;
+    awakeMs += discovery.radioAwakeMs;
+    asleepMs += discovery.radioAsleepMs;
+    delete bot.radio;
+    dlclose(bot.library);
+  }
+  result.sleepPercent =
+      awakeMs + asleepMs ? 100.0 * asleepMs / (awakeMs + asleepMs) : 0;
+  activeMedium = nullptr;
+  return true;
+}
+
+//==============================================================================
+// REPORT
+//==============================================================================
+
+/**
+ * @brief Nearest-rank percentile of sorted samples
+ *
+ * The smallest sample that at least percent of the samples are no larger
+ * than, so p99 of fewer than 100 samples is the largest one.
+ *
+ * @param samples Sorted samples
+ * @param percent Percentile (0-100)
+ * @return Sample at the percentile, 0 without samples
+ */
+static uint32_t percentile(const std::vector<uint32_t> &samples,
+                           int percent) {
+  if (samples.empty())
+    return 0;
+  size_t rank = (samples.size() * percent + 99) / 100;
+  return samples[std::max<size_t>(rank, 1) - 1];
+}
+
+/**
+ * @brief Print the report header
+ */
+static void printHeader(const FleetOptions &options) {
+  printf("%u s per run, loss %u/1000, power-up spread %u ms, seed %u\n\n",
+         options.seconds, options.lossPermille, options.spreadMs,
+         options.seed);
+  printf("%5s %6s %5s %6s  %27s %11s %6s %6s %13s %6s %13s\n", "bots",
+         "paired", "stuck", "groups", "ttp p50/p90/p99/max (ms)",
+         "frames/pair", "air%", "coll%", "hs ok/fail", "sleep%", "pass us");
+}
+
+/**
+ * @brief Print one fleet size
+ */
+static void printResult(const FleetResult &result) {
+  char ttp[40];
+  snprintf(ttp, sizeof(ttp), "%u/%u/%u/%u", percentile(result.ttpMs, 50),
+           percentile(result.ttpMs, 90), percentile(result.ttpMs, 99),
+           percentile(result.ttpMs, 100));
+  char handshakes[24];
+  snprintf(handshakes, sizeof(handshakes), "%u/%u", result.handshakesCompleted,
+           result.handshakesFailed);
+  char pass[24];
+  snprintf(pass, sizeof(pass), "%.2f/%.0f", result.passMeanUs,
+           result.passMaxUs);
+  printf("%5d %6d %5d %6d  %27s %11.1f %6.2f %6.2f %13s %6.1f %13s\n",
+         result.bots, result.paired, result.stuck, result.groups, ttp,
+         result.framesPerPairing, result.airtimePercent,
+         result.collisionPercent, handshakes, result.sleepPercent, pass);
+}
+
+//==============================================================================
+// MAIN
+//==============================================================================
+
+/**
+ * @brief Print usage
+ */
+static void usage(const char *program) {
+  fprintf(stderr,
+          "Usage: %s [-n 2,5,10,20,50,100] [-t seconds] [-l loss_permille]\n"
+          "       [-s spread_ms] [-r seed] [-v] [-L library]\n",
+          program);
+}
+
+/**
+ * @brief Parse a comma separated list of fleet sizes
+ * @return true if every size is in range
+ */
+static bool parseSizes(const char *text, std::vector<int> &sizes) {
+  sizes.clear();
+  for (const char *cursor = text; *cursor;) {
+    char *end;
+    long size = strtol(cursor, &end, 10);
+    if (end == cursor || size < 1 || size > FLEET_MAX_BOTS)
+      return false;
+    sizes.push_back(size);
+    cursor = *end == ',' ? end + 1 : end;
+  }
+  return !sizes.empty();
+}
+
+int main(int argc, char **argv) {
+  FleetOptions options;
+  options.sizes = {2, 5, 10, 20, 50, 100};
+  options.seconds = 120;
+  options.lossPermille = 0;
+  options.spreadMs = 5000;
+  options.seed = 1;
+  options.verbose = false;
+
+  // Bot library next to the simulator by default
+  std::string program = argv[0];
+  size_t slash = program.rfind('/');
+  options.library = (slash == std::string::npos ? std::string(".")
+                                                 : program.substr(0, slash)) +
+                    "/libfleet_bot.so";
+
+  int option;
+  while ((option = getopt(argc, argv, "n:t:l:s:r:vL:")) != -1) {
+    switch (option) {
+    case 'n':
+      if (!parseSizes(optarg, options.sizes)) {
+        usage(argv[0]);
+        return 1;
+      }
+      break;
+    case 't':
+      options.seconds = std::min(atol(optarg), (long)FLEET_MAX_SECONDS);
+      break;
+    case 'l':
+      options.lossPermille = std::min(atoi(optarg), 1000);
+      break;
+    case 's':
+      options.spreadMs = atol(optarg);
+      break;
+    case 'r':
+      options.seed = strtoul(optarg, nullptr, 10);
+      break;
+    case 'v':
+      options.verbose = true;
+      break;
+    case 'L':
+      options.library = optarg;
+      break;
+    default:
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  verboseLog = options.verbose;
+
+  std::vector<char> image;
+  if (!readFile(options.library, image)) {
+    fprintf(stderr, "Can't read %s\n", options.library.c_str());
+    return 1;
+  }
+
+  printHeader(options);
+  for (int size : options.sizes) {
+    FleetResult result;
+    if (!simulateFleet(options, image, size, result))
+      return 1;
+    printResult(result);
+    fflush(stdout);
+  }
+  return 0;
+}
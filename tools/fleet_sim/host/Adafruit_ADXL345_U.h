@@ -0,0 +1,16 @@
+/**
+ * @file Adafruit_ADXL345_U.h
+ * @brief Host stand-in with the ADXL345 types adxl_module.h names
+ */
+
+#ifndef FLEET_SIM_ADAFRUIT_ADXL345_U_H
+#define FLEET_SIM_ADAFRUIT_ADXL345_U_H
+
+#include "Adafruit_Sensor.h"
+
+typedef enum {
+  ADXL345_DATARATE_25_HZ = 0b1000,
+  ADXL345_DATARATE_100_HZ = 0b1010
+} dataRate_t;
+
+#endif /* FLEET_SIM_ADAFRUIT_ADXL345_U_H */
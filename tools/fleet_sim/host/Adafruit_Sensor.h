@@ -0,0 +1,24 @@
+/**
+ * @file Adafruit_Sensor.h
+ * @brief Host stand-in with the sensor types adxl_module.h names
+ */
+
+#ifndef FLEET_SIM_ADAFRUIT_SENSOR_H
+#define FLEET_SIM_ADAFRUIT_SENSOR_H
+
+#include <stdint.h>
+
+typedef struct {
+  float x, y, z;
+} sensors_vec_t;
+
+typedef struct {
+  int32_t version;
+  int32_t sensor_id;
+  int32_t type;
+  int32_t reserved0;
+  int32_t timestamp;
+  sensors_vec_t acceleration;
+} sensors_event_t;
+
+#endif /* FLEET_SIM_ADAFRUIT_SENSOR_H */
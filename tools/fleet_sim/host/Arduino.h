@@ -0,0 +1,38 @@
+/**
+ * @file Arduino.h
+ * @brief Host stand-in for the Arduino core, just what espnow_module needs
+ *
+ * Time and randomness come from the fleet simulator, each bot library has
+ * its own clock and generator.
+ */
+
+#ifndef FLEET_SIM_ARDUINO_H
+#define FLEET_SIM_ARDUINO_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+using std::max;
+using std::min;
+
+#define constrain(amt, low, high)                                             \
+  ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+/** @brief Pins named by the board headers */
+#define D1 1
+#define D4 4
+#define D5 5
+#define GPIO_NUM_1 1
+
+unsigned long millis();
+unsigned long micros();
+long random(long howbig);
+long random(long howsmall, long howbig);
+void delay(unsigned long ms);
+
+#endif /* FLEET_SIM_ARDUINO_H */
@@ -0,0 +1,21 @@
+/**
+ * @file ESP_log.h
+ * @brief Host stand-in for the ESP-IDF log macros
+ *
+ * Messages go to the simulator, which prefixes them with the bot and its
+ * time and drops them unless the run is verbose.
+ */
+
+#ifndef FLEET_SIM_ESP_LOG_H
+#define FLEET_SIM_ESP_LOG_H
+
+void fleetLog(char level, const char *tag, const char *format, ...)
+    __attribute__((format(printf, 3, 4)));
+
+#define ESP_LOGE(tag, ...) fleetLog('E', tag, __VA_ARGS__)
+#define ESP_LOGW(tag, ...) fleetLog('W', tag, __VA_ARGS__)
+#define ESP_LOGI(tag, ...) fleetLog('I', tag, __VA_ARGS__)
+#define ESP_LOGD(tag, ...) fleetLog('D', tag, __VA_ARGS__)
+#define ESP_LOGV(tag, ...) fleetLog('V', tag, __VA_ARGS__)
+
+#endif /* FLEET_SIM_ESP_LOG_H */
@@ -0,0 +1,4 @@
+/**
+ * @file SPI.h
+ * @brief Empty host stand-in, common.h includes it
+ */
@@ -0,0 +1,403 @@
+#!/usr/bin/env python3
+"""
+Serial updater
+
+Uploads a firmware or filesystem image to a BYTE-90 in update mode over USB
+serial using the binary framing of serial_module, the command line
+counterpart of the web installer.
+
+Usage:
+    python3 tools/serial_update.py <port> <image.bin | patch.delta>
+        [--type firmware|filesystem|delta] [--chunk BYTES] [--window N]
+        [--encoding auto|gzip|deflate|none] [--no-resume]
+
+After BINARY:1 every message is a COBS-encoded frame ended by a zero byte:
+type, uint16 sequence, uint16 payload length, payload and a CRC32 of all of
+it, little endian. Up to the negotiated window of chunks is in flight, as
+far as the receive limit in the device's acks allows. Chunks the device
+reports corrupt, or that go unacknowledged, are sent again instead of
+failing the update. Firmware that lists encodings in GET_INFO gets the
+image compressed and inflates it as it arrives. A delta patch from
+delta_patch.py is only sent if it was made for the firmware the device
+reports running.
+
+Firmware that reports resume in GET_INFO keeps an update that stopped
+early, also across a reboot. The image is named by its SHA-256 and running
+the updater again with the same image sends only what the device does not
+have yet (RESUME_UPDATE), --no-resume starts over. Delta patches always
+start over. Requires pyserial.
+"""
+
+import argparse
+import gzip
+import hashlib
+import json
+import struct
+import sys
+import time
+import zlib
+
+import serial
+
+BAUD_RATE = 921600
+
+FRAME_COMMAND = 1
+FRAME_DATA = 2
+FRAME_RESPONSE = 3
+FRAME_ACK = 4
+FRAME_NAK = 5
+
+MAX_PAYLOAD = 4096
+MAX_WINDOW = 8
+FRAME_TIMEOUT = 2.0
+COMMAND_TIMEOUT = 10.0
+MAX_ATTEMPTS = 8
+
+DELTA_MAGIC = b"B90D"
+
+
+def cobs_encode(data):
+    out = bytearray()
+    block = bytearray()
+    for byte in data:
+        if byte == 0:
+            out.append(len(block) + 1)
+            out += block
+            block.clear()
+            continue
+        block.append(byte)
+        if len(block) == 0xFE:
+            out.append(0xFF)
+            out += block
+            block.clear()
+    out.append(len(block) + 1)
+    out += block
+    return bytes(out)
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            raise ValueError("broken COBS block")
+        out += data[i + 1:i + code]
+        i += code
+        if code != 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+class FramedLink:
+    def __init__(self, port):
+        self.port = port
+        self.pending = bytearray()
+        self.sent = 0
+
+    @staticmethod
+    def encode(frame_type, seq, payload=b""):
+        body = struct.pack("<BHH", frame_type, seq & 0xFFFF, len(payload))
+        body += payload
+        body += struct.pack("<I", zlib.crc32(body))
+        return cobs_encode(body) + b"\0"
+
+    def write(self, frame):
+        self.port.write(frame)
+        self.sent = (self.sent + len(frame)) & 0xFFFFFFFF
+
+    def send(self, frame_type, seq, payload=b""):
+        self.write(self.encode(frame_type, seq, payload))
+
+    def receive(self, timeout):
+        """Next valid frame as (type, seq, payload), None on timeout."""
+        deadline = time.monotonic() + timeout
+        while True:
+            end = self.pending.find(b"\0")
+            if end >= 0:
+                encoded = bytes(self.pending[:end])
+                del self.pending[:end + 1]
+                frame = self.parse(encoded)
+                if frame:
+                    return frame
+                continue
+            left = deadline - time.monotonic()
+            if left <= 0:
+                return None
+            self.port.timeout = left
+            self.pending += self.port.read(max(1, self.port.in_waiting))
+
+    @staticmethod
+    def parse(encoded):
+        try:
+            body = cobs_decode(encoded)
+        except ValueError:
+            return None
+        if len(body) < 9:
+            return None
+        frame_type, seq, length = struct.unpack_from("<BHH", body)
+        (crc,) = struct.unpack_from("<I", body, len(body) - 4)
+        if length != len(body) - 9 or zlib.crc32(body[:-4]) != crc:
+            return None
+        return frame_type, seq, body[5:-4]
+
+
+def enable_binary(port, window):
+    """Switch to frames, returns the reply with the accepted limits."""
+    port.reset_input_buffer()
+    port.write(f"\nBINARY:1,{window}\n".encode())
+    deadline = time.monotonic() + COMMAND_TIMEOUT
+    while time.monotonic() < deadline:
+        line = port.readline().decode(errors="replace").strip()
+        if line.startswith("OK:") and "Binary framing" in line:
+            return json.loads(line[3:])
+    raise RuntimeError("device did not switch to binary framing")
+
+
+def command(link, seq, text):
+    """Send a command frame and return the OK:/ERROR: reply as a dict."""
+    for _ in range(MAX_ATTEMPTS):
+        link.send(FRAME_COMMAND, seq, text.encode())
+        deadline = time.monotonic() + COMMAND_TIMEOUT
+        while time.monotonic() < deadline:
+            frame = link.receive(deadline - time.monotonic())
+            if frame is None:
+                break
+            frame_type, frame_seq, payload = frame
+            if frame_type == FRAME_NAK:
+                break
+            if frame_type != FRAME_RESPONSE or frame_seq != seq:
+                continue
+            line = payload.decode(errors="replace")
+            if line.startswith("OK:"):
+                return json.loads(line[3:])
+            if line.startswith("ERROR:"):
+                raise RuntimeError(f"{text.split(':')[0]}: {line[6:]}")
+    raise RuntimeError(f"no reply to {text.split(':')[0]}")
+
+
+def send_image(link, image, chunk_size, window, limit):
+    """Stream the image with up to window chunks in flight.
+
+    limit is the device's receive limit, frames are only sent while the
+    count of frame bytes written stays within it.
+    """
+    chunks = [image[i:i + chunk_size] for i in range(0, len(image), chunk_size)]
+    count = len(chunks)
+    base = 0
+    held = set()
+    sent_at = {}
+    attempts = {}
+    resent = 0
+    progress_at = time.monotonic()
+    busy_at = 0.0  # last PROGRESS, the device is alive but writing flash
+
+    while base < count:
+        now = time.monotonic()
+
+        # Oldest chunk in the window that was never sent or timed out
+        while True:
+            chunk = None
+            for c in range(base, min(base + window, count)):
+                if c not in held and (c not in sent_at or now - max(
+                        sent_at[c], busy_at) > FRAME_TIMEOUT):
+                    chunk = c
+                    break
+            if chunk is None:
+                break
+            frame = link.encode(FRAME_DATA, chunk, chunks[chunk])
+            if (limit - link.sent - len(frame)) & 0x80000000:
+                break  # RX buffer full, wait for the next ack
+            attempts[chunk] = attempts.get(chunk, 0) + 1
+            if attempts[chunk] > 1:
+                resent += 1
+            if attempts[chunk] > MAX_ATTEMPTS:
+                raise RuntimeError(f"chunk {chunk} failed {MAX_ATTEMPTS} times")
+            link.write(frame)
+            sent_at[chunk] = now
+
+        if now - max(progress_at, busy_at) > COMMAND_TIMEOUT:
+            raise RuntimeError(f"no progress at chunk {base}")
+
+        waits = [max(sent_at[c], busy_at) + FRAME_TIMEOUT - now
+                 for c in range(base, min(base + window, count))
+                 if c in sent_at and c not in held]
+        frame = link.receive(max(0.001, min(waits, default=FRAME_TIMEOUT)))
+        if frame is None:
+            continue
+
+        frame_type, seq, payload = frame
+        if frame_type == FRAME_RESPONSE:
+            line = payload.decode(errors="replace")
+            if line.startswith("ERROR:"):
+                raise RuntimeError(line[6:])
+            if line.startswith("PROGRESS:"):
+                busy_at = time.monotonic()
+            continue
+        if frame_type not in (FRAME_ACK, FRAME_NAK):
+            continue
+
+        # Sequence numbers are the low 16 bits of the chunk index
+        ahead = (seq - base) & 0xFFFF
+        if ahead > window:
+            continue
+        if frame_type == FRAME_ACK and len(payload) >= 8:
+            mask, new_limit = struct.unpack_from("<II", payload)
+        elif frame_type == FRAME_NAK and len(payload) >= 5:
+            (new_limit,) = struct.unpack_from("<I", payload, 1)
+            mask = None
+        else:
+            continue
+        if not (new_limit - limit) & 0x80000000:
+            limit = new_limit
+
+        if ahead:
+            base += ahead
+            progress_at = now
+            print(f"\r{base * 100 // count}%", end="", flush=True)
+        if mask is None:
+            # The corrupt frame can be any chunk in flight. Resend the
+            # oldest one right away, unless it already went out after all
+            # the others
+            held = {c for c in held if c > base}
+            newest = max((sent_at[c] for c in range(base + 1, base + window)
+                          if c in sent_at and c not in held), default=None)
+            if base in sent_at and (newest is None
+                                    or sent_at[base] <= newest):
+                del sent_at[base]
+            continue
+        held = {base + 1 + i for i in range(window) if mask >> i & 1}
+
+        # A chunk sent before one that already arrived was lost on the way
+        if held:
+            latest = max(sent_at[c] for c in held if c in sent_at)
+            for c in range(base, max(held)):
+                if c not in held and sent_at.get(c, latest) < latest:
+                    del sent_at[c]
+
+    print()
+    return resent
+
+
+def encode_image(image, encoding):
+    """Compress the image, returns the bytes to send."""
+    if encoding == "gzip":
+        return gzip.compress(image, 9, mtime=0)
+    if encoding == "deflate":
+        return zlib.compress(image, 9)
+    return image
+
+
+def encode_rest(image, offset, encoding):
+    """Compress the image from offset on, returns (encoding, bytes to send)."""
+    payload = encode_image(image[offset:], encoding)
+    if encoding != "none" and len(payload) >= len(image) - offset:
+        return "none", image[offset:]
+    return encoding, payload
+
+
+def check_delta(patch, info):
+    """Raise unless the patch applies to the firmware the device runs."""
+    if patch[:4] != DELTA_MAGIC or len(patch) < 8 + 32:
+        raise RuntimeError("not a delta patch, see tools/delta_patch.py")
+    made_for = patch[8:40].hex()
+    running = info.get("firmware_sha256")
+    if running is None:
+        raise RuntimeError("device firmware does not support delta updates")
+    if running != made_for:
+        raise RuntimeError(f"patch is for firmware {made_for[:16]}, "
+                           f"device runs {running[:16]}")
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description="Upload an image over serial")
+    parser.add_argument("port", help="serial port, e.g. /dev/ttyACM0")
+    parser.add_argument("image", help="firmware or filesystem image, or patch")
+    parser.add_argument("--type", choices=["firmware", "filesystem", "delta"],
+                        default="firmware")
+    parser.add_argument("--chunk", type=int, default=MAX_PAYLOAD,
+                        help="bytes per data frame")
+    parser.add_argument("--window", type=int, default=MAX_WINDOW,
+                        help="data frames in flight, 1 waits for every ack")
+    parser.add_argument("--encoding", default="auto",
+                        choices=["auto", "gzip", "deflate", "none"],
+                        help="compression, auto uses gzip if supported")
+    parser.add_argument("--no-resume", action="store_true",
+                        help="start over even if the device has this image "
+                             "in part")
+    args = parser.parse_args(argv)
+
+    with open(args.image, "rb") as f:
+        image = f.read()
+
+    with serial.Serial(args.port, BAUD_RATE, timeout=1) as port:
+        reply = enable_binary(port, max(1, args.window))
+        link = FramedLink(port)
+        chunk_size = max(1, min(args.chunk, reply["max_payload"]))
+        window = reply["window"]
+        limit = reply["rx_buffer"]
+
+        start = time.monotonic()
+        resumable = False
+        try:
+            encoding = args.encoding
+            info = command(link, 1, "GET_INFO")
+            if args.type == "delta":
+                check_delta(image, info)
+            if encoding == "auto":
+                encoding = "gzip" if "gzip" in info.get("encodings", []) \
+                    else "none"
+
+            resumable = info.get("resume") and args.type != "delta"
+            image_hash = hashlib.sha256(image).hexdigest() if resumable else ""
+            offset = 0
+            session = info.get("session") or {}
+            if (resumable and not args.no_resume
+                    and session.get("sha256") == image_hash
+                    and session.get("type") == args.type
+                    and session.get("offset", 0) < len(image)):
+                offset = session["offset"]
+                print(f"Resuming at {offset} of {len(image)} bytes")
+
+            if offset:
+                sent_as, payload = encode_rest(image, offset, encoding)
+                try:
+                    command(link, 2, f"RESUME_UPDATE:{len(payload)},"
+                            f"{args.type},{sent_as},{image_hash},{offset}")
+                except RuntimeError as error:
+                    # The device drops a session that fails its check
+                    print(f"Starting over, {error}")
+                    offset = 0
+            if not offset:
+                sent_as, payload = encode_rest(image, 0, encoding)
+                update = f"START_UPDATE:{len(payload)},{args.type}"
+                if image_hash:
+                    update += f",{sent_as},{image_hash}"
+                elif sent_as != "none":
+                    update += f",{sent_as}"
+                command(link, 2, update)
+            resent = send_image(link, payload, chunk_size, window, limit)
+            command(link, 3, "FINISH_UPDATE")
+            elapsed = time.monotonic() - start
+        except RuntimeError as error:
+            print(f"\nUpdate failed: {error}", file=sys.stderr)
+            # Aborting would drop what the device kept for a resume
+            if resumable:
+                print("Run again with the same image to resume",
+                      file=sys.stderr)
+            try:
+                if not resumable:
+                    command(link, 4, "ABORT_UPDATE")
+                command(link, 5, "BINARY:0")
+            except RuntimeError:
+                pass
+            return 1
+
+    rate = (len(image) - offset) / elapsed if elapsed > 0 else 0
+    print(f"{len(image)} bytes as {len(payload)} {sent_as} in {elapsed:.1f} s, "
+          f"{rate / 1024:.1f} KB/s, window {window}, {resent} resent")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,86 @@
+#!/usr/bin/env python3
+"""
+Sprite converter
+
+Converts an image or a horizontal strip of frames into the sprite format
+loaded by compositor_module (.spr).
+
+Usage:
+    python3 tools/sprite_converter.py <input.png> <output.spr>
+        [--frames N] [--delay MS] [--opaque]
+
+Frames are cut from the input left to right, so a strip of N frames must be
+N times as wide as one frame. Pixels are stored as little-endian RGB565.
+An 8-bit alpha plane follows every frame unless --opaque is given or the
+image has no transparent pixels. Requires Pillow.
+"""
+
+import argparse
+import struct
+import sys
+
+from PIL import Image
+
+SPRITE_MAGIC = b"SPR1"
+SPRITE_FLAG_ALPHA = 0x01
+DISPLAY_SIZE = 128
+
+
+def rgb565(r, g, b):
+    return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3)
+
+
+def convert(image, frames, delay, opaque):
+    image = image.convert("RGBA")
+    if image.width % frames != 0:
+        raise ValueError(f"width {image.width} is not a multiple of {frames}")
+    width = image.width // frames
+    height = image.height
+    if width > DISPLAY_SIZE or height > DISPLAY_SIZE:
+        raise ValueError(f"frame {width}x{height} exceeds the display")
+    if not 1 <= frames <= 0xFF:
+        raise ValueError("between 1 and 255 frames are supported")
+
+    has_alpha = not opaque and image.getextrema()[3][0] < 0xFF
+    flags = SPRITE_FLAG_ALPHA if has_alpha else 0
+    data = struct.pack("<4sHHBBH", SPRITE_MAGIC, width, height, frames, flags,
+                       delay)
+
+    for frame in range(frames):
+        pixels = image.crop((frame * width, 0, (frame + 1) * width, height))
+        rgba = list(pixels.getdata())
+        data += b"".join(struct.pack("<H", rgb565(r, g, b))
+                         for r, g, b, _ in rgba)
+        if has_alpha:
+            data += bytes(a for _, _, _, a in rgba)
+    return data, width, height, has_alpha
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description="Convert images to .spr")
+    parser.add_argument("input")
+    parser.add_argument("output")
+    parser.add_argument("--frames", type=int, default=1,
+                        help="number of frames in the strip")
+    parser.add_argument("--delay", type=int, default=100,
+                        help="default time per frame in ms")
+    parser.add_argument("--opaque", action="store_true",
+                        help="drop the alpha plane")
+    args = parser.parse_args(argv[1:])
+
+    try:
+        data, width, height, has_alpha = convert(
+            Image.open(args.input), args.frames, args.delay, args.opaque)
+    except (OSError, ValueError) as error:
+        print(f"{args.input}: {error}", file=sys.stderr)
+        return 1
+
+    with open(args.output, "wb") as output:
+        output.write(data)
+    print(f"Wrote {args.output} ({args.frames}x {width}x{height}, "
+          f"{'alpha' if has_alpha else 'opaque'}, {len(data)} bytes)")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
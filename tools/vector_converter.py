@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""
+Vector animation converter
+
+Converts a JSON vector animation description into the binary format
+played by vector_module from LittleFS (.vec).
+
+Usage:
+    python3 tools/vector_converter.py vector/hearts.json data/vectors/hearts.vec
+
+Description format:
+
+    {
+      "duration": 2000,            animation length in ms
+      "size": 128,                 design space width and height
+      "background": "#000000",
+      "shapes": [
+        {
+          "type": "circle",        circle | rect | polygon
+          "color": "#ff2060",
+          "radius": 10,            circle
+          "width": 20, "height": 12, "corner": 4,       rect
+          "points": [[0, -8], [8, 8], [-8, 8]],         polygon
+          "keyframes": [
+            {"t": 0, "x": 64, "y": 64, "scale": 1.0, "alpha": 255,
+             "ease": "linear"}     linear | in | out | in_out | step
+          ]
+        }
+      ]
+    }
+
+Coordinates are design units and may be fractional (1/16 precision).
+Polygon points are relative to the keyframe position. Keyframe fields other
+than "t" default to the previous keyframe's value.
+"""
+
+import json
+import struct
+import sys
+
+# Must match include/vector_module.h
+MAGIC = b"VEC1"
+VERSION = 1
+COORD_SCALE = 16
+MAX_SHAPES = 32
+MAX_FILE_SIZE = 4096
+SHAPE_TYPES = {"circle": 0, "rect": 1, "polygon": 2}
+EASINGS = {"linear": 0, "in": 1, "out": 2, "in_out": 3, "step": 4}
+
+
+class ConvertError(Exception):
+    pass
+
+
+def rgb565(color):
+    text = color.lstrip("#")
+    if len(text) != 6:
+        raise ConvertError(f"bad color '{color}', expected #rrggbb")
+    r, g, b = (int(text[i:i + 2], 16) for i in (0, 2, 4))
+    return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3)
+
+
+def coord(value, signed=True):
+    fixed = round(value * COORD_SCALE)
+    low, high = (-0x8000, 0x7FFF) if signed else (0, 0xFFFF)
+    if not low <= fixed <= high:
+        raise ConvertError(f"coordinate {value} out of range")
+    return fixed
+
+
+def pack_shape(index, shape):
+    kind = shape.get("type")
+    if kind not in SHAPE_TYPES:
+        raise ConvertError(f"shape {index}: unknown type '{kind}'")
+
+    sizes = [0, 0, 0]
+    points = []
+    if kind == "circle":
+        sizes[0] = coord(shape["radius"], False)
+    elif kind == "rect":
+        sizes = [coord(shape["width"], False), coord(shape["height"], False),
+                 coord(shape.get("corner", 0), False)]
+    else:
+        points = shape.get("points", [])
+        if not 3 <= len(points) <= 0xFF:
+            raise ConvertError(f"shape {index}: polygons need 3-255 points")
+
+    keyframes = shape.get("keyframes", [])
+    if not 1 <= len(keyframes) <= 0xFF:
+        raise ConvertError(f"shape {index}: needs 1-255 keyframes")
+
+    data = struct.pack("<BBBBH3H", SHAPE_TYPES[kind], len(keyframes),
+                       len(points), 0, rgb565(shape.get("color", "#ffffff")),
+                       *sizes)
+    for x, y in points:
+        data += struct.pack("<hh", coord(x), coord(y))
+
+    state = {"x": 0, "y": 0, "scale": 1.0, "alpha": 255}
+    last_time = -1
+    for key in keyframes:
+        state.update({k: v for k, v in key.items() if k in state})
+        time = int(key["t"])
+        if time <= last_time:
+            raise ConvertError(f"shape {index}: keyframe times must increase")
+        last_time = time
+        ease = key.get("ease", "linear")
+        if ease not in EASINGS:
+            raise ConvertError(f"shape {index}: unknown easing '{ease}'")
+        data += struct.pack("<HBBhhH", time, EASINGS[ease],
+                            max(0, min(255, int(state["alpha"]))),
+                            coord(state["x"]), coord(state["y"]),
+                            max(0, min(0xFFFF, round(state["scale"] * 256))))
+    return data
+
+
+def convert(description):
+    shapes = description.get("shapes", [])
+    if not 1 <= len(shapes) <= MAX_SHAPES:
+        raise ConvertError(f"between 1 and {MAX_SHAPES} shapes are supported")
+
+    data = struct.pack("<4sBBHHH", MAGIC, VERSION, len(shapes),
+                       int(description.get("duration", 2000)),
+                       int(description.get("size", 128)),
+                       rgb565(description.get("background", "#000000")))
+    for index, shape in enumerate(shapes):
+        data += pack_shape(index, shape)
+
+    if len(data) > MAX_FILE_SIZE:
+        raise ConvertError(f"{len(data)} bytes exceeds {MAX_FILE_SIZE}")
+    return data
+
+
+def main(argv):
+    if len(argv) != 3:
+        print(__doc__.strip().splitlines()[0])
+        print(f"usage: {argv[0]} <input.json> <output.vec>")
+        return 2
+    try:
+        with open(argv[1], "r", encoding="utf-8") as source:
+            data = convert(json.load(source))
+    except (ConvertError, KeyError, ValueError) as error:
+        print(f"{argv[1]}: {error}", file=sys.stderr)
+        return 1
+    with open(argv[2], "wb") as output:
+        output.write(data)
+    print(f"Wrote {argv[2]} ({len(data)} bytes)")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
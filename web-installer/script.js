@@ -17,6 +17,7 @@ const SERIAL_COMMANDS = {
   GET_INFO: "GET_INFO", // Request device information
   GET_STATUS: "GET_STATUS", // Request current device status
   START_UPDATE: "START_UPDATE", // Initialize firmware update process
+  RESUME_UPDATE: "RESUME_UPDATE", // Continue an interrupted update
   SEND_CHUNK: "SEND_CHUNK", // Send firmware data chunk
   FINISH_UPDATE: "FINISH_UPDATE", // Finalize firmware update
   ABORT_UPDATE: "ABORT_UPDATE", // Cancel ongoing update
@@ -25,6 +26,7 @@ const SERIAL_COMMANDS = {
   GET_PARTITION_INFO: "GET_PARTITION_INFO", // Get partition information
   GET_STORAGE_INFO: "GET_STORAGE_INFO", // Get storage information
   VALIDATE_FIRMWARE: "VALIDATE_FIRMWARE", // Validate firmware integrity
+  BINARY: "BINARY", // Switch to binary frames (1,window) or back to text (0)
 };
 
 /**
@@ -52,6 +54,21 @@ const COMMAND_TIMEOUT = 5000; // Default command timeout (5 seconds)
 const CHUNK_TIMEOUT = 10000; // Chunk transfer timeout (10 seconds)
 const MAX_RETRIES = 2; // Maximum retry attempts for failed operations
 
+/**
+ * Binary framing - must match serial_module.h
+ */
+const FRAME_TYPES = {
+  COMMAND: 1, // Command line without the newline
+  DATA: 2, // Raw image chunk
+  RESPONSE: 3, // OK:, ERROR: or PROGRESS: line
+  ACK: 4, // Next chunk expected, chunks held beyond it, receive limit
+  NAK: 5, // Next chunk expected, reason, receive limit
+};
+const BINARY_WINDOW = 8; // Chunks in flight, the device may grant fewer
+const FRAME_TIMEOUT = 2000; // Resend a chunk not acknowledged by then
+const STALL_TIMEOUT = 10000; // Give up when no chunk is acknowledged
+const MAX_CHUNK_ATTEMPTS = 8; // Sends of one chunk before giving up
+
 //==============================================================================
 // GLOBAL STATE MANAGEMENT
 //==============================================================================
@@ -251,6 +268,134 @@ const utils = {
     }
     return btoa(binary);
   },
+
+  /**
+   * Compresses data as a gzip member
+   * @param {Uint8Array} bytes - Data to compress
+   * @returns {Promise<Uint8Array>} - Compressed data
+   */
+  async gzip(bytes) {
+    const stream = new Blob([bytes])
+      .stream()
+      .pipeThrough(new CompressionStream("gzip"));
+    return new Uint8Array(await new Response(stream).arrayBuffer());
+  },
+
+  /**
+   * SHA-256 of data as lowercase hex, names an image for resuming
+   * @param {Uint8Array} bytes - Data to hash
+   * @returns {Promise<string>} - 64 hex digits
+   */
+  async sha256Hex(bytes) {
+    const digest = new Uint8Array(await crypto.subtle.digest("SHA-256", bytes));
+    return Array.from(digest, (b) => b.toString(16).padStart(2, "0")).join("");
+  },
+};
+
+//==============================================================================
+// BINARY FRAMING
+//==============================================================================
+
+/**
+ * COBS framing with CRC32, as used by the device after BINARY:1
+ *
+ * A frame is type, uint16 sequence, uint16 payload length, the payload and
+ * a CRC32 of everything before it, little endian, COBS-encoded and ended
+ * by a zero byte.
+ */
+const framing = {
+  crcTable: null, // Built on first use
+
+  /**
+   * Computes the CRC32 (IEEE) used by zlib and the ESP32 ROM
+   * @param {Uint8Array} bytes - Data to check
+   * @returns {number} - Unsigned CRC32
+   */
+  crc32(bytes) {
+    if (!framing.crcTable) {
+      framing.crcTable = new Uint32Array(256);
+      for (let n = 0; n < 256; n++) {
+        let c = n;
+        for (let k = 0; k < 8; k++) {
+          c = c & 1 ? 0xedb88320 ^ (c >>> 1) : c >>> 1;
+        }
+        framing.crcTable[n] = c >>> 0;
+      }
+    }
+    let crc = 0xffffffff;
+    for (let i = 0; i < bytes.length; i++) {
+      crc = framing.crcTable[(crc ^ bytes[i]) & 0xff] ^ (crc >>> 8);
+    }
+    return (crc ^ 0xffffffff) >>> 0;
+  },
+
+  /**
+   * Builds a complete frame ready to write, delimiter included
+   * @param {number} type - Frame type from FRAME_TYPES
+   * @param {number} seq - Sequence number, low 16 bits are sent
+   * @param {Uint8Array} payload - Payload bytes
+   * @returns {Uint8Array} - Encoded frame
+   */
+  encode(type, seq, payload = new Uint8Array(0)) {
+    const body = new Uint8Array(5 + payload.length + 4);
+    const view = new DataView(body.buffer);
+    view.setUint8(0, type);
+    view.setUint16(1, seq & 0xffff, true);
+    view.setUint16(3, payload.length, true);
+    body.set(payload, 5);
+    const crc = framing.crc32(body.subarray(0, 5 + payload.length));
+    view.setUint32(5 + payload.length, crc, true);
+
+    // One code byte per block of up to 254 non-zero bytes
+    const out = new Uint8Array(body.length + Math.ceil(body.length / 254) + 2);
+    let codeAt = 0;
+    let length = 1;
+    let code = 1;
+    for (let i = 0; i < body.length; i++) {
+      if (body[i] !== 0) {
+        out[length++] = body[i];
+        code++;
+      }
+      if (body[i] === 0 || code === 0xff) {
+        out[codeAt] = code;
+        codeAt = length++;
+        code = 1;
+      }
+    }
+    out[codeAt] = code;
+    out[length++] = 0;
+    return out.subarray(0, length);
+  },
+
+  /**
+   * Decodes and checks one frame
+   * @param {Uint8Array} encoded - Frame bytes without the delimiter
+   * @returns {Object|null} - {type, seq, payload} or null if corrupt
+   */
+  decode(encoded) {
+    const body = new Uint8Array(encoded.length);
+    let length = 0;
+    for (let i = 0; i < encoded.length; ) {
+      const code = encoded[i];
+      if (code === 0 || i + code > encoded.length) return null;
+      body.set(encoded.subarray(i + 1, i + code), length);
+      length += code - 1;
+      i += code;
+      if (code !== 0xff && i < encoded.length) body[length++] = 0;
+    }
+    if (length < 9) return null;
+
+    const view = new DataView(body.buffer, 0, length);
+    const payloadLength = view.getUint16(3, true);
+    if (payloadLength !== length - 9) return null;
+    const crc = framing.crc32(body.subarray(0, length - 4));
+    if (crc !== view.getUint32(length - 4, true)) return null;
+    return {
+      type: view.getUint8(0),
+      seq: view.getUint16(1, true),
+      payload: body.subarray(5, length - 4),
+    };
+  },
 };
 
 //==============================================================================
@@ -262,6 +407,14 @@ const utils = {
  */
 const serial = {
   pendingCommand: null, // Currently awaiting response
+  binary: false, // Device talks in frames instead of text lines
+  commandSeq: 0, // Sequence of the last command frame
+  txBytes: 0, // Frame bytes written since BINARY:1, modulo 2^32
+  rxLimit: 0, // Frame bytes the device can take, from its last ACK or NAK
+  frameQueue: [], // ACK and NAK frames not yet processed
+  frameWaiter: null, // Wakes waitForFrame when a frame is queued
+  deviceError: null, // ERROR: line received outside a command
+  busyAt: 0, // Last PROGRESS line, the device is alive but writing flash
 
   /**
    * Establishes connection to the BYTE-90 device and verifies Update Mode
@@ -379,6 +532,12 @@ const serial = {
     }
 
     try {
+      // Needs the listener, so before isConnected drops
+      if (serial.binary && !serial.pendingCommand) {
+        await serial.disableBinary();
+      }
+      serial.binary = false;
+
       isConnected = false;
 
       if (serial.pendingCommand) {
@@ -460,6 +619,16 @@ const serial = {
     return new Promise((resolve, reject) => {
       const commandString = data ? `${command}:${data}\n` : `${command}\n`;
       const encoder = new TextEncoder();
+      let bytes = encoder.encode(commandString);
+      if (serial.binary) {
+        serial.commandSeq = (serial.commandSeq + 1) & 0xffff;
+        bytes = framing.encode(
+          FRAME_TYPES.COMMAND,
+          serial.commandSeq,
+          bytes.subarray(0, bytes.length - 1)
+        );
+        serial.txBytes = (serial.txBytes + bytes.length) >>> 0;
+      }
 
       const timeoutMs =
         command === SERIAL_COMMANDS.SEND_CHUNK ? CHUNK_TIMEOUT : customTimeout;
@@ -480,7 +649,7 @@ const serial = {
         }
       };
 
-      writer.write(encoder.encode(commandString)).catch((error) => {
+      writer.write(bytes).catch((error) => {
         clearTimeout(timeout);
         serial.pendingCommand = null;
         console.error("Write failed:", error);
@@ -514,10 +683,14 @@ const serial = {
 
   /**
    * Starts listening for incoming serial data and processes responses
+   *
+   * Text lines end with a newline, frames with a zero byte. The device only
+   * sends frames once it has answered BINARY:1, so the mode can be checked
+   * per message.
    */
   async startListening() {
     const decoder = new TextDecoder();
-    let buffer = "";
+    let buffer = new Uint8Array(0);
 
     try {
       while (reader && isConnected) {
@@ -525,16 +698,28 @@ const serial = {
 
         if (done) break;
 
-        buffer += decoder.decode(value, { stream: true });
-
-        let lines = buffer.split("\n");
-        buffer = lines.pop() || "";
-
-        for (const line of lines) {
-          if (line.trim()) {
-            serial.handleResponse(line.trim());
+        const joined = new Uint8Array(buffer.length + value.length);
+        joined.set(buffer);
+        joined.set(value, buffer.length);
+        buffer = joined;
+
+        let start = 0;
+        while (start < buffer.length) {
+          const end = buffer.indexOf(serial.binary ? 0 : 0x0a, start);
+          if (end < 0) break;
+
+          const message = buffer.subarray(start, end);
+          start = end + 1;
+          if (serial.binary) {
+            serial.handleFrame(message);
+          } else {
+            const line = decoder.decode(message).trim();
+            if (line) {
+              serial.handleResponse(line);
+            }
           }
         }
+        buffer = buffer.slice(start);
       }
     } catch (error) {
       if (error.name !== "AbortError") {
@@ -543,6 +728,111 @@ const serial = {
     }
   },
 
+  /**
+   * Processes one frame received in binary mode
+   * @param {Uint8Array} encoded - Frame bytes without the delimiter
+   */
+  handleFrame(encoded) {
+    if (encoded.length === 0) return;
+
+    const frame = framing.decode(encoded);
+    if (!frame) {
+      console.warn("Dropped corrupt frame from device");
+      return;
+    }
+
+    if (frame.type === FRAME_TYPES.RESPONSE) {
+      serial.handleResponse(new TextDecoder().decode(frame.payload).trim());
+    } else if (
+      frame.type === FRAME_TYPES.ACK ||
+      frame.type === FRAME_TYPES.NAK
+    ) {
+      const view = new DataView(
+        frame.payload.buffer,
+        frame.payload.byteOffset,
+        frame.payload.byteLength
+      );
+      const ack = frame.type === FRAME_TYPES.ACK;
+      if (view.byteLength < (ack ? 8 : 5)) return;
+
+      frame.held = ack ? view.getUint32(0, true) : 0;
+      const limit = view.getUint32(ack ? 4 : 1, true);
+      // Limits only grow, an older frame may arrive after a newer one
+      if (((limit - serial.rxLimit) | 0) > 0) {
+        serial.rxLimit = limit;
+      }
+
+      serial.frameQueue.push(frame);
+      if (serial.frameWaiter) {
+        const waiter = serial.frameWaiter;
+        serial.frameWaiter = null;
+        waiter();
+      }
+    }
+  },
+
+  /**
+   * Takes the next ACK or NAK frame, waiting for one if none is queued
+   * @param {number} timeoutMs - Longest wait in milliseconds
+   * @returns {Promise<Object|null>} - Frame, or null on timeout
+   */
+  async waitForFrame(timeoutMs) {
+    if (serial.frameQueue.length === 0) {
+      await new Promise((resolve) => {
+        const timeout = setTimeout(() => {
+          serial.frameWaiter = null;
+          resolve();
+        }, timeoutMs);
+        serial.frameWaiter = () => {
+          clearTimeout(timeout);
+          resolve();
+        };
+      });
+    }
+    return serial.frameQueue.shift() || null;
+  },
+
+  /**
+   * Switches the device to binary framing
+   * @param {number} window - Chunks to keep in flight
+   * @returns {Promise<Object|null>} - Accepted limits, null on older firmware
+   */
+  async enableBinary(window) {
+    let response;
+    try {
+      response = await serial.sendCommand(
+        SERIAL_COMMANDS.BINARY,
+        `1,${window}`
+      );
+    } catch (error) {
+      console.warn("Binary framing not available:", error);
+      return null;
+    }
+    if (!response.success || !response.window) {
+      return null;
+    }
+
+    serial.binary = true;
+    serial.txBytes = 0;
+    serial.rxLimit = response.rx_buffer;
+    serial.frameQueue = [];
+    return response;
+  },
+
+  /**
+   * Returns the device to the text protocol
+   */
+  async disableBinary() {
+    if (!serial.binary) return;
+    try {
+      await serial.sendCommand(SERIAL_COMMANDS.BINARY, "0", 2000);
+    } catch (error) {
+      console.warn("Failed to leave binary framing:", error);
+    }
+    // The device falls back by itself after a few seconds of silence
+    serial.binary = false;
+  },
+
   /**
    * Processes incoming responses from the device
    * @param {string} line - Raw response line from device
@@ -582,6 +872,7 @@ const serial = {
     }
 
     if (isProgress) {
+      serial.busyAt = performance.now();
       if (response.completed) {
         updateInProgress = false;
         if (response.success) {
@@ -604,6 +895,9 @@ const serial = {
       const handler = serial.pendingCommand;
       serial.pendingCommand = null;
       handler(response);
+    } else if (!response.success) {
+      // A chunk failed on the device while frames were streaming
+      serial.deviceError = response.message || "Device reported an error";
     }
   },
 };
@@ -663,41 +957,116 @@ const updater = {
       utils.hideStatus(elements.updateStatus);
       utils.updateProgress(0, "Checking device status...");
 
-      try {
-        const statusResponse = await serial.sendCommand(
-          SERIAL_COMMANDS.GET_STATUS
-        );
-
-        if (statusResponse && statusResponse.update_active) {
-          await serial.sendCommand(SERIAL_COMMANDS.ABORT_UPDATE);
-          await new Promise((resolve) => setTimeout(resolve, 1000));
+      // Firmware with update sessions keeps an interrupted update, only the
+      // part of this image it does not have yet needs to be sent
+      const fileBytes = new Uint8Array(await file.arrayBuffer());
+      const imageHash = deviceInfo?.resume
+        ? await utils.sha256Hex(fileBytes)
+        : "";
+      let offset = 0;
+      if (imageHash) {
+        try {
+          const info = await serial.sendCommand(
+            SERIAL_COMMANDS.GET_INFO,
+            "",
+            5000
+          );
+          const session = info?.session;
+          if (
+            session &&
+            session.sha256 === imageHash &&
+            session.type === updateType &&
+            session.offset < fileBytes.length
+          ) {
+            offset = session.offset;
+          }
+        } catch (error) {
+          console.warn("Failed to get update session:", error);
         }
-      } catch (error) {
-        console.warn("Failed to get status:", error);
       }
 
-      utils.updateProgress(1, "Resetting device state...");
+      // Aborting would drop the session
+      if (offset === 0) {
+        try {
+          const statusResponse = await serial.sendCommand(
+            SERIAL_COMMANDS.GET_STATUS
+          );
 
-      try {
-        await serial.sendCommand(SERIAL_COMMANDS.ABORT_UPDATE);
-        await new Promise((resolve) => setTimeout(resolve, 500));
-      } catch (error) {
-        console.warn("Abort command failed:", error);
+          if (statusResponse && statusResponse.update_active) {
+            await serial.sendCommand(SERIAL_COMMANDS.ABORT_UPDATE);
+            await new Promise((resolve) => setTimeout(resolve, 1000));
+          }
+        } catch (error) {
+          console.warn("Failed to get status:", error);
+        }
+
+        utils.updateProgress(1, "Resetting device state...");
+
+        try {
+          await serial.sendCommand(SERIAL_COMMANDS.ABORT_UPDATE);
+          await new Promise((resolve) => setTimeout(resolve, 500));
+        } catch (error) {
+          console.warn("Abort command failed:", error);
+        }
       }
 
-      utils.updateProgress(3, "Starting new update...");
+      utils.updateProgress(
+        3,
+        offset > 0
+          ? `Resuming update at ${utils.formatBytes(offset)}...`
+          : "Starting new update..."
+      );
 
-      console.log(`Starting update: ${file.size} bytes, type: ${updateType}`);
+      // Older firmware only speaks text, one chunk per round trip
+      const binary = await serial.enableBinary(BINARY_WINDOW);
+
+      utils.updateProgress(4, "Reading firmware file...");
+
+      let image = fileBytes.slice(offset);
+      let encoding = "";
+      // Firmware that lists encodings inflates images as they arrive
+      if (
+        binary &&
+        deviceInfo?.encodings?.includes("gzip") &&
+        typeof CompressionStream !== "undefined"
+      ) {
+        const compressed = await utils.gzip(image);
+        if (compressed.length < image.length) {
+          image = compressed;
+          encoding = "gzip";
+        }
+      }
 
-      const startResponse = await serial.sendCommandWithRetry(
-        SERIAL_COMMANDS.START_UPDATE,
-        `${file.size},${updateType}`,
-        2
+      console.log(
+        `Starting update: ${file.size} bytes, type: ${updateType}, ` +
+          (binary ? `binary window ${binary.window}` : "text") +
+          (offset > 0 ? `, resuming at ${offset}` : "") +
+          (encoding ? `, ${encoding} to ${image.length} bytes` : "")
       );
 
+      let startResponse;
+      if (offset > 0) {
+        startResponse = await serial.sendCommandWithRetry(
+          SERIAL_COMMANDS.RESUME_UPDATE,
+          `${image.length},${updateType},${encoding || "none"},` +
+            `${imageHash},${offset}`,
+          2
+        );
+      } else {
+        startResponse = await serial.sendCommandWithRetry(
+          SERIAL_COMMANDS.START_UPDATE,
+          `${image.length},${updateType}` +
+            (encoding || imageHash ? `,${encoding || "none"}` : "") +
+            (imageHash ? `,${imageHash}` : ""),
+          2
+        );
+      }
+
       if (!startResponse || !startResponse.success) {
         throw new Error(
-          startResponse?.message || "START_UPDATE command failed"
+          startResponse?.message ||
+            (offset > 0 ? "RESUME_UPDATE" : "START_UPDATE") +
+              " command failed"
         );
       }
 
@@ -707,80 +1076,27 @@ const updater = {
         );
       }
 
-      utils.updateProgress(5, "Reading firmware file...");
-
-      const arrayBuffer = await file.arrayBuffer();
-      const totalChunks = Math.ceil(arrayBuffer.byteLength / CHUNK_SIZE);
+      const chunkSize = binary ? binary.max_payload : CHUNK_SIZE;
+      const totalChunks = Math.ceil(image.length / chunkSize);
 
       console.log(
-        `File read: ${arrayBuffer.byteLength} bytes in ${totalChunks} chunks of ${CHUNK_SIZE} bytes each`
+        `File read: ${image.length} bytes in ${totalChunks} chunks of ${chunkSize} bytes each`
       );
       utils.updateProgress(10, "Starting upload...");
 
       const startTime = performance.now();
-      let bytesTransferred = 0;
-      let consecutiveErrors = 0;
-      const maxConsecutiveErrors = 3;
-
-      for (let i = 0; i < totalChunks; i++) {
-        const start = i * CHUNK_SIZE;
-        const end = Math.min(start + CHUNK_SIZE, arrayBuffer.byteLength);
-        const chunk = arrayBuffer.slice(start, end);
-        const base64Chunk = utils.arrayBufferToBase64(chunk);
-
-        if (i % 50 === 0 || i === totalChunks - 1) {
-          const transferProgress = 10 + (i / totalChunks) * 80;
-
-          utils.updateProgress(
-            transferProgress,
-            `Uploading: ${Math.round(
-              transferProgress
-            )}% Do not disconnect device.`
-          );
-        }
-
-        try {
-          const chunkResponse = await serial.sendCommand(
-            SERIAL_COMMANDS.SEND_CHUNK,
-            base64Chunk
-          );
-
-          if (!chunkResponse || !chunkResponse.success) {
-            consecutiveErrors++;
-            throw new Error(
-              chunkResponse?.message || `Chunk ${i + 1} rejected by device`
-            );
-          }
-
-          consecutiveErrors = 0;
-          if (i < totalChunks - 1) {
-            await new Promise((resolve) => setTimeout(resolve, 1));
-          }
-        } catch (chunkError) {
-          consecutiveErrors++;
-          console.error(
-            `Chunk ${i + 1} failed (${consecutiveErrors} consecutive errors):`,
-            chunkError
-          );
-
-          if (consecutiveErrors >= maxConsecutiveErrors) {
-            throw new Error(
-              `Too many consecutive errors (${consecutiveErrors}). Last error: ${chunkError.message}`
-            );
-          }
-
-          i--;
-          continue;
-        }
-
-        bytesTransferred = end;
+      if (binary) {
+        const resent = await updater.sendImageFramed(image, binary);
+        console.log(`Binary transfer done, ${resent} chunks resent`);
+      } else {
+        await updater.sendImageText(image.buffer);
       }
 
       const totalTime = (performance.now() - startTime) / 1000;
-      const avgSpeed = arrayBuffer.byteLength / totalTime;
+      const avgSpeed = image.length / totalTime;
       console.log(
         `Transfer completed: ${utils.formatBytes(
-          arrayBuffer.byteLength
+          image.length
         )} in ${totalTime.toFixed(2)}s (${utils.formatBytes(avgSpeed)}/s)`
       );
 
@@ -793,6 +1109,7 @@ const updater = {
       if (!finishResponse || !finishResponse.success) {
         throw new Error(finishResponse?.message || "Failed to finish update");
       }
+      serial.binary = false; // The device restarts in text mode
 
       utils.updateProgress(100, "Update completed successfully!");
       utils.showStatus(
@@ -828,22 +1145,224 @@ const updater = {
       }, 2000);
     } catch (error) {
       console.error("Update failed:", error);
-      utils.showStatus(
-        elements.updateStatus,
-        `Update failed: ${error.message}`,
-        "error"
-      );
       updateInProgress = false;
       ui.updateUpdateState(false);
 
+      // Keep the session, what reached flash is not sent again next time
+      if (deviceInfo?.resume) {
+        utils.showStatus(
+          elements.updateStatus,
+          `Update failed: ${error.message}. Press Update again to resume.`,
+          "error"
+        );
+      } else {
+        utils.showStatus(
+          elements.updateStatus,
+          `Update failed: ${error.message}`,
+          "error"
+        );
+        try {
+          await serial.sendCommand(SERIAL_COMMANDS.ABORT_UPDATE);
+        } catch (abortError) {
+          console.warn("Failed to abort update after error:", abortError);
+        }
+      }
+      await serial.disableBinary();
+    }
+  },
+
+  /**
+   * Sends the image as base64 SEND_CHUNK lines, waiting for each reply
+   * @param {ArrayBuffer} arrayBuffer - Image to send
+   * @returns {Promise<void>} - Resolves when every chunk was accepted
+   */
+  async sendImageText(arrayBuffer) {
+    const totalChunks = Math.ceil(arrayBuffer.byteLength / CHUNK_SIZE);
+    let consecutiveErrors = 0;
+    const maxConsecutiveErrors = 3;
+
+    for (let i = 0; i < totalChunks; i++) {
+      const start = i * CHUNK_SIZE;
+      const end = Math.min(start + CHUNK_SIZE, arrayBuffer.byteLength);
+      const chunk = arrayBuffer.slice(start, end);
+      const base64Chunk = utils.arrayBufferToBase64(chunk);
+
+      if (i % 50 === 0 || i === totalChunks - 1) {
+        const transferProgress = 10 + (i / totalChunks) * 80;
+
+        utils.updateProgress(
+          transferProgress,
+          `Uploading: ${Math.round(
+            transferProgress
+          )}% Do not disconnect device.`
+        );
+      }
+
       try {
-        await serial.sendCommand(SERIAL_COMMANDS.ABORT_UPDATE);
-      } catch (abortError) {
-        console.warn("Failed to abort update after error:", abortError);
+        const chunkResponse = await serial.sendCommand(
+          SERIAL_COMMANDS.SEND_CHUNK,
+          base64Chunk
+        );
+
+        if (!chunkResponse || !chunkResponse.success) {
+          consecutiveErrors++;
+          throw new Error(
+            chunkResponse?.message || `Chunk ${i + 1} rejected by device`
+          );
+        }
+
+        consecutiveErrors = 0;
+        if (i < totalChunks - 1) {
+          await new Promise((resolve) => setTimeout(resolve, 1));
+        }
+      } catch (chunkError) {
+        consecutiveErrors++;
+        console.error(
+          `Chunk ${i + 1} failed (${consecutiveErrors} consecutive errors):`,
+          chunkError
+        );
+
+        if (consecutiveErrors >= maxConsecutiveErrors) {
+          throw new Error(
+            `Too many consecutive errors (${consecutiveErrors}). Last error: ${chunkError.message}`
+          );
+        }
+
+        i--;
+        continue;
       }
     }
   },
 
+  /**
+   * Streams the image as DATA frames with several chunks in flight
+   *
+   * The window slides on the device's cumulative acks. Chunks it holds
+   * beyond a gap are not resent, a gap below a held chunk is resent at
+   * once and anything else after FRAME_TIMEOUT. Frames are only written
+   * while they fit the receive limit of the last ack, so the device's RX
+   * buffer never overflows.
+   *
+   * @param {Uint8Array} bytes - Image to send
+   * @param {Object} limits - BINARY reply with max_payload and window
+   * @returns {Promise<number>} - Chunks sent more than once
+   */
+  async sendImageFramed(bytes, limits) {
+    const chunkSize = limits.max_payload;
+    const window = limits.window;
+    const totalChunks = Math.ceil(bytes.length / chunkSize);
+    const sentAt = new Float64Array(totalChunks); // 0 until first sent
+    const attempts = new Uint8Array(totalChunks);
+    const isHeld = (chunk, base, held) =>
+      chunk > base && ((held >>> (chunk - base - 1)) & 1) === 1;
+    // Progress while a chunk inflates to many sectors delays timeouts
+    const quietSince = (chunk) => Math.max(sentAt[chunk], serial.busyAt);
+    let base = 0; // Every chunk before it is written
+    let held = 0; // Bit i: chunk base + 1 + i is held by the device
+    let resent = 0;
+    let progressAt = performance.now();
+    let shownPercent = -1;
+
+    serial.deviceError = null;
+
+    while (base < totalChunks) {
+      const now = performance.now();
+      const end = Math.min(base + window, totalChunks);
+
+      for (let chunk = base; chunk < end; chunk++) {
+        if (isHeld(chunk, base, held)) continue;
+        if (sentAt[chunk] && now - quietSince(chunk) < FRAME_TIMEOUT) continue;
+
+        const frame = framing.encode(
+          FRAME_TYPES.DATA,
+          chunk,
+          bytes.subarray(chunk * chunkSize, (chunk + 1) * chunkSize)
+        );
+        if (((serial.rxLimit - serial.txBytes - frame.length) | 0) < 0) {
+          break; // RX buffer full, wait for the next ack
+        }
+        if (++attempts[chunk] > MAX_CHUNK_ATTEMPTS) {
+          throw new Error(
+            `Chunk ${chunk + 1} failed ${MAX_CHUNK_ATTEMPTS} times`
+          );
+        }
+        if (attempts[chunk] > 1) resent++;
+
+        sentAt[chunk] = now;
+        serial.txBytes = (serial.txBytes + frame.length) >>> 0;
+        await writer.write(frame);
+      }
+
+      if (serial.deviceError) {
+        throw new Error(serial.deviceError);
+      }
+      if (now - Math.max(progressAt, serial.busyAt) > STALL_TIMEOUT) {
+        throw new Error(`No progress at chunk ${base + 1}`);
+      }
+
+      let wait = FRAME_TIMEOUT;
+      for (let chunk = base; chunk < end; chunk++) {
+        if (sentAt[chunk] && !isHeld(chunk, base, held)) {
+          wait = Math.min(wait, quietSince(chunk) + FRAME_TIMEOUT - now);
+        }
+      }
+      const frame = await serial.waitForFrame(Math.max(1, wait));
+      if (!frame) continue;
+
+      // Sequence numbers are the low 16 bits of the chunk index
+      const ahead = (frame.seq - base) & 0xffff;
+      if (ahead > window) continue;
+      if (ahead > 0) {
+        base += ahead;
+        held >>>= ahead;
+        progressAt = performance.now();
+        const percent = Math.floor((base * 100) / totalChunks);
+        if (percent !== shownPercent) {
+          shownPercent = percent;
+          const transferProgress = 10 + percent * 0.8;
+          utils.updateProgress(
+            transferProgress,
+            `Uploading: ${Math.round(
+              transferProgress
+            )}% Do not disconnect device.`
+          );
+        }
+      }
+      if (frame.type === FRAME_TYPES.ACK) {
+        held = frame.held;
+      } else if (base < totalChunks) {
+        // The corrupt frame can be any chunk in flight. Resend the oldest
+        // one right away, unless it already went out after all the others
+        let newest = 0;
+        for (let chunk = base + 1; chunk < end; chunk++) {
+          if (!isHeld(chunk, base, held)) {
+            newest = Math.max(newest, sentAt[chunk]);
+          }
+        }
+        if (sentAt[base] <= newest || newest === 0) {
+          sentAt[base] = 0;
+        }
+      }
+
+      // A chunk sent before one that already arrived was lost on the way
+      let latest = 0;
+      let highest = base;
+      for (let i = 0; i < window; i++) {
+        if ((held >>> i) & 1) {
+          latest = Math.max(latest, sentAt[base + 1 + i]);
+          highest = base + 1 + i;
+        }
+      }
+      for (let chunk = base; chunk < highest; chunk++) {
+        if (!isHeld(chunk, base, held) && sentAt[chunk] < latest) {
+          sentAt[chunk] = 0;
+        }
+      }
+    }
+
+    return resent;
+  },
+
   /**
    * Cancels an ongoing firmware update operation
    * @returns {Promise<void>} - Resolves when abort completes